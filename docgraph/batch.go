@@ -0,0 +1,406 @@
+package docgraph
+
+import (
+	"bytes"
+	"context"
+	"encoding/json"
+	"fmt"
+	"io/ioutil"
+	"net/http"
+	"sync"
+	"time"
+
+	eos "github.com/eoscanada/eos-go"
+)
+
+// BatchOptions configures a BatchWriter; zero values select the defaults
+type BatchOptions struct {
+	// transactions pushed concurrently, default 4
+	InFlight int
+	// upper bound on the actions packed into one transaction, default 200
+	MaxActions int
+	// actions in the first transactions, before any receipt has been seen, default 10
+	InitialActions int
+	// billed CPU, in microseconds, each transaction is sized towards, default 50000; keep it
+	// well below the chain's max_transaction_cpu_usage, the billed CPU varies between blocks
+	TargetCPU uint32
+	// further pushes of a transaction that expired or got no response, default 3
+	Retries int
+}
+
+// BatchStats counts the work a BatchWriter has pushed
+type BatchStats struct {
+	Transactions uint64
+	Actions      uint64
+	Retries      uint64
+	Splits       uint64
+	CPU          uint64
+	Duration     time.Duration
+}
+
+// ActionsPerSecond is the rate the actions were applied at
+func (s BatchStats) ActionsPerSecond() float64 {
+	if s.Duration <= 0 {
+		return 0
+	}
+	return float64(s.Actions) / s.Duration.Seconds()
+}
+
+// BatchWriter packs actions into transactions and pushes several of them at once. The number
+// of actions per transaction follows the billed CPU of earlier receipts, and a transaction that
+// exceeds its CPU or deadline is split in half and pushed again.
+//
+// Transactions in flight may be applied in any order. Call Flush between actions that depend on
+// each other, e.g. after creating documents and before creating the edges between them. Add,
+// Flush and Close are called from a single goroutine.
+type BatchWriter struct {
+	ctx  context.Context
+	api  *eos.API
+	opts BatchOptions
+
+	pending  []*eos.Action
+	work     chan []*eos.Action
+	inFlight sync.WaitGroup
+	workers  sync.WaitGroup
+	started  time.Time
+
+	mu        sync.Mutex
+	txOpts    *eos.TxOptions
+	filled    time.Time
+	cpuAction float64
+	stats     BatchStats
+	err       error
+}
+
+// tapos is refreshed this often; the reference block only has to be among the last 2^16 blocks
+const taposRefresh = time.Minute
+
+// NewBatchWriter starts the workers of a BatchWriter; Close must be called to stop them
+func NewBatchWriter(ctx context.Context, api *eos.API, opts BatchOptions) *BatchWriter {
+	if opts.InFlight <= 0 {
+		opts.InFlight = 4
+	}
+	if opts.MaxActions <= 0 {
+		opts.MaxActions = 200
+	}
+	if opts.InitialActions <= 0 {
+		opts.InitialActions = 10
+	}
+	if opts.TargetCPU == 0 {
+		opts.TargetCPU = 50000
+	}
+	if opts.Retries <= 0 {
+		opts.Retries = 3
+	}
+
+	w := &BatchWriter{
+		ctx:     ctx,
+		api:     api,
+		opts:    opts,
+		work:    make(chan []*eos.Action),
+		started: time.Now(),
+	}
+	for i := 0; i < opts.InFlight; i++ {
+		w.workers.Add(1)
+		go func() {
+			defer w.workers.Done()
+			for actions := range w.work {
+				w.push(actions)
+				w.inFlight.Done()
+			}
+		}()
+	}
+	return w
+}
+
+// Add queues an action, pushing a transaction once enough actions are queued. It returns the
+// first error of an earlier transaction, after which nothing more is pushed.
+func (w *BatchWriter) Add(action *eos.Action) error {
+	if err := w.Err(); err != nil {
+		return err
+	}
+	w.pending = append(w.pending, action)
+	if len(w.pending) >= w.batchSize() {
+		w.dispatch()
+	}
+	return nil
+}
+
+// Flush pushes the queued actions and waits until every transaction in flight is applied
+func (w *BatchWriter) Flush() error {
+	w.dispatch()
+	w.inFlight.Wait()
+	return w.Err()
+}
+
+// Close flushes the writer and stops its workers
+func (w *BatchWriter) Close() (BatchStats, error) {
+	err := w.Flush()
+	close(w.work)
+	w.workers.Wait()
+	return w.Stats(), err
+}
+
+// Err returns the first error of a transaction pushed by the writer
+func (w *BatchWriter) Err() error {
+	w.mu.Lock()
+	defer w.mu.Unlock()
+	return w.err
+}
+
+// Stats returns what the writer has pushed so far
+func (w *BatchWriter) Stats() BatchStats {
+	w.mu.Lock()
+	defer w.mu.Unlock()
+	stats := w.stats
+	stats.Duration = time.Since(w.started)
+	return stats
+}
+
+// batchSize is the number of actions expected to bill TargetCPU, from the average CPU per action
+func (w *BatchWriter) batchSize() int {
+	w.mu.Lock()
+	defer w.mu.Unlock()
+	if w.cpuAction == 0 {
+		return w.opts.InitialActions
+	}
+	size := int(float64(w.opts.TargetCPU) / w.cpuAction)
+	if size < 1 {
+		return 1
+	}
+	if size > w.opts.MaxActions {
+		return w.opts.MaxActions
+	}
+	return size
+}
+
+func (w *BatchWriter) dispatch() {
+	if len(w.pending) == 0 {
+		return
+	}
+	w.inFlight.Add(1)
+	w.work <- w.pending
+	w.pending = nil
+}
+
+func (w *BatchWriter) push(actions []*eos.Action) {
+	if w.Err() != nil {
+		return
+	}
+
+	var signed []byte
+	for attempt := 0; ; attempt++ {
+		if signed == nil {
+			txOpts, err := w.tapos(attempt > 0)
+			if err != nil {
+				w.fail(err)
+				return
+			}
+			signed, err = signActions(w.ctx, w.api, txOpts, actions)
+			if err != nil {
+				w.fail(err)
+				return
+			}
+		}
+
+		receipt, err := pushSigned(w.ctx, w.api, signed)
+		if err == nil {
+			w.record(len(actions), receipt.CPU)
+			return
+		}
+
+		chainErr, ok := err.(*ChainError)
+		retry := attempt < w.opts.Retries && w.ctx.Err() == nil
+		switch {
+		case ok && chainErr.Name == "tx_duplicate":
+			// an earlier push of this transaction was applied even though its response was lost
+			w.record(len(actions), 0)
+			return
+		case ok && chainErr.exceedsLimits() && len(actions) > 1:
+			w.split(actions)
+			return
+		case ok && chainErr.Name == "expired_tx_exception" && retry:
+			// sign again with a fresh reference block and expiration
+			signed = nil
+		case !ok && retry:
+			// the transaction may have been applied, so the same one is pushed again
+		default:
+			w.fail(fmt.Errorf("push %v actions: %v", len(actions), err))
+			return
+		}
+
+		w.mu.Lock()
+		w.stats.Retries++
+		w.mu.Unlock()
+	}
+}
+
+// split pushes the two halves of a transaction that was too expensive, one after the other
+func (w *BatchWriter) split(actions []*eos.Action) {
+	w.mu.Lock()
+	w.stats.Splits++
+	w.mu.Unlock()
+
+	half := len(actions) / 2
+	w.push(actions[:half])
+	w.push(actions[half:])
+}
+
+// tapos returns the shared transaction options, refreshing them when they are old or when a
+// transaction is retried
+func (w *BatchWriter) tapos(refresh bool) (*eos.TxOptions, error) {
+	w.mu.Lock()
+	defer w.mu.Unlock()
+	if w.txOpts != nil && !refresh && time.Since(w.filled) < taposRefresh {
+		return w.txOpts, nil
+	}
+
+	txOpts := &eos.TxOptions{}
+	if err := txOpts.FillFromChain(w.ctx, w.api); err != nil {
+		return nil, fmt.Errorf("fill tx options: %v", err)
+	}
+	w.txOpts = txOpts
+	w.filled = time.Now()
+	return txOpts, nil
+}
+
+func (w *BatchWriter) record(actions int, cpu uint32) {
+	w.mu.Lock()
+	defer w.mu.Unlock()
+	w.stats.Transactions++
+	w.stats.Actions += uint64(actions)
+	w.stats.CPU += uint64(cpu)
+	if cpu == 0 {
+		return
+	}
+
+	// moving average, so that the batch size follows the cost of the current kind of action
+	perAction := float64(cpu) / float64(actions)
+	if w.cpuAction == 0 {
+		w.cpuAction = perAction
+	} else {
+		w.cpuAction = 0.7*w.cpuAction + 0.3*perAction
+	}
+}
+
+func (w *BatchWriter) fail(err error) {
+	w.mu.Lock()
+	defer w.mu.Unlock()
+	if w.err == nil {
+		w.err = err
+	}
+}
+
+// ChainError is an error returned by nodeos for a pushed transaction
+type ChainError struct {
+	Code    int    `json:"code"`
+	Name    string `json:"name"`
+	What    string `json:"what"`
+	Details []struct {
+		Message string `json:"message"`
+	} `json:"details"`
+}
+
+func (e *ChainError) Error() string {
+	if len(e.Details) > 0 {
+		return fmt.Sprintf("%v: %v", e.Name, e.Details[0].Message)
+	}
+	return fmt.Sprintf("%v: %v", e.Name, e.What)
+}
+
+// exceedsLimits reports whether the transaction failed for its size rather than its content
+func (e *ChainError) exceedsLimits() bool {
+	switch e.Name {
+	case "tx_cpu_usage_exceeded", "deadline_exception", "leeway_deadline_exception", "tx_net_usage_exceeded":
+		return true
+	}
+	return false
+}
+
+// Receipt is the part of a pushed transaction's trace the package uses
+type Receipt struct {
+	TransactionID string
+	CPU           uint32
+}
+
+// ExecTrxCPU pushes the actions in a single transaction and returns the cpu_usage_us
+// billed in its receipt, which is not exposed by eos-go's push response
+func ExecTrxCPU(ctx context.Context, api *eos.API, actions []*eos.Action) (uint32, error) {
+	txOpts := &eos.TxOptions{}
+	err := txOpts.FillFromChain(ctx, api)
+	if err != nil {
+		return 0, fmt.Errorf("fill tx options: %v", err)
+	}
+
+	signed, err := signActions(ctx, api, txOpts, actions)
+	if err != nil {
+		return 0, err
+	}
+
+	receipt, err := pushSigned(ctx, api, signed)
+	if err != nil {
+		return 0, err
+	}
+	return receipt.CPU, nil
+}
+
+// signActions signs the actions as one transaction and returns the push_transaction request body
+func signActions(ctx context.Context, api *eos.API, txOpts *eos.TxOptions, actions []*eos.Action) ([]byte, error) {
+	tx := eos.NewTransaction(actions, txOpts)
+	_, packedTx, err := api.SignTransaction(ctx, tx, txOpts.ChainID, eos.CompressionNone)
+	if err != nil {
+		return nil, fmt.Errorf("sign transaction: %v", err)
+	}
+
+	body, err := json.Marshal(packedTx)
+	if err != nil {
+		return nil, fmt.Errorf("marshal transaction: %v", err)
+	}
+	return body, nil
+}
+
+// pushSigned pushes a signed transaction, returning a *ChainError when nodeos rejects it
+func pushSigned(ctx context.Context, api *eos.API, signed []byte) (Receipt, error) {
+	request, err := http.NewRequestWithContext(ctx, "POST", api.BaseURL+"/v1/chain/push_transaction", bytes.NewReader(signed))
+	if err != nil {
+		return Receipt{}, fmt.Errorf("push transaction: %v", err)
+	}
+	request.Header.Set("Content-Type", "application/json")
+
+	resp, err := api.HttpClient.Do(request)
+	if err != nil {
+		return Receipt{}, fmt.Errorf("push transaction: %v", err)
+	}
+	defer resp.Body.Close()
+
+	data, err := ioutil.ReadAll(resp.Body)
+	if err != nil {
+		return Receipt{}, fmt.Errorf("read push response: %v", err)
+	}
+	if resp.StatusCode >= 300 {
+		var failed struct {
+			Error ChainError `json:"error"`
+		}
+		if json.Unmarshal(data, &failed) != nil || failed.Error.Name == "" {
+			return Receipt{}, fmt.Errorf("push transaction: %v", string(data))
+		}
+		return Receipt{}, &failed.Error
+	}
+
+	var pushed struct {
+		TransactionID string `json:"transaction_id"`
+		Processed     struct {
+			Receipt struct {
+				CPUUsageMicroSeconds uint32 `json:"cpu_usage_us"`
+			} `json:"receipt"`
+		} `json:"processed"`
+	}
+	err = json.Unmarshal(data, &pushed)
+	if err != nil {
+		return Receipt{}, fmt.Errorf("unmarshal push response: %v", err)
+	}
+	return Receipt{
+		TransactionID: pushed.TransactionID,
+		CPU:           pushed.Processed.Receipt.CPUUsageMicroSeconds,
+	}, nil
+}
@@ -0,0 +1,309 @@
+package docgraph
+
+import (
+	"container/list"
+	"context"
+	"encoding/json"
+	"fmt"
+	"io/ioutil"
+	"os"
+	"sync"
+	"time"
+
+	eos "github.com/eoscanada/eos-go"
+)
+
+// CacheOptions configures a DocumentCache; zero values select the defaults
+type CacheOptions struct {
+	// documents held before the least recently used is evicted, default 10000
+	Capacity int
+	// concurrent requests LoadDocuments makes for misses, default 8
+	Workers int
+	// how long a hash that was not found is remembered as missing, default 30 seconds;
+	// content addressing means the same document may be created again later
+	NegativeTTL time.Duration
+	// read documents from the keyed 'docsbyhash' table layout
+	Keyed bool
+	// file the cache is loaded from and saved to by Save, if set
+	Path string
+}
+
+// CacheStats counts the lookups of a DocumentCache
+type CacheStats struct {
+	Hits         uint64
+	NegativeHits uint64
+	Misses       uint64
+	Evictions    uint64
+	Size         int
+}
+
+// HitRate is the share of lookups answered without a request
+func (s CacheStats) HitRate() float64 {
+	lookups := s.Hits + s.NegativeHits + s.Misses
+	if lookups == 0 {
+		return 0
+	}
+	return float64(s.Hits+s.NegativeHits) / float64(lookups)
+}
+
+// DocumentCache is a bounded LRU cache of documents by hash. A document never changes under its
+// hash, so a cached document stays valid until it is erased; hashes that were not found or were
+// erased are remembered as missing for NegativeTTL.
+type DocumentCache struct {
+	api      *eos.API
+	contract eos.AccountName
+	opts     CacheOptions
+
+	mu      sync.Mutex
+	entries map[string]*list.Element
+	recent  *list.List
+	stats   CacheStats
+}
+
+type cacheEntry struct {
+	key      string
+	document Document
+	// set for a hash remembered as missing, until when it is
+	missingUntil time.Time
+}
+
+// NewDocumentCache returns an empty cache, or the cache saved at opts.Path if there is one
+func NewDocumentCache(api *eos.API, contract eos.AccountName, opts CacheOptions) (*DocumentCache, error) {
+	if opts.Capacity <= 0 {
+		opts.Capacity = 10000
+	}
+	if opts.Workers <= 0 {
+		opts.Workers = 8
+	}
+	if opts.NegativeTTL <= 0 {
+		opts.NegativeTTL = 30 * time.Second
+	}
+
+	c := &DocumentCache{
+		api:      api,
+		contract: contract,
+		opts:     opts,
+		entries:  make(map[string]*list.Element),
+		recent:   list.New(),
+	}
+	if opts.Path == "" {
+		return c, nil
+	}
+
+	data, err := ioutil.ReadFile(opts.Path)
+	if os.IsNotExist(err) {
+		return c, nil
+	}
+	if err != nil {
+		return nil, fmt.Errorf("read cache %v: %v", opts.Path, err)
+	}
+
+	var documents []Document
+	err = json.Unmarshal(data, &documents)
+	if err != nil {
+		return nil, fmt.Errorf("unmarshal cache %v: %v", opts.Path, err)
+	}
+	for _, document := range documents {
+		c.store(cacheEntry{key: string(document.Hash), document: document})
+	}
+	return c, nil
+}
+
+// Get returns the document with the hash, reading it from the chain if it is not cached; a
+// *DocumentNotFoundError is returned for a hash that is not stored
+func (c *DocumentCache) Get(ctx context.Context, hash eos.Checksum256) (Document, error) {
+	document, cached, err := c.lookup(hash)
+	if cached {
+		return document, err
+	}
+	return c.fetch(ctx, hash)
+}
+
+// LoadDocuments returns the documents with the hashes, in the same order. Each distinct hash that
+// is not cached is read once, several at a time; the first error of those reads is returned.
+func (c *DocumentCache) LoadDocuments(ctx context.Context, hashes []eos.Checksum256) ([]Document, error) {
+	documents := make([]Document, len(hashes))
+	var misses []eos.Checksum256
+	missing := make(map[string][]int)
+	for i, hash := range hashes {
+		key := string(hash)
+		if indexes, ok := missing[key]; ok {
+			missing[key] = append(indexes, i)
+			continue
+		}
+
+		document, cached, err := c.lookup(hash)
+		if cached {
+			if err != nil {
+				return nil, err
+			}
+			documents[i] = document
+			continue
+		}
+		missing[key] = []int{i}
+		misses = append(misses, hash)
+	}
+
+	var errOnce sync.Once
+	var firstErr error
+	next := make(chan eos.Checksum256)
+	var wg sync.WaitGroup
+	for w := 0; w < c.opts.Workers && w < len(misses); w++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for hash := range next {
+				document, err := c.fetch(ctx, hash)
+				if err != nil {
+					errOnce.Do(func() { firstErr = err })
+					continue
+				}
+				// each worker writes distinct indexes
+				for _, i := range missing[string(hash)] {
+					documents[i] = document
+				}
+			}
+		}()
+	}
+	for _, hash := range misses {
+		next <- hash
+	}
+	close(next)
+	wg.Wait()
+
+	if firstErr != nil {
+		return nil, firstErr
+	}
+	return documents, nil
+}
+
+// Erased remembers the hash as missing, e.g. after the client erased the document
+func (c *DocumentCache) Erased(hash eos.Checksum256) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	c.storeLocked(cacheEntry{key: string(hash), missingUntil: time.Now().Add(c.opts.NegativeTTL)})
+}
+
+// Forget removes the hash from the cache, found or missing
+func (c *DocumentCache) Forget(hash eos.Checksum256) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	if element, ok := c.entries[string(hash)]; ok {
+		c.recent.Remove(element)
+		delete(c.entries, string(hash))
+	}
+}
+
+// Stats returns the lookups counted so far
+func (c *DocumentCache) Stats() CacheStats {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	stats := c.stats
+	stats.Size = len(c.entries)
+	return stats
+}
+
+// Save writes the cached documents to opts.Path, least recently used first so that loading the
+// file restores the order; hashes remembered as missing are not saved
+func (c *DocumentCache) Save() error {
+	if c.opts.Path == "" {
+		return fmt.Errorf("cache has no path to save to")
+	}
+
+	c.mu.Lock()
+	documents := make([]Document, 0, len(c.entries))
+	for element := c.recent.Back(); element != nil; element = element.Prev() {
+		entry := element.Value.(*cacheEntry)
+		if entry.missingUntil.IsZero() {
+			documents = append(documents, entry.document)
+		}
+	}
+	c.mu.Unlock()
+
+	data, err := json.Marshal(documents)
+	if err != nil {
+		return fmt.Errorf("marshal cache: %v", err)
+	}
+
+	// written aside and renamed, so a crash never leaves a truncated cache behind
+	tmp := c.opts.Path + ".tmp"
+	err = ioutil.WriteFile(tmp, data, 0644)
+	if err != nil {
+		return fmt.Errorf("write cache %v: %v", tmp, err)
+	}
+	return os.Rename(tmp, c.opts.Path)
+}
+
+// lookup returns the cached document, or a *DocumentNotFoundError for a hash remembered as
+// missing; cached is false when the chain has to be asked
+func (c *DocumentCache) lookup(hash eos.Checksum256) (document Document, cached bool, err error) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	element, ok := c.entries[string(hash)]
+	if !ok {
+		c.stats.Misses++
+		return Document{}, false, nil
+	}
+
+	entry := element.Value.(*cacheEntry)
+	if !entry.missingUntil.IsZero() {
+		if time.Now().After(entry.missingUntil) {
+			c.recent.Remove(element)
+			delete(c.entries, entry.key)
+			c.stats.Misses++
+			return Document{}, false, nil
+		}
+		c.recent.MoveToFront(element)
+		c.stats.NegativeHits++
+		return Document{}, true, &DocumentNotFoundError{Hash: hash.String()}
+	}
+
+	c.recent.MoveToFront(element)
+	c.stats.Hits++
+	return entry.document, true, nil
+}
+
+// fetch reads the document from the chain and caches the outcome
+func (c *DocumentCache) fetch(ctx context.Context, hash eos.Checksum256) (Document, error) {
+	var document Document
+	var err error
+	if c.opts.Keyed {
+		document, err = LoadKeyedDocument(ctx, c.api, c.contract, hash)
+	} else {
+		document, err = LoadDocument(ctx, c.api, c.contract, hash.String())
+	}
+
+	if _, notFound := err.(*DocumentNotFoundError); notFound {
+		c.Erased(hash)
+		return Document{}, err
+	}
+	if err != nil {
+		return Document{}, err
+	}
+
+	c.store(cacheEntry{key: string(hash), document: document})
+	return document, nil
+}
+
+func (c *DocumentCache) store(entry cacheEntry) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	c.storeLocked(entry)
+}
+
+func (c *DocumentCache) storeLocked(entry cacheEntry) {
+	if element, ok := c.entries[entry.key]; ok {
+		element.Value = &entry
+		c.recent.MoveToFront(element)
+		return
+	}
+
+	c.entries[entry.key] = c.recent.PushFront(&entry)
+	for c.recent.Len() > c.opts.Capacity {
+		oldest := c.recent.Back()
+		c.recent.Remove(oldest)
+		delete(c.entries, oldest.Value.(*cacheEntry).key)
+		c.stats.Evictions++
+	}
+}
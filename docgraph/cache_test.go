@@ -0,0 +1,112 @@
+package docgraph
+
+import (
+	"context"
+	"encoding/json"
+	"io/ioutil"
+	"net/http"
+	"net/http/httptest"
+	"os"
+	"path/filepath"
+	"sync/atomic"
+	"testing"
+
+	eos "github.com/eoscanada/eos-go"
+	"github.com/stretchr/testify/require"
+)
+
+// newDocumentServer serves get_table_rows for the documents with the hashes, counting requests
+func newDocumentServer(t *testing.T, hashes ...string) (*httptest.Server, *int64) {
+	var document Document
+	require.NoError(t, json.Unmarshal([]byte(testDocument), &document))
+
+	rows := make(map[string]json.RawMessage)
+	for _, hash := range hashes {
+		document.Hash = eos.Checksum256(mustDecodeHex(t, hash))
+		row, err := json.Marshal(document)
+		require.NoError(t, err)
+		rows[hash] = row
+	}
+
+	var requests int64
+	server := httptest.NewServer(http.HandlerFunc(func(w http.ResponseWriter, r *http.Request) {
+		atomic.AddInt64(&requests, 1)
+		var request struct {
+			LowerBound string `json:"lower_bound"`
+		}
+		json.NewDecoder(r.Body).Decode(&request)
+
+		response := struct {
+			Rows []json.RawMessage `json:"rows"`
+			More bool              `json:"more"`
+		}{Rows: []json.RawMessage{}}
+		if row, ok := rows[request.LowerBound]; ok {
+			response.Rows = append(response.Rows, row)
+		}
+		json.NewEncoder(w).Encode(response)
+	}))
+	return server, &requests
+}
+
+func TestDocumentCache(t *testing.T) {
+	hashes := []string{
+		"2867b68741bf31331220ed7fd433069731749bd593aeef83c81ff3db190f1eec",
+		"7463fa7dda551b9c4bbd2ba17b793931c825cefff9eede14461fd1a5c9f07d15",
+		"d4ec74355830056924c83f20ffb1a22ad0c5145a96daddf6301897a092de951e",
+	}
+	missing := eos.Checksum256(mustDecodeHex(t, "05e81010c4600ed5d978d2ddf22420ffdf6c4094f4b3822711f0596c7c342ccb"))
+
+	server, requests := newDocumentServer(t, hashes...)
+	defer server.Close()
+
+	folder, err := ioutil.TempDir("", "docgraph")
+	require.NoError(t, err)
+	defer os.RemoveAll(folder)
+
+	api := eos.New(server.URL)
+	cache, err := NewDocumentCache(api, "documents", CacheOptions{Capacity: 2, Path: filepath.Join(folder, "cache.json")})
+	require.NoError(t, err)
+
+	first := eos.Checksum256(mustDecodeHex(t, hashes[0]))
+	second := eos.Checksum256(mustDecodeHex(t, hashes[1]))
+	third := eos.Checksum256(mustDecodeHex(t, hashes[2]))
+
+	// duplicates are read once
+	documents, err := cache.LoadDocuments(context.Background(), []eos.Checksum256{first, second, first, second})
+	require.NoError(t, err)
+	require.Equal(t, int64(2), atomic.LoadInt64(requests))
+	require.Equal(t, hashes[0], documents[2].Hash.String())
+	require.Equal(t, hashes[1], documents[3].Hash.String())
+
+	document, err := cache.Get(context.Background(), first)
+	require.NoError(t, err)
+	require.Equal(t, hashes[0], document.Hash.String())
+	require.Equal(t, int64(2), atomic.LoadInt64(requests))
+
+	// a missing hash is only requested once
+	for i := 0; i < 2; i++ {
+		_, err = cache.Get(context.Background(), missing)
+		require.IsType(t, &DocumentNotFoundError{}, err)
+	}
+	require.Equal(t, int64(3), atomic.LoadInt64(requests))
+
+	// the second and then the first document, the least recently used, are evicted
+	_, err = cache.Get(context.Background(), third)
+	require.NoError(t, err)
+	stats := cache.Stats()
+	require.Equal(t, uint64(2), stats.Evictions)
+	require.Equal(t, 2, stats.Size)
+	require.Equal(t, uint64(1), stats.Hits)
+	require.Equal(t, uint64(1), stats.NegativeHits)
+	require.Equal(t, uint64(4), stats.Misses)
+
+	// only the third document is saved, the missing hash is not
+	require.NoError(t, cache.Save())
+	reloaded, err := NewDocumentCache(api, "documents", CacheOptions{Capacity: 2, Path: filepath.Join(folder, "cache.json")})
+	require.NoError(t, err)
+	documents, err = reloaded.LoadDocuments(context.Background(), []eos.Checksum256{third, first})
+	require.NoError(t, err)
+	require.Equal(t, hashes[2], documents[0].Hash.String())
+	require.Equal(t, hashes[0], documents[1].Hash.String())
+	require.Equal(t, int64(5), atomic.LoadInt64(requests))
+}
@@ -1,14 +1,20 @@
 package docgraph_test
 
 import (
+	"bufio"
+	"bytes"
+	"crypto/sha256"
 	"encoding/json"
+	"errors"
 	"io/ioutil"
 	"log"
 	"os"
 	"os/exec"
+	"strconv"
 	"testing"
 	"time"
 
+	eostest "github.com/digital-scarcity/eos-go-test"
 	eos "github.com/eoscanada/eos-go"
 	"github.com/hypha-dao/document/docgraph"
 	"gotest.tools/v3/assert"
@@ -19,7 +25,7 @@ const testingEndpoint = "http://localhost:8888"
 var env *Environment
 var chainResponsePause time.Duration
 
-func setupTestCase(t *testing.T) func(t *testing.T) {
+func setupTestCase(t testing.TB) func(t testing.TB) {
 	t.Log("Bootstrapping testing environment ...")
 
 	_, err := exec.Command("sh", "-c", "pkill -SIGINT nodeos").Output()
@@ -38,7 +44,7 @@ func setupTestCase(t *testing.T) func(t *testing.T) {
 
 	pause(t, 500*time.Millisecond, "", "")
 
-	return func(t *testing.T) {
+	return func(t testing.TB) {
 		folderName := "test_results"
 		t.Log("Saving graph to : ", folderName)
 		err := SaveGraph(env.ctx, &env.api, env.Docs, folderName)
@@ -90,6 +96,11 @@ func TestDocuments(t *testing.T) {
 
 				// compare document from chain to document from file
 				assert.Assert(t, lastDoc.IsEqual(documentFromFile))
+
+				// the hash computed by the client is the one the contract stored
+				loadedDoc, err := docgraph.LoadDocument(env.ctx, &env.api, env.Docs, lastDoc.Hash.String())
+				assert.NilError(t, err)
+				assert.Assert(t, loadedDoc.IsEqual(documentFromFile))
 			})
 		}
 	})
@@ -215,6 +226,12 @@ func TestEdges(t *testing.T) {
 			doesNotExist, err := docgraph.EdgeExists(env.ctx, &env.api, env.Docs, test.fromDoc, test.toDoc, eos.Name("doesnotexist"))
 			assert.NilError(t, err)
 			assert.Assert(t, !doesNotExist)
+
+			// the Go port of concatHash gives the id the contract stored
+			edgesBetween, err := test.fromDoc.GetEdgesBetween(env.ctx, &env.api, env.Docs, test.toDoc.Hash)
+			assert.NilError(t, err)
+			assert.Equal(t, 1, len(edgesBetween))
+			assert.Equal(t, docgraph.EdgeID(test.fromDoc.Hash, test.toDoc.Hash, test.edgeName), edgesBetween[0].ID)
 		})
 	}
 }
@@ -310,6 +327,48 @@ func TestRemoveEdges(t *testing.T) {
 	// // *****************************  END
 }
 
+func TestEdgesByTime(t *testing.T) {
+
+	teardownTestCase := setupTestCase(t)
+	defer teardownTestCase(t)
+
+	env = SetupEnvironment(t)
+	t.Log("\nEnvironment Setup complete\n")
+
+	var err error
+	docs := make([]docgraph.Document, 5)
+	for i := 0; i < 5; i++ {
+		docs[i], err = CreateRandomDocument(env.ctx, &env.api, env.Docs, env.Creators[1])
+		assert.NilError(t, err)
+	}
+
+	// separate blocks give each edge a distinct created_date
+	for i := 1; i < 5; i++ {
+		_, err = docgraph.CreateEdge(env.ctx, &env.api, env.Docs, env.Creators[1], docs[0].Hash, docs[i].Hash, "assign")
+		assert.NilError(t, err)
+		pause(t, chainResponsePause, "Build block...", "")
+	}
+
+	latest, err := docs[0].GetEdgesFromSince(env.ctx, &env.api, env.Docs, "assign", time.Unix(0, 0), true, 2)
+	assert.NilError(t, err)
+	assert.Equal(t, 2, len(latest))
+	assert.Equal(t, docs[4].Hash.String(), latest[0].ToNode.String())
+	assert.Equal(t, docs[3].Hash.String(), latest[1].ToNode.String())
+
+	oldest, err := docs[0].GetEdgesFromSince(env.ctx, &env.api, env.Docs, "assign", time.Unix(0, 0), false, 10)
+	assert.NilError(t, err)
+	assert.Equal(t, 4, len(oldest))
+	assert.Equal(t, docs[1].Hash.String(), oldest[0].ToNode.String())
+
+	since, err := docgraph.GetEdgesByNameSince(env.ctx, &env.api, env.Docs, "assign", oldest[2].CreatedDate.Time, false, 10)
+	assert.NilError(t, err)
+	assert.Equal(t, 2, len(since))
+
+	incoming, err := docs[2].GetEdgesToSince(env.ctx, &env.api, env.Docs, "assign", time.Unix(0, 0), true, 10)
+	assert.NilError(t, err)
+	assert.Equal(t, 1, len(incoming))
+}
+
 func TestGetOrNewNew(t *testing.T) {
 
 	teardownTestCase := setupTestCase(t)
@@ -380,3 +439,787 @@ func TestEraseDocument(t *testing.T) {
 	_, err = docgraph.LoadDocument(env.ctx, &env.api, env.Docs, randomDoc.Hash.String())
 	assert.ErrorContains(t, err, "document not found")
 }
+
+func TestUpdateDocument(t *testing.T) {
+
+	teardownTestCase := setupTestCase(t)
+	defer teardownTestCase(t)
+
+	env = SetupEnvironment(t)
+	t.Log("\nEnvironment Setup complete\n")
+
+	fromDoc, err := CreateRandomDocument(env.ctx, &env.api, env.Docs, env.Creators[1])
+	assert.NilError(t, err)
+
+	toDoc, err := CreateRandomDocument(env.ctx, &env.api, env.Docs, env.Creators[1])
+	assert.NilError(t, err)
+
+	_, err = docgraph.CreateEdge(env.ctx, &env.api, env.Docs, env.Creators[1], fromDoc.Hash, toDoc.Hash, "test")
+	assert.NilError(t, err)
+
+	toContent := randomContentGroups()
+	_, err = docgraph.UpdateDocument(env.ctx, &env.api, env.Docs, env.Creators[1], toDoc.Hash, toContent)
+	assert.NilError(t, err)
+
+	// whether the edge was moved to the new hash or kept on the identity, there is still one edge
+	edges, err := GetAllEdges(env.ctx, &env.api, env.Docs)
+	assert.NilError(t, err)
+	assert.Equal(t, 1, len(edges))
+	assert.Equal(t, fromDoc.Hash.String(), edges[0].FromNode.String())
+
+	fromContent := randomContentGroups()
+	_, err = docgraph.UpdateDocument(env.ctx, &env.api, env.Docs, env.Creators[1], fromDoc.Hash, fromContent)
+	assert.NilError(t, err)
+	pause(t, chainResponsePause, "", "")
+
+	fromHead, err := docgraph.HashContents(fromContent)
+	assert.NilError(t, err)
+	toHead, err := docgraph.HashContents(toContent)
+	assert.NilError(t, err)
+
+	// the contract finds and removes the edge by the current hashes of both documents
+	page, err := docgraph.QueryEdges(env.ctx, &env.api, env.Docs, env.Docs, env.Docs, toHead, "test", true, nil, 10)
+	if err != nil {
+		t.Log("contract was built without DOCUMENT_GRAPH_QUERY_ACTIONS, not querying edges: ", err)
+	} else {
+		assert.Equal(t, 1, len(page.Edges))
+		page, err = docgraph.QueryEdges(env.ctx, &env.api, env.Docs, env.Docs, env.Docs, fromHead, "test", false, nil, 10)
+		assert.NilError(t, err)
+		assert.Equal(t, 1, len(page.Edges))
+	}
+
+	_, err = docgraph.RemoveEdge(env.ctx, &env.api, env.Docs, fromHead, toHead, "test")
+	assert.NilError(t, err)
+
+	edges, err = GetAllEdges(env.ctx, &env.api, env.Docs)
+	assert.NilError(t, err)
+	assert.Equal(t, 0, len(edges))
+}
+
+// TestUpdateDocumentToEarlierContent updates a document and then back to its first content. Without
+// stable identities the first version was erased, so its content can be written again; with them
+// every version is kept and the update is refused.
+func TestUpdateDocumentToEarlierContent(t *testing.T) {
+
+	teardownTestCase := setupTestCase(t)
+	defer teardownTestCase(t)
+
+	env = SetupEnvironment(t)
+	t.Log("\nEnvironment Setup complete\n")
+
+	doc, err := CreateRandomDocument(env.ctx, &env.api, env.Docs, env.Creators[1])
+	assert.NilError(t, err)
+
+	secondContent := randomContentGroups()
+	_, err = docgraph.UpdateDocument(env.ctx, &env.api, env.Docs, env.Creators[1], doc.Hash, secondContent)
+	assert.NilError(t, err)
+	pause(t, chainResponsePause, "", "")
+
+	secondHash, err := docgraph.HashContents(secondContent)
+	assert.NilError(t, err)
+
+	var request eos.GetTableRowsRequest
+	request.Code = string(env.Docs)
+	request.Scope = string(env.Docs)
+	request.Table = "docheads"
+	request.Limit = 1
+	request.JSON = true
+	response, err := env.api.GetTableRows(env.ctx, request)
+	assert.NilError(t, err)
+	var heads []map[string]interface{}
+	assert.NilError(t, response.JSONToStructs(&heads))
+
+	_, err = docgraph.UpdateDocument(env.ctx, &env.api, env.Docs, env.Creators[1], secondHash, doc.ContentGroups)
+	if len(heads) == 0 {
+		assert.NilError(t, err)
+		lastDoc, err := docgraph.GetLastDocument(env.ctx, &env.api, env.Docs)
+		assert.NilError(t, err)
+		assert.Equal(t, doc.Hash.String(), lastDoc.Hash.String())
+		return
+	}
+
+	assert.ErrorContains(t, err, "is already a version of "+doc.Hash.String())
+
+	// the head did not move
+	_, err = docgraph.UpdateDocument(env.ctx, &env.api, env.Docs, env.Creators[1], secondHash, randomContentGroups())
+	assert.NilError(t, err)
+}
+
+// TestJournal needs a contract built with -DDOCUMENT_GRAPH_JOURNAL=ON and is skipped otherwise
+func TestJournal(t *testing.T) {
+
+	teardownTestCase := setupTestCase(t)
+	defer teardownTestCase(t)
+
+	env = SetupEnvironment(t)
+	t.Log("\nEnvironment Setup complete\n")
+
+	fromDoc, err := CreateRandomDocument(env.ctx, &env.api, env.Docs, env.Creators[1])
+	assert.NilError(t, err)
+
+	entries, cursor, err := docgraph.GetJournal(env.ctx, &env.api, env.Docs, 0, 2)
+	assert.NilError(t, err)
+	if len(entries) == 0 {
+		t.Skip("contract was built without DOCUMENT_GRAPH_JOURNAL")
+	}
+	assert.Equal(t, docgraph.JournalCreateDocument, entries[len(entries)-1].Operation)
+	assert.Equal(t, fromDoc.Hash.String(), entries[len(entries)-1].Node.String())
+
+	toDoc, err := CreateRandomDocument(env.ctx, &env.api, env.Docs, env.Creators[1])
+	assert.NilError(t, err)
+
+	_, err = docgraph.CreateEdge(env.ctx, &env.api, env.Docs, env.Creators[1], fromDoc.Hash, toDoc.Hash, "test")
+	assert.NilError(t, err)
+
+	_, err = docgraph.EraseDocument(env.ctx, &env.api, env.Docs, toDoc.Hash)
+	assert.NilError(t, err)
+
+	// only the changes after the cursor are read: create, edge, then the erase of the edge and document
+	entries, cursor, err = docgraph.GetJournal(env.ctx, &env.api, env.Docs, cursor, 2)
+	assert.NilError(t, err)
+	assert.Equal(t, 4, len(entries))
+	assert.Equal(t, docgraph.JournalCreateDocument, entries[0].Operation)
+	assert.Equal(t, docgraph.JournalCreateEdge, entries[1].Operation)
+	assert.Equal(t, docgraph.JournalEraseDocument, entries[2].Operation)
+	assert.Equal(t, docgraph.JournalEraseEdge, entries[3].Operation)
+	assert.Equal(t, toDoc.Hash.String(), entries[3].ToNode.String())
+
+	// everything but the newest entry can be pruned; a reader behind the pruned range gets an error
+	_, err = docgraph.PruneJournal(env.ctx, &env.api, env.Docs, cursor, 1000)
+	assert.NilError(t, err)
+
+	_, _, err = docgraph.GetJournal(env.ctx, &env.api, env.Docs, 1, 100)
+	assert.ErrorContains(t, err, "were pruned")
+
+	// a new reader starting at 0 is told where the retained entries begin
+	_, _, err = docgraph.GetJournal(env.ctx, &env.api, env.Docs, 0, 100)
+	var pruned *docgraph.JournalPrunedError
+	assert.Assert(t, errors.As(err, &pruned))
+	assert.Equal(t, cursor-1, pruned.Oldest)
+
+	entries, _, err = docgraph.GetJournal(env.ctx, &env.api, env.Docs, cursor-1, 100)
+	assert.NilError(t, err)
+	assert.Equal(t, 1, len(entries))
+}
+
+// TestExport pages the documents table with several workers and small pages. Set
+// DOCGRAPH_EXPORT_DOCUMENTS to load more documents first, e.g. 100000 for a throughput figure.
+func TestExport(t *testing.T) {
+
+	teardownTestCase := setupTestCase(t)
+	defer teardownTestCase(t)
+
+	env = SetupEnvironment(t)
+	t.Log("\nEnvironment Setup complete\n")
+
+	count := 250
+	if value := os.Getenv("DOCGRAPH_EXPORT_DOCUMENTS"); value != "" {
+		var err error
+		count, err = strconv.Atoi(value)
+		assert.NilError(t, err)
+	}
+
+	// several creates per transaction keep loading large tables reasonably fast
+	const perTrx = 25
+	for created := 0; created < count; created += perTrx {
+		var actions []*eos.Action
+		for i := created; i < count && i < created+perTrx; i++ {
+			actions = append(actions, &eos.Action{
+				Account: env.Docs,
+				Name:    eos.ActN("create"),
+				Authorization: []eos.PermissionLevel{
+					{Actor: env.Creators[1], Permission: eos.PN("active")},
+				},
+				ActionData: eos.NewActionData(createDoc{
+					Creator:       env.Creators[1],
+					ContentGroups: randomContentGroups(),
+				}),
+			})
+		}
+		_, err := eostest.ExecTrx(env.ctx, &env.api, actions)
+		assert.NilError(t, err)
+	}
+
+	var ndjson bytes.Buffer
+	stats, err := docgraph.ExportTable(env.ctx, &env.api, env.Docs, "documents", &ndjson,
+		docgraph.ExportOptions{Format: docgraph.ExportNDJSON, Workers: 4, PageSize: 50})
+	assert.NilError(t, err)
+	t.Logf("NDJSON: %v rows in %v requests, %.0f rows/s", stats.Rows, stats.Requests, stats.RowsPerSecond())
+
+	ids := make(map[uint64]bool)
+	scanner := bufio.NewScanner(&ndjson)
+	scanner.Buffer(make([]byte, 1<<20), 1<<24)
+	for scanner.Scan() {
+		var document docgraph.Document
+		assert.NilError(t, json.Unmarshal(scanner.Bytes(), &document))
+		ids[document.ID] = true
+	}
+	assert.Assert(t, len(ids) >= count)
+	assert.Equal(t, int(stats.Rows), len(ids))
+
+	var packed bytes.Buffer
+	stats, err = docgraph.ExportTable(env.ctx, &env.api, env.Docs, "documents", &packed,
+		docgraph.ExportOptions{Format: docgraph.ExportBinary, Workers: 8})
+	assert.NilError(t, err)
+	t.Logf("binary: %v rows, %v bytes, %.0f rows/s", stats.Rows, stats.Bytes, stats.RowsPerSecond())
+	assert.Equal(t, len(ids), int(stats.Rows))
+}
+
+// TestDocumentLookupCPU reports the billed CPU of document writes, point lookups and erases.
+// Run it against a contract built with and without -DDOCUMENT_GRAPH_KEYED_DOCUMENTS=ON to
+// compare the idhash and hash-keyed table layouts.
+func TestDocumentLookupCPU(t *testing.T) {
+
+	teardownTestCase := setupTestCase(t)
+	defer teardownTestCase(t)
+
+	env = SetupEnvironment(t)
+	t.Log("\nEnvironment Setup complete\n")
+
+	const count = 50
+	var createCPU, lookupCPU, eraseCPU uint32
+	contentGroups := make([][]docgraph.ContentGroup, count)
+
+	for i := 0; i < count; i++ {
+		contentGroups[i] = randomContentGroups()
+		cpu, err := docgraph.ExecTrxCPU(env.ctx, &env.api, []*eos.Action{{
+			Account: env.Docs,
+			Name:    eos.ActN("create"),
+			Authorization: []eos.PermissionLevel{
+				{Actor: env.Creators[0], Permission: eos.PN("active")},
+			},
+			ActionData: eos.NewActionData(createDoc{
+				Creator:       env.Creators[0],
+				ContentGroups: contentGroups[i],
+			}),
+		}})
+		assert.NilError(t, err)
+		createCPU += cpu
+	}
+
+	for i := 0; i < count; i++ {
+		cpu, err := docgraph.ExecTrxCPU(env.ctx, &env.api, []*eos.Action{{
+			Account: env.Docs,
+			Name:    eos.ActN("getornewget"),
+			Authorization: []eos.PermissionLevel{
+				{Actor: env.Creators[0], Permission: eos.PN("active")},
+			},
+			ActionData: eos.NewActionData(createDoc{
+				Creator:       env.Creators[0],
+				ContentGroups: contentGroups[i],
+			}),
+		}})
+		assert.NilError(t, err)
+		lookupCPU += cpu
+	}
+
+	// depending on the layout under test, the documents are in one of these tables
+	var hashes []eos.Checksum256
+	for _, table := range []string{"documents", "docsbyhash"} {
+		var request eos.GetTableRowsRequest
+		request.Code = string(env.Docs)
+		request.Scope = string(env.Docs)
+		request.Table = table
+		request.Limit = count
+		request.JSON = true
+		response, err := env.api.GetTableRows(env.ctx, request)
+		if err != nil {
+			// the ABI of a legacy build may not declare the keyed table
+			continue
+		}
+
+		var documents []docgraph.Document
+		err = response.JSONToStructs(&documents)
+		assert.NilError(t, err)
+		for _, document := range documents {
+			hashes = append(hashes, document.Hash)
+		}
+	}
+	assert.Equal(t, count, len(hashes))
+
+	for _, hash := range hashes {
+		cpu, err := docgraph.ExecTrxCPU(env.ctx, &env.api, []*eos.Action{{
+			Account: env.Docs,
+			Name:    eos.ActN("erase"),
+			Authorization: []eos.PermissionLevel{
+				{Actor: env.Docs, Permission: eos.PN("active")},
+			},
+			ActionData: eos.NewActionData(struct {
+				Hash eos.Checksum256 `json:"hash"`
+			}{Hash: hash}),
+		}})
+		assert.NilError(t, err)
+		eraseCPU += cpu
+	}
+
+	t.Logf("average cpu_usage_us over %v documents: create %v, lookup %v, erase %v",
+		count, createCPU/count, lookupCPU/count, eraseCPU/count)
+}
+
+// BenchmarkCreateDocument reports how many documents per second a single client creates
+// against local nodeos, each create being one locally encoded push
+func BenchmarkCreateDocument(b *testing.B) {
+
+	teardownTestCase := setupTestCase(b)
+	defer teardownTestCase(b)
+
+	env = SetupEnvironment(b)
+
+	contentGroups := make([][]docgraph.ContentGroup, b.N)
+	for i := range contentGroups {
+		contentGroups[i] = randomContentGroups()
+	}
+
+	b.ResetTimer()
+	start := time.Now()
+	for i := 0; i < b.N; i++ {
+		_, err := docgraph.CreateDocumentWithContent(env.ctx, &env.api, env.Docs, env.Creators[0], contentGroups[i])
+		assert.NilError(b, err)
+	}
+	b.ReportMetric(float64(b.N)/time.Since(start).Seconds(), "creates/s")
+}
+
+// TestBatchWriter loads documents and the edges between them in packed, pipelined transactions
+func TestBatchWriter(t *testing.T) {
+
+	teardownTestCase := setupTestCase(t)
+	defer teardownTestCase(t)
+
+	env = SetupEnvironment(t)
+	t.Log("\nEnvironment Setup complete\n")
+
+	const count = 500
+	writer := docgraph.NewBatchWriter(env.ctx, &env.api, docgraph.BatchOptions{})
+
+	hashes := make([]eos.Checksum256, count)
+	for i := range hashes {
+		contentGroups := randomContentGroups()
+		hash, err := docgraph.HashContents(contentGroups)
+		assert.NilError(t, err)
+		hashes[i] = hash
+		assert.NilError(t, writer.Add(docgraph.CreateDocumentAction(env.Docs, env.Creators[0], contentGroups)))
+	}
+
+	// the edges need both of their documents
+	assert.NilError(t, writer.Flush())
+
+	for i := 1; i < count; i++ {
+		assert.NilError(t, writer.Add(docgraph.CreateEdgeAction(env.Docs, env.Creators[0], hashes[i-1], hashes[i], "next")))
+	}
+	assert.NilError(t, writer.Flush())
+
+	for i := 1; i < count; i += 2 {
+		assert.NilError(t, writer.Add(docgraph.RemoveEdgeAction(env.Docs, hashes[i-1], hashes[i], "next")))
+	}
+
+	stats, err := writer.Close()
+	assert.NilError(t, err)
+	t.Logf("%v actions in %v transactions, %v retries, %v splits, %.0f actions/s",
+		stats.Actions, stats.Transactions, stats.Retries, stats.Splits, stats.ActionsPerSecond())
+	assert.Equal(t, uint64(count+count-1+count/2), stats.Actions)
+	assert.Assert(t, stats.Transactions < stats.Actions)
+
+	first := docgraph.Document{Hash: hashes[0]}
+	edges, err := first.GetEdgesFrom(env.ctx, &env.api, env.Docs)
+	assert.NilError(t, err)
+	assert.Equal(t, 0, len(edges))
+
+	second := docgraph.Document{Hash: hashes[1]}
+	edges, err = second.GetEdgesFrom(env.ctx, &env.api, env.Docs)
+	assert.NilError(t, err)
+	assert.Equal(t, 1, len(edges))
+	assert.Equal(t, hashes[2].String(), edges[0].ToNode.String())
+}
+
+// TestScopes keeps two tenants' graphs in their own scopes, links them with a cross-scope edge and
+// erases one tenant without touching the other
+func TestScopes(t *testing.T) {
+
+	teardownTestCase := setupTestCase(t)
+	defer teardownTestCase(t)
+
+	env = SetupEnvironment(t)
+	t.Log("\nEnvironment Setup complete\n")
+
+	tenantA := eos.AN("tenanta")
+	tenantB := eos.AN("tenantb")
+
+	a, err := docgraph.CreateDocumentIn(env.ctx, &env.api, env.Docs, tenantA, env.Creators[0], randomContentGroups())
+	assert.NilError(t, err)
+	b1, err := docgraph.CreateDocumentIn(env.ctx, &env.api, env.Docs, tenantB, env.Creators[0], randomContentGroups())
+	assert.NilError(t, err)
+	b2, err := docgraph.CreateDocumentIn(env.ctx, &env.api, env.Docs, tenantB, env.Creators[0], randomContentGroups())
+	assert.NilError(t, err)
+
+	_, err = eostest.ExecTrx(env.ctx, &env.api, []*eos.Action{
+		docgraph.CreateEdgeInAction(env.Docs, tenantA, env.Creators[0], a.Hash, b1.Hash, "crossscope"),
+		docgraph.CreateEdgeInAction(env.Docs, tenantB, env.Creators[0], b1.Hash, b2.Hash, "next"),
+	})
+	assert.NilError(t, err)
+
+	// a tenant's documents are only found in its scope
+	loaded, err := docgraph.LoadDocumentIn(env.ctx, &env.api, env.Docs, tenantA, a.Hash.String())
+	assert.NilError(t, err)
+	assert.Equal(t, a.Hash.String(), loaded.Hash.String())
+	_, err = docgraph.LoadDocument(env.ctx, &env.api, env.Docs, a.Hash.String())
+	assert.ErrorType(t, err, &docgraph.DocumentNotFoundError{})
+	_, err = docgraph.LoadDocumentIn(env.ctx, &env.api, env.Docs, tenantB, a.Hash.String())
+	assert.ErrorType(t, err, &docgraph.DocumentNotFoundError{})
+
+	var edges bytes.Buffer
+	stats, err := docgraph.ExportTable(env.ctx, &env.api, env.Docs, "edges", &edges,
+		docgraph.ExportOptions{Format: docgraph.ExportNDJSON, Scope: tenantA})
+	assert.NilError(t, err)
+	assert.Equal(t, uint64(1), stats.Rows)
+
+	// a few rows per action, so that erasing takes several pushes
+	for pushes := 0; ; pushes++ {
+		empty, err := docgraph.ScopeIsEmpty(env.ctx, &env.api, env.Docs, tenantA)
+		assert.NilError(t, err)
+		if empty {
+			break
+		}
+		assert.Assert(t, pushes < 10)
+		_, err = docgraph.EraseScope(env.ctx, &env.api, env.Docs, tenantA, 1)
+		assert.NilError(t, err)
+		pause(t, chainResponsePause, "", "")
+	}
+
+	empty, err := docgraph.ScopeIsEmpty(env.ctx, &env.api, env.Docs, tenantB)
+	assert.NilError(t, err)
+	assert.Assert(t, !empty)
+	_, err = docgraph.LoadDocumentIn(env.ctx, &env.api, env.Docs, tenantB, b1.Hash.String())
+	assert.NilError(t, err)
+
+	edges.Reset()
+	stats, err = docgraph.ExportTable(env.ctx, &env.api, env.Docs, "edges", &edges,
+		docgraph.ExportOptions{Format: docgraph.ExportNDJSON, Scope: tenantB})
+	assert.NilError(t, err)
+	assert.Equal(t, uint64(1), stats.Rows)
+}
+
+// BenchmarkScopedLookup grows the documents kept in other scopes and reports, for a tenant of a fixed
+// size, the latency of a document read, the time to export the tenant's documents and the billed CPU
+// of a create in the tenant's scope. Set DOCGRAPH_SCOPE_DOCUMENTS for a larger final graph.
+func BenchmarkScopedLookup(b *testing.B) {
+
+	teardownTestCase := setupTestCase(b)
+	defer teardownTestCase(b)
+
+	env = SetupEnvironment(b)
+
+	total := 8000
+	if value := os.Getenv("DOCGRAPH_SCOPE_DOCUMENTS"); value != "" {
+		var err error
+		total, err = strconv.Atoi(value)
+		assert.NilError(b, err)
+	}
+
+	tenant := eos.AN("tenant")
+	const tenantSize = 100
+	writer := docgraph.NewBatchWriter(env.ctx, &env.api, docgraph.BatchOptions{})
+	var hashes []eos.Checksum256
+	for i := 0; i < tenantSize; i++ {
+		contentGroups := randomContentGroups()
+		hash, err := docgraph.HashContents(contentGroups)
+		assert.NilError(b, err)
+		hashes = append(hashes, hash)
+		assert.NilError(b, writer.Add(docgraph.CreateDocumentInAction(env.Docs, tenant, env.Creators[0], contentGroups)))
+	}
+	assert.NilError(b, writer.Flush())
+
+	others := []eos.AccountName{"other1", "other2", "other3", "other4"}
+	stored := 0
+	for _, size := range []int{0, total / 8, total / 2, total} {
+		for ; stored < size; stored++ {
+			action := docgraph.CreateDocumentInAction(env.Docs, others[stored%len(others)], env.Creators[1], randomContentGroups())
+			assert.NilError(b, writer.Add(action))
+		}
+		assert.NilError(b, writer.Flush())
+
+		b.Run("others="+strconv.Itoa(size), func(b *testing.B) {
+			var readTime, exportTime time.Duration
+			var createCPU uint32
+			for i := 0; i < b.N; i++ {
+				start := time.Now()
+				_, err := docgraph.LoadDocumentIn(env.ctx, &env.api, env.Docs, tenant, hashes[i%len(hashes)].String())
+				assert.NilError(b, err)
+				readTime += time.Since(start)
+
+				start = time.Now()
+				stats, err := docgraph.ExportTable(env.ctx, &env.api, env.Docs, "documents", ioutil.Discard,
+					docgraph.ExportOptions{Format: docgraph.ExportBinary, Scope: tenant})
+				assert.NilError(b, err)
+				assert.Assert(b, stats.Rows >= tenantSize)
+				exportTime += time.Since(start)
+
+				cpu, err := docgraph.ExecTrxCPU(env.ctx, &env.api, []*eos.Action{
+					docgraph.CreateDocumentInAction(env.Docs, tenant, env.Creators[0], randomContentGroups()),
+				})
+				assert.NilError(b, err)
+				createCPU += cpu
+			}
+			b.ReportMetric(float64(readTime.Microseconds())/float64(b.N), "read-us/op")
+			b.ReportMetric(float64(exportTime.Microseconds())/float64(b.N), "export-us/op")
+			b.ReportMetric(float64(createCPU)/float64(b.N), "create-cpu-us/op")
+		})
+	}
+	_, err := writer.Close()
+	assert.NilError(b, err)
+}
+
+// TestGarbageCollection needs a contract built with -DDOCUMENT_GRAPH_GC=ON and is skipped otherwise
+func TestGarbageCollection(t *testing.T) {
+
+	teardownTestCase := setupTestCase(t)
+	defer teardownTestCase(t)
+
+	env = SetupEnvironment(t)
+	t.Log("\nEnvironment Setup complete\n")
+
+	scope := eos.AN("gctest")
+	documents := make([]docgraph.Document, 5)
+	for i := range documents {
+		var err error
+		documents[i], err = docgraph.CreateDocumentIn(env.ctx, &env.api, env.Docs, scope, env.Creators[0], randomContentGroups())
+		assert.NilError(t, err)
+	}
+
+	// 0 -> 1 -> 2 along 'owns' is live; 3 is only linked by an edge that is not followed, 4 not at all
+	_, err := eostest.ExecTrx(env.ctx, &env.api, []*eos.Action{
+		docgraph.CreateEdgeInAction(env.Docs, scope, env.Creators[0], documents[0].Hash, documents[1].Hash, "owns"),
+		docgraph.CreateEdgeInAction(env.Docs, scope, env.Creators[0], documents[1].Hash, documents[2].Hash, "owns"),
+		docgraph.CreateEdgeInAction(env.Docs, scope, env.Creators[0], documents[0].Hash, documents[3].Hash, "mentions"),
+	})
+	assert.NilError(t, err)
+	pause(t, chainResponsePause, "", "")
+
+	roots := []eos.Checksum256{documents[0].Hash}
+	_, err = docgraph.StartGC(env.ctx, &env.api, env.Docs, scope, roots, []eos.Name{"owns"}, true)
+	if err != nil {
+		t.Skip("contract was built without DOCUMENT_GRAPH_GC: ", err)
+	}
+
+	state, err := docgraph.RunGC(env.ctx, &env.api, env.Docs, scope, 2)
+	assert.NilError(t, err)
+	assert.Equal(t, eos.Uint64(3), state.Marked)
+	assert.Equal(t, eos.Uint64(2), state.Documents)
+	assert.Equal(t, eos.Uint64(1), state.Edges)
+
+	// the dry run erased nothing
+	_, err = docgraph.LoadDocumentIn(env.ctx, &env.api, env.Docs, scope, documents[4].Hash.String())
+	assert.NilError(t, err)
+
+	_, err = docgraph.StartGC(env.ctx, &env.api, env.Docs, scope, roots, []eos.Name{"owns"}, false)
+	assert.NilError(t, err)
+	state, err = docgraph.RunGC(env.ctx, &env.api, env.Docs, scope, 3)
+	assert.NilError(t, err)
+	assert.Equal(t, eos.Uint64(2), state.Documents)
+
+	for i, document := range documents {
+		_, err = docgraph.LoadDocumentIn(env.ctx, &env.api, env.Docs, scope, document.Hash.String())
+		if i < 3 {
+			assert.NilError(t, err)
+		} else {
+			assert.ErrorType(t, err, &docgraph.DocumentNotFoundError{})
+		}
+	}
+}
+
+// TestGarbageCollectionUpdatedRoot needs a contract built with -DDOCUMENT_GRAPH_GC=ON and is skipped
+// otherwise; the root is given by the hash of its current version, and it has more edges than a step visits
+func TestGarbageCollectionUpdatedRoot(t *testing.T) {
+
+	teardownTestCase := setupTestCase(t)
+	defer teardownTestCase(t)
+
+	env = SetupEnvironment(t)
+	t.Log("\nEnvironment Setup complete\n")
+
+	documents := make([]docgraph.Document, 7)
+	for i := range documents {
+		var err error
+		documents[i], err = CreateRandomDocument(env.ctx, &env.api, env.Docs, env.Creators[0])
+		assert.NilError(t, err)
+	}
+
+	// 0 owns 1 to 5; 6 is unreachable and its edge to 1 goes with it
+	var actions []*eos.Action
+	for _, document := range documents[1:6] {
+		actions = append(actions, docgraph.CreateEdgeAction(env.Docs, env.Creators[0], documents[0].Hash, document.Hash, "owns"))
+	}
+	actions = append(actions, docgraph.CreateEdgeAction(env.Docs, env.Creators[0], documents[6].Hash, documents[1].Hash, "owns"))
+	_, err := eostest.ExecTrx(env.ctx, &env.api, actions)
+	assert.NilError(t, err)
+
+	content := randomContentGroups()
+	_, err = docgraph.UpdateDocument(env.ctx, &env.api, env.Docs, env.Creators[0], documents[0].Hash, content)
+	assert.NilError(t, err)
+	head, err := docgraph.HashContents(content)
+	assert.NilError(t, err)
+	pause(t, chainResponsePause, "", "")
+
+	_, err = docgraph.StartGC(env.ctx, &env.api, env.Docs, env.Docs, []eos.Checksum256{head}, []eos.Name{"owns"}, false)
+	if err != nil {
+		t.Skip("contract was built without DOCUMENT_GRAPH_GC: ", err)
+	}
+
+	state, err := docgraph.RunGC(env.ctx, &env.api, env.Docs, env.Docs, 2)
+	assert.NilError(t, err)
+	assert.Equal(t, eos.Uint64(6), state.Marked)
+	assert.Equal(t, eos.Uint64(1), state.Documents)
+	assert.Equal(t, eos.Uint64(1), state.Edges)
+
+	_, err = docgraph.LoadDocument(env.ctx, &env.api, env.Docs, head.String())
+	assert.NilError(t, err)
+	for _, document := range documents[1:6] {
+		_, err = docgraph.LoadDocument(env.ctx, &env.api, env.Docs, document.Hash.String())
+		assert.NilError(t, err)
+	}
+	_, err = docgraph.LoadDocument(env.ctx, &env.api, env.Docs, documents[6].Hash.String())
+	assert.ErrorType(t, err, &docgraph.DocumentNotFoundError{})
+}
+
+func TestQueryActions(t *testing.T) {
+
+	teardownTestCase := setupTestCase(t)
+	defer teardownTestCase(t)
+
+	env = SetupEnvironment(t)
+	t.Log("\nEnvironment Setup complete\n")
+
+	scope := eos.AN("querytest")
+	documents := make([]docgraph.Document, 6)
+	for i := range documents {
+		var err error
+		documents[i], err = docgraph.CreateDocumentIn(env.ctx, &env.api, env.Docs, scope, env.Creators[0], randomContentGroups())
+		assert.NilError(t, err)
+	}
+
+	root := documents[0]
+	_, err := docgraph.QueryDocument(env.ctx, &env.api, env.Docs, scope, env.Docs, root.Hash)
+	if err != nil {
+		t.Skip("contract was built without DOCUMENT_GRAPH_QUERY_ACTIONS: ", err)
+	}
+
+	var actions []*eos.Action
+	for _, document := range documents[1:] {
+		actions = append(actions, docgraph.CreateEdgeInAction(env.Docs, scope, env.Creators[0], root.Hash, document.Hash, "owns"))
+	}
+	_, err = eostest.ExecTrx(env.ctx, &env.api, actions)
+	assert.NilError(t, err)
+	pause(t, chainResponsePause, "", "")
+
+	document, err := docgraph.QueryDocument(env.ctx, &env.api, env.Docs, scope, env.Docs, documents[2].Hash)
+	assert.NilError(t, err)
+	assert.Assert(t, document.IsEqual(documents[2]))
+
+	missing := randomContentGroups()
+	missingHash, err := docgraph.HashContents(missing)
+	assert.NilError(t, err)
+	hashes := []eos.Checksum256{documents[3].Hash, missingHash, documents[1].Hash}
+	found, err := docgraph.QueryDocuments(env.ctx, &env.api, env.Docs, scope, env.Docs, hashes)
+	assert.NilError(t, err)
+	assert.Equal(t, 2, len(found))
+	assert.Equal(t, documents[3].Hash.String(), found[0].Hash.String())
+	assert.Equal(t, documents[1].Hash.String(), found[1].Hash.String())
+
+	// pages of two edges until Next is nil
+	seen := map[string]bool{}
+	var after *docgraph.EdgeCursor
+	for pages := 0; ; pages++ {
+		assert.Assert(t, pages < 3)
+		page, err := docgraph.QueryEdges(env.ctx, &env.api, env.Docs, scope, env.Docs, root.Hash, "owns", false, after, 2)
+		assert.NilError(t, err)
+		for _, edge := range page.Edges {
+			seen[edge.ToNode.String()] = true
+		}
+		if page.Next == nil {
+			break
+		}
+		after = page.Next
+	}
+	assert.Equal(t, len(documents)-1, len(seen))
+
+	incoming, err := docgraph.QueryEdges(env.ctx, &env.api, env.Docs, scope, env.Docs, documents[4].Hash, "owns", true, nil, 10)
+	assert.NilError(t, err)
+	assert.Equal(t, 1, len(incoming.Edges))
+	assert.Equal(t, root.Hash.String(), incoming.Edges[0].FromNode.String())
+
+	neighborhood, err := docgraph.QueryNeighbors(env.ctx, &env.api, env.Docs, scope, env.Docs, root.Hash, "owns", nil, 10)
+	assert.NilError(t, err)
+	assert.Assert(t, neighborhood.Document.IsEqual(root))
+	assert.Equal(t, len(documents)-1, len(neighborhood.Neighbors))
+	assert.Assert(t, neighborhood.Next == nil)
+	for i, edge := range neighborhood.Edges {
+		assert.Equal(t, edge.ToNode.String(), neighborhood.Neighbors[i].Hash.String())
+	}
+}
+
+func schemaContent(label, typeID string, value interface{}) docgraph.ContentItem {
+	return docgraph.ContentItem{
+		Label: label,
+		Value: &docgraph.FlexValue{
+			BaseVariant: eos.BaseVariant{
+				TypeID: docgraph.FlexValueVariant.TypeID(typeID),
+				Impl:   value,
+			},
+		},
+	}
+}
+
+func testSchemaAction(contentGroups []docgraph.ContentGroup) *eos.Action {
+	return &eos.Action{
+		Account: env.Docs,
+		Name:    eos.ActN("testschema"),
+		Authorization: []eos.PermissionLevel{
+			{Actor: env.Creators[0], Permission: eos.PN("active")},
+		},
+		ActionData: eos.NewActionData(struct {
+			ContentGroups []docgraph.ContentGroup `json:"content_groups"`
+		}{contentGroups}),
+	}
+}
+
+func TestSchema(t *testing.T) {
+
+	teardownTestCase := setupTestCase(t)
+	defer teardownTestCase(t)
+
+	env = SetupEnvironment(t)
+	t.Log("\nEnvironment Setup complete\n")
+
+	reference := sha256.Sum256([]byte("schema reference"))
+	details := docgraph.ContentGroup{
+		schemaContent("content_group_label", "string", "details"),
+		schemaContent("salary_amount", "asset", &eos.Asset{Amount: 13000, Symbol: eos.Symbol{Precision: 2, Symbol: "USD"}}),
+		schemaContent("recipient", "name", eos.Name("recipient")),
+		schemaContent("vote_count", "int64", int64(42)),
+		schemaContent("title", "string", "schema test"),
+	}
+	links := docgraph.ContentGroup{
+		schemaContent("content_group_label", "string", "links"),
+		schemaContent("reference", "checksum256", eos.Checksum256(reference[:])),
+	}
+
+	// the optional start is absent, then present
+	_, err := eostest.ExecTrx(env.ctx, &env.api, []*eos.Action{testSchemaAction([]docgraph.ContentGroup{details, links})})
+	assert.NilError(t, err)
+
+	started := append(docgraph.ContentGroup{}, details...)
+	started = append(started, schemaContent("start", "time_point", eos.TimePoint(1600000000000000)))
+	_, err = eostest.ExecTrx(env.ctx, &env.api, []*eos.Action{testSchemaAction([]docgraph.ContentGroup{links, started})})
+	assert.NilError(t, err)
+
+	// a mistyped content and a content under the wrong group label are both reported
+	mistyped := append(docgraph.ContentGroup{}, details[:2]...)
+	mistyped = append(mistyped, schemaContent("recipient", "string", "recipient"), details[3], details[4])
+	misplaced := docgraph.ContentGroup{
+		schemaContent("content_group_label", "string", "details"),
+		links[1],
+	}
+	_, err = eostest.ExecTrx(env.ctx, &env.api, []*eos.Action{testSchemaAction([]docgraph.ContentGroup{mistyped, misplaced})})
+	assert.ErrorContains(t, err, "document does not match schema schematest")
+	assert.ErrorContains(t, err, "details/recipient is not of type name")
+	assert.ErrorContains(t, err, "links/reference is missing")
+}
@@ -1,8 +1,13 @@
 package docgraph
 
 import (
+	"crypto/sha256"
+	"encoding/binary"
+	"encoding/hex"
 	"fmt"
 	"log"
+	"math"
+	"strconv"
 	"strings"
 
 	eos "github.com/eoscanada/eos-go"
@@ -178,3 +183,147 @@ func (d *Document) IsEqual(d2 Document) bool {
 	// if we got through all the above checks, the documents are equal
 	return true
 }
+
+// MaxKeyProbes is the number of consecutive primary keys, starting at DocumentKey,
+// that may hold a document in the keyed 'docsbyhash' table layout
+const MaxKeyProbes = 16
+
+// DocumentKey returns the primary key a document hash derives in the keyed table layout,
+// matching Document::hashKey in the contract
+func DocumentKey(hash eos.Checksum256) uint64 {
+	key := binary.BigEndian.Uint64(hash[:8])
+	if key > math.MaxUint64-MaxKeyProbes {
+		key = math.MaxUint64 - MaxKeyProbes
+	}
+	return key
+}
+
+var (
+	monostateTypeID   = FlexValueVariant.TypeID("monostate")
+	nameTypeID        = FlexValueVariant.TypeID("name")
+	stringTypeID      = FlexValueVariant.TypeID("string")
+	assetTypeID       = FlexValueVariant.TypeID("asset")
+	timePointTypeID   = FlexValueVariant.TypeID("time_point")
+	int64TypeID       = FlexValueVariant.TypeID("int64")
+	checksum256TypeID = FlexValueVariant.TypeID("checksum256")
+)
+
+// Fingerprint returns the string the contract hashes to derive a document's hash, matching
+// Document::toString: each content is written as {label=[type,value]} and empty contents as nothing
+func Fingerprint(contentGroups []ContentGroup) (string, error) {
+	var fingerprint strings.Builder
+	fingerprint.WriteString("[")
+	for groupIndex, contentGroup := range contentGroups {
+		if groupIndex > 0 {
+			fingerprint.WriteString(",")
+		}
+		fingerprint.WriteString("[")
+		for contentIndex, content := range contentGroup {
+			if contentIndex > 0 {
+				fingerprint.WriteString(",")
+			}
+			if err := content.writeFingerprint(&fingerprint); err != nil {
+				return "", err
+			}
+		}
+		fingerprint.WriteString("]")
+	}
+	fingerprint.WriteString("]")
+	return fingerprint.String(), nil
+}
+
+// HashContents returns the hash the contract assigns to a document with these content groups,
+// matching Document::hashContents
+func HashContents(contentGroups []ContentGroup) (eos.Checksum256, error) {
+	fingerprint, err := Fingerprint(contentGroups)
+	if err != nil {
+		return nil, err
+	}
+	hash := sha256.Sum256([]byte(fingerprint))
+	return eos.Checksum256(hash[:]), nil
+}
+
+func (c *ContentItem) writeFingerprint(fingerprint *strings.Builder) error {
+	// the monostate check must come first, its Impl is an int64 as well
+	if c.Value == nil || c.Value.TypeID == monostateTypeID {
+		return nil
+	}
+
+	var typeName, value string
+	switch c.Value.TypeID {
+	case nameTypeID:
+		// accept plain strings too, as content built in code often holds them
+		switch v := c.Value.Impl.(type) {
+		case eos.Name:
+			typeName, value = "name", string(v)
+		case string:
+			typeName, value = "name", v
+		}
+	case stringTypeID:
+		if v, ok := c.Value.Impl.(string); ok {
+			typeName, value = "string", v
+		}
+	case assetTypeID:
+		switch v := c.Value.Impl.(type) {
+		case *eos.Asset:
+			typeName, value = "asset", assetString(*v)
+		case eos.Asset:
+			typeName, value = "asset", assetString(v)
+		}
+	case timePointTypeID:
+		// the contract hashes whole seconds
+		if v, ok := c.Value.Impl.(eos.TimePoint); ok {
+			typeName, value = "time_point", strconv.FormatUint(uint64(v)/1000000, 10)
+		}
+	case int64TypeID:
+		if v, ok := c.Value.Impl.(int64); ok {
+			typeName, value = "int64", strconv.FormatInt(v, 10)
+		}
+	case checksum256TypeID:
+		if v, ok := c.Value.Impl.(eos.Checksum256); ok {
+			typeName, value = "checksum256", hex.EncodeToString(v)
+		}
+	}
+	if typeName == "" {
+		return fmt.Errorf("cannot fingerprint content %v: unexpected type %T for type id %v", c.Label, c.Value.Impl, c.Value.TypeID)
+	}
+
+	fingerprint.WriteString("{")
+	fingerprint.WriteString(c.Label)
+	fingerprint.WriteString("=[")
+	fingerprint.WriteString(typeName)
+	fingerprint.WriteString(",")
+	fingerprint.WriteString(value)
+	fingerprint.WriteString("]}")
+	return nil
+}
+
+// assetString formats an asset as eosio::asset::to_string does, so that fingerprints do not
+// depend on eos-go's own formatting
+func assetString(a eos.Asset) string {
+	negative := a.Amount < 0
+	amount := uint64(a.Amount)
+	if negative {
+		amount = uint64(-a.Amount)
+	}
+
+	p10 := uint64(1)
+	for i := uint8(0); i < a.Symbol.Precision; i++ {
+		p10 *= 10
+	}
+
+	var str strings.Builder
+	if negative {
+		str.WriteString("-")
+	}
+	str.WriteString(strconv.FormatUint(amount/p10, 10))
+	if a.Symbol.Precision > 0 {
+		fraction := strconv.FormatUint(amount%p10, 10)
+		str.WriteString(".")
+		str.WriteString(strings.Repeat("0", int(a.Symbol.Precision)-len(fraction)))
+		str.WriteString(fraction)
+	}
+	str.WriteString(" ")
+	str.WriteString(a.Symbol.Symbol)
+	return str.String()
+}
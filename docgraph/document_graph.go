@@ -6,6 +6,7 @@ import (
 	"fmt"
 	"io/ioutil"
 	"log"
+	"strconv"
 
 	eostest "github.com/digital-scarcity/eos-go-test"
 	eos "github.com/eoscanada/eos-go"
@@ -16,58 +17,81 @@ type DocumentGraph struct {
 	RootNode Document
 }
 
+type createDocument struct {
+	Creator       eos.AccountName `json:"creator"`
+	ContentGroups []ContentGroup  `json:"content_groups"`
+}
+
+// newDocumentTrx encodes the action locally and computes the document's hash before pushing,
+// so a create is a single request and does not need to read the new row back; the returned
+// document is not populated with the ID and CreatedDate assigned on chain
 func newDocumentTrx(ctx context.Context, api *eos.API,
-	contract, creator eos.AccountName, actionName,
-	fileName string) (Document, error) {
+	contract, creator eos.AccountName, actionName string,
+	contentGroups []ContentGroup) (Document, error) {
 
-	data, err := ioutil.ReadFile(fileName)
+	hash, err := HashContents(contentGroups)
 	if err != nil {
-		return Document{}, fmt.Errorf("readfile %v: %v", fileName, err)
+		return Document{}, fmt.Errorf("hash contents: %v", err)
 	}
 
-	action := eos.ActN(actionName)
+	actions := []*eos.Action{documentAction(contract, creator, actionName, contentGroups)}
 
-	var dump map[string]interface{}
-	err = json.Unmarshal(data, &dump)
+	_, err = eostest.ExecTrx(ctx, api, actions)
 	if err != nil {
-		return Document{}, fmt.Errorf("unmarshal %v: %v", fileName, err)
+		return Document{}, fmt.Errorf("execute transaction %v: %v", hash.String(), err)
 	}
 
-	dump["creator"] = creator
+	return Document{
+		Hash:          hash,
+		Creator:       creator,
+		ContentGroups: contentGroups,
+	}, nil
+}
 
-	actionBinary, err := api.ABIJSONToBin(ctx, contract, eos.Name(action), dump)
+// CreateDocument creates a new document on chain from the provided file
+func CreateDocument(ctx context.Context, api *eos.API,
+	contract, creator eos.AccountName,
+	fileName string) (Document, error) {
+
+	data, err := ioutil.ReadFile(fileName)
 	if err != nil {
-		return Document{}, fmt.Errorf("api json to bin %v: %v", fileName, err)
+		return Document{}, fmt.Errorf("readfile %v: %v", fileName, err)
 	}
 
-	actions := []*eos.Action{
-		{
-			Account: contract,
-			Name:    action,
-			Authorization: []eos.PermissionLevel{
-				{Actor: creator, Permission: eos.PN("active")},
-			},
-			ActionData: eos.NewActionDataFromHexData([]byte(actionBinary)),
-		}}
-
-	_, err = eostest.ExecTrx(ctx, api, actions)
+	var document createDocument
+	err = json.Unmarshal(data, &document)
 	if err != nil {
-		return Document{}, fmt.Errorf("execute transaction %v: %v", fileName, err)
+		return Document{}, fmt.Errorf("unmarshal %v: %v", fileName, err)
 	}
 
-	lastDoc, err := GetLastDocument(ctx, api, contract)
-	if err != nil {
-		return Document{}, fmt.Errorf("get last document %v: %v", fileName, err)
+	return newDocumentTrx(ctx, api, contract, creator, "create", document.ContentGroups)
+}
+
+func documentAction(contract, creator eos.AccountName, actionName string, contentGroups []ContentGroup) *eos.Action {
+	return &eos.Action{
+		Account: contract,
+		Name:    eos.ActN(actionName),
+		Authorization: []eos.PermissionLevel{
+			{Actor: creator, Permission: eos.PN("active")},
+		},
+		ActionData: eos.NewActionData(createDocument{
+			Creator:       creator,
+			ContentGroups: contentGroups,
+		}),
 	}
-	return lastDoc, nil
 }
 
-// CreateDocument creates a new document on chain from the provided file
-func CreateDocument(ctx context.Context, api *eos.API,
+// CreateDocumentAction returns the action that creates a document, e.g. to add to a BatchWriter
+func CreateDocumentAction(contract, creator eos.AccountName, contentGroups []ContentGroup) *eos.Action {
+	return documentAction(contract, creator, "create", contentGroups)
+}
+
+// CreateDocumentWithContent creates a new document on chain with the content groups
+func CreateDocumentWithContent(ctx context.Context, api *eos.API,
 	contract, creator eos.AccountName,
-	fileName string) (Document, error) {
+	contentGroups []ContentGroup) (Document, error) {
 
-	return newDocumentTrx(ctx, api, contract, creator, "create", fileName)
+	return newDocumentTrx(ctx, api, contract, creator, "create", contentGroups)
 }
 
 // // GetOrNewNew creates a new document on chain from the provided file
@@ -88,15 +112,32 @@ func CreateDocument(ctx context.Context, api *eos.API,
 
 // }
 
+// DocumentNotFoundError is returned when no document with the hash is stored
+type DocumentNotFoundError struct {
+	Hash string
+}
+
+func (e *DocumentNotFoundError) Error() string {
+	return fmt.Sprintf("document not found %v", e.Hash)
+}
+
 // LoadDocument reads a document from the blockchain and creates a Document instance
 func LoadDocument(ctx context.Context, api *eos.API,
 	contract eos.AccountName,
 	hash string) (Document, error) {
 
+	return LoadDocumentIn(ctx, api, contract, contract, hash)
+}
+
+// LoadDocumentIn reads a document from the graph kept in scope
+func LoadDocumentIn(ctx context.Context, api *eos.API,
+	contract, scope eos.AccountName,
+	hash string) (Document, error) {
+
 	var documents []Document
 	var request eos.GetTableRowsRequest
 	request.Code = string(contract)
-	request.Scope = string(contract)
+	request.Scope = string(scope)
 	request.Table = "documents"
 	request.Index = "2"
 	request.KeyType = "sha256"
@@ -115,80 +156,122 @@ func LoadDocument(ctx context.Context, api *eos.API,
 	}
 
 	if len(documents) == 0 {
-		return Document{}, fmt.Errorf("document not found %v: %v", hash, err)
+		return Document{}, &DocumentNotFoundError{Hash: hash}
 	}
 	return documents[0], nil
 }
 
+// LoadKeyedDocument reads a document from a contract built with the keyed 'docsbyhash'
+// table layout, scanning the probe window of the hash's derived primary key
+func LoadKeyedDocument(ctx context.Context, api *eos.API,
+	contract eos.AccountName,
+	hash eos.Checksum256) (Document, error) {
+
+	return LoadKeyedDocumentIn(ctx, api, contract, contract, hash)
+}
+
+// LoadKeyedDocumentIn reads a document from the keyed table of the graph kept in scope
+func LoadKeyedDocumentIn(ctx context.Context, api *eos.API,
+	contract, scope eos.AccountName,
+	hash eos.Checksum256) (Document, error) {
+
+	key := DocumentKey(hash)
+
+	var documents []Document
+	var request eos.GetTableRowsRequest
+	request.Code = string(contract)
+	request.Scope = string(scope)
+	request.Table = "docsbyhash"
+	request.KeyType = "i64"
+	request.LowerBound = strconv.FormatUint(key, 10)
+	request.UpperBound = strconv.FormatUint(key+MaxKeyProbes-1, 10)
+	request.Limit = MaxKeyProbes
+	request.JSON = true
+	response, err := api.GetTableRows(ctx, request)
+	if err != nil {
+		return Document{}, fmt.Errorf("get table rows %v: %v", hash.String(), err)
+	}
+
+	err = response.JSONToStructs(&documents)
+	if err != nil {
+		return Document{}, fmt.Errorf("json to structs %v: %v", hash.String(), err)
+	}
+
+	for _, document := range documents {
+		if document.Hash.String() == hash.String() {
+			return document, nil
+		}
+	}
+	return Document{}, &DocumentNotFoundError{Hash: hash.String()}
+}
+
+type newEdge struct {
+	Creator  eos.AccountName `json:"creator"`
+	FromNode eos.Checksum256 `json:"from_node"`
+	ToNode   eos.Checksum256 `json:"to_node"`
+	EdgeName eos.Name        `json:"edge_name"`
+}
+
 // CreateEdge creates an edge from one document node to another with the specified name
 func CreateEdge(ctx context.Context, api *eos.API,
 	contract, creator eos.AccountName,
 	fromNode, toNode eos.Checksum256,
 	edgeName eos.Name) (string, error) {
 
-	actionData := make(map[string]interface{})
-	actionData["creator"] = creator
-	actionData["from_node"] = fromNode
-	actionData["to_node"] = toNode
-	actionData["edge_name"] = edgeName
-
-	actionBinary, err := api.ABIJSONToBin(ctx, contract, eos.Name("newedge"), actionData)
-	if err != nil {
-		log.Println("Error with ABIJSONToBin: ", err)
-		return "error", err
-	}
+	actions := []*eos.Action{CreateEdgeAction(contract, creator, fromNode, toNode, edgeName)}
+	return eostest.ExecTrx(ctx, api, actions)
+}
 
-	actions := []*eos.Action{
-		{
-			Account: contract,
-			Name:    eos.ActN("newedge"),
-			Authorization: []eos.PermissionLevel{
-				{Actor: creator, Permission: eos.PN("active")},
-			},
-			ActionData: eos.NewActionDataFromHexData([]byte(actionBinary)),
-		}}
+// CreateEdgeAction returns the action that creates an edge, e.g. to add to a BatchWriter
+func CreateEdgeAction(contract, creator eos.AccountName,
+	fromNode, toNode eos.Checksum256, edgeName eos.Name) *eos.Action {
 
-	return eostest.ExecTrx(ctx, api, actions)
+	return &eos.Action{
+		Account: contract,
+		Name:    eos.ActN("newedge"),
+		Authorization: []eos.PermissionLevel{
+			{Actor: creator, Permission: eos.PN("active")},
+		},
+		ActionData: eos.NewActionData(newEdge{
+			Creator:  creator,
+			FromNode: fromNode,
+			ToNode:   toNode,
+			EdgeName: edgeName,
+		}),
+	}
 }
 
 // EdgeExists checks to see if the edge exists
 func EdgeExists(ctx context.Context, api *eos.API, contract eos.AccountName,
 	fromNode, toNode Document, edgeName eos.Name) (bool, error) {
 
-	edges, err := fromNode.GetEdgesFromByName(ctx, api, contract, edgeName)
+	// the primary key is the edge's id, so this reads at most the rows sharing that key
+	edges, err := getEdgesByKey(ctx, api, contract, "1", EdgeID(fromNode.Hash, toNode.Hash, edgeName), func(edge *Edge) bool {
+		return edge.FromNode.String() == fromNode.Hash.String() && edge.ToNode.String() == toNode.Hash.String() &&
+			edge.EdgeName == edgeName
+	})
 	if err != nil {
-		return false, fmt.Errorf("get edges from by name doc: %v err: %v", fromNode.Hash, err)
+		return false, fmt.Errorf("get edge doc: %v err: %v", fromNode.Hash, err)
 	}
-
-	for _, edge := range edges {
-		if edge.ToNode.String() == toNode.Hash.String() {
-			return true, nil
-		}
-	}
-	return false, nil
+	return len(edges) > 0, nil
 }
 
+// getEdgesIndex pages through every edge with this document's hash on a checksum256 edge index
 func (d *Document) getEdgesIndex(ctx context.Context, api *eos.API, contract eos.AccountName, edgeIndex string) ([]Edge, error) {
-	var edges []Edge
-	var request eos.GetTableRowsRequest
-	request.Code = string(contract)
-	request.Scope = string(contract)
-	request.Table = "edges"
-	request.Index = edgeIndex
-	request.KeyType = "sha256"
-	request.LowerBound = d.Hash.String()
-	request.UpperBound = d.Hash.String()
-	request.Limit = 1000
-	request.JSON = true
-	response, err := api.GetTableRows(ctx, request)
-	if err != nil {
-		log.Println("Error with GetTableRows: ", err)
-		return []Edge{}, err
+	request := tableRowsRequest{
+		Code:       string(contract),
+		Scope:      string(contract),
+		Table:      "edges",
+		Index:      edgeIndex,
+		KeyType:    "sha256",
+		LowerBound: d.Hash.String(),
+		UpperBound: d.Hash.String(),
+		Limit:      1000,
+		JSON:       true,
 	}
-
-	err = response.JSONToStructs(&edges)
+	edges, err := getEdgesPaged(ctx, api, request, func(edge *Edge) bool { return true })
 	if err != nil {
-		log.Println("Error with JSONToStructs: ", err)
+		log.Println("Error with GetTableRows: ", err)
 		return []Edge{}, err
 	}
 	return edges, nil
@@ -204,38 +287,35 @@ func (d *Document) GetEdgesTo(ctx context.Context, api *eos.API, contract eos.Ac
 	return d.getEdgesIndex(ctx, api, contract, string("3"))
 }
 
-// GetEdgesFromByName retrieves a list of edges from this node to other nodes
+// GetEdgesFromByName retrieves the edges with the edge name from this node through the byfromtime index,
+// oldest first; edges stored before that index existed are found once the contract's reindex has run
 func (d *Document) GetEdgesFromByName(ctx context.Context, api *eos.API, contract eos.AccountName, edgeName eos.Name) ([]Edge, error) {
-	edges, err := d.getEdgesIndex(ctx, api, contract, string("2"))
+	prefix, err := EdgeNodeNameKey(d.Hash, edgeName)
 	if err != nil {
-		log.Println("Error with JSONToStructs: ", err)
 		return []Edge{}, err
 	}
-
-	var namedEdges []Edge
-	for _, edge := range edges {
-		if edge.EdgeName == edgeName {
-			namedEdges = append(namedEdges, edge)
-		}
-	}
-	return namedEdges, nil
+	return getEdgesByPrefix(ctx, api, contract, "10", prefix, func(edge *Edge) bool {
+		return edge.FromNode.String() == d.Hash.String() && edge.EdgeName == edgeName
+	})
 }
 
-// GetEdgesToByName retrieves a list of edges from this node to other nodes
+// GetEdgesToByName retrieves the edges with the edge name to this node through the bytotime index,
+// oldest first
 func (d *Document) GetEdgesToByName(ctx context.Context, api *eos.API, contract eos.AccountName, edgeName eos.Name) ([]Edge, error) {
-	edges, err := d.getEdgesIndex(ctx, api, contract, string("3"))
+	prefix, err := EdgeNodeNameKey(d.Hash, edgeName)
 	if err != nil {
-		log.Println("Error with JSONToStructs: ", err)
 		return []Edge{}, err
 	}
+	return getEdgesByPrefix(ctx, api, contract, "11", prefix, func(edge *Edge) bool {
+		return edge.ToNode.String() == d.Hash.String() && edge.EdgeName == edgeName
+	})
+}
 
-	var namedEdges []Edge
-	for _, edge := range edges {
-		if edge.EdgeName == edgeName {
-			namedEdges = append(namedEdges, edge)
-		}
-	}
-	return namedEdges, nil
+// GetEdgesBetween retrieves the edges of any name from this node to toNode through the byfromto index
+func (d *Document) GetEdgesBetween(ctx context.Context, api *eos.API, contract eos.AccountName, toNode eos.Checksum256) ([]Edge, error) {
+	return getEdgesByKey(ctx, api, contract, "6", EdgeFromToKey(d.Hash, toNode), func(edge *Edge) bool {
+		return edge.FromNode.String() == d.Hash.String() && edge.ToNode.String() == toNode.String()
+	})
 }
 
 // GetLastDocument retrieves the last document that was created from the contract
@@ -262,6 +342,33 @@ func GetLastDocument(ctx context.Context, api *eos.API, contract eos.AccountName
 	return docs[0], nil
 }
 
+type updateDoc struct {
+	Updater       eos.AccountName `json:"updater"`
+	Hash          eos.Checksum256 `json:"hash"`
+	ContentGroups []ContentGroup  `json:"content_groups"`
+}
+
+// UpdateDocument replaces the content of a document; with stable identities the edges keep
+// pointing to the document's identity, otherwise they are moved to the new hash
+func UpdateDocument(ctx context.Context, api *eos.API,
+	contract, updater eos.AccountName,
+	hash eos.Checksum256, contentGroups []ContentGroup) (string, error) {
+
+	actions := []*eos.Action{{
+		Account: contract,
+		Name:    eos.ActN("update"),
+		Authorization: []eos.PermissionLevel{
+			{Actor: updater, Permission: eos.PN("active")},
+		},
+		ActionData: eos.NewActionData(updateDoc{
+			Updater:       updater,
+			Hash:          hash,
+			ContentGroups: contentGroups,
+		}),
+	}}
+	return eostest.ExecTrx(ctx, api, actions)
+}
+
 type eraseDoc struct {
 	Hash eos.Checksum256 `json:"hash"`
 }
@@ -2,6 +2,14 @@ package docgraph
 
 import (
 	"context"
+	"crypto/sha256"
+	"encoding/binary"
+	"encoding/json"
+	"fmt"
+	"math"
+	"math/big"
+	"strconv"
+	"time"
 
 	eostest "github.com/digital-scarcity/eos-go-test"
 	eos "github.com/eoscanada/eos-go"
@@ -16,6 +24,214 @@ type Edge struct {
 	CreatedDate eos.BlockTimestamp `json:"created_date"`
 }
 
+// EdgeNodeNameKey returns the high 64 bits of the byfromtime and bytotime index keys,
+// matching Edge::nodeNameKey in the contract
+func EdgeNodeNameKey(node eos.Checksum256, edgeName eos.Name) (uint64, error) {
+	z, err := eos.StringToName(string(edgeName))
+	if err != nil {
+		return 0, fmt.Errorf("edge name %v: %v", edgeName, err)
+	}
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9
+	z = (z ^ (z >> 27)) * 0x94d049bb133111eb
+	return binary.BigEndian.Uint64(node[:8]) ^ z ^ (z >> 31), nil
+}
+
+// concatHash matches concatHash in the contract's util.cpp: the first 4 bytes of the sha256 of the
+// concatenated parts, read big endian, so edge keys only use the low 32 of their 64 bits
+func concatHash(parts ...string) uint64 {
+	h := sha256.New()
+	for _, part := range parts {
+		h.Write([]byte(part))
+	}
+	return uint64(binary.BigEndian.Uint32(h.Sum(nil)[:4]))
+}
+
+// EdgeID returns the primary key of the edge with these nodes and name
+func EdgeID(fromNode, toNode eos.Checksum256, edgeName eos.Name) uint64 {
+	return concatHash(fromNode.String(), toNode.String(), string(edgeName))
+}
+
+// EdgeFromNameKey returns the byfromname index key of edges with this from node and name
+func EdgeFromNameKey(fromNode eos.Checksum256, edgeName eos.Name) uint64 {
+	return concatHash(fromNode.String(), string(edgeName))
+}
+
+// EdgeFromToKey returns the byfromto index key of edges between these nodes
+func EdgeFromToKey(fromNode, toNode eos.Checksum256) uint64 {
+	return concatHash(fromNode.String(), toNode.String())
+}
+
+// EdgeToNameKey returns the bytoname index key of edges with this to node and name
+func EdgeToNameKey(toNode eos.Checksum256, edgeName eos.Name) uint64 {
+	return concatHash(toNode.String(), string(edgeName))
+}
+
+// getEdgesPaged reads every edge in the key range of the request's edge index that matches. All rows
+// of a node share its key on a secondary index, so pages can overlap (see forEachTablePage); rows
+// are kept once by primary key.
+func getEdgesPaged(ctx context.Context, api *eos.API, request tableRowsRequest, matches func(edge *Edge) bool) ([]Edge, error) {
+	var edges []Edge
+	seen := make(map[uint64]struct{})
+	_, err := forEachTablePage(ctx, api.HttpClient, api.BaseURL, request, func(rows []json.RawMessage) error {
+		for _, row := range rows {
+			var edge Edge
+			if err := json.Unmarshal(row, &edge); err != nil {
+				return fmt.Errorf("json to struct index %v: %v", request.Index, err)
+			}
+			if _, ok := seen[edge.ID]; ok {
+				continue
+			}
+			seen[edge.ID] = struct{}{}
+			if matches(&edge) {
+				edges = append(edges, edge)
+			}
+		}
+		return nil
+	})
+	return edges, err
+}
+
+// getEdgesByKey reads every edge with the key on a uint64 edge index; the keys are 32-bit hashes,
+// so matches drops the rows of colliding nodes and names
+func getEdgesByKey(ctx context.Context, api *eos.API, contract eos.AccountName,
+	edgeIndex string, key uint64, matches func(edge *Edge) bool) ([]Edge, error) {
+
+	request := tableRowsRequest{
+		Code:       string(contract),
+		Scope:      string(contract),
+		Table:      "edges",
+		Index:      edgeIndex,
+		KeyType:    "i64",
+		LowerBound: strconv.FormatUint(key, 10),
+		UpperBound: strconv.FormatUint(key, 10),
+		Limit:      1000,
+		JSON:       true,
+	}
+	edges, err := getEdgesPaged(ctx, api, request, matches)
+	if err != nil {
+		return []Edge{}, err
+	}
+	return edges, nil
+}
+
+// getEdgesByPrefix reads every edge with the 64-bit prefix on a time-ordered idx128 edge index. The
+// low half of the key is the created time, so unlike a byfromname or bytoname key it moves on from
+// page to page; only edges created in the same block share a key.
+func getEdgesByPrefix(ctx context.Context, api *eos.API, contract eos.AccountName,
+	edgeIndex string, prefix uint64, matches func(edge *Edge) bool) ([]Edge, error) {
+
+	request := tableRowsRequest{
+		Code:       string(contract),
+		Scope:      string(contract),
+		Table:      "edges",
+		Index:      edgeIndex,
+		KeyType:    "i128",
+		LowerBound: edgeTimeKey(prefix, time.Unix(0, 0)),
+		UpperBound: edgeTimeKey(prefix, time.Unix(0, math.MaxInt64)),
+		Limit:      1000,
+		JSON:       true,
+	}
+	edges, err := getEdgesPaged(ctx, api, request, matches)
+	if err != nil {
+		return []Edge{}, err
+	}
+	return edges, nil
+}
+
+// edgeTimeKey returns the decimal form of a time-ordered index key, as expected for i128 bounds
+func edgeTimeKey(prefix uint64, created time.Time) string {
+	key := new(big.Int).Lsh(new(big.Int).SetUint64(prefix), 64)
+	key.Or(key, new(big.Int).SetUint64(uint64(created.UnixNano()/1000)))
+	return key.String()
+}
+
+// getEdgesByTime reads edges of one index prefix created at or after since, oldest first or newest first
+func getEdgesByTime(ctx context.Context, api *eos.API, contract eos.AccountName,
+	edgeIndex string, prefix uint64, since time.Time, newestFirst bool, limit uint32) ([]Edge, error) {
+
+	var edges []Edge
+	var request eos.GetTableRowsRequest
+	request.Code = string(contract)
+	request.Scope = string(contract)
+	request.Table = "edges"
+	request.Index = edgeIndex
+	request.KeyType = "i128"
+	request.LowerBound = edgeTimeKey(prefix, since)
+	request.UpperBound = edgeTimeKey(prefix, time.Unix(0, math.MaxInt64))
+	request.Reverse = newestFirst
+	request.Limit = limit
+	request.JSON = true
+	response, err := api.GetTableRows(ctx, request)
+	if err != nil {
+		return []Edge{}, fmt.Errorf("get table rows index %v: %v", edgeIndex, err)
+	}
+
+	err = response.JSONToStructs(&edges)
+	if err != nil {
+		return []Edge{}, fmt.Errorf("json to structs index %v: %v", edgeIndex, err)
+	}
+	return edges, nil
+}
+
+// GetEdgesFromSince retrieves up to limit edges with the edge name from this node created at or after since
+func (d *Document) GetEdgesFromSince(ctx context.Context, api *eos.API, contract eos.AccountName,
+	edgeName eos.Name, since time.Time, newestFirst bool, limit uint32) ([]Edge, error) {
+
+	prefix, err := EdgeNodeNameKey(d.Hash, edgeName)
+	if err != nil {
+		return []Edge{}, err
+	}
+
+	edges, err := getEdgesByTime(ctx, api, contract, "10", prefix, since, newestFirst, limit)
+	if err != nil {
+		return []Edge{}, err
+	}
+
+	// the prefix is a 64-bit hash, so drop rows of any colliding node and name
+	var namedEdges []Edge
+	for _, edge := range edges {
+		if edge.FromNode.String() == d.Hash.String() && edge.EdgeName == edgeName {
+			namedEdges = append(namedEdges, edge)
+		}
+	}
+	return namedEdges, nil
+}
+
+// GetEdgesToSince retrieves up to limit edges with the edge name to this node created at or after since
+func (d *Document) GetEdgesToSince(ctx context.Context, api *eos.API, contract eos.AccountName,
+	edgeName eos.Name, since time.Time, newestFirst bool, limit uint32) ([]Edge, error) {
+
+	prefix, err := EdgeNodeNameKey(d.Hash, edgeName)
+	if err != nil {
+		return []Edge{}, err
+	}
+
+	edges, err := getEdgesByTime(ctx, api, contract, "11", prefix, since, newestFirst, limit)
+	if err != nil {
+		return []Edge{}, err
+	}
+
+	var namedEdges []Edge
+	for _, edge := range edges {
+		if edge.ToNode.String() == d.Hash.String() && edge.EdgeName == edgeName {
+			namedEdges = append(namedEdges, edge)
+		}
+	}
+	return namedEdges, nil
+}
+
+// GetEdgesByNameSince retrieves up to limit edges with the edge name created at or after since
+func GetEdgesByNameSince(ctx context.Context, api *eos.API, contract eos.AccountName,
+	edgeName eos.Name, since time.Time, newestFirst bool, limit uint32) ([]Edge, error) {
+
+	prefix, err := eos.StringToName(string(edgeName))
+	if err != nil {
+		return []Edge{}, fmt.Errorf("edge name %v: %v", edgeName, err)
+	}
+	return getEdgesByTime(ctx, api, contract, "12", prefix, since, newestFirst, limit)
+}
+
 // RemoveEdges ...
 type RemoveEdges struct {
 	FromNode eos.Checksum256 `json:"from_node"`
@@ -34,7 +250,13 @@ func RemoveEdge(ctx context.Context, api *eos.API,
 	contract eos.AccountName,
 	fromHash, toHash eos.Checksum256, edgeName eos.Name) (string, error) {
 
-	actions := []*eos.Action{{
+	actions := []*eos.Action{RemoveEdgeAction(contract, fromHash, toHash, edgeName)}
+	return eostest.ExecTrx(ctx, api, actions)
+}
+
+// RemoveEdgeAction returns the action that removes an edge, e.g. to add to a BatchWriter
+func RemoveEdgeAction(contract eos.AccountName, fromHash, toHash eos.Checksum256, edgeName eos.Name) *eos.Action {
+	return &eos.Action{
 		Account: contract,
 		Name:    eos.ActN("removeedge"),
 		Authorization: []eos.PermissionLevel{
@@ -45,8 +267,7 @@ func RemoveEdge(ctx context.Context, api *eos.API,
 			ToNode:   toHash,
 			EdgeName: edgeName,
 		}),
-	}}
-	return eostest.ExecTrx(ctx, api, actions)
+	}
 }
 
 // RemoveEdgesFromAndName ...
@@ -19,7 +19,7 @@ type Environment struct {
 	Creators []eos.AccountName
 }
 
-func SetupEnvironment(t *testing.T) *Environment {
+func SetupEnvironment(t testing.TB) *Environment {
 
 	var env Environment
 	env.api = *eos.New(testingEndpoint)
@@ -0,0 +1,375 @@
+package docgraph
+
+import (
+	"bufio"
+	"bytes"
+	"context"
+	"encoding/binary"
+	"encoding/hex"
+	"encoding/json"
+	"fmt"
+	"io"
+	"io/ioutil"
+	"math/big"
+	"net/http"
+	"strconv"
+	"strings"
+	"sync"
+	"time"
+
+	eos "github.com/eoscanada/eos-go"
+)
+
+// ExportFormat selects how ExportTable writes rows
+type ExportFormat int
+
+const (
+	// ExportNDJSON writes one JSON row per line
+	ExportNDJSON ExportFormat = iota
+	// ExportJSONArray writes a single JSON array, the format SaveGraph and the native tools read
+	ExportJSONArray
+	// ExportBinary writes every row as stored by the contract: a uvarint length, then the packed row
+	ExportBinary
+)
+
+// ExportOptions tunes ExportTable; zero values select the defaults
+type ExportOptions struct {
+	Format ExportFormat
+
+	// number of key ranges fetched concurrently, 8 by default
+	Workers int
+
+	// rows per get_table_rows request, 1000 by default
+	PageSize uint32
+
+	// scope of the table, e.g. a tenant's graph; the contract's own scope by default
+	Scope eos.AccountName
+}
+
+// ExportStats describes a finished export
+type ExportStats struct {
+	Rows     uint64
+	Bytes    uint64
+	Requests uint64
+	Duration time.Duration
+}
+
+// RowsPerSecond is the export throughput
+func (s ExportStats) RowsPerSecond() float64 {
+	if s.Duration <= 0 {
+		return 0
+	}
+	return float64(s.Rows) / s.Duration.Seconds()
+}
+
+// tableRowsRequest mirrors the get_table_rows parameters; eos-go's response drops next_key
+type tableRowsRequest struct {
+	Code       string `json:"code"`
+	Scope      string `json:"scope"`
+	Table      string `json:"table"`
+	Index      string `json:"index_position,omitempty"`
+	KeyType    string `json:"key_type,omitempty"`
+	LowerBound string `json:"lower_bound,omitempty"`
+	UpperBound string `json:"upper_bound,omitempty"`
+	Limit      uint32 `json:"limit"`
+	Reverse    bool   `json:"reverse,omitempty"`
+	JSON       bool   `json:"json"`
+}
+
+type tableRowsResponse struct {
+	Rows    []json.RawMessage `json:"rows"`
+	More    bool              `json:"more"`
+	NextKey string            `json:"next_key"`
+}
+
+// newTableClient returns an HTTP client that keeps one idle connection per worker
+func newTableClient(workers int) *http.Client {
+	return &http.Client{
+		Transport: &http.Transport{
+			MaxIdleConns:        workers,
+			MaxIdleConnsPerHost: workers,
+			IdleConnTimeout:     90 * time.Second,
+		},
+	}
+}
+
+func getTableRowsPage(ctx context.Context, client *http.Client, baseURL string, request tableRowsRequest) (tableRowsResponse, error) {
+	var response tableRowsResponse
+	body, err := json.Marshal(request)
+	if err != nil {
+		return response, err
+	}
+
+	httpRequest, err := http.NewRequestWithContext(ctx, "POST", baseURL+"/v1/chain/get_table_rows", bytes.NewReader(body))
+	if err != nil {
+		return response, err
+	}
+	httpResponse, err := client.Do(httpRequest)
+	if err != nil {
+		return response, fmt.Errorf("get table rows %v: %v", request.Table, err)
+	}
+	defer httpResponse.Body.Close()
+
+	if httpResponse.StatusCode != http.StatusOK {
+		message, _ := ioutil.ReadAll(io.LimitReader(httpResponse.Body, 4096))
+		return response, fmt.Errorf("get table rows %v: %v %s", request.Table, httpResponse.Status, message)
+	}
+	err = json.NewDecoder(httpResponse.Body).Decode(&response)
+	if err != nil {
+		return response, fmt.Errorf("decode table rows %v: %v", request.Table, err)
+	}
+	return response, nil
+}
+
+// forEachTablePage requests pages from request.LowerBound to request.UpperBound, following next_key,
+// and passes each page's rows to visit.
+//
+// On a secondary index next_key is only the key of the first row not returned, so a page can end
+// inside a run of rows sharing one key and the next page starts at the beginning of that run again.
+// When every row of a page has the key the page started at, next_key does not move at all; that page
+// is then requested again with twice the limit until the run fits. Callers paging a secondary index
+// must therefore drop rows they have already visited, e.g. by primary key. A node that returns a
+// short page for a run it cannot move past, e.g. because of its time limit, is an error.
+func forEachTablePage(ctx context.Context, client *http.Client, baseURL string, request tableRowsRequest,
+	visit func(rows []json.RawMessage) error) (uint64, error) {
+
+	var requests uint64
+	pageSize := request.Limit
+	for {
+		response, err := getTableRowsPage(ctx, client, baseURL, request)
+		requests++
+		if err != nil {
+			return requests, err
+		}
+		if err = visit(response.Rows); err != nil {
+			return requests, err
+		}
+		if !response.More {
+			return requests, nil
+		}
+		if response.NextKey == "" {
+			return requests, fmt.Errorf("get table rows %v: node does not return next_key", request.Table)
+		}
+		if sameTableKey(response.NextKey, request.LowerBound) {
+			if uint32(len(response.Rows)) < request.Limit {
+				return requests, fmt.Errorf("get table rows %v: node returns %v of the rows with key %v in one request",
+					request.Table, len(response.Rows), request.LowerBound)
+			}
+			request.Limit *= 2
+			continue
+		}
+		request.LowerBound = response.NextKey
+		request.Limit = pageSize
+	}
+}
+
+// sameTableKey compares a next_key with a bound; the node may format a numeric key differently than
+// the bound was given, e.g. in hex, and checksums in either case
+func sameTableKey(a, b string) bool {
+	if strings.EqualFold(a, b) {
+		return true
+	}
+	x, ok := new(big.Int).SetString(a, 0)
+	if !ok {
+		return false
+	}
+	y, ok := new(big.Int).SetString(b, 0)
+	return ok && x.Cmp(y) == 0
+}
+
+// primaryKeyBound reads the first or last primary key of a table. Every table of the contract
+// starts with its uint64 primary key, so it is the first 8 bytes of the packed row.
+func primaryKeyBound(ctx context.Context, client *http.Client, baseURL string, request tableRowsRequest, last bool) (uint64, bool, error) {
+	request.Limit = 1
+	request.Reverse = last
+	request.JSON = false
+	response, err := getTableRowsPage(ctx, client, baseURL, request)
+	if err != nil || len(response.Rows) == 0 {
+		return 0, false, err
+	}
+
+	row, err := decodeBinaryRow(response.Rows[0])
+	if err != nil {
+		return 0, false, err
+	}
+	if len(row) < 8 {
+		return 0, false, fmt.Errorf("table %v: row is shorter than a primary key", request.Table)
+	}
+	return binary.LittleEndian.Uint64(row[:8]), true, nil
+}
+
+func decodeBinaryRow(row json.RawMessage) ([]byte, error) {
+	var encoded string
+	if err := json.Unmarshal(row, &encoded); err != nil {
+		return nil, fmt.Errorf("binary row is not a hex string: %v", err)
+	}
+	return hex.DecodeString(encoded)
+}
+
+// rowWriter serialises the pages of concurrent workers into one output stream
+type rowWriter struct {
+	mutex  sync.Mutex
+	output *bufio.Writer
+	format ExportFormat
+	rows   uint64
+	bytes  uint64
+	length [binary.MaxVarintLen64]byte
+}
+
+func (w *rowWriter) writePage(rows []json.RawMessage) error {
+	w.mutex.Lock()
+	defer w.mutex.Unlock()
+
+	for _, row := range rows {
+		var err error
+		switch w.format {
+		case ExportBinary:
+			var data []byte
+			data, err = decodeBinaryRow(row)
+			if err != nil {
+				return err
+			}
+			n := binary.PutUvarint(w.length[:], uint64(len(data)))
+			w.output.Write(w.length[:n])
+			_, err = w.output.Write(data)
+			w.bytes += uint64(n + len(data))
+		case ExportJSONArray:
+			if w.rows > 0 {
+				w.output.WriteString(",\n")
+			}
+			_, err = w.output.Write(row)
+			w.bytes += uint64(len(row) + 2)
+		default:
+			w.output.Write(row)
+			err = w.output.WriteByte('\n')
+			w.bytes += uint64(len(row) + 1)
+		}
+		if err != nil {
+			return err
+		}
+		w.rows++
+	}
+	return nil
+}
+
+type keyRange struct {
+	lower, upper uint64
+}
+
+// splitKeys divides [lower, upper] into at most parts inclusive ranges of nearly equal width
+func splitKeys(lower, upper uint64, parts int) []keyRange {
+	width := (upper-lower)/uint64(parts) + 1
+	var ranges []keyRange
+	for start := lower; ; start += width {
+		end := start + width - 1
+		if end < start || end >= upper {
+			return append(ranges, keyRange{start, upper})
+		}
+		ranges = append(ranges, keyRange{start, end})
+	}
+}
+
+// ExportTable streams every row of a contract table to output. The primary key range is split into
+// several ranges per worker, which are paged through concurrently with more and next_key over a
+// shared keep-alive connection pool, so rows arrive ordered within a page but not across ranges.
+func ExportTable(ctx context.Context, api *eos.API, contract eos.AccountName, table string,
+	output io.Writer, options ExportOptions) (ExportStats, error) {
+
+	var stats ExportStats
+	started := time.Now()
+	if options.Workers <= 0 {
+		options.Workers = 8
+	}
+	if options.PageSize == 0 {
+		options.PageSize = 1000
+	}
+
+	if options.Scope == "" {
+		options.Scope = contract
+	}
+
+	client := newTableClient(options.Workers)
+	request := tableRowsRequest{
+		Code:    string(contract),
+		Scope:   string(options.Scope),
+		Table:   table,
+		KeyType: "i64",
+		Limit:   options.PageSize,
+		JSON:    options.Format != ExportBinary,
+	}
+
+	writer := &rowWriter{output: bufio.NewWriterSize(output, 1<<20), format: options.Format}
+	if options.Format == ExportJSONArray {
+		writer.output.WriteString("[")
+	}
+
+	lower, found, err := primaryKeyBound(ctx, client, api.BaseURL, request, false)
+	if err != nil {
+		return stats, err
+	}
+	upper, _, err := primaryKeyBound(ctx, client, api.BaseURL, request, true)
+	if err != nil {
+		return stats, err
+	}
+	stats.Requests = 2
+
+	if found {
+		ctx, cancel := context.WithCancel(ctx)
+		defer cancel()
+
+		ranges := make(chan keyRange)
+		errs := make(chan error, options.Workers)
+		var requests uint64
+		var wait sync.WaitGroup
+		for i := 0; i < options.Workers; i++ {
+			wait.Add(1)
+			go func() {
+				defer wait.Done()
+				for r := range ranges {
+					rangeRequest := request
+					rangeRequest.LowerBound = strconv.FormatUint(r.lower, 10)
+					rangeRequest.UpperBound = strconv.FormatUint(r.upper, 10)
+					n, err := forEachTablePage(ctx, client, api.BaseURL, rangeRequest, writer.writePage)
+					writer.mutex.Lock()
+					requests += n
+					writer.mutex.Unlock()
+					if err != nil {
+						errs <- err
+						cancel()
+						return
+					}
+				}
+			}()
+		}
+
+	feed:
+		for _, r := range splitKeys(lower, upper, options.Workers*4) {
+			select {
+			case ranges <- r:
+			case <-ctx.Done():
+				break feed
+			}
+		}
+		close(ranges)
+		wait.Wait()
+		stats.Requests += requests
+
+		select {
+		case err = <-errs:
+			return stats, err
+		default:
+		}
+	}
+
+	if options.Format == ExportJSONArray {
+		writer.output.WriteString("]\n")
+	}
+	if err = writer.output.Flush(); err != nil {
+		return stats, err
+	}
+
+	stats.Rows = writer.rows
+	stats.Bytes = writer.bytes
+	stats.Duration = time.Since(started)
+	return stats, nil
+}
@@ -0,0 +1,197 @@
+package docgraph
+
+import (
+	"context"
+	"encoding/json"
+	"fmt"
+	"math/big"
+	"net/http"
+	"net/http/httptest"
+	"sort"
+	"sync/atomic"
+	"testing"
+	"time"
+
+	eos "github.com/eoscanada/eos-go"
+	"github.com/stretchr/testify/require"
+)
+
+type indexedEdge struct {
+	key *big.Int
+	row json.RawMessage
+	id  uint64
+}
+
+// newEdgeIndexServer serves get_table_rows on the edges' secondary indexes the way nodeos does: rows in
+// key and then primary key order, at most maxRows of them per response if it is not zero, and
+// next_key the key of the first row not returned, so it repeats for rows sharing a key
+func newEdgeIndexServer(t *testing.T, edges []Edge, maxRows int,
+	key func(edge *Edge, index string) *big.Int) (*httptest.Server, *int64) {
+
+	var requests int64
+	server := httptest.NewServer(http.HandlerFunc(func(w http.ResponseWriter, r *http.Request) {
+		if atomic.AddInt64(&requests, 1) > 100 {
+			http.Error(w, "too many requests", http.StatusTooManyRequests)
+			return
+		}
+		var request tableRowsRequest
+		json.NewDecoder(r.Body).Decode(&request)
+
+		base := 0
+		if request.KeyType == "sha256" {
+			base = 16
+		}
+		lower, _ := new(big.Int).SetString(request.LowerBound, base)
+		upper, _ := new(big.Int).SetString(request.UpperBound, base)
+
+		var rows []indexedEdge
+		for i := range edges {
+			k := key(&edges[i], request.Index)
+			if k.Cmp(lower) >= 0 && k.Cmp(upper) <= 0 {
+				row, _ := json.Marshal(edges[i])
+				rows = append(rows, indexedEdge{key: k, row: row, id: edges[i].ID})
+			}
+		}
+		sort.Slice(rows, func(i, j int) bool {
+			if c := rows[i].key.Cmp(rows[j].key); c != 0 {
+				return c < 0
+			}
+			return rows[i].id < rows[j].id
+		})
+
+		limit := int(request.Limit)
+		if maxRows > 0 && limit > maxRows {
+			limit = maxRows
+		}
+		response := tableRowsResponse{Rows: []json.RawMessage{}}
+		for i, row := range rows {
+			if i == limit {
+				response.More = true
+				if request.KeyType == "sha256" {
+					response.NextKey = fmt.Sprintf("%064x", row.key)
+				} else {
+					response.NextKey = fmt.Sprintf("0x%x", row.key)
+				}
+				break
+			}
+			response.Rows = append(response.Rows, row.row)
+		}
+		json.NewEncoder(w).Encode(response)
+	}))
+	return server, &requests
+}
+
+func edgeNodeKey(edge *Edge, index string) *big.Int {
+	if index == "3" {
+		return new(big.Int).SetBytes(edge.ToNode)
+	}
+	return new(big.Int).SetBytes(edge.FromNode)
+}
+
+// more edges than fit in a page share the node's key on the fromnode index
+func TestGetEdgesFromPages(t *testing.T) {
+	hub := Document{Hash: eos.Checksum256(mustDecodeHex(t, "7463fa7dda551b9c4bbd2ba17b793931c825cefff9eede14461fd1a5c9f07d15"))}
+	other := eos.Checksum256(mustDecodeHex(t, "d4ec74355830056924c83f20ffb1a22ad0c5145a96daddf6301897a092de951e"))
+
+	created := eos.BlockTimestamp{Time: time.Unix(1600000000, 0).UTC()}
+
+	var edges []Edge
+	for i := 0; i < 2500; i++ {
+		edges = append(edges, Edge{ID: uint64(i), FromNode: hub.Hash, ToNode: other, EdgeName: "member", CreatedDate: created})
+	}
+	edges = append(edges, Edge{ID: 2500, FromNode: other, ToNode: hub.Hash, EdgeName: "member", CreatedDate: created})
+
+	server, requests := newEdgeIndexServer(t, edges, 0, edgeNodeKey)
+	defer server.Close()
+
+	fromEdges, err := hub.GetEdgesFrom(context.Background(), eos.New(server.URL), "documents")
+	require.NoError(t, err)
+	require.Len(t, fromEdges, 2500)
+	ids := make(map[uint64]bool)
+	for _, edge := range fromEdges {
+		ids[edge.ID] = true
+	}
+	require.Len(t, ids, 2500)
+	// the page grows from 1000 to 2000 to 4000 rows once next_key stops moving
+	require.Equal(t, int64(3), atomic.LoadInt64(requests))
+
+	toEdges, err := hub.GetEdgesTo(context.Background(), eos.New(server.URL), "documents")
+	require.NoError(t, err)
+	require.Len(t, toEdges, 1)
+}
+
+// a node that cannot return every row of a key in one response fails the query instead of looping
+func TestGetEdgesFromShortPage(t *testing.T) {
+	hub := Document{Hash: eos.Checksum256(mustDecodeHex(t, "7463fa7dda551b9c4bbd2ba17b793931c825cefff9eede14461fd1a5c9f07d15"))}
+
+	var edges []Edge
+	for i := 0; i < 2500; i++ {
+		edges = append(edges, Edge{ID: uint64(i), FromNode: hub.Hash, ToNode: hub.Hash, EdgeName: "member",
+			CreatedDate: eos.BlockTimestamp{Time: time.Unix(1600000000, 0).UTC()}})
+	}
+
+	server, requests := newEdgeIndexServer(t, edges, 1500, edgeNodeKey)
+	defer server.Close()
+
+	_, err := hub.GetEdgesFrom(context.Background(), eos.New(server.URL), "documents")
+	require.Error(t, err)
+	require.Equal(t, int64(2), atomic.LoadInt64(requests))
+}
+
+func edgeTimeIndexKey(edge *Edge, index string) *big.Int {
+	var key *big.Int
+	switch index {
+	case "6":
+		return new(big.Int).SetUint64(EdgeFromToKey(edge.FromNode, edge.ToNode))
+	case "11":
+		prefix, _ := EdgeNodeNameKey(edge.ToNode, edge.EdgeName)
+		key, _ = new(big.Int).SetString(edgeTimeKey(prefix, edge.CreatedDate.Time), 10)
+	default:
+		prefix, _ := EdgeNodeNameKey(edge.FromNode, edge.EdgeName)
+		key, _ = new(big.Int).SetString(edgeTimeKey(prefix, edge.CreatedDate.Time), 10)
+	}
+	return key
+}
+
+// a hub node's edges of one name span several pages, and more of them than a page holds were created
+// in the same block and so share a byfromtime key
+func TestGetEdgesByNamePages(t *testing.T) {
+	hub := Document{Hash: eos.Checksum256(mustDecodeHex(t, "7463fa7dda551b9c4bbd2ba17b793931c825cefff9eede14461fd1a5c9f07d15"))}
+	other := eos.Checksum256(mustDecodeHex(t, "d4ec74355830056924c83f20ffb1a22ad0c5145a96daddf6301897a092de951e"))
+
+	var edges []Edge
+	for i := 0; i < 2500; i++ {
+		block := time.Unix(1600000000, 0)
+		if i >= 700 {
+			block = block.Add(500 * time.Millisecond)
+		}
+		if i >= 1900 {
+			block = block.Add(500 * time.Millisecond)
+		}
+		edges = append(edges, Edge{ID: uint64(i), FromNode: hub.Hash, ToNode: other, EdgeName: "member",
+			CreatedDate: eos.BlockTimestamp{Time: block.UTC()}})
+	}
+	edges = append(edges, Edge{ID: 2500, FromNode: hub.Hash, ToNode: other, EdgeName: "owns",
+		CreatedDate: eos.BlockTimestamp{Time: time.Unix(1600000000, 0).UTC()}})
+
+	server, requests := newEdgeIndexServer(t, edges, 0, edgeTimeIndexKey)
+	defer server.Close()
+	api := eos.New(server.URL)
+
+	fromEdges, err := hub.GetEdgesFromByName(context.Background(), api, "documents", "member")
+	require.NoError(t, err)
+	require.Len(t, fromEdges, 2500)
+	for i, edge := range fromEdges {
+		require.Equal(t, uint64(i), edge.ID)
+	}
+	// one page ends inside the second block, whose 1200 edges then take a page of 2000
+	require.Equal(t, int64(3), atomic.LoadInt64(requests))
+
+	toEdges, err := (&Document{Hash: other}).GetEdgesToByName(context.Background(), api, "documents", "owns")
+	require.NoError(t, err)
+	require.Len(t, toEdges, 1)
+
+	between, err := hub.GetEdgesBetween(context.Background(), api, "documents", other)
+	require.NoError(t, err)
+	require.Len(t, between, 2501)
+}
@@ -0,0 +1,126 @@
+package docgraph
+
+import (
+	"context"
+	"fmt"
+
+	eostest "github.com/digital-scarcity/eos-go-test"
+	eos "github.com/eoscanada/eos-go"
+)
+
+// GCState is the progress and report of a garbage collection run by a contract built with
+// DOCUMENT_GRAPH_GC
+type GCState struct {
+	Phase          eos.Name           `json:"phase"`
+	Started        eos.BlockTimestamp `json:"started"`
+	Roots          []eos.Checksum256  `json:"roots"`
+	EdgeNames      []eos.Name         `json:"edge_names"`
+	DryRun         bool               `json:"dry_run"`
+	MarkCursor     eos.Uint64         `json:"mark_cursor"`
+	DocumentCursor eos.Uint64         `json:"document_cursor"`
+	KeyedCursor    eos.Uint64         `json:"keyed_cursor"`
+	EdgeCursor     eos.Uint64         `json:"edge_cursor"`
+	MarkRun        eos.Uint64         `json:"mark_run"`
+	MarkEdge       eos.Uint64         `json:"mark_edge"`
+	SweepRun       eos.Uint64         `json:"sweep_run"`
+	SweepEdge      eos.Uint64         `json:"sweep_edge"`
+	Sweeping       eos.Checksum256    `json:"sweeping"`
+	Marked         eos.Uint64         `json:"marked"`
+	Documents      eos.Uint64         `json:"documents"`
+	Edges          eos.Uint64         `json:"edges"`
+}
+
+// GCDone is the phase of a finished collection
+const GCDone eos.Name = "done"
+
+type gcStart struct {
+	Scope     eos.AccountName   `json:"scope"`
+	Roots     []eos.Checksum256 `json:"roots"`
+	EdgeNames []eos.Name        `json:"edge_names"`
+	DryRun    bool              `json:"dry_run"`
+}
+
+type gcStep struct {
+	Scope   eos.AccountName `json:"scope"`
+	MaxRows uint64          `json:"max_rows"`
+}
+
+// StartGC starts a collection of the graph in scope that keeps the documents reachable from roots
+// along edges named in edgeNames, or along any edge if it is empty; a dry run only counts
+func StartGC(ctx context.Context, api *eos.API, contract, scope eos.AccountName,
+	roots []eos.Checksum256, edgeNames []eos.Name, dryRun bool) (string, error) {
+
+	if edgeNames == nil {
+		edgeNames = []eos.Name{}
+	}
+	actions := []*eos.Action{{
+		Account: contract,
+		Name:    eos.ActN("gcstart"),
+		Authorization: []eos.PermissionLevel{
+			{Actor: contract, Permission: eos.PN("active")},
+		},
+		ActionData: eos.NewActionData(gcStart{
+			Scope:     scope,
+			Roots:     roots,
+			EdgeNames: edgeNames,
+			DryRun:    dryRun,
+		}),
+	}}
+	return eostest.ExecTrx(ctx, api, actions)
+}
+
+// GCStepAction returns the action that advances the collection of scope by up to maxRows rows
+func GCStepAction(contract, scope eos.AccountName, maxRows uint64) *eos.Action {
+	return &eos.Action{
+		Account: contract,
+		Name:    eos.ActN("gcstep"),
+		Authorization: []eos.PermissionLevel{
+			{Actor: contract, Permission: eos.PN("active")},
+		},
+		ActionData: eos.NewActionData(gcStep{
+			Scope:   scope,
+			MaxRows: maxRows,
+		}),
+	}
+}
+
+// GetGCState reads the state of the last collection of scope
+func GetGCState(ctx context.Context, api *eos.API, contract, scope eos.AccountName) (GCState, error) {
+	var states []GCState
+	var request eos.GetTableRowsRequest
+	request.Code = string(contract)
+	request.Scope = string(scope)
+	request.Table = "gcstate"
+	request.Limit = 1
+	request.JSON = true
+	response, err := api.GetTableRows(ctx, request)
+	if err != nil {
+		return GCState{}, fmt.Errorf("get table rows gcstate: %v", err)
+	}
+
+	err = response.JSONToStructs(&states)
+	if err != nil {
+		return GCState{}, fmt.Errorf("json to structs gcstate: %v", err)
+	}
+	if len(states) == 0 {
+		return GCState{}, fmt.Errorf("no garbage collection has been started in scope %v", scope)
+	}
+	return states[0], nil
+}
+
+// RunGC pushes gcstep until the collection of scope is done and returns its final state. Each
+// step is a separate transaction, and max_rows varies slightly between steps so that steps
+// pushed within one block are not rejected as duplicates.
+func RunGC(ctx context.Context, api *eos.API, contract, scope eos.AccountName, maxRows uint64) (GCState, error) {
+	for i := uint64(0); ; i++ {
+		_, err := eostest.ExecTrx(ctx, api, []*eos.Action{GCStepAction(contract, scope, maxRows+i%1000)})
+		if err != nil {
+			return GCState{}, fmt.Errorf("gc step: %v", err)
+		}
+
+		state, err := GetGCState(ctx, api, contract, scope)
+		if err != nil || state.Phase == GCDone {
+			return state, err
+		}
+	}
+}
@@ -3,9 +3,9 @@ package docgraph_test
 import (
 	"context"
 	"fmt"
-	"io/ioutil"
 	"log"
 	"math/rand"
+	"os"
 	"testing"
 	"time"
 
@@ -91,8 +91,8 @@ func GetOrNewGet(ctx context.Context, api *eos.API, contract, creator eos.Accoun
 	return lastDoc, nil
 }
 
-// CreateRandomDocument creates a document with a single random value
-func CreateRandomDocument(ctx context.Context, api *eos.API, contract, creator eos.AccountName) (docgraph.Document, error) {
+// randomContentGroups returns a single content group with a single random value
+func randomContentGroups() []docgraph.ContentGroup {
 
 	var ci docgraph.ContentItem
 	ci.Label = randomString()
@@ -107,6 +107,11 @@ func CreateRandomDocument(ctx context.Context, api *eos.API, contract, creator e
 	cg[0] = ci
 	cgs := make([]docgraph.ContentGroup, 1)
 	cgs[0] = cg
+	return cgs
+}
+
+// CreateRandomDocument creates a document with a single random value
+func CreateRandomDocument(ctx context.Context, api *eos.API, contract, creator eos.AccountName) (docgraph.Document, error) {
 
 	actions := []*eos.Action{{
 		Account: contract,
@@ -116,7 +121,7 @@ func CreateRandomDocument(ctx context.Context, api *eos.API, contract, creator e
 		},
 		ActionData: eos.NewActionData(createDoc{
 			Creator:       creator,
-			ContentGroups: cgs,
+			ContentGroups: randomContentGroups(),
 		}),
 	}}
 	_, err := eostest.ExecTrx(ctx, api, actions)
@@ -154,7 +159,7 @@ func GetAllEdges(ctx context.Context, api *eos.API, contract eos.AccountName) ([
 	return edges, nil
 }
 
-func pause(t *testing.T, seconds time.Duration, headline, prefix string) {
+func pause(t testing.TB, seconds time.Duration, headline, prefix string) {
 	if headline != "" {
 		t.Log(headline)
 	}
@@ -182,52 +187,24 @@ func pause(t *testing.T, seconds time.Duration, headline, prefix string) {
 	fmt.Println()
 }
 
+// SaveGraph writes every document and edge of the contract to documents.json and edges.json
 func SaveGraph(ctx context.Context, api *eos.API, contract eos.AccountName, folderName string) error {
 
-	var request eos.GetTableRowsRequest
-	request.Code = string(contract)
-	request.Scope = string(contract)
-	request.Table = "documents"
-	request.Limit = 1000
-	request.JSON = true
-	response, err := api.GetTableRows(ctx, request)
-	if err != nil {
-		return fmt.Errorf("Unable to retrieve rows: %v", err)
-	}
-
-	data, err := response.Rows.MarshalJSON()
-	if err != nil {
-		return fmt.Errorf("Unable to marshal json: %v", err)
-	}
-
-	documentsFile := folderName + "/documents.json"
-	err = ioutil.WriteFile(documentsFile, data, 0644)
-	if err != nil {
-		return fmt.Errorf("Unable to write file: %v", err)
+	for _, table := range []string{"documents", "edges"} {
+		file, err := os.Create(folderName + "/" + table + ".json")
+		if err != nil {
+			return fmt.Errorf("Unable to create file: %v", err)
+		}
+
+		_, err = docgraph.ExportTable(ctx, api, contract, table, file, docgraph.ExportOptions{Format: docgraph.ExportJSONArray})
+		closeErr := file.Close()
+		if err != nil {
+			return fmt.Errorf("Unable to export %v: %v", table, err)
+		}
+		if closeErr != nil {
+			return fmt.Errorf("Unable to write %v: %v", table, closeErr)
+		}
 	}
-
-	request = eos.GetTableRowsRequest{}
-	request.Code = string(contract)
-	request.Scope = string(contract)
-	request.Table = "edges"
-	request.Limit = 1000
-	request.JSON = true
-	response, err = api.GetTableRows(ctx, request)
-	if err != nil {
-		return fmt.Errorf("Unable to retrieve rows: %v", err)
-	}
-
-	data, err = response.Rows.MarshalJSON()
-	if err != nil {
-		return fmt.Errorf("Unable to marshal json: %v", err)
-	}
-
-	edgesFile := folderName + "/edges.json"
-	err = ioutil.WriteFile(edgesFile, data, 0644)
-	if err != nil {
-		return fmt.Errorf("Unable to write file: %v", err)
-	}
-
 	return nil
 }
 
@@ -0,0 +1,111 @@
+package docgraph
+
+import (
+	"context"
+	"fmt"
+	"strconv"
+
+	eostest "github.com/digital-scarcity/eos-go-test"
+	eos "github.com/eoscanada/eos-go"
+)
+
+// JournalEntry is one document or edge change recorded by a contract built with DOCUMENT_GRAPH_JOURNAL
+type JournalEntry struct {
+	Sequence  uint64          `json:"sequence"`
+	Operation eos.Name        `json:"operation"`
+	Node      eos.Checksum256 `json:"node"`
+	ToNode    eos.Checksum256 `json:"to_node"`
+	EdgeName  eos.Name        `json:"edge_name"`
+}
+
+// Journal operations
+const (
+	JournalCreateDocument eos.Name = "createdoc"
+	JournalEraseDocument  eos.Name = "erasedoc"
+	JournalCreateEdge     eos.Name = "createedge"
+	JournalEraseEdge      eos.Name = "eraseedge"
+)
+
+// JournalPrunedError is returned when entries after the cursor were pruned before they were read;
+// the replica has to be rebuilt from a full dump
+type JournalPrunedError struct {
+	Cursor uint64
+	Oldest uint64
+}
+
+func (e *JournalPrunedError) Error() string {
+	return fmt.Sprintf("journal entries %v to %v were pruned", e.Cursor, e.Oldest-1)
+}
+
+// GetJournal reads every journal entry with a sequence of at least cursor, pageSize rows per request.
+// It returns the entries in order and the cursor to pass on the next call; start with a cursor of 0.
+// If the oldest retained entry is above cursor, including a cursor of 0 on a pruned journal, it
+// returns a JournalPrunedError whose Oldest is the lowest retained sequence.
+func GetJournal(ctx context.Context, api *eos.API, contract eos.AccountName,
+	cursor uint64, pageSize uint32) ([]JournalEntry, uint64, error) {
+
+	return GetJournalIn(ctx, api, contract, contract, cursor, pageSize)
+}
+
+// GetJournalIn reads the journal of the graph kept in scope; each scope numbers its entries separately
+func GetJournalIn(ctx context.Context, api *eos.API, contract, scope eos.AccountName,
+	cursor uint64, pageSize uint32) ([]JournalEntry, uint64, error) {
+
+	var entries []JournalEntry
+	for {
+		var page []JournalEntry
+		var request eos.GetTableRowsRequest
+		request.Code = string(contract)
+		request.Scope = string(scope)
+		request.Table = "journal"
+		request.LowerBound = strconv.FormatUint(cursor, 10)
+		request.Limit = pageSize
+		request.JSON = true
+		response, err := api.GetTableRows(ctx, request)
+		if err != nil {
+			return entries, cursor, fmt.Errorf("get table rows journal: %v", err)
+		}
+
+		err = response.JSONToStructs(&page)
+		if err != nil {
+			return entries, cursor, fmt.Errorf("json to structs journal: %v", err)
+		}
+
+		// sequences start at 0 and the newest entry is never pruned, so a gap means entries after
+		// the cursor are lost
+		if len(page) > 0 && len(entries) == 0 && page[0].Sequence > cursor {
+			return entries, cursor, &JournalPrunedError{Cursor: cursor, Oldest: page[0].Sequence}
+		}
+
+		entries = append(entries, page...)
+		if len(page) > 0 {
+			cursor = page[len(page)-1].Sequence + 1
+		}
+		if !response.More || len(page) == 0 {
+			return entries, cursor, nil
+		}
+	}
+}
+
+type pruneJournal struct {
+	BeforeSequence uint64 `json:"before_sequence"`
+	MaxRows        uint64 `json:"max_rows"`
+}
+
+// PruneJournal erases up to maxRows journal entries with a sequence below beforeSequence
+func PruneJournal(ctx context.Context, api *eos.API, contract eos.AccountName,
+	beforeSequence, maxRows uint64) (string, error) {
+
+	actions := []*eos.Action{{
+		Account: contract,
+		Name:    eos.ActN("prunejournal"),
+		Authorization: []eos.PermissionLevel{
+			{Actor: contract, Permission: eos.PN("active")},
+		},
+		ActionData: eos.NewActionData(pruneJournal{
+			BeforeSequence: beforeSequence,
+			MaxRows:        maxRows,
+		}),
+	}}
+	return eostest.ExecTrx(ctx, api, actions)
+}
@@ -1,2 +1,2 @@
 #!/bin/sh
-/Users/max/eosio/2.0/bin/nodeos -e -p eosio --plugin eosio::producer_plugin  --max-transaction-time 300 --plugin eosio::producer_api_plugin --plugin eosio::chain_api_plugin --plugin eosio::http_plugin --plugin eosio::history_plugin --plugin eosio::history_api_plugin --filter-on='*' --access-control-allow-origin='*' --contracts-console --http-validate-host=false --verbose-http-errors --delete-all-blocks
\ No newline at end of file
+/Users/max/eosio/2.0/bin/nodeos -e -p eosio --plugin eosio::producer_plugin  --max-transaction-time 300 --plugin eosio::producer_api_plugin --plugin eosio::chain_api_plugin --plugin eosio::http_plugin --plugin eosio::history_plugin --plugin eosio::history_api_plugin --filter-on='*' --access-control-allow-origin='*' --contracts-console --http-validate-host=false --verbose-http-errors --plugin eosio::state_history_plugin --chain-state-history --state-history-endpoint=127.0.0.1:8080 --disable-replay-opts --delete-all-blocks
\ No newline at end of file
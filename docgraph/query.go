@@ -0,0 +1,330 @@
+package docgraph
+
+import (
+	"bytes"
+	"context"
+	"encoding/hex"
+	"encoding/json"
+	"fmt"
+	"io/ioutil"
+	"net/http"
+	"sync"
+
+	eos "github.com/eoscanada/eos-go"
+)
+
+// A contract built with DOCUMENT_GRAPH_QUERY_ACTIONS answers getdoc, getdocs, getedges and
+// neighbors with a packed action return value. The functions below run those actions with
+// compute_transaction, which executes the transaction without committing it, and decode the
+// result, so one call replaces a get_table_rows request per document and index probe.
+
+// EdgeCursor is where the next page of edges starts
+type EdgeCursor struct {
+	CreatedDate eos.TimePoint `json:"created_date"`
+	ID          uint64        `json:"id"`
+}
+
+// EdgePage is a page of edges, newest first; Next is nil on the last page
+type EdgePage struct {
+	Edges []Edge
+	Next  *EdgeCursor
+}
+
+// Neighborhood is a document, a page of its outgoing edges of one name and the documents
+// they point to, in the same order as the edges. A neighbor that is not stored has a zero hash.
+type Neighborhood struct {
+	Document  Document
+	Edges     []Edge
+	Neighbors []Document
+	Next      *EdgeCursor
+}
+
+type packedEdgePage struct {
+	Edges []packedEdge
+	Next  *EdgeCursor `eos:"optional"`
+}
+
+type packedEdgePageV2 struct {
+	Edges []packedEdgeV2
+	Next  *EdgeCursor `eos:"optional"`
+}
+
+type packedNeighborhood struct {
+	Document  packedDocument
+	Edges     []packedEdge
+	Neighbors []packedDocument
+	Next      *EdgeCursor `eos:"optional"`
+}
+
+type packedNeighborhoodV2 struct {
+	Document  packedDocumentV2
+	Edges     []packedEdgeV2
+	Neighbors []packedDocumentV2
+	Next      *EdgeCursor `eos:"optional"`
+}
+
+func unpackDocuments(packed []packedDocument) []Document {
+	documents := make([]Document, 0, len(packed))
+	for i := range packed {
+		documents = append(documents, packed[i].document())
+	}
+	return documents
+}
+
+func unpackDocumentsV2(packed []packedDocumentV2) []Document {
+	documents := make([]Document, 0, len(packed))
+	for i := range packed {
+		documents = append(documents, packed[i].document())
+	}
+	return documents
+}
+
+func unpackEdges(packed []packedEdge) []Edge {
+	edges := make([]Edge, 0, len(packed))
+	for i := range packed {
+		edges = append(edges, packed[i].edge())
+	}
+	return edges
+}
+
+func unpackEdgesV2(packed []packedEdgeV2) []Edge {
+	edges := make([]Edge, 0, len(packed))
+	for i := range packed {
+		edges = append(edges, packed[i].edge())
+	}
+	return edges
+}
+
+// rowLayouts caches the row layout of every contract queried, keyed by node URL and contract,
+// so that the ABI is read once rather than on every query
+var rowLayouts sync.Map
+
+func queryRowLayout(ctx context.Context, api *eos.API, contract eos.AccountName) (RowLayout, error) {
+	key := api.BaseURL + "/" + string(contract)
+	if layout, ok := rowLayouts.Load(key); ok {
+		return layout.(RowLayout), nil
+	}
+	layout, err := ContractRowLayout(ctx, api, contract)
+	if err != nil {
+		return 0, err
+	}
+	rowLayouts.Store(key, layout)
+	return layout, nil
+}
+
+type getDoc struct {
+	Scope eos.AccountName `json:"scope"`
+	Hash  eos.Checksum256 `json:"hash"`
+}
+
+type getDocs struct {
+	Scope  eos.AccountName   `json:"scope"`
+	Hashes []eos.Checksum256 `json:"hashes"`
+}
+
+type getEdges struct {
+	Scope    eos.AccountName `json:"scope"`
+	Node     eos.Checksum256 `json:"node"`
+	EdgeName eos.Name        `json:"edge_name"`
+	Incoming bool            `json:"incoming"`
+	After    *EdgeCursor     `json:"after" eos:"optional"`
+	Limit    uint32          `json:"limit"`
+}
+
+type getNeighbors struct {
+	Scope    eos.AccountName `json:"scope"`
+	Hash     eos.Checksum256 `json:"hash"`
+	EdgeName eos.Name        `json:"edge_name"`
+	After    *EdgeCursor     `json:"after" eos:"optional"`
+	Limit    uint32          `json:"limit"`
+}
+
+// QueryDocument reads one document of scope; reader is the account the transaction is
+// authorized by, the action itself checks no authority
+func QueryDocument(ctx context.Context, api *eos.API, contract, scope, reader eos.AccountName,
+	hash eos.Checksum256) (Document, error) {
+
+	var packed packedDocument
+	var compact packedDocumentV2
+	layout, err := computeQuery(ctx, api, contract, reader, "getdoc", getDoc{Scope: scope, Hash: hash}, &packed, &compact)
+	if err != nil {
+		return Document{}, err
+	}
+	if layout == RowLayoutV2 {
+		return compact.document(), nil
+	}
+	return packed.document(), nil
+}
+
+// QueryDocuments reads the stored documents among hashes, in the same order, in one call
+func QueryDocuments(ctx context.Context, api *eos.API, contract, scope, reader eos.AccountName,
+	hashes []eos.Checksum256) ([]Document, error) {
+
+	var packed []packedDocument
+	var compact []packedDocumentV2
+	layout, err := computeQuery(ctx, api, contract, reader, "getdocs", getDocs{Scope: scope, Hashes: hashes}, &packed, &compact)
+	if err != nil {
+		return nil, err
+	}
+	if layout == RowLayoutV2 {
+		return unpackDocumentsV2(compact), nil
+	}
+	return unpackDocuments(packed), nil
+}
+
+// QueryEdges reads a page of up to limit edges named edgeName from node, or to it if
+// incoming, newest first; pass the Next of a page as after to read the following one
+func QueryEdges(ctx context.Context, api *eos.API, contract, scope, reader eos.AccountName,
+	node eos.Checksum256, edgeName eos.Name, incoming bool, after *EdgeCursor, limit uint32) (EdgePage, error) {
+
+	var packed packedEdgePage
+	var compact packedEdgePageV2
+	layout, err := computeQuery(ctx, api, contract, reader, "getedges", getEdges{
+		Scope:    scope,
+		Node:     node,
+		EdgeName: edgeName,
+		Incoming: incoming,
+		After:    after,
+		Limit:    limit,
+	}, &packed, &compact)
+	if err != nil {
+		return EdgePage{}, err
+	}
+	if layout == RowLayoutV2 {
+		return EdgePage{Edges: unpackEdgesV2(compact.Edges), Next: compact.Next}, nil
+	}
+	return EdgePage{Edges: unpackEdges(packed.Edges), Next: packed.Next}, nil
+}
+
+// QueryNeighbors reads a document with a page of its edges named edgeName and the documents
+// they point to
+func QueryNeighbors(ctx context.Context, api *eos.API, contract, scope, reader eos.AccountName,
+	hash eos.Checksum256, edgeName eos.Name, after *EdgeCursor, limit uint32) (Neighborhood, error) {
+
+	var packed packedNeighborhood
+	var compact packedNeighborhoodV2
+	layout, err := computeQuery(ctx, api, contract, reader, "neighbors", getNeighbors{
+		Scope:    scope,
+		Hash:     hash,
+		EdgeName: edgeName,
+		After:    after,
+		Limit:    limit,
+	}, &packed, &compact)
+	if err != nil {
+		return Neighborhood{}, err
+	}
+	if layout == RowLayoutV2 {
+		return Neighborhood{
+			Document:  compact.Document.document(),
+			Edges:     unpackEdgesV2(compact.Edges),
+			Neighbors: unpackDocumentsV2(compact.Neighbors),
+			Next:      compact.Next,
+		}, nil
+	}
+	return Neighborhood{
+		Document:  packed.Document.document(),
+		Edges:     unpackEdges(packed.Edges),
+		Neighbors: unpackDocuments(packed.Neighbors),
+		Next:      packed.Next,
+	}, nil
+}
+
+// computeQuery runs one query action with compute_transaction and decodes its return value
+// into result, or into compact if the contract writes v2 rows; it returns the layout decoded
+func computeQuery(ctx context.Context, api *eos.API, contract, reader eos.AccountName,
+	action string, data interface{}, result interface{}, compact interface{}) (RowLayout, error) {
+
+	layout, err := queryRowLayout(ctx, api, contract)
+	if err != nil {
+		return 0, err
+	}
+	if layout == RowLayoutV2 {
+		result = compact
+	}
+
+	txOpts := &eos.TxOptions{}
+	err = txOpts.FillFromChain(ctx, api)
+	if err != nil {
+		return 0, fmt.Errorf("fill tx options: %v", err)
+	}
+
+	signed, err := signActions(ctx, api, txOpts, []*eos.Action{{
+		Account: contract,
+		Name:    eos.ActN(action),
+		Authorization: []eos.PermissionLevel{
+			{Actor: reader, Permission: eos.PN("active")},
+		},
+		ActionData: eos.NewActionData(data),
+	}})
+	if err != nil {
+		return 0, err
+	}
+
+	returned, err := computeSigned(ctx, api, signed)
+	if err != nil {
+		return 0, fmt.Errorf("%v: %v", action, err)
+	}
+
+	err = eos.NewDecoder(returned).Decode(result)
+	if err != nil {
+		return 0, fmt.Errorf("%v: decode return value: %v", action, err)
+	}
+	return layout, nil
+}
+
+// computeSigned executes a signed transaction without committing it and returns the return
+// value of its first action, or a *ChainError when nodeos rejects it
+func computeSigned(ctx context.Context, api *eos.API, signed []byte) ([]byte, error) {
+	body, err := json.Marshal(struct {
+		Transaction json.RawMessage `json:"transaction"`
+	}{signed})
+	if err != nil {
+		return nil, fmt.Errorf("marshal compute request: %v", err)
+	}
+
+	request, err := http.NewRequestWithContext(ctx, "POST", api.BaseURL+"/v1/chain/compute_transaction", bytes.NewReader(body))
+	if err != nil {
+		return nil, fmt.Errorf("compute transaction: %v", err)
+	}
+	request.Header.Set("Content-Type", "application/json")
+
+	resp, err := api.HttpClient.Do(request)
+	if err != nil {
+		return nil, fmt.Errorf("compute transaction: %v", err)
+	}
+	defer resp.Body.Close()
+
+	data, err := ioutil.ReadAll(resp.Body)
+	if err != nil {
+		return nil, fmt.Errorf("read compute response: %v", err)
+	}
+	if resp.StatusCode >= 300 {
+		var failed struct {
+			Error ChainError `json:"error"`
+		}
+		if json.Unmarshal(data, &failed) != nil || failed.Error.Name == "" {
+			return nil, fmt.Errorf("compute transaction: %v", string(data))
+		}
+		return nil, &failed.Error
+	}
+
+	var computed struct {
+		Processed struct {
+			Except       *ChainError `json:"except"`
+			ActionTraces []struct {
+				ReturnValueHexData string `json:"return_value_hex_data"`
+			} `json:"action_traces"`
+		} `json:"processed"`
+	}
+	err = json.Unmarshal(data, &computed)
+	if err != nil {
+		return nil, fmt.Errorf("unmarshal compute response: %v", err)
+	}
+	if computed.Processed.Except != nil {
+		return nil, computed.Processed.Except
+	}
+	if len(computed.Processed.ActionTraces) == 0 {
+		return nil, fmt.Errorf("compute transaction: no action trace")
+	}
+	return hex.DecodeString(computed.Processed.ActionTraces[0].ReturnValueHexData)
+}
@@ -0,0 +1,183 @@
+package docgraph
+
+import (
+	"context"
+	"fmt"
+	"time"
+
+	eos "github.com/eoscanada/eos-go"
+)
+
+// RowLayout is how a contract packs its documents and edges rows. A contract built with
+// DOCUMENT_GRAPH_COMPACT_ROWS writes RowLayoutV2 and still reads RowLayoutV1 rows until the
+// compactdocs and compactedges actions have rewritten them.
+type RowLayout int
+
+const (
+	// RowLayoutV1 stores the contract in every row, the three derived index keys in edge rows
+	// and created times in microseconds
+	RowLayoutV1 RowLayout = iota + 1
+	// RowLayoutV2 leaves the contract and the derived keys out and stores created times as
+	// block timestamps
+	RowLayoutV2
+)
+
+// sizes of an edges row, and of what follows the certificates in a documents row
+const (
+	edgeRowSizeV1      = 128
+	edgeRowSizeV2      = 92
+	documentTailSizeV1 = 16
+	documentTailSizeV2 = 4
+)
+
+// packed layouts of the contract's Document and Edge, which differ from the table JSON
+type packedCertificate struct {
+	Certifier         eos.AccountName
+	Notes             string
+	CertificationDate eos.TimePoint
+}
+
+type packedDocument struct {
+	ID            uint64
+	Hash          eos.Checksum256
+	Creator       eos.AccountName
+	ContentGroups []ContentGroup
+	Certificates  []packedCertificate
+	CreatedDate   eos.TimePoint
+	Contract      eos.AccountName
+}
+
+type packedDocumentV2 struct {
+	ID            uint64
+	Hash          eos.Checksum256
+	Creator       eos.AccountName
+	ContentGroups []ContentGroup
+	Certificates  []packedCertificate
+	CreatedDate   eos.BlockTimestamp
+}
+
+type packedEdge struct {
+	ID                  uint64
+	FromNodeEdgeNameKey uint64
+	FromNodeToNodeKey   uint64
+	ToNodeEdgeNameKey   uint64
+	FromNode            eos.Checksum256
+	ToNode              eos.Checksum256
+	EdgeName            eos.Name
+	CreatedDate         eos.TimePoint
+	Creator             eos.AccountName
+	Contract            eos.AccountName
+}
+
+type packedEdgeV2 struct {
+	ID          uint64
+	FromNode    eos.Checksum256
+	ToNode      eos.Checksum256
+	EdgeName    eos.Name
+	CreatedDate eos.BlockTimestamp
+	Creator     eos.AccountName
+}
+
+func blockTimestamp(t eos.TimePoint) eos.BlockTimestamp {
+	return eos.BlockTimestamp{Time: time.Unix(0, int64(t)*int64(time.Microsecond)).UTC()}
+}
+
+func newDocument(id uint64, hash eos.Checksum256, creator eos.AccountName, contentGroups []ContentGroup,
+	certificates []packedCertificate, created eos.BlockTimestamp) Document {
+
+	d := Document{
+		ID:            id,
+		Hash:          hash,
+		Creator:       creator,
+		ContentGroups: contentGroups,
+		CreatedDate:   created,
+	}
+	for _, c := range certificates {
+		d.Certificates = append(d.Certificates, struct {
+			Certifier         eos.AccountName    `json:"certifier"`
+			Notes             string             `json:"notes"`
+			CertificationDate eos.BlockTimestamp `json:"certification_date"`
+		}{c.Certifier, c.Notes, blockTimestamp(c.CertificationDate)})
+	}
+	return d
+}
+
+func (p *packedDocument) document() Document {
+	return newDocument(p.ID, p.Hash, p.Creator, p.ContentGroups, p.Certificates, blockTimestamp(p.CreatedDate))
+}
+
+func (p *packedDocumentV2) document() Document {
+	return newDocument(p.ID, p.Hash, p.Creator, p.ContentGroups, p.Certificates, p.CreatedDate)
+}
+
+func (p *packedEdge) edge() Edge {
+	return Edge{
+		ID:          p.ID,
+		FromNode:    p.FromNode,
+		ToNode:      p.ToNode,
+		EdgeName:    p.EdgeName,
+		CreatedDate: blockTimestamp(p.CreatedDate),
+	}
+}
+
+func (p *packedEdgeV2) edge() Edge {
+	return Edge{
+		ID:          p.ID,
+		FromNode:    p.FromNode,
+		ToNode:      p.ToNode,
+		EdgeName:    p.EdgeName,
+		CreatedDate: p.CreatedDate,
+	}
+}
+
+// DecodeEdgeRow decodes a packed edges row, e.g. one written by ExportTable with ExportBinary,
+// in either layout; edge rows have a fixed size in each
+func DecodeEdgeRow(row []byte) (Edge, error) {
+	switch len(row) {
+	case edgeRowSizeV1:
+		var packed packedEdge
+		if err := eos.NewDecoder(row).Decode(&packed); err != nil {
+			return Edge{}, fmt.Errorf("decode v1 edge row: %v", err)
+		}
+		return packed.edge(), nil
+	case edgeRowSizeV2:
+		var packed packedEdgeV2
+		if err := eos.NewDecoder(row).Decode(&packed); err != nil {
+			return Edge{}, fmt.Errorf("decode v2 edge row: %v", err)
+		}
+		return packed.edge(), nil
+	}
+	return Edge{}, fmt.Errorf("edge row of %d bytes has an unknown layout", len(row))
+}
+
+// DecodeDocumentRow decodes a packed documents row in either layout. Both layouts are the same
+// up to the certificates and a v2 row ends too early for the v1 tail, so v1 is tried first.
+func DecodeDocumentRow(row []byte) (Document, error) {
+	var packed packedDocument
+	if err := eos.NewDecoder(row).Decode(&packed); err == nil {
+		return packed.document(), nil
+	}
+
+	var compact packedDocumentV2
+	if err := eos.NewDecoder(row).Decode(&compact); err != nil {
+		return Document{}, fmt.Errorf("decode document row: %v", err)
+	}
+	return compact.document(), nil
+}
+
+// ContractRowLayout reads the row layout a contract writes from its ABI: only v1 edge rows have
+// the derived index keys
+func ContractRowLayout(ctx context.Context, api *eos.API, contract eos.AccountName) (RowLayout, error) {
+	abi, err := api.GetABI(ctx, contract)
+	if err != nil {
+		return 0, fmt.Errorf("get abi of %v: %v", contract, err)
+	}
+	for _, s := range abi.ABI.Structs {
+		for _, field := range s.Fields {
+			if field.Name == "from_node_edge_name_index" {
+				return RowLayoutV1, nil
+			}
+		}
+	}
+	return RowLayoutV2, nil
+}
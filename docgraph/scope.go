@@ -0,0 +1,187 @@
+package docgraph
+
+import (
+	"context"
+	"fmt"
+
+	eostest "github.com/digital-scarcity/eos-go-test"
+	eos "github.com/eoscanada/eos-go"
+)
+
+// A contract can keep several graphs, one per scope, e.g. one per DAO sharing the contract. Each
+// scope has its own documents, edges and journal tables and index trees, so listing, exporting or
+// erasing a scope only visits its own rows. Edges are stored in the scope they are created in and
+// may point to documents of any scope.
+
+type createDocumentIn struct {
+	Scope         eos.AccountName `json:"scope"`
+	Creator       eos.AccountName `json:"creator"`
+	ContentGroups []ContentGroup  `json:"content_groups"`
+}
+
+type newEdgeIn struct {
+	Scope    eos.AccountName `json:"scope"`
+	Creator  eos.AccountName `json:"creator"`
+	FromNode eos.Checksum256 `json:"from_node"`
+	ToNode   eos.Checksum256 `json:"to_node"`
+	EdgeName eos.Name        `json:"edge_name"`
+}
+
+type removeEdgeIn struct {
+	Scope    eos.AccountName `json:"scope"`
+	FromNode eos.Checksum256 `json:"from_node"`
+	ToNode   eos.Checksum256 `json:"to_node"`
+	EdgeName eos.Name        `json:"edge_name"`
+}
+
+type eraseIn struct {
+	Scope eos.AccountName `json:"scope"`
+	Hash  eos.Checksum256 `json:"hash"`
+}
+
+type eraseScope struct {
+	Scope   eos.AccountName `json:"scope"`
+	MaxRows uint64          `json:"max_rows"`
+}
+
+// CreateDocumentIn creates a document in the graph kept in scope
+func CreateDocumentIn(ctx context.Context, api *eos.API,
+	contract, scope, creator eos.AccountName,
+	contentGroups []ContentGroup) (Document, error) {
+
+	hash, err := HashContents(contentGroups)
+	if err != nil {
+		return Document{}, fmt.Errorf("hash contents: %v", err)
+	}
+
+	actions := []*eos.Action{CreateDocumentInAction(contract, scope, creator, contentGroups)}
+	_, err = eostest.ExecTrx(ctx, api, actions)
+	if err != nil {
+		return Document{}, fmt.Errorf("execute transaction %v: %v", hash.String(), err)
+	}
+
+	return Document{
+		Hash:          hash,
+		Creator:       creator,
+		ContentGroups: contentGroups,
+	}, nil
+}
+
+// CreateDocumentInAction returns the action that creates a document in scope
+func CreateDocumentInAction(contract, scope, creator eos.AccountName, contentGroups []ContentGroup) *eos.Action {
+	return &eos.Action{
+		Account: contract,
+		Name:    eos.ActN("createin"),
+		Authorization: []eos.PermissionLevel{
+			{Actor: creator, Permission: eos.PN("active")},
+		},
+		ActionData: eos.NewActionData(createDocumentIn{
+			Scope:         scope,
+			Creator:       creator,
+			ContentGroups: contentGroups,
+		}),
+	}
+}
+
+// CreateEdgeInAction returns the action that creates an edge in scope; the nodes may be documents
+// of any scope
+func CreateEdgeInAction(contract, scope, creator eos.AccountName,
+	fromNode, toNode eos.Checksum256, edgeName eos.Name) *eos.Action {
+
+	return &eos.Action{
+		Account: contract,
+		Name:    eos.ActN("newedgein"),
+		Authorization: []eos.PermissionLevel{
+			{Actor: creator, Permission: eos.PN("active")},
+		},
+		ActionData: eos.NewActionData(newEdgeIn{
+			Scope:    scope,
+			Creator:  creator,
+			FromNode: fromNode,
+			ToNode:   toNode,
+			EdgeName: edgeName,
+		}),
+	}
+}
+
+// RemoveEdgeInAction returns the action that removes an edge stored in scope
+func RemoveEdgeInAction(contract, scope eos.AccountName, fromHash, toHash eos.Checksum256, edgeName eos.Name) *eos.Action {
+	return &eos.Action{
+		Account: contract,
+		Name:    eos.ActN("removeedgein"),
+		Authorization: []eos.PermissionLevel{
+			{Actor: contract, Permission: eos.PN("active")},
+		},
+		ActionData: eos.NewActionData(removeEdgeIn{
+			Scope:    scope,
+			FromNode: fromHash,
+			ToNode:   toHash,
+			EdgeName: edgeName,
+		}),
+	}
+}
+
+// EraseDocumentInAction returns the action that erases a document of scope and its edges in scope
+func EraseDocumentInAction(contract, scope eos.AccountName, hash eos.Checksum256) *eos.Action {
+	return &eos.Action{
+		Account: contract,
+		Name:    eos.ActN("erasein"),
+		Authorization: []eos.PermissionLevel{
+			{Actor: contract, Permission: eos.PN("active")},
+		},
+		ActionData: eos.NewActionData(eraseIn{
+			Scope: scope,
+			Hash:  hash,
+		}),
+	}
+}
+
+// EraseScope erases up to maxRows rows of the graph kept in scope; push it until
+// ScopeIsEmpty reports the scope empty
+func EraseScope(ctx context.Context, api *eos.API,
+	contract, scope eos.AccountName, maxRows uint64) (string, error) {
+
+	actions := []*eos.Action{{
+		Account: contract,
+		Name:    eos.ActN("erasescope"),
+		Authorization: []eos.PermissionLevel{
+			{Actor: contract, Permission: eos.PN("active")},
+		},
+		ActionData: eos.NewActionData(eraseScope{
+			Scope:   scope,
+			MaxRows: maxRows,
+		}),
+	}}
+	return eostest.ExecTrx(ctx, api, actions)
+}
+
+// ScopeIsEmpty reports whether the graph kept in scope has no documents or edges left; the
+// journal of the scope is kept by EraseScope
+func ScopeIsEmpty(ctx context.Context, api *eos.API, contract, scope eos.AccountName) (bool, error) {
+	for _, table := range []string{"edges", "docversions", "docheads", "documents", "docsbyhash"} {
+		var request eos.GetTableRowsRequest
+		request.Code = string(contract)
+		request.Scope = string(scope)
+		request.Table = table
+		request.Limit = 1
+		request.JSON = true
+		response, err := api.GetTableRows(ctx, request)
+		if err != nil && table == "docsbyhash" {
+			// the ABI of a legacy build may not declare the keyed table
+			continue
+		}
+		if err != nil {
+			return false, fmt.Errorf("get table rows %v: %v", table, err)
+		}
+
+		var rows []map[string]interface{}
+		err = response.JSONToStructs(&rows)
+		if err != nil {
+			return false, fmt.Errorf("json to structs %v: %v", table, err)
+		}
+		if len(rows) > 0 {
+			return false, nil
+		}
+	}
+	return true, nil
+}
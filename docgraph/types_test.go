@@ -1,9 +1,11 @@
 package docgraph
 
 import (
+	"encoding/hex"
 	"encoding/json"
 	"io/ioutil"
 	"testing"
+	"time"
 
 	eos "github.com/eoscanada/eos-go"
 	"github.com/stretchr/testify/require"
@@ -320,3 +322,230 @@ func TestDocumentInEquality(t *testing.T) {
 		})
 	}
 }
+
+func TestDocumentKey(t *testing.T) {
+	tests := []struct {
+		name string
+		hash string
+		key  uint64
+	}{
+		{
+			name: "first 8 bytes",
+			hash: "2867b68741bf31331220ed7fd433069731749bd593aeef83c81ff3db190f1eec",
+			key:  0x2867b68741bf3133,
+		},
+		{
+			name: "clamped to probe window",
+			hash: "fffffffffffffff51220ed7fd433069731749bd593aeef83c81ff3db190f1eec",
+			key:  0xffffffffffffffef,
+		},
+	}
+
+	for _, test := range tests {
+		t.Run(test.name, func(t *testing.T) {
+			hash, err := hex.DecodeString(test.hash)
+			require.NoError(t, err)
+			require.Equal(t, test.key, DocumentKey(eos.Checksum256(hash)))
+		})
+	}
+}
+
+func TestEdgeNodeNameKey(t *testing.T) {
+	hash, err := hex.DecodeString("2867b68741bf31331220ed7fd433069731749bd593aeef83c81ff3db190f1eec")
+	require.NoError(t, err)
+
+	tests := []struct {
+		edgeName eos.Name
+		key      uint64
+	}{
+		{edgeName: "assign", key: 0xd3d553b3e1a689aa},
+		{edgeName: "member", key: 0x21f6909fedc52e75},
+	}
+
+	for _, test := range tests {
+		t.Run(string(test.edgeName), func(t *testing.T) {
+			key, err := EdgeNodeNameKey(eos.Checksum256(hash), test.edgeName)
+			require.NoError(t, err)
+			require.Equal(t, test.key, key)
+		})
+	}
+}
+
+// the expected keys were computed with concatHash from the contract's util.cpp; the id is the
+// primary key of the edge in TestEdgeJSONUnmarshal, read from chain
+func TestEdgeKeys(t *testing.T) {
+	fromNode := eos.Checksum256(mustDecodeHex(t, "7463fa7dda551b9c4bbd2ba17b793931c825cefff9eede14461fd1a5c9f07d15"))
+	toNode := eos.Checksum256(mustDecodeHex(t, "d4ec74355830056924c83f20ffb1a22ad0c5145a96daddf6301897a092de951e"))
+
+	tests := []struct {
+		edgeName eos.Name
+		id       uint64
+		fromName uint64
+		toName   uint64
+	}{
+		{edgeName: "memberof", id: 349057277, fromName: 725187621, toName: 392637999},
+		{edgeName: "owns", id: 266706314, fromName: 2391967832, toName: 2267235138},
+		{edgeName: "a.b", id: 3902945913, fromName: 1175066896, toName: 3743897142},
+	}
+
+	for _, test := range tests {
+		t.Run(string(test.edgeName), func(t *testing.T) {
+			require.Equal(t, test.id, EdgeID(fromNode, toNode, test.edgeName))
+			require.Equal(t, test.fromName, EdgeFromNameKey(fromNode, test.edgeName))
+			require.Equal(t, test.toName, EdgeToNameKey(toNode, test.edgeName))
+		})
+	}
+	require.Equal(t, uint64(1094525680), EdgeFromToKey(fromNode, toNode))
+}
+
+// an edge and a document packed in each row layout decode to the same values; the row sizes
+// are what the compact layout saves per row
+func TestRowLayouts(t *testing.T) {
+	fromNode := eos.Checksum256(mustDecodeHex(t, "7463fa7dda551b9c4bbd2ba17b793931c825cefff9eede14461fd1a5c9f07d15"))
+	toNode := eos.Checksum256(mustDecodeHex(t, "d4ec74355830056924c83f20ffb1a22ad0c5145a96daddf6301897a092de951e"))
+	created := eos.BlockTimestamp{Time: time.Date(2020, 10, 16, 14, 11, 37, 500000000, time.UTC)}
+	createdMicros := eos.TimePoint(created.UnixNano() / int64(time.Microsecond))
+
+	v1Edge, err := eos.MarshalBinary(packedEdge{
+		ID:                  EdgeID(fromNode, toNode, "memberof"),
+		FromNodeEdgeNameKey: EdgeFromNameKey(fromNode, "memberof"),
+		FromNodeToNodeKey:   EdgeFromToKey(fromNode, toNode),
+		ToNodeEdgeNameKey:   EdgeToNameKey(toNode, "memberof"),
+		FromNode:            fromNode,
+		ToNode:              toNode,
+		EdgeName:            "memberof",
+		CreatedDate:         createdMicros,
+		Creator:             "johnnyhypha1",
+		Contract:            "docs.hypha",
+	})
+	require.NoError(t, err)
+	v2Edge, err := eos.MarshalBinary(packedEdgeV2{
+		ID:          EdgeID(fromNode, toNode, "memberof"),
+		FromNode:    fromNode,
+		ToNode:      toNode,
+		EdgeName:    "memberof",
+		CreatedDate: created,
+		Creator:     "johnnyhypha1",
+	})
+	require.NoError(t, err)
+	require.Len(t, v1Edge, edgeRowSizeV1)
+	require.Len(t, v2Edge, edgeRowSizeV2)
+
+	v1, err := DecodeEdgeRow(v1Edge)
+	require.NoError(t, err)
+	v2, err := DecodeEdgeRow(v2Edge)
+	require.NoError(t, err)
+	require.Equal(t, v1.ID, v2.ID)
+	require.Equal(t, v1.FromNode, v2.FromNode)
+	require.Equal(t, v1.ToNode, v2.ToNode)
+	require.Equal(t, v1.EdgeName, v2.EdgeName)
+	require.True(t, v1.CreatedDate.Equal(created.Time))
+	require.True(t, v2.CreatedDate.Equal(created.Time))
+
+	_, err = DecodeEdgeRow(v2Edge[:len(v2Edge)-1])
+	require.Error(t, err)
+
+	certificates := []packedCertificate{{Certifier: "dao.hypha", Notes: "certification notes", CertificationDate: createdMicros}}
+	hash := eos.Checksum256(mustDecodeHex(t, "05e81010c4600ed5d978d2ddf22420ffdf6c4094f4b3822711f0596c7c342ccb"))
+	v1Document, err := eos.MarshalBinary(packedDocument{
+		ID:            24,
+		Hash:          hash,
+		Creator:       "johnnyhypha1",
+		ContentGroups: []ContentGroup{},
+		Certificates:  certificates,
+		CreatedDate:   createdMicros,
+		Contract:      "docs.hypha",
+	})
+	require.NoError(t, err)
+	v2Document, err := eos.MarshalBinary(packedDocumentV2{
+		ID:            24,
+		Hash:          hash,
+		Creator:       "johnnyhypha1",
+		ContentGroups: []ContentGroup{},
+		Certificates:  certificates,
+		CreatedDate:   created,
+	})
+	require.NoError(t, err)
+	require.Equal(t, documentTailSizeV1-documentTailSizeV2, len(v1Document)-len(v2Document))
+
+	d1, err := DecodeDocumentRow(v1Document)
+	require.NoError(t, err)
+	d2, err := DecodeDocumentRow(v2Document)
+	require.NoError(t, err)
+	require.Equal(t, d1.Hash, d2.Hash)
+	require.Equal(t, d1.Creator, d2.Creator)
+	require.Len(t, d2.Certificates, 1)
+	require.True(t, d1.CreatedDate.Equal(created.Time))
+	require.True(t, d2.CreatedDate.Equal(created.Time))
+
+	const edges, documents = 1000000, 100000
+	saved := edges*(edgeRowSizeV1-edgeRowSizeV2) + documents*(documentTailSizeV1-documentTailSizeV2)
+	t.Logf("edge row %d -> %d bytes, document row %d -> %d bytes", len(v1Edge), len(v2Edge), len(v1Document), len(v2Document))
+	t.Logf("%d edges and %d documents: %.1f MiB less row data", edges, documents, float64(saved)/(1<<20))
+}
+
+func mustDecodeHex(t *testing.T, s string) []byte {
+	data, err := hex.DecodeString(s)
+	require.NoError(t, err)
+	return data
+}
+
+// the expected hashes were computed with Document::hashContents from the contract
+func TestHashContents(t *testing.T) {
+	tests := []struct {
+		input string
+		hash  string
+	}{
+		{input: "../test/examples/simplest.json", hash: "ad10b49437f75ca3bbc3b762fa4e2c10286c3ece22b08f9d9313d5646ebd0e79"},
+		{input: "../test/examples/each-type.json", hash: "c0b0e48a9cd1b73ac924cf58a430abd5d3091ca7cbcda6caf5b7e7cebb379327"},
+		{input: "../test/examples/contribution.json", hash: "e9df2eccc7e9f5cb35c41f0f16ba265ac599b04a47fd82ce54e7a1e4ac898639"},
+		{input: "../test/examples/compliance-tags.json", hash: "b0c49c8c6dd3309e580b7cdbf7f1c6108c7ad4debde37223e22e89432ff97fbf"},
+	}
+
+	for _, test := range tests {
+		t.Run(test.input, func(t *testing.T) {
+			data, err := ioutil.ReadFile(test.input)
+			require.NoError(t, err)
+
+			var d Document
+			err = json.Unmarshal(data, &d)
+			require.NoError(t, err)
+
+			hash, err := HashContents(d.ContentGroups)
+			require.NoError(t, err)
+			require.Equal(t, test.hash, hash.String())
+		})
+	}
+}
+
+func TestFingerprint(t *testing.T) {
+	contentGroups := []ContentGroup{{
+		{Label: "empty", Value: &FlexValue{BaseVariant: eos.BaseVariant{TypeID: FlexValueVariant.TypeID("monostate"), Impl: int64(0)}}},
+		{Label: "who", Value: &FlexValue{BaseVariant: eos.BaseVariant{TypeID: FlexValueVariant.TypeID("name"), Impl: "alice"}}},
+		{Label: "count", Value: &FlexValue{BaseVariant: eos.BaseVariant{TypeID: FlexValueVariant.TypeID("int64"), Impl: int64(-7)}}},
+	}, {
+		{Label: "when", Value: &FlexValue{BaseVariant: eos.BaseVariant{TypeID: FlexValueVariant.TypeID("time_point"), Impl: eos.TimePoint(1580389200500000)}}},
+	}}
+
+	fingerprint, err := Fingerprint(contentGroups)
+	require.NoError(t, err)
+	require.Equal(t, "[[,{who=[name,alice]},{count=[int64,-7]}],[{when=[time_point,1580389200]}]]", fingerprint)
+}
+
+func TestAssetString(t *testing.T) {
+	tests := []struct {
+		asset    eos.Asset
+		expected string
+	}{
+		{asset: eos.Asset{Amount: 13000, Symbol: eos.Symbol{Precision: 2, Symbol: "USD"}}, expected: "130.00 USD"},
+		{asset: eos.Asset{Amount: 5, Symbol: eos.Symbol{Precision: 4, Symbol: "SEEDS"}}, expected: "0.0005 SEEDS"},
+		{asset: eos.Asset{Amount: -150, Symbol: eos.Symbol{Precision: 2, Symbol: "USD"}}, expected: "-1.50 USD"},
+		{asset: eos.Asset{Amount: 42, Symbol: eos.Symbol{Precision: 0, Symbol: "TOK"}}, expected: "42 TOK"},
+	}
+
+	for _, test := range tests {
+		t.Run(test.expected, func(t *testing.T) {
+			require.Equal(t, test.expected, assetString(test.asset))
+		})
+	}
+}
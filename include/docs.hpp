@@ -6,6 +6,10 @@
 
 #include <document_graph/content_group.hpp>
 #include <document_graph/document_graph.hpp>
+#include <document_graph/instrumentation.hpp>
+#include <document_graph/journal.hpp>
+#include <document_graph/gc.hpp>
+#include <document_graph/query.hpp>
 
 using namespace eosio;
 
@@ -31,10 +35,74 @@ namespace hypha
 
       ACTION erase(const checksum256 &hash);
 
+      ACTION update(const name &updater, const checksum256 &hash, ContentGroups &content_groups);
+
+      // the same operations on the graph kept in scope, e.g. one per tenant; an edge is stored in the
+      // scope it is created in, its nodes may be documents of any scope
+      ACTION createin(const name &scope, name &creator, ContentGroups &content_groups);
+      ACTION newedgein(const name &scope, name &creator, const checksum256 &from_node, const checksum256 &to_node, const name &edge_name);
+      ACTION removeedgein(const name &scope, const checksum256 &from_node, const checksum256 &to_node, const name &edge_name);
+      ACTION erasein(const name &scope, const checksum256 &hash);
+
+      // erases up to max_rows rows of the graph in scope; push repeatedly until the scope is empty.
+      // The erases are journaled and the journal is kept, prunejrnlin prunes it afterwards
+      ACTION erasescope(const name &scope, const uint64_t &max_rows);
+
+      // adds time-ordered index entries to edges of scope stored before those indexes existed;
+      // push with the printed next id as from_id until the edges table has been covered
+      ACTION reindexedges(const name &scope, const uint64_t &from_id, const uint64_t &max_rows);
+
+#ifdef DOCUMENT_GRAPH_KEYED_DOCUMENTS
+      // moves up to max_rows documents of scope from the legacy 'documents' table to 'docsbyhash';
+      // push repeatedly until the scope's legacy table is empty
+      ACTION migratedocs(const name &scope, const uint64_t &max_rows);
+#endif
+
+#ifdef DOCUMENT_GRAPH_COMPACT_ROWS
+      // rewrite up to max_rows documents or edges of scope in the v2 row layout, starting at primary
+      // key from_id; push with increasing from_id until the table has been covered
+      ACTION compactdocs(const name &scope, const uint64_t &from_id, const uint64_t &max_rows);
+      ACTION compactedges(const name &scope, const uint64_t &from_id, const uint64_t &max_rows);
+#endif
+
+#ifdef DOCUMENT_GRAPH_JOURNAL
+      // erases up to max_rows journal entries with a sequence below before_sequence, oldest first;
+      // the newest entry is always kept
+      ACTION prunejournal(const uint64_t &before_sequence, const uint64_t &max_rows);
+
+      // the same for the journal of a scope's graph
+      ACTION prunejrnlin(const name &scope, const uint64_t &before_sequence, const uint64_t &max_rows);
+#endif
+
+#ifdef DOCUMENT_GRAPH_GC
+      // starts a garbage collection of the graph in scope that keeps what is reachable from roots
+      // along edges named in edge_names, or any edge if empty; with dry_run, nothing is erased and
+      // the 'gcstate' row reports what would have been
+      ACTION gcstart(const name &scope, const std::vector<checksum256> &roots, const std::vector<name> &edge_names, const bool &dry_run);
+
+      // advances the collection by up to max_rows rows; push repeatedly until the phase is 'done'
+      ACTION gcstep(const name &scope, const uint64_t &max_rows);
+#endif
+
+#ifdef DOCUMENT_GRAPH_QUERY_ACTIONS
+      // read-only queries of the graph in scope that return their result as the action return value;
+      // they write nothing and check no authority, run them with compute_transaction
+      [[eosio::action]] Document getdoc(const name &scope, const checksum256 &hash);
+      [[eosio::action]] std::vector<Document> getdocs(const name &scope, const std::vector<checksum256> &hashes);
+      [[eosio::action]] EdgePage getedges(const name &scope, const checksum256 &node, const name &edge_name, const bool &incoming,
+                                          const std::optional<EdgeCursor> &after, const uint32_t &limit);
+      [[eosio::action]] Neighborhood neighbors(const name &scope, const checksum256 &hash, const name &edge_name,
+                                               const std::optional<EdgeCursor> &after, const uint32_t &limit);
+#endif
+
       ACTION testgetasset(const checksum256 &hash,
                           const string &groupLabel,
                           const string &contentLabel,
                           const asset &contentValue);
+
+      // decodes content_groups with a test schema, encodes the values and decodes them again,
+      // failing with the schema's mismatch report if the contents do not fit it
+      ACTION testschema(const ContentGroups &content_groups);
       // // Fork creates a new document (node in a graph) from an existing document.
       // // The forked content should contain only new or updated entries to avoid data duplication. (lazily enforced?)
       // ACTION fork(const checksum256 &hash, const name &creator, const vector<document_graph::content_group> &content_groups);
@@ -48,6 +116,12 @@ namespace hypha
       // ACTION reset();
 
    private:
+      DocumentGraph scoped(const name &scope);
+
+#ifdef DOCUMENT_GRAPH_STABLE_IDENTITIES
+      DocumentGraph m_dg = DocumentGraph(get_self(), true);
+#else
       DocumentGraph m_dg = DocumentGraph(get_self());
+#endif
    };
 } // namespace hypha
\ No newline at end of file
@@ -24,6 +24,8 @@ namespace hypha
         EOSLIB_SERIALIZE(Certificate, (certifier)(notes)(certification_date))
     };
 
+    struct DocumentTables;
+
     // TODO: need to move the contract ABI generator tag to a Macro
     struct [[eosio::table, eosio::contract("docs")]] Document
     {
@@ -38,15 +40,40 @@ namespace hypha
 
         // this constructor reads the hash from the table and populates the object from storage
         Document(eosio::name contract, const eosio::checksum256 &hash);
+        Document(DocumentTables &tables, const eosio::checksum256 &hash);
         ~Document();
 
         void emplace();
+        void emplace(DocumentTables &tables);
 
         static Document getOrNew(eosio::name contract, eosio::name creator, ContentGroups contentGroups);
         static Document getOrNew(eosio::name contract, eosio::name creator, ContentGroup contentGroup);
         static Document getOrNew(eosio::name contract, eosio::name creator, Content content);
         static Document getOrNew(eosio::name contract, eosio::name creator, const std::string &label, const Content::FlexValue &value);
 
+        static bool exists(eosio::name contract, const eosio::checksum256 &hash);
+        static bool exists(DocumentTables &tables, const eosio::checksum256 &hash);
+        static void erase(eosio::name contract, const eosio::checksum256 &hash);
+        static void erase(DocumentTables &tables, const eosio::checksum256 &hash);
+
+        // primary key used by the keyed table layout, derived from the first 8 bytes of the hash
+        static uint64_t hashKey(const eosio::checksum256 &hash);
+
+        // number of consecutive primary keys, starting at hashKey, that may hold a given hash
+        static constexpr uint64_t MAX_KEY_PROBES = 16;
+
+#ifdef DOCUMENT_GRAPH_KEYED_DOCUMENTS
+        // moves up to maxRows documents from the legacy idhash-indexed table to the keyed table
+        static uint64_t migrate(eosio::name contract, const uint64_t maxRows);
+        static uint64_t migrate(eosio::name contract, eosio::name scope, const uint64_t maxRows);
+#endif
+
+#ifdef DOCUMENT_GRAPH_COMPACT_ROWS
+        // rewrites up to maxRows documents of scope starting at primary key fromId in the v2 layout,
+        // in the table documents are emplaced in; returns the next id to continue from
+        static uint64_t compact(eosio::name contract, eosio::name scope, const uint64_t fromId, const uint64_t maxRows);
+#endif
+
         // certificates are not yet used
         void certify(const eosio::name &certifier, const std::string &notes);
 
@@ -59,21 +86,37 @@ namespace hypha
 
         const ContentGroups &getContentGroups() const { return content_groups; } // should this be const?
         const eosio::checksum256 &getHash() const { return hash; }
-        const eosio::time_point &getCreated() const { return created_date; }
+        eosio::time_point getCreated() const { return created_date; }
         const eosio::name &getCreator() const { return creator; }
 
+        // a documents row has one of two layouts, which only differ after the certificates: v1 ends
+        // with the created time in microseconds and the contract, v2 (DOCUMENT_GRAPH_COMPACT_ROWS)
+        // with the created time in block slots. Both are read, the build's own is written.
+        static constexpr uint32_t V1_TAIL_SIZE = 16;
+        static constexpr uint32_t V2_TAIL_SIZE = 4;
+
     private:
+        // reads the stored row for _hash into this instance; returns false if it is not stored
+        bool load(DocumentTables &tables, const eosio::checksum256 &_hash);
+
         // members, with names as serialized - these must be public for EOSIO tables
         std::uint64_t id;
         eosio::checksum256 hash;
         eosio::name creator;
         ContentGroups content_groups;
         std::vector<Certificate> certificates;
+#ifdef DOCUMENT_GRAPH_COMPACT_ROWS
+        eosio::block_timestamp created_date;
+#else
         eosio::time_point created_date;
         eosio::name contract;
+#endif
+
+        // compact rows leave the contract out, as it is always the contract that is running
+        eosio::name getContract() const;
 
         // indexes for table
-        uint64_t by_created() const { return created_date.sec_since_epoch(); }
+        uint64_t by_created() const { return getCreated().sec_since_epoch(); }
         uint64_t by_creator() const { return creator.value; }
         eosio::checksum256 by_hash() const { return hash; }
 
@@ -83,7 +126,41 @@ namespace hypha
         static const std::string toString(ContentGroups & contentGroups);
         static const std::string toString(ContentGroup & contentGroup);
 
-        EOSLIB_SERIALIZE(Document, (id)(hash)(creator)(content_groups)(certificates)(created_date)(contract))
+        template <typename DataStream>
+        friend DataStream &operator<<(DataStream &ds, const Document &d)
+        {
+            ds << d.id << d.hash << d.creator << d.content_groups << d.certificates << d.created_date;
+#ifndef DOCUMENT_GRAPH_COMPACT_ROWS
+            ds << d.contract;
+#endif
+            return ds;
+        }
+
+        // multi_index unpacks each row from a stream of just that row, so the size of the tail is
+        // what is left after the certificates
+        template <typename DataStream>
+        friend DataStream &operator>>(DataStream &ds, Document &d)
+        {
+            ds >> d.id >> d.hash >> d.creator >> d.content_groups >> d.certificates;
+            eosio::check(ds.remaining() == V1_TAIL_SIZE || ds.remaining() == V2_TAIL_SIZE, "document row has an unknown layout");
+            if (ds.remaining() == V1_TAIL_SIZE)
+            {
+#ifdef DOCUMENT_GRAPH_COMPACT_ROWS
+                eosio::time_point created;
+                ds >> created;
+                ds.skip(sizeof(uint64_t));
+                d.created_date = created;
+#else
+                ds >> d.created_date >> d.contract;
+#endif
+                return ds;
+            }
+
+            eosio::block_timestamp created;
+            ds >> created;
+            d.created_date = created;
+            return ds;
+        }
 
     public:
         // for unknown reason, primary_key() must be public
@@ -94,6 +171,32 @@ namespace hypha
                                    eosio::indexed_by<eosio::name("bycreator"), eosio::const_mem_fun<Document, uint64_t, &Document::by_creator>>,
                                    eosio::indexed_by<eosio::name("bycreated"), eosio::const_mem_fun<Document, uint64_t, &Document::by_created>>>
             document_table;
+
+        // keyed layout: the primary key is derived from the hash (see hashKey) and collisions are
+        // resolved by probing the next MAX_KEY_PROBES keys, so lookups use the primary index only
+        typedef eosio::multi_index<eosio::name("docsbyhash"), Document,
+                                   eosio::indexed_by<eosio::name("bycreator"), eosio::const_mem_fun<Document, uint64_t, &Document::by_creator>>,
+                                   eosio::indexed_by<eosio::name("bycreated"), eosio::const_mem_fun<Document, uint64_t, &Document::by_created>>>
+            keyed_document_table;
+    };
+
+    // the tables documents are stored in, opened once so that several lookups can share them; each
+    // scope has its own tables and index trees, the contract's own scope is the default
+    struct DocumentTables
+    {
+        DocumentTables(const eosio::name &contract);
+        DocumentTables(const eosio::name &contract, const eosio::name &scope);
+
+        // the legacy table of a keyed build only shrinks, so once seen empty it stays empty
+        bool hasLegacyRows();
+
+        eosio::name contract;
+        eosio::name scope;
+        Document::document_table documents;
+#ifdef DOCUMENT_GRAPH_KEYED_DOCUMENTS
+        Document::keyed_document_table keyedDocuments;
+        bool legacyEmpty = false;
+#endif
     };
 
 } // namespace hypha
\ No newline at end of file
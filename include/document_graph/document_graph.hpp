@@ -7,32 +7,89 @@
 #include <eosio/multi_index.hpp>
 #include <eosio/name.hpp>
 #include <cstring>
+#include <limits>
+#include <map>
+#include <optional>
 
 #include <document_graph/content.hpp>
 #include <document_graph/document.hpp>
+#include <document_graph/document_head.hpp>
 #include <document_graph/edge.hpp>
 
 namespace hypha
 {
+    // bounds and paging of a time-ordered edge scan
+    struct EdgeRange
+    {
+        // inclusive bounds on created_date
+        eosio::time_point start;
+        eosio::time_point end = eosio::time_point(eosio::microseconds(std::numeric_limits<int64_t>::max()));
+
+        bool newestFirst = true;
+        std::uint32_t limit = 100;
+
+        // continue after this edge, usually the last edge of the previous page
+        std::optional<Edge> after;
+    };
+
     class DocumentGraph
     {
     public:
-        DocumentGraph(const eosio::name &contract) : m_contract(contract) {}
+        DocumentGraph(const eosio::name &contract) : m_contract(contract), m_scope(contract) {}
+
+        // with stable identities, edges point to a document's identity (the hash of its first version)
+        // and an update moves the identity's head instead of rewriting every incident edge
+        DocumentGraph(const eosio::name &contract, const bool stableIdentities)
+            : m_contract(contract), m_scope(contract), m_stableIdentities(stableIdentities) {}
+
+        // a graph whose documents, edges, heads and versions are kept in their own scope, e.g. one per
+        // tenant of a shared contract; lookups and scans only visit the rows of that scope. Edges are
+        // stored in the scope of the graph that creates them and may point to a node of any scope;
+        // with stable identities, versions are only resolved within this scope.
+        DocumentGraph(const eosio::name &contract, const eosio::name &scope, const bool stableIdentities = false)
+            : m_contract(contract), m_scope(scope), m_stableIdentities(stableIdentities) {}
         ~DocumentGraph() {}
 
+        const eosio::name &getContract() const { return m_contract; }
+        const eosio::name &getScope() const { return m_scope; }
+        bool hasStableIdentities() const { return m_stableIdentities; }
+
+        // reads go through a cache keyed by hash, so a document is loaded and verified at most once
+        // per DocumentGraph instance, i.e. per action; writes made through this class keep it current,
+        // documents erased directly with Document::erase in the same action are not seen
+        const Document &getDocument(const eosio::checksum256 &hash);
+        bool documentExists(const eosio::checksum256 &hash);
+        Document createDocument(const eosio::name &creator, ContentGroups contentGroups);
+
         void removeEdges(const eosio::checksum256 &node);
 
+        // erases the edge, failing if it does not exist
+        void removeEdge(const eosio::checksum256 &fromNode, const eosio::checksum256 &toNode, const eosio::name &edgeName);
+
+        // with stable identities, the edge queries and removeEdge accept any version hash of a node
         std::vector<Edge> getEdges(const eosio::checksum256 &fromNode, const eosio::checksum256 &toNode);
         std::vector<Edge> getEdgesOrFail(const eosio::checksum256 &fromNode, const eosio::checksum256 &toNode);
 
+        // every edge from or to the node, whatever its name
+        std::vector<Edge> getEdgesFrom(const eosio::checksum256 &fromNode);
+        std::vector<Edge> getEdgesTo(const eosio::checksum256 &toNode);
+
         std::vector<Edge> getEdgesFrom(const eosio::checksum256 &fromNode, const eosio::name &edgeName);
         std::vector<Edge> getEdgesFromOrFail(const eosio::checksum256 &fromNode, const eosio::name &edgeName);
 
         std::vector<Edge> getEdgesTo(const eosio::checksum256 &toNode, const eosio::name &edgeName);
         std::vector<Edge> getEdgesToOrFail(const eosio::checksum256 &toNode, const eosio::name &edgeName);
 
+        // time-ordered scans over the (node, edge name, created) and (edge name, created) indexes;
+        // a page shorter than range.limit means there are no more matching edges
+        std::vector<Edge> getEdgesFrom(const eosio::checksum256 &fromNode, const eosio::name &edgeName, const EdgeRange &range);
+        std::vector<Edge> getEdgesTo(const eosio::checksum256 &toNode, const eosio::name &edgeName, const EdgeRange &range);
+        std::vector<Edge> getEdgesByName(const eosio::name &edgeName, const EdgeRange &range);
+
         Edge createEdge(eosio::name &creator, const eosio::checksum256 &fromNode, const eosio::checksum256 &toNode, const eosio::name &edgeName);
 
+        // with stable identities, only the current version or the identity can be updated, and not
+        // to the content of any version the identity had before: version hashes are never reused
         Document updateDocument(const eosio::name &updater,
                                 const eosio::checksum256 &doc_hash,
                                 ContentGroups content_groups);
@@ -41,8 +98,41 @@ namespace hypha
         void eraseDocument(const eosio::checksum256 &document_hash);
         void eraseDocument(const eosio::checksum256 &document_hash, const bool includeEdges);
 
+        // stable identities: any version hash resolves to its identity, unknown hashes resolve to themselves
+        eosio::checksum256 getIdentity(const eosio::checksum256 &hash);
+        Document getHead(const eosio::checksum256 &identity);
+
+        // version hashes of an identity, newest first and ending with the identity itself
+        std::vector<eosio::checksum256> getVersions(const eosio::checksum256 &identity);
+
+        // erases up to maxRows rows of this scope, garbage collection state and edges first, then
+        // versions, heads and documents, and returns the number erased; call again until it returns 0.
+        // The cost depends on the size of this scope only. Edges stored in other scopes that point
+        // into this one are not touched. Each erased document and edge is journaled and the journal
+        // of the scope is kept, so its sequence numbers never restart; prune it with journal::prune
+        // once indexers have read the erases.
+        uint64_t eraseScope(const uint64_t maxRows);
+
     private:
+        Document updateVersion(const eosio::name &updater,
+                               const eosio::checksum256 &documentHash,
+                               ContentGroups contentGroups);
+        void eraseIdentity(const eosio::checksum256 &identity, const bool includeEdges);
+
+        // the hash edges of the node are stored under: its identity with stable identities, else itself
+        eosio::checksum256 resolveNode(const eosio::checksum256 &hash);
+
+        DocumentTables &getDocumentTables();
+        Edge::edge_table &getEdgeTable();
+
         eosio::name m_contract;
+        eosio::name m_scope;
+        bool m_stableIdentities = false;
+
+        // opened on first use and shared by all methods for the lifetime of this instance
+        std::optional<DocumentTables> m_documentTables;
+        std::optional<Edge::edge_table> m_edgeTable;
+        std::map<eosio::checksum256, Document> m_documents;
     };
 }; // namespace hypha
 
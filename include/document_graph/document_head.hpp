@@ -0,0 +1,48 @@
+#pragma once
+#include <eosio/multi_index.hpp>
+#include <eosio/name.hpp>
+#include <eosio/time.hpp>
+#include <eosio/crypto.hpp>
+
+namespace hypha
+{
+    // maps a stable document identity, the hash of its first version, to its current version
+    struct [[eosio::table, eosio::contract("docs")]] DocumentHead
+    {
+        std::uint64_t id;
+        eosio::checksum256 identity;
+        eosio::checksum256 head;
+        std::uint64_t version;
+        eosio::name updater;
+        eosio::time_point updated_date;
+
+        uint64_t primary_key() const { return id; }
+        eosio::checksum256 by_identity() const { return identity; }
+
+        EOSLIB_SERIALIZE(DocumentHead, (id)(identity)(head)(version)(updater)(updated_date))
+
+        typedef eosio::multi_index<eosio::name("docheads"), DocumentHead,
+                                   eosio::indexed_by<eosio::name("byidentity"), eosio::const_mem_fun<DocumentHead, eosio::checksum256, &DocumentHead::by_identity>>>
+            head_table;
+    };
+
+    // one link in the version chain of an identity; version 0 is the identity itself and has no link
+    struct [[eosio::table, eosio::contract("docs")]] DocumentVersion
+    {
+        std::uint64_t id;
+        eosio::checksum256 hash;
+        eosio::checksum256 identity;
+        eosio::checksum256 previous;
+        std::uint64_t version;
+
+        uint64_t primary_key() const { return id; }
+        eosio::checksum256 by_hash() const { return hash; }
+
+        EOSLIB_SERIALIZE(DocumentVersion, (id)(hash)(identity)(previous)(version))
+
+        typedef eosio::multi_index<eosio::name("docversions"), DocumentVersion,
+                                   eosio::indexed_by<eosio::name("byhash"), eosio::const_mem_fun<DocumentVersion, eosio::checksum256, &DocumentVersion::by_hash>>>
+            version_table;
+    };
+
+} // namespace hypha
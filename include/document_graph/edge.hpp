@@ -20,9 +20,13 @@ namespace hypha
         const eosio::checksum256 &getFromNode() { return from_node; }
         const eosio::checksum256 &getToNode() { return to_node; }
         const eosio::name &getEdgeName() { return edge_name; }
-        const eosio::time_point &getCreated() { return created_date; }
+        eosio::time_point getCreated() const { return created_date; }
         const eosio::name &getCreator() { return creator; }
 
+        // the contract whose tables the edge is stored in; compact rows leave it out, as it is
+        // always the contract that is running
+        eosio::name getContract() const;
+
         static Edge get(const eosio::name &contract,
                         const eosio::checksum256 &from_node,
                         const eosio::checksum256 &to_node,
@@ -37,20 +41,66 @@ namespace hypha
                            const eosio::checksum256 &_to_node,
                            const eosio::name &_edge_name);
 
+        // the same lookups in the edges table of a scope; the overloads above use the contract's scope
+        static Edge get(const eosio::name &contract,
+                        const eosio::name &scope,
+                        const eosio::checksum256 &from_node,
+                        const eosio::checksum256 &to_node,
+                        const eosio::name &edge_name);
+
+        static Edge get(const eosio::name &contract,
+                        const eosio::name &scope,
+                        const eosio::checksum256 &from_node,
+                        const eosio::name &edge_name);
+
+        static bool exists(const eosio::name &contract,
+                           const eosio::name &scope,
+                           const eosio::checksum256 &from_node,
+                           const eosio::checksum256 &to_node,
+                           const eosio::name &edge_name);
+
+        // re-emplaces up to max_rows edges starting at primary key from_id so that rows stored before
+        // the time-ordered indexes existed get index entries; returns the next id to continue from
+        static uint64_t reindex(const eosio::name &contract, const uint64_t from_id, const uint64_t max_rows);
+        static uint64_t reindex(const eosio::name &contract, const eosio::name &scope, const uint64_t from_id, const uint64_t max_rows);
+
+#ifdef DOCUMENT_GRAPH_COMPACT_ROWS
+        // rewrites up to max_rows edges of scope starting at primary key from_id in the v2 layout;
+        // index entries are unchanged. Returns the next id to continue from
+        static uint64_t compact(const eosio::name &contract, const eosio::name &scope, const uint64_t from_id, const uint64_t max_rows);
+#endif
+
+        // 64-bit key of a node and edge name, used as the high half of the time-ordered indexes
+        static uint64_t nodeNameKey(const eosio::checksum256 &node, const eosio::name &edge_name);
+
+        // composite key of a 64-bit prefix and a created time in microseconds
+        static uint128_t timeKey(const uint64_t prefix, const eosio::time_point &created);
+
+        // sets id and, in the v1 layout, the three index keys from from_node, to_node and edge_name
+        void deriveKeys();
+
         uint64_t id; // hash of from_node, to_node, and edge_name
 
+#ifndef DOCUMENT_GRAPH_COMPACT_ROWS
         // these three additional indexes allow isolating/querying edges more precisely (less iteration)
         uint64_t from_node_edge_name_index;
         uint64_t from_node_to_node_index;
         uint64_t to_node_edge_name_index;
+#endif
 
         // these members should be private, but they are used in DocumentGraph for edge replacement logic
         eosio::checksum256 from_node;
         eosio::checksum256 to_node;
         eosio::name edge_name;
+#ifdef DOCUMENT_GRAPH_COMPACT_ROWS
+        // block time only has half-second slots, so nothing current_time_point() returns is lost
+        eosio::block_timestamp created_date;
+        eosio::name creator;
+#else
         eosio::time_point created_date;
         eosio::name creator;
         eosio::name contract;
+#endif
 
         uint64_t primary_key() const;
         uint64_t by_from_node_edge_name_index() const;
@@ -62,7 +112,59 @@ namespace hypha
         eosio::checksum256 by_from() const;
         eosio::checksum256 by_to() const;
 
-        EOSLIB_SERIALIZE(Edge, (id)(from_node_edge_name_index)(from_node_to_node_index)(to_node_edge_name_index)(from_node)(to_node)(edge_name)(created_date)(creator)(contract))
+        // time-ordered composite indexes: (from_node, edge_name, created), (to_node, edge_name, created)
+        // and (edge_name, created), with created_date in microseconds
+        uint128_t by_from_node_edge_name_created() const;
+        uint128_t by_to_node_edge_name_created() const;
+        uint128_t by_edge_name_created() const;
+
+        // an edges row has one of two layouts: v1 holds the index keys, the created time in
+        // microseconds and the contract, v2 (DOCUMENT_GRAPH_COMPACT_ROWS) only the fields the keys are
+        // derived from and the created time in block slots. Rows of either size are read, as
+        // multi_index unpacks each row from a stream of just that row; the build's own is written.
+        static constexpr uint32_t V1_ROW_SIZE = 128;
+        static constexpr uint32_t V2_ROW_SIZE = 92;
+
+        template <typename DataStream>
+        friend DataStream &operator<<(DataStream &ds, const Edge &e)
+        {
+#ifdef DOCUMENT_GRAPH_COMPACT_ROWS
+            return ds << e.id << e.from_node << e.to_node << e.edge_name << e.created_date << e.creator;
+#else
+            return ds << e.id << e.from_node_edge_name_index << e.from_node_to_node_index << e.to_node_edge_name_index
+                      << e.from_node << e.to_node << e.edge_name << e.created_date << e.creator << e.contract;
+#endif
+        }
+
+        template <typename DataStream>
+        friend DataStream &operator>>(DataStream &ds, Edge &e)
+        {
+            eosio::check(ds.remaining() == V1_ROW_SIZE || ds.remaining() == V2_ROW_SIZE, "edge row has an unknown layout");
+            if (ds.remaining() == V1_ROW_SIZE)
+            {
+#ifdef DOCUMENT_GRAPH_COMPACT_ROWS
+                eosio::time_point created;
+                ds >> e.id;
+                ds.skip(3 * sizeof(uint64_t));
+                ds >> e.from_node >> e.to_node >> e.edge_name >> created >> e.creator;
+                ds.skip(sizeof(uint64_t));
+                e.created_date = created;
+#else
+                ds >> e.id >> e.from_node_edge_name_index >> e.from_node_to_node_index >> e.to_node_edge_name_index
+                   >> e.from_node >> e.to_node >> e.edge_name >> e.created_date >> e.creator >> e.contract;
+#endif
+                return ds;
+            }
+
+            eosio::block_timestamp created;
+            ds >> e.id >> e.from_node >> e.to_node >> e.edge_name >> created >> e.creator;
+            e.created_date = created;
+#ifndef DOCUMENT_GRAPH_COMPACT_ROWS
+            // a v1 build, e.g. a native tool, fills in the keys; the contract is not known here
+            e.deriveKeys();
+#endif
+            return ds;
+        }
 
         typedef eosio::multi_index<eosio::name("edges"), Edge,
                                    eosio::indexed_by<eosio::name("fromnode"), eosio::const_mem_fun<Edge, eosio::checksum256, &Edge::by_from>>,
@@ -72,8 +174,15 @@ namespace hypha
                                    eosio::indexed_by<eosio::name("byfromto"), eosio::const_mem_fun<Edge, uint64_t, &Edge::by_from_node_to_node_index>>,
                                    eosio::indexed_by<eosio::name("bytoname"), eosio::const_mem_fun<Edge, uint64_t, &Edge::by_to_node_edge_name_index>>,
                                    eosio::indexed_by<eosio::name("bycreated"), eosio::const_mem_fun<Edge, uint64_t, &Edge::by_created>>,
-                                   eosio::indexed_by<eosio::name("bycreator"), eosio::const_mem_fun<Edge, uint64_t, &Edge::by_creator>>>
+                                   eosio::indexed_by<eosio::name("bycreator"), eosio::const_mem_fun<Edge, uint64_t, &Edge::by_creator>>,
+                                   eosio::indexed_by<eosio::name("byfromtime"), eosio::const_mem_fun<Edge, uint128_t, &Edge::by_from_node_edge_name_created>>,
+                                   eosio::indexed_by<eosio::name("bytotime"), eosio::const_mem_fun<Edge, uint128_t, &Edge::by_to_node_edge_name_created>>,
+                                   eosio::indexed_by<eosio::name("bynametime"), eosio::const_mem_fun<Edge, uint128_t, &Edge::by_edge_name_created>>>
             edge_table;
+
+        // same as emplace() and erase(), using a table the caller already has open, in any scope
+        void emplace(edge_table &e_t);
+        void erase(edge_table &e_t);
     };
 
 } // namespace hypha
\ No newline at end of file
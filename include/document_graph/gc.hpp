@@ -0,0 +1,122 @@
+#pragma once
+#include <eosio/multi_index.hpp>
+#include <eosio/name.hpp>
+#include <eosio/time.hpp>
+#include <eosio/crypto.hpp>
+
+#include <limits>
+#include <vector>
+
+#include <document_graph/edge.hpp>
+
+namespace hypha
+{
+    // progress of the garbage collection of one scope; the table holds a single row
+    struct [[eosio::table, eosio::contract("docs")]] GcState
+    {
+        // reset, mark, sweepdocs, sweepedges or done
+        eosio::name phase;
+
+        // documents and edges created at or after this time are never swept
+        eosio::time_point started;
+
+        std::vector<eosio::checksum256> roots;
+
+        // edge names followed while marking, all edges if empty
+        std::vector<eosio::name> edge_names;
+
+        // count what would be swept, without erasing
+        bool dry_run;
+
+        // next mark to expand, and the next primary keys to sweep; NO_CURSOR once a table is done
+        std::uint64_t mark_cursor;
+        std::uint64_t document_cursor;
+        std::uint64_t keyed_cursor;
+        std::uint64_t edge_cursor;
+
+        // a node's edges are visited in runs that may span several steps: the mark being expanded has
+        // one run per name in edge_names, or a single one if all edges are followed, and the node being
+        // swept has a run of the edges from it and one of the edges to it. Each run position is the
+        // index of the run and the primary key of the last edge visited and kept, NO_CURSOR before the first.
+        std::uint64_t mark_run;
+        std::uint64_t mark_edge;
+        std::uint64_t sweep_run;
+        std::uint64_t sweep_edge;
+
+        // the unreachable node whose edges are being swept, zero if there is none; its document is
+        // erased before its edges
+        eosio::checksum256 sweeping;
+
+        // reachable documents marked, and the unreachable documents and edges swept or found
+        std::uint64_t marked;
+        std::uint64_t documents;
+        std::uint64_t edges;
+
+        static constexpr std::uint64_t NO_CURSOR = std::numeric_limits<std::uint64_t>::max();
+
+        uint64_t primary_key() const { return 0; }
+
+        EOSLIB_SERIALIZE(GcState, (phase)(started)(roots)(edge_names)(dry_run)(mark_cursor)(document_cursor)(keyed_cursor)(edge_cursor)(mark_run)(mark_edge)(sweep_run)(sweep_edge)(sweeping)(marked)(documents)(edges))
+
+        typedef eosio::multi_index<eosio::name("gcstate"), GcState> state_table;
+    };
+
+    // a node found reachable by the current collection, with stable identities its identity; rows are
+    // expanded in id order, so the table is also the queue of the breadth-first mark
+    struct [[eosio::table, eosio::contract("docs")]] GcMark
+    {
+        std::uint64_t id;
+        eosio::checksum256 node;
+
+        uint64_t primary_key() const { return id; }
+        eosio::checksum256 by_node() const { return node; }
+
+        EOSLIB_SERIALIZE(GcMark, (id)(node))
+
+        typedef eosio::multi_index<eosio::name("gcmarks"), GcMark,
+                                   eosio::indexed_by<eosio::name("bynode"), eosio::const_mem_fun<GcMark, eosio::checksum256, &GcMark::by_node>>>
+            mark_table;
+    };
+
+} // namespace hypha
+
+// Build with DOCUMENT_GRAPH_GC to collect documents that cannot be reached from a set of roots.
+// A collection runs over many actions: start records the roots, then each step does a bounded
+// amount of work, first clearing the previous marks, then marking from the roots along the edge
+// indexes, then sweeping the documents and finally the dangling edges. Edges created while a
+// collection runs mark their to_node, so a node linked in after it was passed is not swept.
+// Without the flag, DG_GC_EDGE expands to nothing.
+#ifdef DOCUMENT_GRAPH_GC
+
+namespace hypha
+{
+    class DocumentGraph;
+
+    namespace gc
+    {
+        const eosio::name RESET = eosio::name("reset");
+        const eosio::name MARK = eosio::name("mark");
+        const eosio::name SWEEP_DOCUMENTS = eosio::name("sweepdocs");
+        const eosio::name SWEEP_EDGES = eosio::name("sweepedges");
+        const eosio::name DONE = eosio::name("done");
+
+        // starts a collection of the graph's scope, abandoning one that is in progress
+        void start(DocumentGraph &graph, const std::vector<eosio::checksum256> &roots,
+                   const std::vector<eosio::name> &edgeNames, const bool dryRun);
+
+        // visits up to maxRows rows and returns the state afterwards; phase is DONE when finished
+        GcState step(DocumentGraph &graph, const uint64_t maxRows);
+
+        // the write barrier, called for every edge emplaced while a collection may be running
+        void edgeCreated(const eosio::name &contract, const eosio::name &scope, const Edge &edge);
+
+    } // namespace gc
+} // namespace hypha
+
+#define DG_GC_EDGE(contract, scope, edge) (::hypha::gc::edgeCreated((contract), (scope), (edge)))
+
+#else
+
+#define DG_GC_EDGE(contract, scope, edge) ((void)0)
+
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+#include <eosio/name.hpp>
+
+#include <map>
+#include <utility>
+
+// Build with DOCUMENT_GRAPH_INSTRUMENTATION to count the work done by the library during an
+// action. Without it, the DG_COUNT macros expand to nothing and no counter code is compiled.
+#ifdef DOCUMENT_GRAPH_INSTRUMENTATION
+
+namespace hypha
+{
+    // lookups are find/lower_bound/upper_bound calls, reads are rows visited through an iterator
+    struct IndexCounters
+    {
+        uint64_t lookups = 0;
+        uint64_t reads = 0;
+        uint64_t writes = 0;
+        uint64_t erases = 0;
+    };
+
+    struct Counters
+    {
+        uint64_t fingerprintBytes = 0;
+        uint64_t sha256Calls = 0;
+        uint64_t sha256Bytes = 0;
+        uint64_t concatHashCalls = 0;
+
+        // keyed by table and index name; the primary index is named "primary"
+        std::map<std::pair<eosio::name, eosio::name>, IndexCounters> indexes;
+    };
+
+    // contract memory starts out fresh for each action, so the counters cover the current action;
+    // native code that runs several actions in one process calls resetCounters between them
+    Counters &counters();
+    IndexCounters &indexCounters(const eosio::name &table, const eosio::name &index);
+    void resetCounters();
+
+    // prints one line with the hashing totals and one line per index used, through eosio::print
+    void printCounters();
+
+} // namespace hypha
+
+#define DG_COUNT(counter, n) (::hypha::counters().counter += (n))
+#define DG_COUNT_INDEX(table, index, counter, n) (::hypha::indexCounters(eosio::name(table), eosio::name(index)).counter += (n))
+
+#else
+
+#define DG_COUNT(counter, n) ((void)0)
+#define DG_COUNT_INDEX(table, index, counter, n) ((void)0)
+
+#endif
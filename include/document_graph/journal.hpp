@@ -0,0 +1,68 @@
+#pragma once
+#include <eosio/multi_index.hpp>
+#include <eosio/name.hpp>
+#include <eosio/crypto.hpp>
+
+#include <document_graph/edge.hpp>
+
+namespace hypha
+{
+    // one change to the graph; rows are appended with increasing sequence numbers and never modified,
+    // so an indexer that remembers the last sequence it read can fetch only what changed since
+    struct [[eosio::table, eosio::contract("docs")]] JournalEntry
+    {
+        std::uint64_t sequence;
+
+        // createdoc, erasedoc, createedge or eraseedge
+        eosio::name operation;
+
+        // the document hash, or the from_node of an edge
+        eosio::checksum256 node;
+
+        // empty for documents
+        eosio::checksum256 to_node;
+        eosio::name edge_name;
+
+        uint64_t primary_key() const { return sequence; }
+
+        EOSLIB_SERIALIZE(JournalEntry, (sequence)(operation)(node)(to_node)(edge_name))
+
+        typedef eosio::multi_index<eosio::name("journal"), JournalEntry> journal_table;
+    };
+
+} // namespace hypha
+
+// Build with DOCUMENT_GRAPH_JOURNAL to append a JournalEntry for every document and edge that is
+// created or erased, to the journal in the same scope as the changed row. Without it, the DG_JOURNAL
+// macros expand to nothing and the table stays empty.
+#ifdef DOCUMENT_GRAPH_JOURNAL
+
+namespace hypha
+{
+    namespace journal
+    {
+        const eosio::name CREATE_DOCUMENT = eosio::name("createdoc");
+        const eosio::name ERASE_DOCUMENT = eosio::name("erasedoc");
+        const eosio::name CREATE_EDGE = eosio::name("createedge");
+        const eosio::name ERASE_EDGE = eosio::name("eraseedge");
+
+        void appendDocument(const eosio::name &contract, const eosio::name &scope, const eosio::name &operation,
+                            const eosio::checksum256 &hash);
+        void appendEdge(const eosio::name &contract, const eosio::name &scope, const eosio::name &operation, const Edge &edge);
+
+        // erases up to maxRows entries with a sequence below beforeSequence, oldest first, and returns
+        // the number erased; the newest entry is always kept so that sequence numbers never restart
+        uint64_t prune(const eosio::name &contract, const eosio::name &scope, const uint64_t beforeSequence, const uint64_t maxRows);
+
+    } // namespace journal
+} // namespace hypha
+
+#define DG_JOURNAL_DOCUMENT(contract, scope, operation, hash) (::hypha::journal::appendDocument((contract), (scope), ::hypha::journal::operation, (hash)))
+#define DG_JOURNAL_EDGE(contract, scope, operation, edge) (::hypha::journal::appendEdge((contract), (scope), ::hypha::journal::operation, (edge)))
+
+#else
+
+#define DG_JOURNAL_DOCUMENT(contract, scope, operation, hash) ((void)0)
+#define DG_JOURNAL_EDGE(contract, scope, operation, edge) ((void)0)
+
+#endif
@@ -0,0 +1,67 @@
+#pragma once
+#include <eosio/name.hpp>
+#include <eosio/time.hpp>
+#include <eosio/crypto.hpp>
+
+#include <optional>
+#include <vector>
+
+#include <document_graph/document.hpp>
+#include <document_graph/edge.hpp>
+
+namespace hypha
+{
+    class DocumentGraph;
+
+    // where the next page of a time-ordered edge scan starts; the values of the last edge returned,
+    // so a page can be resumed after that edge has been erased
+    struct EdgeCursor
+    {
+        eosio::time_point created_date;
+        std::uint64_t id;
+
+        EOSLIB_SERIALIZE(EdgeCursor, (created_date)(id))
+    };
+
+    struct EdgePage
+    {
+        std::vector<Edge> edges;
+
+        // empty on the last page
+        std::optional<EdgeCursor> next;
+
+        EOSLIB_SERIALIZE(EdgePage, (edges)(next))
+    };
+
+    // a document with a page of its outgoing edges of one name and the documents they point to,
+    // in the same order as the edges; a neighbor that is not stored is an empty document
+    struct Neighborhood
+    {
+        Document document;
+        std::vector<Edge> edges;
+        std::vector<Document> neighbors;
+        std::optional<EdgeCursor> next;
+
+        EOSLIB_SERIALIZE(Neighborhood, (document)(edges)(neighbors)(next))
+    };
+
+    // lookups that read a whole result in one call, for the read-only query actions of the contract
+    namespace query
+    {
+        // the most documents or edges one call returns
+        constexpr std::uint32_t MAX_RESULTS = 500;
+
+        // the stored documents among hashes, in the same order; hashes not stored are left out
+        std::vector<Document> getDocuments(DocumentGraph &graph, const std::vector<eosio::checksum256> &hashes);
+
+        // edges of a name from the node, or to it if incoming, newest first
+        EdgePage getEdges(DocumentGraph &graph, const eosio::checksum256 &node, const eosio::name &edgeName,
+                          const bool incoming, const std::optional<EdgeCursor> &after, const std::uint32_t limit);
+
+        // with stable identities, edges are looked up from the identity of hash and the neighbors
+        // are the heads of the identities the edges point to
+        Neighborhood getNeighbors(DocumentGraph &graph, const eosio::checksum256 &hash, const eosio::name &edgeName,
+                                  const std::optional<EdgeCursor> &after, const std::uint32_t limit);
+
+    } // namespace query
+} // namespace hypha
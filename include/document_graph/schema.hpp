@@ -0,0 +1,271 @@
+#pragma once
+#include <eosio/eosio.hpp>
+
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include <document_graph/content_group.hpp>
+#include <document_graph/document.hpp>
+
+// A schema binds the contents of a document to the members of a struct, so that a contract reads
+// and writes typed values instead of looking each one up by group and content label:
+//
+//     struct Payout
+//     {
+//         eosio::asset salary;
+//         eosio::name recipient;
+//         std::optional<eosio::time_point> start;
+//     };
+//
+//     struct PayoutSchema
+//     {
+//         using type = Payout;
+//         static constexpr std::string_view name = "payout";
+//         static constexpr auto fields = std::make_tuple(
+//             schema::field("details", "salary_amount", &Payout::salary),
+//             schema::field("details", "recipient", &Payout::recipient),
+//             schema::field("details", "start", &Payout::start));
+//     };
+//
+//     Payout payout = schema::decode<PayoutSchema>(document.getContentGroups());
+//     graph.createDocument(creator, schema::encode<PayoutSchema>(std::move(payout)));
+//
+// Members are one of the FlexValue types, or a std::optional of one for contents that may be
+// absent; any other type fails to compile. Groups are matched by their content_group_label.
+namespace hypha
+{
+    namespace schema
+    {
+        template <typename T>
+        struct FieldValue
+        {
+            using type = T;
+            static constexpr bool optional = false;
+        };
+
+        template <typename T>
+        struct FieldValue<std::optional<T>>
+        {
+            using type = T;
+            static constexpr bool optional = true;
+        };
+
+        template <typename T, typename Variant>
+        struct IsAlternative;
+
+        template <typename T, typename... Types>
+        struct IsAlternative<T, std::variant<Types...>> : std::disjunction<std::is_same<T, Types>...>
+        {
+        };
+
+        // name of a FlexValue type as the ABI spells it, for mismatch messages
+        template <typename T>
+        constexpr std::string_view typeName()
+        {
+            if constexpr (std::is_same_v<T, eosio::name>)
+                return "name";
+            else if constexpr (std::is_same_v<T, std::string>)
+                return "string";
+            else if constexpr (std::is_same_v<T, eosio::asset>)
+                return "asset";
+            else if constexpr (std::is_same_v<T, eosio::time_point>)
+                return "time_point";
+            else if constexpr (std::is_same_v<T, std::int64_t>)
+                return "int64";
+            else
+                return "checksum256";
+        }
+
+        template <typename Class, typename Member>
+        struct Field
+        {
+            using value_type = typename FieldValue<Member>::type;
+            static constexpr bool optional = FieldValue<Member>::optional;
+
+            static_assert(IsAlternative<value_type, Content::FlexValue>::value && !std::is_same_v<value_type, std::monostate>,
+                          "a schema field must be a FlexValue type or a std::optional of one");
+
+            std::string_view group;
+            std::string_view label;
+            Member Class::*member;
+        };
+
+        template <typename Class, typename Member>
+        constexpr Field<Class, Member> field(std::string_view group, std::string_view label, Member Class::*member)
+        {
+            return Field<Class, Member>{group, label, member};
+        }
+
+        template <typename Schema>
+        constexpr std::size_t fieldCount()
+        {
+            return std::tuple_size_v<std::decay_t<decltype(Schema::fields)>>;
+        }
+
+        // calls f(index, field) for every field of the schema, unrolled at compile time
+        template <typename Schema, typename F, std::size_t... I>
+        void forEachField(F &&f, std::index_sequence<I...>)
+        {
+            (f(std::integral_constant<std::size_t, I>{}, std::get<I>(Schema::fields)), ...);
+        }
+
+        template <typename Schema, typename F>
+        void forEachField(F &&f)
+        {
+            forEachField<Schema>(std::forward<F>(f), std::make_index_sequence<fieldCount<Schema>()>{});
+        }
+
+        // the value of the group's content_group_label, or nullptr for a group without one
+        inline const std::string *groupLabel(const ContentGroup &group)
+        {
+            for (const Content &content : group)
+            {
+                if (content.label == CONTENT_GROUP_LABEL && std::holds_alternative<std::string>(content.value))
+                {
+                    return &std::get<std::string>(content.value);
+                }
+            }
+            return nullptr;
+        }
+
+        // matches every content against the fields in one pass over the groups, then reports every
+        // missing or mistyped content at once; values are moved out when groups is not const
+        template <typename Schema, typename Groups>
+        typename Schema::type decodeGroups(Groups &groups)
+        {
+            constexpr bool moveValues = !std::is_const_v<Groups>;
+
+            typename Schema::type result{};
+            std::array<bool, fieldCount<Schema>()> found{};
+            std::string errors;
+
+            for (auto &group : groups)
+            {
+                const std::string *label = groupLabel(group);
+                if (label == nullptr)
+                {
+                    continue;
+                }
+
+                for (auto &content : group)
+                {
+                    forEachField<Schema>([&](auto index, const auto &field) {
+                        using Value = typename std::decay_t<decltype(field)>::value_type;
+
+                        // the first content with a label counts, as with ContentWrapper::getContent
+                        if (found[index] || field.label != content.label || field.group != *label)
+                        {
+                            return;
+                        }
+                        found[index] = true;
+
+                        if (!std::holds_alternative<Value>(content.value))
+                        {
+                            errors += " " + std::string(field.group) + "/" + std::string(field.label) +
+                                      " is not of type " + std::string(typeName<Value>()) + ";";
+                        }
+                        else if constexpr (moveValues)
+                        {
+                            result.*(field.member) = std::move(std::get<Value>(content.value));
+                        }
+                        else
+                        {
+                            result.*(field.member) = std::get<Value>(content.value);
+                        }
+                    });
+                }
+            }
+
+            forEachField<Schema>([&](auto index, const auto &field) {
+                if (!found[index] && !std::decay_t<decltype(field)>::optional)
+                {
+                    errors += " " + std::string(field.group) + "/" + std::string(field.label) + " is missing;";
+                }
+            });
+
+            eosio::check(errors.empty(), "document does not match schema " + std::string(Schema::name) + ":" + errors);
+            return result;
+        }
+
+        template <typename Schema>
+        typename Schema::type decode(const ContentGroups &contentGroups)
+        {
+            return decodeGroups<Schema>(contentGroups);
+        }
+
+        template <typename Schema>
+        typename Schema::type decode(ContentGroups &&contentGroups)
+        {
+            return decodeGroups<Schema>(contentGroups);
+        }
+
+        template <typename Schema>
+        typename Schema::type decode(const Document &document)
+        {
+            return decodeGroups<Schema>(document.getContentGroups());
+        }
+
+        // builds the contents of value, a group per distinct group label in the order the fields
+        // first name it, each led by its content_group_label; absent optional members are left out.
+        // Values are moved in when value is an rvalue.
+        template <typename Schema, typename Value>
+        ContentGroups encode(Value &&value)
+        {
+            static_assert(std::is_same_v<std::decay_t<Value>, typename Schema::type>, "value is not of the schema's type");
+            constexpr bool moveValues = !std::is_lvalue_reference_v<Value>;
+
+            ContentGroups groups;
+            groups.reserve(fieldCount<Schema>());
+
+            forEachField<Schema>([&](auto, const auto &field) {
+                auto &member = value.*(field.member);
+                if constexpr (std::decay_t<decltype(field)>::optional)
+                {
+                    if (!member.has_value())
+                    {
+                        return;
+                    }
+                }
+
+                ContentGroup *group = nullptr;
+                for (ContentGroup &existing : groups)
+                {
+                    if (std::get<std::string>(existing.front().value) == field.group)
+                    {
+                        group = &existing;
+                        break;
+                    }
+                }
+                if (group == nullptr)
+                {
+                    group = &groups.emplace_back();
+                    group->emplace_back(CONTENT_GROUP_LABEL, std::string(field.group));
+                }
+
+                auto &stored = [&]() -> auto & {
+                    if constexpr (std::decay_t<decltype(field)>::optional)
+                        return *member;
+                    else
+                        return member;
+                }();
+                if constexpr (moveValues)
+                {
+                    group->emplace_back(std::string(field.label), std::move(stored));
+                }
+                else
+                {
+                    group->emplace_back(std::string(field.label), stored);
+                }
+            });
+
+            return groups;
+        }
+
+    } // namespace schema
+} // namespace hypha
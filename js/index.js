@@ -42,9 +42,17 @@ async function getDocuments (host, contract) {
   options.table = 'documents'
   options.limit = 1000
 
-  const result = await rpc.get_table_rows(options)
-  if (result.rows.length > 0) {
-    return result.rows
+  // follow next_key until the table is exhausted, a single request stops at the limit
+  const rows = []
+  let result
+  do {
+    result = await rpc.get_table_rows(options)
+    rows.push(...result.rows)
+    options.lower_bound = result.next_key
+  } while (result.more && result.next_key)
+
+  if (rows.length > 0) {
+    return rows
   }
 
   console.log('There are no documents')
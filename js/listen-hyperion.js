@@ -1,36 +1,41 @@
 const HyperionSocketClient = require('@eosrio/hyperion-stream-client').default
-const { Document } = require('./model')
-const { DGraph } = require('./service')
+const { DGraph, GraphSync } = require('./service')
 
 async function run () {
   const dgraph = new DGraph({})
-  const document = new Document(dgraph)
+  const sync = new GraphSync({ dgraph })
 
-  await document.setSchema()
+  await sync.setSchema()
 
   const ENDPOINT = 'https://testnet.telos.caleos.io'
   const client = new HyperionSocketClient(ENDPOINT, { async: true })
 
   client.onConnect = () => {
-    client.streamDeltas({
-      code: 'docs.hypha',
-      table: 'documents',
-      account: 'docs.hypha',
-      scope: '',
-      payer: '',
-      start_from: '2020-08-15T00:00:00.000Z',
-      read_until: 0
-    })
+    for (const table of ['documents', 'edges']) {
+      client.streamDeltas({
+        code: 'docs.hypha',
+        table,
+        account: 'docs.hypha',
+        scope: '',
+        payer: '',
+        start_from: '2020-08-15T00:00:00.000Z',
+        read_until: 0
+      })
+    }
   }
 
-  // see 3 for handling data
+  // ack once the row is queued; the sync holds the ack back while its batches are
+  // all in flight, which throttles the stream during catch-up
   client.onData = async (delta, ack) => {
     const {
-      content: { data: doc }
+      content: { table, present, data: row }
     } = delta
-    console.log(JSON.stringify(doc, null, 4))
-    if (doc) {
-      await document.store(doc)
+    if (row) {
+      if (table === 'edges') {
+        await (present === false || present === 0 ? sync.removeEdge(row) : sync.addEdge(row))
+      } else {
+        await sync.addDocument(row)
+      }
       ack()
     }
   }
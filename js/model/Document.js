@@ -1,3 +1,4 @@
+const UpsertBlock = require('../service/UpsertBlock')
 
 const schema =
     `
@@ -27,7 +28,7 @@ const schema =
         certification_date
       }
       
-      hash: string @index(exact) .
+      hash: string @index(exact) @upsert .
       created_date: datetime .
       creator: string @index(term) .
       content_groups: [uid] .
@@ -88,13 +89,39 @@ class Document {
   }
 
   async store (chainDoc) {
-    const uid = await this.getUID(chainDoc.hash)
-    const dgraphDoc = this._transform(chainDoc, uid)
+    const block = new UpsertBlock()
+    return this.upsertInto(block, chainDoc) ? this.dgraph.upsertBlock(block) : null
+  }
 
-    return dgraphDoc ? this.dgraph.updateData(dgraphDoc) : null
+  /**
+   * Adds the mutations that store the document to an upsert block, keyed on its hash.
+   * Contents are hashed so they are only written if the node has none yet; certificates
+   * may be added on chain later, so they replace the stored ones.
+   * @returns {boolean} false for a row without contents, which adds nothing
+   */
+  upsertInto (block, chainDoc) {
+    const transformed = this._transform(chainDoc)
+    if (!transformed) {
+      return false
+    }
+    const node = block.nodeVar(chainDoc.hash)
+    const stored = block.contentVar(chainDoc.hash)
+    block.set({
+      uid: `uid(${node})`,
+      ...transformed
+    }, `@if(eq(len(${stored}), 0))`)
+    block.delete({
+      uid: `uid(${stored})`,
+      certificates: null
+    }, `@if(gt(len(${stored}), 0))`)
+    block.set({
+      uid: `uid(${stored})`,
+      certificates: transformed.certificates
+    }, `@if(gt(len(${stored}), 0))`)
+    return true
   }
 
-  _transform (chainDoc, uid) {
+  _transform (chainDoc) {
     const {
       hash,
       creator,
@@ -107,25 +134,13 @@ class Document {
     if (!contentGroups) {
       return null
     }
-    let transformed
-
-    if (uid) {
-      transformed = {
-        uid
-      }
-    } else {
-      transformed = {
-        hash,
-        creator,
-        created_date: createdDate,
-        content_groups: this._transformContentGroups(contentGroups)
-      }
-    }
     return {
-      ...transformed,
+      hash,
+      creator,
+      created_date: createdDate,
+      content_groups: this._transformContentGroups(contentGroups),
       certificates: this._transformCertificates(certificates),
       'dgraph.type': 'Document'
-
     }
   }
 
@@ -0,0 +1,99 @@
+/**
+ * Edges are stored as uid predicates between document nodes, one predicate per edge
+ * name, so that a traversal is a plain predicate expansion and ~predicate walks it
+ * backwards. The edge's created_date is kept as a facet.
+ */
+class Edge {
+  constructor (dgraph) {
+    this.dgraph = dgraph
+    this.predicates = new Set()
+  }
+
+  /**
+   * Predicate of an edge name; eosio names may contain dots, and the prefix keeps edge
+   * names such as creator apart from the document predicates
+   * @param {string} edgeName
+   */
+  static predicate (edgeName) {
+    return `edge_${edgeName.replace(/\./g, '_')}`
+  }
+
+  /**
+   * Declares the predicates of edge names not seen yet, before any edge is stored with them
+   * @param {string[]} edgeNames
+   */
+  async ensurePredicates (edgeNames) {
+    const missing = [...new Set(edgeNames.map(Edge.predicate))]
+      .filter(predicate => !this.predicates.has(predicate))
+    if (!missing.length) {
+      return
+    }
+    await this.dgraph.updateSchema(
+      missing.map(predicate => `${predicate}: [uid] @reverse .`).join('\n')
+    )
+    missing.forEach(predicate => this.predicates.add(predicate))
+  }
+
+  async getTargets (fromHash, edgeName) {
+    const predicate = Edge.predicate(edgeName)
+    const { documents } = await this.dgraph.query(
+      `query documents ($hash: string){
+        documents(func: eq(hash, $hash)){
+          ${predicate} {
+            hash
+          }
+        }
+      }`,
+      { $hash: fromHash }
+    )
+    return documents.length && documents[0][predicate]
+      ? documents[0][predicate].map(doc => doc.hash)
+      : []
+  }
+
+  /**
+   * Adds the mutation that stores the edge to an upsert block. Ends not stored yet are
+   * created with just their hash, and filled in when their document arrives.
+   */
+  upsertInto (block, chainEdge) {
+    const {
+      from_node: fromNode,
+      to_node: toNode,
+      edge_name: edgeName,
+      created_date: createdDate
+    } = chainEdge
+    const predicate = Edge.predicate(edgeName)
+    block.set({
+      uid: `uid(${block.nodeVar(fromNode)})`,
+      hash: fromNode,
+      'dgraph.type': 'Document',
+      [predicate]: {
+        uid: `uid(${block.nodeVar(toNode)})`,
+        hash: toNode,
+        'dgraph.type': 'Document',
+        [`${predicate}|created_date`]: createdDate
+      }
+    })
+  }
+
+  /**
+   * Adds the mutation that removes the edge to an upsert block
+   */
+  removeFrom (block, chainEdge) {
+    const {
+      from_node: fromNode,
+      to_node: toNode,
+      edge_name: edgeName
+    } = chainEdge
+    const from = block.nodeVar(fromNode)
+    const to = block.nodeVar(toNode)
+    block.delete({
+      uid: `uid(${from})`,
+      [Edge.predicate(edgeName)]: {
+        uid: `uid(${to})`
+      }
+    }, `@if(gt(len(${from}), 0) AND gt(len(${to}), 0))`)
+  }
+}
+
+module.exports = Edge
@@ -1,5 +1,7 @@
 const Document = require('./Document')
+const Edge = require('./Edge')
 
 module.exports = {
-  Document
+  Document,
+  Edge
 }
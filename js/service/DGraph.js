@@ -3,7 +3,8 @@ const {
   DgraphClientStub,
   Operation,
   Mutation,
-  Request
+  Request,
+  ERR_ABORTED
 } = require('dgraph-js')
 
 const { Util } = require('../util')
@@ -83,6 +84,44 @@ class DGraph {
     }
   }
 
+  /**
+   * Runs the query and all mutations of an UpsertBlock in a single request and commits it
+   * @param {UpsertBlock} block
+   */
+  async upsertBlock (block) {
+    if (!block.size) {
+      return null
+    }
+    const txn = this.newTxn()
+    try {
+      const req = new Request()
+      req.setQuery(block.query)
+      for (const { set, delete: del, condition } of block.mutations) {
+        const mutation = new Mutation()
+        if (set) {
+          mutation.setSetJson(set)
+        } else {
+          mutation.setDeleteJson(del)
+        }
+        if (condition) {
+          mutation.setCond(condition)
+        }
+        req.addMutations(mutation)
+      }
+      req.setCommitNow(true)
+      return await txn.doRequest(req)
+    } finally {
+      await txn.discard()
+    }
+  }
+
+  /**
+   * Whether the error is a transaction aborted by a conflicting one, which may be retried
+   */
+  static isAborted (err) {
+    return err === ERR_ABORTED || (err && err.code === grpc.status.ABORTED)
+  }
+
   async query (queryStr, vars = null) {
     const txn = this.newTxn(true)
     const results = await (vars ? txn.queryWithVars(queryStr, vars) : txn.query(queryStr))
@@ -0,0 +1,115 @@
+const { Api, JsonRpc, Serialize } = require('eosjs')
+const { JsSignatureProvider } = require('eosjs/dist/eosjs-jssig')
+const fetch = require('node-fetch')
+const { TextEncoder, TextDecoder } = require('util')
+
+/**
+ * Runs the read-only query actions of a contract built with DOCUMENT_GRAPH_QUERY_ACTIONS
+ * through compute_transaction, which executes a transaction without committing it, and
+ * decodes their return values with the contract's ABI. One call reads what would take a
+ * get_table_rows request per document and per index probe.
+ */
+class DocQuery {
+  constructor ({
+    host = null,
+    contract = 'docs.hypha',
+    reader = null,
+    privateKey = null
+  }) {
+    this.contract = contract
+    this.reader = reader || contract
+    this.sign = !!privateKey
+    this.rpc = new JsonRpc(host || 'http://localhost:8888', { fetch })
+    this.api = new Api({
+      rpc: this.rpc,
+      signatureProvider: new JsSignatureProvider(privateKey ? [privateKey] : []),
+      textDecoder: new TextDecoder(),
+      textEncoder: new TextEncoder()
+    })
+  }
+
+  async getDoc (scope, hash) {
+    return this._compute('getdoc', { scope, hash })
+  }
+
+  /**
+   * The stored documents among hashes, in the same order; hashes not stored are left out
+   */
+  async getDocs (scope, hashes) {
+    return this._compute('getdocs', { scope, hashes })
+  }
+
+  /**
+   * A page of edges from node, or to it if incoming, newest first; pass the page's next as
+   * after to read the following one, next is null on the last page
+   */
+  async getEdges (scope, node, edgeName, { incoming = false, after = null, limit = 100 } = {}) {
+    return this._compute('getedges', {
+      scope,
+      node,
+      edge_name: edgeName,
+      incoming,
+      after,
+      limit
+    })
+  }
+
+  /**
+   * A document, a page of its edges named edgeName and the documents they point to
+   */
+  async neighbors (scope, hash, edgeName, { after = null, limit = 100 } = {}) {
+    return this._compute('neighbors', {
+      scope,
+      hash,
+      edge_name: edgeName,
+      after,
+      limit
+    })
+  }
+
+  async _compute (action, data) {
+    const { serializedTransaction, signatures } = await this.api.transact({
+      actions: [{
+        account: this.contract,
+        name: action,
+        authorization: [{ actor: this.reader, permission: 'active' }],
+        data
+      }]
+    }, {
+      blocksBehind: 3,
+      expireSeconds: 30,
+      broadcast: false,
+      sign: this.sign
+    })
+
+    const { processed } = await this.rpc.fetch('/v1/chain/compute_transaction', {
+      transaction: {
+        signatures,
+        compression: 0,
+        packed_context_free_data: '',
+        packed_trx: Serialize.arrayToHex(serializedTransaction)
+      }
+    })
+    if (processed.except) {
+      throw new Error(`${action}: ${processed.except.message || processed.except.name}`)
+    }
+    return this._decode(action, processed.action_traces[0].return_value_hex_data)
+  }
+
+  async _decode (action, hex) {
+    const { abi } = await this.api.getCachedAbi(this.contract)
+    const result = (abi.action_results || []).find(({ name }) => name === action)
+    if (!result) {
+      throw new Error(`${action}: the contract ABI declares no return value`)
+    }
+    const { types } = await this.api.getContract(this.contract)
+    const buffer = new Serialize.SerialBuffer({
+      textEncoder: new TextEncoder(),
+      textDecoder: new TextDecoder(),
+      array: Serialize.hexToUint8Array(hex)
+    })
+    return Serialize.getType(types, result.result_type).deserialize(buffer)
+  }
+}
+
+module.exports = DocQuery
@@ -0,0 +1,186 @@
+const DGraph = require('./DGraph')
+const UpsertBlock = require('./UpsertBlock')
+const { Document, Edge } = require('../model')
+
+const sleep = ms => new Promise(resolve => setTimeout(resolve, ms))
+
+/**
+ * Replicates document and edge rows into Dgraph. Rows are queued and committed in
+ * batches of up to batchSize rows, each batch a single upsert request, with up to
+ * concurrency batches in flight. Adding a row waits while all slots are taken, so a
+ * listener that awaits each add is slowed down to the rate Dgraph keeps up with.
+ *
+ * Within the queue a later row replaces an earlier one for the same document or edge,
+ * and a batch touching a document or edge of a batch in flight waits for it to commit,
+ * so the replica ends up with the rows in the order they were added. Batches start
+ * through a single promise chain, one after the other in the order they were taken from
+ * the queue, so a later batch never overtakes an earlier one waiting on the same row.
+ */
+class GraphSync {
+  constructor ({
+    dgraph,
+    batchSize = 500,
+    concurrency = 4,
+    flushInterval = 1000,
+    maxRetries = 5
+  }) {
+    this.dgraph = dgraph
+    this.document = new Document(dgraph)
+    this.edge = new Edge(dgraph)
+    this.batchSize = batchSize
+    this.concurrency = concurrency
+    this.flushInterval = flushInterval
+    this.maxRetries = maxRetries
+
+    this.pending = new Map()
+    this.inFlight = new Map()
+    this.dispatching = Promise.resolve()
+    this.timer = null
+    this.error = null
+    this.stats = {
+      documents: 0,
+      edges: 0,
+      removedEdges: 0,
+      skipped: 0,
+      batches: 0,
+      retries: 0
+    }
+  }
+
+  async setSchema () {
+    return this.document.setSchema()
+  }
+
+  async addDocument (chainDoc) {
+    return this._add(`d:${chainDoc.hash}`, { kind: 'document', row: chainDoc })
+  }
+
+  async addEdge (chainEdge) {
+    return this._add(GraphSync._edgeKey(chainEdge), { kind: 'edge', row: chainEdge })
+  }
+
+  async removeEdge (chainEdge) {
+    return this._add(GraphSync._edgeKey(chainEdge), { kind: 'removeEdge', row: chainEdge })
+  }
+
+  /**
+   * Commits everything queued and waits for all batches, started or still waiting to start
+   */
+  async flush () {
+    if (this.pending.size) {
+      this._dispatch()
+    }
+    await this.dispatching
+    await Promise.all(this.inFlight.values())
+    this._throwIfFailed()
+  }
+
+  static _edgeKey ({ from_node: fromNode, to_node: toNode, edge_name: edgeName }) {
+    return `e:${fromNode}:${edgeName}:${toNode}`
+  }
+
+  async _add (key, item) {
+    this._throwIfFailed()
+    this.pending.delete(key)
+    this.pending.set(key, item)
+    if (this.pending.size >= this.batchSize) {
+      await this._dispatch()
+    } else if (!this.timer && this.flushInterval) {
+      this.timer = setTimeout(() => this._dispatch(), this.flushInterval)
+      this.timer.unref()
+    }
+  }
+
+  /**
+   * Takes the queue as a batch and chains its start behind the batches taken before it;
+   * resolves once the batch is in flight
+   */
+  _dispatch () {
+    clearTimeout(this.timer)
+    this.timer = null
+    const batch = this.pending
+    this.pending = new Map()
+
+    this.dispatching = this.dispatching.then(() => this._start(batch))
+    return this.dispatching
+  }
+
+  async _start (batch) {
+    for (;;) {
+      const blockers = [...batch.keys()]
+        .filter(key => this.inFlight.has(key))
+        .map(key => this.inFlight.get(key))
+      if (blockers.length) {
+        await Promise.all(blockers)
+      } else if (new Set(this.inFlight.values()).size >= this.concurrency) {
+        await Promise.race(this.inFlight.values())
+      } else {
+        break
+      }
+    }
+
+    // never rejects, a failure is raised by the next add or flush
+    const running = this._commit([...batch.values()])
+      .catch(err => { this.error = this.error || err })
+      .finally(() => {
+        for (const key of batch.keys()) {
+          if (this.inFlight.get(key) === running) {
+            this.inFlight.delete(key)
+          }
+        }
+      })
+    for (const key of batch.keys()) {
+      this.inFlight.set(key, running)
+    }
+  }
+
+  async _commit (items) {
+    await this.edge.ensurePredicates(
+      items.filter(({ kind }) => kind === 'edge').map(({ row }) => row.edge_name)
+    )
+
+    const block = new UpsertBlock()
+    const counts = { documents: 0, edges: 0, removedEdges: 0, skipped: 0 }
+    for (const { kind, row } of items) {
+      if (kind === 'document') {
+        if (this.document.upsertInto(block, row)) {
+          counts.documents++
+        } else {
+          counts.skipped++
+        }
+      } else if (kind === 'edge') {
+        this.edge.upsertInto(block, row)
+        counts.edges++
+      } else {
+        this.edge.removeFrom(block, row)
+        counts.removedEdges++
+      }
+    }
+
+    for (let attempt = 1; ; attempt++) {
+      try {
+        await this.dgraph.upsertBlock(block)
+        break
+      } catch (err) {
+        if (!DGraph.isAborted(err) || attempt >= this.maxRetries) {
+          throw err
+        }
+        this.stats.retries++
+        await sleep(50 * attempt)
+      }
+    }
+
+    for (const name in counts) {
+      this.stats[name] += counts[name]
+    }
+    this.stats.batches++
+  }
+
+  _throwIfFailed () {
+    if (this.error) {
+      throw this.error
+    }
+  }
+}
+
+module.exports = GraphSync
@@ -0,0 +1,227 @@
+/* eslint-disable no-undef */
+const crypto = require('crypto')
+const path = require('path')
+const fs = require('fs')
+const DGraph = require('./DGraph')
+const GraphSync = require('./GraphSync')
+const { Edge } = require('../model')
+const syncDump = require('../sync-dump')
+
+jest.setTimeout(60000)
+
+const sleep = ms => new Promise(resolve => setTimeout(resolve, ms))
+
+let dgraph = null
+
+const hashOf = text => crypto.createHash('sha256').update(text).digest('hex')
+
+const chainDoc = (name, certificates = []) => ({
+  hash: hashOf(name),
+  creator: 'johnnyhypha1',
+  content_groups: [
+    [
+      {
+        label: 'content_group_name',
+        value: ['string', name]
+      }
+    ]
+  ],
+  certificates,
+  created_date: '2020-08-25T03:02:10.000'
+})
+
+const chainEdge = (from, to, edgeName) => ({
+  from_node: from.hash,
+  to_node: to.hash,
+  edge_name: edgeName,
+  created_date: '2020-08-25T03:02:11.000'
+})
+
+async function countDocuments () {
+  const { documents } = await dgraph.query(
+    `{
+      documents(func: type(Document)) @filter(has(content_groups)) {
+        count(uid)
+      }
+    }`
+  )
+  return documents[0].count
+}
+
+async function countHash (hash) {
+  const { documents } = await dgraph.query(
+    `query documents ($hash: string){
+      documents(func: eq(hash, $hash)){
+        count(uid)
+      }
+    }`,
+    { $hash: hash }
+  )
+  return documents[0].count
+}
+
+beforeAll(async () => {
+  dgraph = new DGraph({
+  })
+  await dgraph.dropAll()
+})
+
+describe('Test sync', () => {
+  test('sync', async () => {
+    const sync = new GraphSync({ dgraph, batchSize: 2, concurrency: 2 })
+    await sync.setSchema()
+    const edge = new Edge(dgraph)
+
+    const root = chainDoc('root')
+    const child = chainDoc('child')
+    const late = chainDoc('late')
+
+    // the edge to late arrives before late itself, as it does when edges are streamed separately
+    await sync.addDocument(root)
+    await sync.addDocument(child)
+    await sync.addEdge(chainEdge(root, child, 'member'))
+    await sync.addEdge(chainEdge(root, late, 'member'))
+    await sync.addEdge(chainEdge(child, root, 'member.of'))
+    await sync.flush()
+
+    await sync.addDocument(late)
+    await sync.addDocument(chainDoc('root', [{
+      certifier: 'alice',
+      notes: "Alice's notes",
+      certification_date: '2020-08-26T03:02:10.000'
+    }]))
+    await sync.addDocument({ hash: hashOf('invalid') })
+    await sync.flush()
+
+    expect(sync.stats.documents).toBe(4)
+    expect(sync.stats.edges).toBe(3)
+    expect(sync.stats.skipped).toBe(1)
+    expect(await countDocuments()).toBe(3)
+    for (const doc of [root, child, late]) {
+      expect(await countHash(doc.hash)).toBe(1)
+    }
+
+    const targets = await edge.getTargets(root.hash, 'member')
+    expect(targets.sort()).toEqual([child.hash, late.hash].sort())
+    expect(await edge.getTargets(child.hash, 'member.of')).toEqual([root.hash])
+
+    const { documents } = await dgraph.query(
+      `query documents ($hash: string){
+        documents(func: eq(hash, $hash)){
+          certificates {
+            certifier
+          }
+          content_groups {
+            contents {
+              value
+            }
+          }
+        }
+      }`,
+      { $hash: root.hash }
+    )
+    expect(documents[0].certificates).toEqual([{ certifier: 'alice' }])
+    expect(documents[0].content_groups).toHaveLength(1)
+
+    // replaying the same rows changes nothing, and a removal is applied after the add it follows
+    await sync.addDocument(root)
+    await sync.addEdge(chainEdge(root, child, 'member'))
+    await sync.removeEdge(chainEdge(root, late, 'member'))
+    await sync.flush()
+
+    expect(await countDocuments()).toBe(3)
+    expect(await edge.getTargets(root.hash, 'member')).toEqual([child.hash])
+  })
+})
+
+describe('Test dispatch order', () => {
+  test('batches sharing a row commit in the order they were queued', async () => {
+    const sync = new GraphSync({ dgraph, batchSize: 3, concurrency: 4, flushInterval: 10 })
+
+    // commits hang until released, in any order the test picks
+    const commits = []
+    const releases = []
+    sync._commit = async items => {
+      commits.push(items)
+      await new Promise(resolve => releases.push(resolve))
+    }
+
+    const a = chainDoc('a')
+    const e = chainEdge(a, chainDoc('b'), 'member')
+
+    await sync.addDocument(a)
+    await sync.addDocument(chainDoc('p'))
+    await sync.addDocument(chainDoc('q'))
+    await sync.addEdge(e)
+    await sync.addDocument(chainDoc('r'))
+    await sync.addDocument(chainDoc('s'))
+    expect(commits).toHaveLength(2)
+
+    // the timer takes e and a, which wait on both batches in flight
+    await sync.addEdge(e)
+    await sync.addDocument(a)
+    await sleep(50)
+
+    // the size limit takes the removal of e, which only shares e with the second batch
+    await sync.removeEdge(e)
+    await sync.addDocument(chainDoc('t'))
+    const sized = sync.addDocument(chainDoc('u'))
+    const flushed = sync.flush()
+
+    releases[1]()
+    await sleep(10)
+    expect(commits).toHaveLength(2)
+    releases[0]()
+    await sleep(10)
+    expect(commits).toHaveLength(3)
+    releases[2]()
+    await sized
+    expect(commits).toHaveLength(4)
+    releases[3]()
+    await flushed
+
+    const key = GraphSync._edgeKey(e)
+    const kinds = commits.map(items => items.filter(({ row }) => row.from_node && GraphSync._edgeKey(row) === key))
+      .filter(items => items.length)
+      .map(([{ kind }]) => kind)
+    expect(kinds).toEqual(['edge', 'edge', 'removeEdge'])
+    expect(sync.inFlight.size).toBe(0)
+  })
+})
+
+// DOCGRAPH_DUMP names a folder written by SaveGraph (or graph_generate dump)
+const dump = process.env.DOCGRAPH_DUMP;
+
+(dump ? describe : describe.skip)('Test sync dump', () => {
+  test('syncDump', async () => {
+    await dgraph.dropAll()
+    const documents = JSON.parse(fs.readFileSync(path.join(dump, 'documents.json'), 'utf8'))
+    const edges = JSON.parse(fs.readFileSync(path.join(dump, 'edges.json'), 'utf8'))
+
+    const stats = await syncDump({ dgraph, folder: dump, batchSize: 500, concurrency: 4 })
+    console.log(stats)
+
+    const hashes = new Set(documents.filter(doc => doc.content_groups).map(doc => doc.hash))
+    expect(await countDocuments()).toBe(hashes.size)
+
+    const edgeNames = [...new Set(edges.map(edge => edge.edge_name))]
+    let stored = 0
+    for (const edgeName of edgeNames) {
+      const predicate = Edge.predicate(edgeName)
+      const { counts } = await dgraph.query(
+        `{
+          counts(func: has(${predicate})) {
+            count(${predicate})
+          }
+        }`
+      )
+      stored += counts.reduce((sum, count) => sum + count[`count(${predicate})`], 0)
+    }
+    const distinct = new Set(edges.map(edge => GraphSync._edgeKey(edge)))
+    expect(stored).toBe(distinct.size)
+  })
+})
+
+afterAll(() => {
+  dgraph.close()
+})
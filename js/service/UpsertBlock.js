@@ -0,0 +1,66 @@
+const HASH = /^[0-9a-f]{64}$/
+
+/**
+ * Collects the query and mutations of one upsert request. Every document hash gets a
+ * single query variable, so all mutations of the block that touch a document agree on
+ * its node, and a hash not stored yet becomes one new node shared by all of them.
+ */
+class UpsertBlock {
+  constructor () {
+    this.queries = []
+    this.mutations = []
+    this.nodeVars = new Map()
+    this.contentVars = new Map()
+  }
+
+  /**
+   * Variable holding the node of the document with this hash, empty if it is not stored
+   * @param {string} hash
+   */
+  nodeVar (hash) {
+    if (!HASH.test(hash)) {
+      throw new Error(`Invalid document hash: ${hash}`)
+    }
+    let name = this.nodeVars.get(hash)
+    if (!name) {
+      name = `h${this.nodeVars.size}`
+      this.nodeVars.set(hash, name)
+      this.queries.push(`${name} as var(func: eq(hash, "${hash}"))`)
+    }
+    return name
+  }
+
+  /**
+   * Variable holding the node of the document with this hash if its contents are stored;
+   * nodes created for the ends of an edge have none until the document itself arrives
+   * @param {string} hash
+   */
+  contentVar (hash) {
+    let name = this.contentVars.get(hash)
+    if (!name) {
+      const node = this.nodeVar(hash)
+      name = `c${this.contentVars.size}`
+      this.contentVars.set(hash, name)
+      this.queries.push(`${name} as var(func: uid(${node})) @filter(has(content_groups))`)
+    }
+    return name
+  }
+
+  set (json, condition = null) {
+    this.mutations.push({ set: json, condition })
+  }
+
+  delete (json, condition = null) {
+    this.mutations.push({ delete: json, condition })
+  }
+
+  get query () {
+    return `query {\n  ${this.queries.join('\n  ')}\n}`
+  }
+
+  get size () {
+    return this.mutations.length
+  }
+}
+
+module.exports = UpsertBlock
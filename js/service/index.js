@@ -1,5 +1,11 @@
 const DGraph = require('./DGraph')
+const DocQuery = require('./DocQuery')
+const GraphSync = require('./GraphSync')
+const UpsertBlock = require('./UpsertBlock')
 
 module.exports = {
-  DGraph
+  DGraph,
+  DocQuery,
+  GraphSync,
+  UpsertBlock
 }
@@ -0,0 +1,75 @@
+const commandLineArgs = require('command-line-args')
+const fs = require('fs')
+const path = require('path')
+const { DGraph, GraphSync } = require('./service')
+const { Rows } = require('./util')
+
+const optionDefinitions = [
+  { name: 'folder', alias: 'f', type: String },
+  { name: 'dgraph', type: String, defaultValue: 'localhost:9080' },
+  { name: 'batch', type: Number, defaultValue: 500 },
+  { name: 'concurrency', type: Number, defaultValue: 4 },
+  { name: 'drop', type: Boolean, defaultValue: false }
+]
+
+// prefers the JSON dump, then the binary rows of ExportBinary or graph_generate binary, in
+// either row layout
+function readRows (folder, table, decodeRow) {
+  const file = path.join(folder, `${table}.json`)
+  if (fs.existsSync(file)) {
+    return JSON.parse(fs.readFileSync(file, 'utf8'))
+  }
+  const binary = path.join(folder, `${table}.bin`)
+  return fs.existsSync(binary) ? Rows.splitRows(fs.readFileSync(binary)).map(decodeRow) : []
+}
+
+/**
+ * Loads the documents.json and edges.json written by SaveGraph, or by graph_generate dump, or
+ * the documents.bin and edges.bin written by ExportBinary and graph_generate binary, into
+ * Dgraph through the same sync pipeline the listener uses
+ */
+async function syncDump ({ dgraph, folder, batchSize, concurrency }) {
+  const sync = new GraphSync({ dgraph, batchSize, concurrency })
+  await sync.setSchema()
+
+  for (const doc of readRows(folder, 'documents', Rows.decodeDocumentRow)) {
+    await sync.addDocument(doc)
+  }
+  for (const edge of readRows(folder, 'edges', Rows.decodeEdgeRow)) {
+    await sync.addEdge(edge)
+  }
+  await sync.flush()
+  return sync.stats
+}
+
+const main = async () => {
+  const opts = commandLineArgs(optionDefinitions)
+  if (!opts.folder) {
+    console.log('usage: node sync-dump.js --folder <dump folder> [--dgraph host:port] [--batch n] [--concurrency n] [--drop]')
+    return
+  }
+
+  const dgraph = new DGraph({ addr: opts.dgraph })
+  try {
+    if (opts.drop) {
+      await dgraph.dropAll()
+    }
+    const start = Date.now()
+    const stats = await syncDump({
+      dgraph,
+      folder: opts.folder,
+      batchSize: opts.batch,
+      concurrency: opts.concurrency
+    })
+    const seconds = (Date.now() - start) / 1000
+    console.log(`${stats.documents} documents, ${stats.edges} edges in ${stats.batches} batches, ${stats.retries} retries, ${seconds.toFixed(2)} s`)
+  } finally {
+    dgraph.close()
+  }
+}
+
+if (require.main === module) {
+  main()
+}
+
+module.exports = syncDump
@@ -0,0 +1,137 @@
+const { TextEncoder, TextDecoder } = require('util')
+const { Numeric, Serialize } = require('eosjs')
+
+const EDGE_V1_SIZE = 128
+const EDGE_V2_SIZE = 92
+const DOCUMENT_V1_TAIL_SIZE = 16
+const DOCUMENT_V2_TAIL_SIZE = 4
+
+// in the order of the FlexValue variant
+const VALUE_TYPES = ['monostate', 'name', 'string', 'asset', 'time_point', 'int64', 'checksum256']
+
+/**
+ * Decodes packed documents and edges rows, as returned by get_table_rows with json=false or
+ * written to documents.bin and edges.bin, in both the v1 and the compact v2 layout. The
+ * layout is told apart by the row size; rows come out in the JSON shape of get_table_rows.
+ */
+class Rows {
+  static decodeEdgeRow (bytes) {
+    if (bytes.length !== EDGE_V1_SIZE && bytes.length !== EDGE_V2_SIZE) {
+      throw new Error(`edge row has an unknown layout: ${bytes.length} bytes`)
+    }
+    const v1 = bytes.length === EDGE_V1_SIZE
+    const buffer = Rows._buffer(bytes)
+    const id = Rows._uint64(buffer)
+    if (v1) {
+      buffer.readPos += 3 * 8
+    }
+    const edge = {
+      id,
+      from_node: Rows._checksum256(buffer),
+      to_node: Rows._checksum256(buffer),
+      edge_name: buffer.getName(),
+      created_date: v1 ? Rows._timePoint(buffer) : Serialize.blockTimestampToDate(buffer.getUint32()),
+      creator: buffer.getName()
+    }
+    if (v1) {
+      edge.contract = buffer.getName()
+    }
+    return edge
+  }
+
+  static decodeDocumentRow (bytes) {
+    const buffer = Rows._buffer(bytes)
+    const document = {
+      id: Rows._uint64(buffer),
+      hash: Rows._checksum256(buffer),
+      creator: buffer.getName(),
+      content_groups: Rows._array(buffer, () => Rows._array(buffer, () => ({
+        label: buffer.getString(),
+        value: Rows._value(buffer)
+      }))),
+      certificates: Rows._array(buffer, () => ({
+        certifier: buffer.getName(),
+        notes: buffer.getString(),
+        certification_date: Rows._timePoint(buffer)
+      }))
+    }
+
+    const tail = bytes.length - buffer.readPos
+    if (tail === DOCUMENT_V1_TAIL_SIZE) {
+      document.created_date = Rows._timePoint(buffer)
+      document.contract = buffer.getName()
+    } else if (tail === DOCUMENT_V2_TAIL_SIZE) {
+      document.created_date = Serialize.blockTimestampToDate(buffer.getUint32())
+    } else {
+      throw new Error(`document row has an unknown layout: ${tail} bytes after the certificates`)
+    }
+    return document
+  }
+
+  /**
+   * Splits a documents.bin or edges.bin file into its rows, each a uvarint length then the row
+   */
+  static splitRows (bytes) {
+    const buffer = Rows._buffer(bytes)
+    const rows = []
+    while (buffer.haveReadData()) {
+      const length = buffer.getVaruint32()
+      rows.push(buffer.getUint8Array(length))
+    }
+    return rows
+  }
+
+  static _buffer (bytes) {
+    return new Serialize.SerialBuffer({
+      textEncoder: new TextEncoder(),
+      textDecoder: new TextDecoder(),
+      array: Uint8Array.from(bytes)
+    })
+  }
+
+  static _array (buffer, read) {
+    const values = []
+    for (let count = buffer.getVaruint32(); count > 0; count--) {
+      values.push(read())
+    }
+    return values
+  }
+
+  static _value (buffer) {
+    const type = VALUE_TYPES[buffer.getVaruint32()]
+    switch (type) {
+      case 'monostate':
+        return [type, {}]
+      case 'name':
+        return [type, buffer.getName()]
+      case 'string':
+        return [type, buffer.getString()]
+      case 'asset':
+        return [type, buffer.getAsset()]
+      case 'time_point':
+        return [type, Rows._timePoint(buffer)]
+      case 'int64':
+        return [type, Numeric.signedBinaryToDecimal(buffer.getUint8Array(8))]
+      case 'checksum256':
+        return [type, Rows._checksum256(buffer)]
+      default:
+        throw new Error('content value has an unknown type')
+    }
+  }
+
+  static _uint64 (buffer) {
+    return Numeric.binaryToDecimal(buffer.getUint8Array(8))
+  }
+
+  static _checksum256 (buffer) {
+    return Serialize.arrayToHex(buffer.getUint8Array(32)).toLowerCase()
+  }
+
+  static _timePoint (buffer) {
+    const low = buffer.getUint32()
+    const high = buffer.getUint32()
+    return Serialize.timePointToDate(high * 0x100000000 + low)
+  }
+}
+
+module.exports = Rows
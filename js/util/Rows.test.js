@@ -0,0 +1,135 @@
+/* eslint-disable no-undef */
+const Rows = require('./Rows')
+
+const HASH_A = '2404353ebf87567c6e52586a5e1e6c18da17b8a45f324a5ef716da67e9506cc5'
+const HASH_B = '92a8ca3402790f27b6ee79b9f9bd4c0d4b05f0770cd9315c8cc924f67b7bc514'
+
+// names, numbers and times packed as the contract packs them, little-endian
+const OWNS = '00000000008027a7'
+const JOHNNY = '104cabbef9391b7d' // johnnyhypha1
+const DAO = '000030adfa06a849' // dao.hypha
+const CERTIFIER = '0040b8ca2d97af42' // certifier1
+const CREATED_TIME_POINT = '20a322e6d5b70500' // 2021-01-01T12:30:00.500 in microseconds
+const CREATED_SLOT = '91a4034f' // 2021-01-01T12:30:00.500 in half-second block slots
+const CREATED = '2021-01-01T12:30:00.500'
+
+const bytes = (...parts) => Buffer.from(parts.join(''), 'hex')
+
+const uvarint = (value) => {
+  const encoded = []
+  for (; value >= 0x80; value >>>= 7) {
+    encoded.push((value & 0x7f) | 0x80)
+  }
+  encoded.push(value)
+  return Buffer.from(encoded)
+}
+
+const EDGE_V1 = bytes(
+  '15cd5b0700000000', // id 123456789
+  '010000000000000002000000000000000300000000000000', // the three index keys, skipped
+  HASH_A, HASH_B, OWNS, CREATED_TIME_POINT, JOHNNY, DAO
+)
+
+const EDGE_V2 = bytes('15cd5b0700000000', HASH_A, HASH_B, OWNS, CREATED_SLOT, JOHNNY)
+
+const EDGE = {
+  id: '123456789',
+  from_node: HASH_A,
+  to_node: HASH_B,
+  edge_name: 'owns',
+  created_date: CREATED,
+  creator: 'johnnyhypha1'
+}
+
+// everything up to the created date is the same in both document layouts
+const DOCUMENT_HEAD = [
+  '0700000000000000', // id 7
+  HASH_B,
+  JOHNNY,
+  '01', // one content group
+  '07', // of seven contents, one of each value type
+  '046e616d65', '01', DAO, // name: dao.hypha
+  '0474657874', '02', '06c3a9f09f9880', // text: é😀
+  '06616d6f756e74', '03', '6400000000000000', '0248555344000000', // amount: 1.00 HUSD
+  '047768656e', '04', '0040fac1089b0500', // when: 2020-01-01
+  '05636f756e74', '05', 'd6ffffffffffffff', // count: -42
+  '0468617368', '06', HASH_A, // hash
+  '046e6f6e65', '00', // none: monostate
+  '01', CERTIFIER, '026f6b', '0020fa083bba0500' // one certificate, certified 2021-02-01
+]
+
+const DOCUMENT_V1 = bytes(...DOCUMENT_HEAD, CREATED_TIME_POINT, DAO)
+const DOCUMENT_V2 = bytes(...DOCUMENT_HEAD, CREATED_SLOT)
+
+const DOCUMENT = {
+  id: '7',
+  hash: HASH_B,
+  creator: 'johnnyhypha1',
+  content_groups: [[
+    { label: 'name', value: ['name', 'dao.hypha'] },
+    { label: 'text', value: ['string', 'é😀'] },
+    { label: 'amount', value: ['asset', '1.00 HUSD'] },
+    { label: 'when', value: ['time_point', '2020-01-01T00:00:00.000'] },
+    { label: 'count', value: ['int64', '-42'] },
+    { label: 'hash', value: ['checksum256', HASH_A] },
+    { label: 'none', value: ['monostate', {}] }
+  ]],
+  certificates: [
+    { certifier: 'certifier1', notes: 'ok', certification_date: '2021-02-01T00:00:00.000' }
+  ],
+  created_date: CREATED
+}
+
+describe('Test edge rows', () => {
+  test('v1 layout', () => {
+    expect(EDGE_V1.length).toBe(128)
+    expect(Rows.decodeEdgeRow(EDGE_V1)).toEqual({ ...EDGE, contract: 'dao.hypha' })
+  })
+
+  test('v2 layout', () => {
+    expect(EDGE_V2.length).toBe(92)
+    expect(Rows.decodeEdgeRow(EDGE_V2)).toEqual(EDGE)
+  })
+
+  test('unknown layout', () => {
+    expect(() => Rows.decodeEdgeRow(EDGE_V2.subarray(1))).toThrow('edge row has an unknown layout: 91 bytes')
+  })
+})
+
+describe('Test document rows', () => {
+  test('v1 layout', () => {
+    expect(Rows.decodeDocumentRow(DOCUMENT_V1)).toEqual({ ...DOCUMENT, contract: 'dao.hypha' })
+  })
+
+  test('v2 layout', () => {
+    expect(Rows.decodeDocumentRow(DOCUMENT_V2)).toEqual(DOCUMENT)
+  })
+
+  test('unknown layout', () => {
+    expect(() => Rows.decodeDocumentRow(DOCUMENT_V1.subarray(0, DOCUMENT_V1.length - 1)))
+      .toThrow('document row has an unknown layout: 15 bytes after the certificates')
+  })
+})
+
+describe('Test split rows', () => {
+  test('multi-row buffer', () => {
+    // a v2 edge has a one byte length, the others need two bytes
+    const file = Buffer.concat([
+      bytes('8001'), EDGE_V1,
+      bytes('5c'), EDGE_V2,
+      uvarint(DOCUMENT_V2.length), DOCUMENT_V2,
+      uvarint(DOCUMENT_V1.length), DOCUMENT_V1
+    ])
+    expect(uvarint(DOCUMENT_V2.length).length).toBe(2)
+    const rows = Rows.splitRows(file)
+    expect(rows.map(row => Buffer.from(row))).toEqual([EDGE_V1, EDGE_V2, DOCUMENT_V2, DOCUMENT_V1])
+    expect(Rows.decodeEdgeRow(rows[0])).toEqual({ ...EDGE, contract: 'dao.hypha' })
+    expect(Rows.decodeEdgeRow(rows[1])).toEqual(EDGE)
+    expect(Rows.decodeDocumentRow(rows[2])).toEqual(DOCUMENT)
+    expect(Rows.decodeDocumentRow(rows[3])).toEqual({ ...DOCUMENT, contract: 'dao.hypha' })
+  })
+
+  test('empty buffer', () => {
+    expect(Rows.splitRows(Buffer.alloc(0))).toEqual([])
+  })
+})
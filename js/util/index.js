@@ -1,5 +1,7 @@
+const Rows = require('./Rows')
 const Util = require('./Util')
 
 module.exports = {
+  Rows,
   Util
 }
@@ -1,15 +1,45 @@
 #include <docs.hpp>
+#include <document_graph/schema.hpp>
 
 namespace hypha
 {
+   namespace
+   {
+      struct SchemaTestValue
+      {
+         eosio::asset salary;
+         eosio::name recipient;
+         int64_t votes;
+         std::string title;
+         eosio::checksum256 reference;
+         std::optional<eosio::time_point> start;
+      };
+
+      struct SchemaTest
+      {
+         using type = SchemaTestValue;
+         static constexpr std::string_view name = "schematest";
+         static constexpr auto fields = std::make_tuple(
+             schema::field("details", "salary_amount", &SchemaTestValue::salary),
+             schema::field("details", "recipient", &SchemaTestValue::recipient),
+             schema::field("details", "vote_count", &SchemaTestValue::votes),
+             schema::field("details", "title", &SchemaTestValue::title),
+             schema::field("links", "reference", &SchemaTestValue::reference),
+             schema::field("details", "start", &SchemaTestValue::start));
+      };
+   } // namespace
 
    docs::docs(name self, name code, datastream<const char *> ds) : contract(self, code, ds) {}
-   docs::~docs() {}
+   docs::~docs()
+   {
+#ifdef DOCUMENT_GRAPH_INSTRUMENTATION_PRINT
+      printCounters();
+#endif
+   }
 
    void docs::create(name &creator, ContentGroups &content_groups)
    {
-      Document document(get_self(), creator, content_groups);
-      document.emplace();
+      m_dg.createDocument(creator, content_groups);
    }
 
    void docs::getornewget(const name &creator, const ContentGroups &content_groups)
@@ -28,20 +58,143 @@ namespace hypha
 
    void docs::newedge(name &creator, const checksum256 &from_node, const checksum256 &to_node, const name &edge_name)
    {
-      Edge edge(get_self(), creator, from_node, to_node, edge_name);
-      edge.emplace();
+      m_dg.createEdge(creator, from_node, to_node, edge_name);
    }
 
    void docs::removeedge(const checksum256 &from_node, const checksum256 &to_node, const name &edge_name)
    {
-      Edge edge = Edge::get(get_self(), from_node, to_node, edge_name);
-      edge.erase();
+      m_dg.removeEdge(from_node, to_node, edge_name);
    }
 
    void docs::erase(const checksum256 &hash)
    {
-      DocumentGraph dg(get_self());
-      dg.eraseDocument(hash);
+      m_dg.eraseDocument(hash);
+   }
+
+   void docs::update(const name &updater, const checksum256 &hash, ContentGroups &content_groups)
+   {
+      require_auth(updater);
+      m_dg.updateDocument(updater, hash, content_groups);
+   }
+
+   DocumentGraph docs::scoped(const name &scope)
+   {
+#ifdef DOCUMENT_GRAPH_STABLE_IDENTITIES
+      return DocumentGraph(get_self(), scope, true);
+#else
+      return DocumentGraph(get_self(), scope);
+#endif
+   }
+
+   void docs::createin(const name &scope, name &creator, ContentGroups &content_groups)
+   {
+      scoped(scope).createDocument(creator, content_groups);
+   }
+
+   void docs::newedgein(const name &scope, name &creator, const checksum256 &from_node, const checksum256 &to_node, const name &edge_name)
+   {
+      scoped(scope).createEdge(creator, from_node, to_node, edge_name);
+   }
+
+   void docs::removeedgein(const name &scope, const checksum256 &from_node, const checksum256 &to_node, const name &edge_name)
+   {
+      scoped(scope).removeEdge(from_node, to_node, edge_name);
+   }
+
+   void docs::erasein(const name &scope, const checksum256 &hash)
+   {
+      scoped(scope).eraseDocument(hash);
+   }
+
+   void docs::erasescope(const name &scope, const uint64_t &max_rows)
+   {
+      require_auth(get_self());
+      scoped(scope).eraseScope(max_rows);
+   }
+
+#ifdef DOCUMENT_GRAPH_KEYED_DOCUMENTS
+   void docs::migratedocs(const name &scope, const uint64_t &max_rows)
+   {
+      require_auth(get_self());
+      Document::migrate(get_self(), scope, max_rows);
+   }
+#endif
+
+#ifdef DOCUMENT_GRAPH_COMPACT_ROWS
+   void docs::compactdocs(const name &scope, const uint64_t &from_id, const uint64_t &max_rows)
+   {
+      require_auth(get_self());
+      eosio::print("compactdocs: next id ", Document::compact(get_self(), scope, from_id, max_rows));
+   }
+
+   void docs::compactedges(const name &scope, const uint64_t &from_id, const uint64_t &max_rows)
+   {
+      require_auth(get_self());
+      eosio::print("compactedges: next id ", Edge::compact(get_self(), scope, from_id, max_rows));
+   }
+#endif
+
+#ifdef DOCUMENT_GRAPH_JOURNAL
+   void docs::prunejournal(const uint64_t &before_sequence, const uint64_t &max_rows)
+   {
+      require_auth(get_self());
+      journal::prune(get_self(), get_self(), before_sequence, max_rows);
+   }
+
+   void docs::prunejrnlin(const name &scope, const uint64_t &before_sequence, const uint64_t &max_rows)
+   {
+      require_auth(get_self());
+      journal::prune(get_self(), scope, before_sequence, max_rows);
+   }
+#endif
+
+#ifdef DOCUMENT_GRAPH_GC
+   void docs::gcstart(const name &scope, const std::vector<checksum256> &roots, const std::vector<name> &edge_names, const bool &dry_run)
+   {
+      require_auth(get_self());
+      DocumentGraph graph = scoped(scope);
+      gc::start(graph, roots, edge_names, dry_run);
+   }
+
+   void docs::gcstep(const name &scope, const uint64_t &max_rows)
+   {
+      require_auth(get_self());
+      DocumentGraph graph = scoped(scope);
+      gc::step(graph, max_rows);
+   }
+#endif
+
+#ifdef DOCUMENT_GRAPH_QUERY_ACTIONS
+   Document docs::getdoc(const name &scope, const checksum256 &hash)
+   {
+      return scoped(scope).getDocument(hash);
+   }
+
+   std::vector<Document> docs::getdocs(const name &scope, const std::vector<checksum256> &hashes)
+   {
+      DocumentGraph graph = scoped(scope);
+      return query::getDocuments(graph, hashes);
+   }
+
+   EdgePage docs::getedges(const name &scope, const checksum256 &node, const name &edge_name, const bool &incoming,
+                           const std::optional<EdgeCursor> &after, const uint32_t &limit)
+   {
+      DocumentGraph graph = scoped(scope);
+      return query::getEdges(graph, node, edge_name, incoming, after, limit);
+   }
+
+   Neighborhood docs::neighbors(const name &scope, const checksum256 &hash, const name &edge_name,
+                                const std::optional<EdgeCursor> &after, const uint32_t &limit)
+   {
+      DocumentGraph graph = scoped(scope);
+      return query::getNeighbors(graph, hash, edge_name, after, limit);
+   }
+#endif
+
+   void docs::reindexedges(const name &scope, const uint64_t &from_id, const uint64_t &max_rows)
+   {
+      require_auth(get_self());
+      eosio::print("reindexedges: next id ", Edge::reindex(get_self(), scope, from_id, max_rows));
    }
 
    void docs::testgetasset(const checksum256 &hash,
@@ -49,12 +202,23 @@ namespace hypha
                            const string &contentLabel,
                            const asset &contentValue)
    {
-      Document document(get_self(), hash);
+      const Document &document = m_dg.getDocument(hash);
       asset readValue = ContentWrapper::getContent(document.getContentGroups(), groupLabel, contentLabel).getAs<eosio::asset>();
       eosio::check(readValue == contentValue, "read value does not equal content value. read value: " +
                                                   readValue.to_string() + " expected value: " + contentValue.to_string());
    }
 
+   void docs::testschema(const ContentGroups &content_groups)
+   {
+      SchemaTestValue value = schema::decode<SchemaTest>(content_groups);
+      SchemaTestValue decoded = schema::decode<SchemaTest>(schema::encode<SchemaTest>(value));
+
+      eosio::check(decoded.salary == value.salary && decoded.recipient == value.recipient &&
+                       decoded.votes == value.votes && decoded.title == value.title &&
+                       decoded.reference == value.reference && decoded.start == value.start,
+                   "schema values changed when encoded and decoded again");
+   }
+
    // void docs::fork (const checksum256 &hash, const name &creator, const vector<document_graph::content_group> &content_groups )
    // {
    //    _document_graph.fork_document(hash, creator, content_groups);
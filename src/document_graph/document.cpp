@@ -1,7 +1,12 @@
 #include <document_graph/document.hpp>
 #include <document_graph/content_group.hpp>
 #include <document_graph/util.hpp>
+#include <document_graph/instrumentation.hpp>
+#include <document_graph/journal.hpp>
 #include <eosio/crypto.hpp>
+#include <eosio/action.hpp>
+
+#include <limits>
 
 namespace hypha
 {
@@ -10,7 +15,10 @@ namespace hypha
     Document::Document() {}
 
     Document::Document(eosio::name contract, eosio::name creator, ContentGroups contentGroups)
-        : contract{contract}, creator{creator}, content_groups{std::move(contentGroups)}
+        : creator{creator}, content_groups{std::move(contentGroups)}
+#ifndef DOCUMENT_GRAPH_COMPACT_ROWS
+          , contract{contract}
+#endif
     {
         hashContents();
     }
@@ -30,59 +38,341 @@ namespace hypha
         Document(contract, creator, rollup(Content(label, value)));
     }
 
-    Document::Document(eosio::name contract, const eosio::checksum256 &_hash) : contract{contract}
+    Document::Document(eosio::name contract, const eosio::checksum256 &_hash)
+#ifndef DOCUMENT_GRAPH_COMPACT_ROWS
+        : contract{contract}
+#endif
     {
-        document_table d_t(contract, contract.value);
-        auto hash_index = d_t.get_index<eosio::name("idhash")>();
-        auto h_itr = hash_index.find(_hash);
-        eosio::check(h_itr != hash_index.end(), "document not found: " + readableHash(_hash));
+        DocumentTables tables(contract);
+        eosio::check(load(tables, _hash), "document not found: " + readableHash(_hash));
+        hashContents();
+
+        // this should never happen, only if hash algorithm somehow changed
+        eosio::check(hash == _hash, "fatal error: provided and indexed hash does not match newly generated hash");
+    }
 
-        id = h_itr->id;
-        creator = h_itr->creator;
-        created_date = h_itr->created_date;
-        certificates = h_itr->certificates;
-        content_groups = h_itr->content_groups;
+    Document::Document(DocumentTables &tables, const eosio::checksum256 &_hash)
+#ifndef DOCUMENT_GRAPH_COMPACT_ROWS
+        : contract{tables.contract}
+#endif
+    {
+        eosio::check(load(tables, _hash), "document not found: " + readableHash(_hash));
         hashContents();
 
         // this should never happen, only if hash algorithm somehow changed
         eosio::check(hash == _hash, "fatal error: provided and indexed hash does not match newly generated hash");
     }
 
+    uint64_t Document::hashKey(const eosio::checksum256 &hash)
+    {
+        auto hbytes = hash.extract_as_byte_array();
+        uint64_t key = 0;
+        for (int i = 0; i < 8; i++)
+        {
+            key <<= 8;
+            key |= hbytes[i];
+        }
+
+        // keep the whole probe window inside the key space
+        return std::min(key, std::numeric_limits<uint64_t>::max() - MAX_KEY_PROBES);
+    }
+
+    // erased rows can leave holes in a probe window, so the whole window is scanned in key
+    // order rather than stopping at the first unused key
+    static Document::keyed_document_table::const_iterator findKeyed(const Document::keyed_document_table &k_t,
+                                                                    const eosio::checksum256 &hash)
+    {
+        uint64_t key = Document::hashKey(hash);
+        auto itr = k_t.lower_bound(key);
+        DG_COUNT_INDEX("docsbyhash", "primary", lookups, 1);
+        while (itr != k_t.end() && itr->primary_key() < key + Document::MAX_KEY_PROBES)
+        {
+            DG_COUNT_INDEX("docsbyhash", "primary", reads, 1);
+            if (itr->getHash() == hash)
+            {
+                return itr;
+            }
+            itr++;
+        }
+        return k_t.end();
+    }
+
+    // returns the first unused key in the probe window, failing if the hash is already stored
+    static uint64_t availableKey(const Document::keyed_document_table &k_t, const eosio::checksum256 &hash)
+    {
+        uint64_t key = Document::hashKey(hash);
+        uint64_t available = key + Document::MAX_KEY_PROBES;
+        auto itr = k_t.lower_bound(key);
+        DG_COUNT_INDEX("docsbyhash", "primary", lookups, 1);
+
+        for (uint64_t probe = key; probe < key + Document::MAX_KEY_PROBES; probe++)
+        {
+            if (itr != k_t.end() && itr->primary_key() == probe)
+            {
+                DG_COUNT_INDEX("docsbyhash", "primary", reads, 1);
+                eosio::check(itr->getHash() != hash, "document exists already: " + readableHash(hash));
+                itr++;
+            }
+            else if (available == key + Document::MAX_KEY_PROBES)
+            {
+                available = probe;
+            }
+        }
+
+        eosio::check(available < key + Document::MAX_KEY_PROBES, "no primary key available for document: " + readableHash(hash));
+        return available;
+    }
+
+    DocumentTables::DocumentTables(const eosio::name &contract) : DocumentTables(contract, contract)
+    {
+    }
+
+    DocumentTables::DocumentTables(const eosio::name &contract, const eosio::name &scope)
+        : contract{contract}, scope{scope}, documents(contract, scope.value)
+#ifdef DOCUMENT_GRAPH_KEYED_DOCUMENTS
+          , keyedDocuments(contract, scope.value)
+#endif
+    {
+    }
+
+    bool DocumentTables::hasLegacyRows()
+    {
+#ifdef DOCUMENT_GRAPH_KEYED_DOCUMENTS
+        if (!legacyEmpty)
+        {
+            DG_COUNT_INDEX("documents", "primary", lookups, 1);
+        }
+        legacyEmpty = legacyEmpty || documents.begin() == documents.end();
+        return !legacyEmpty;
+#else
+        return true;
+#endif
+    }
+
+    bool Document::load(DocumentTables &tables, const eosio::checksum256 &_hash)
+    {
+        auto read = [&](const Document &stored) {
+            id = stored.id;
+            creator = stored.creator;
+            created_date = stored.created_date;
+            certificates = stored.certificates;
+            content_groups = stored.content_groups;
+        };
+
+#ifdef DOCUMENT_GRAPH_KEYED_DOCUMENTS
+        auto k_itr = findKeyed(tables.keyedDocuments, _hash);
+        if (k_itr != tables.keyedDocuments.end())
+        {
+            read(*k_itr);
+            return true;
+        }
+#endif
+
+        // in a keyed build, the legacy table only holds documents that have not been migrated yet
+        if (!tables.hasLegacyRows())
+        {
+            return false;
+        }
+
+        auto hash_index = tables.documents.get_index<eosio::name("idhash")>();
+        auto h_itr = hash_index.find(_hash);
+        DG_COUNT_INDEX("documents", "idhash", lookups, 1);
+        if (h_itr == hash_index.end())
+        {
+            return false;
+        }
+
+        DG_COUNT_INDEX("documents", "idhash", reads, 1);
+        read(*h_itr);
+        return true;
+    }
+
+    bool Document::exists(eosio::name contract, const eosio::checksum256 &hash)
+    {
+        DocumentTables tables(contract);
+        return exists(tables, hash);
+    }
+
+    bool Document::exists(DocumentTables &tables, const eosio::checksum256 &hash)
+    {
+#ifdef DOCUMENT_GRAPH_KEYED_DOCUMENTS
+        if (findKeyed(tables.keyedDocuments, hash) != tables.keyedDocuments.end())
+        {
+            return true;
+        }
+#endif
+
+        if (!tables.hasLegacyRows())
+        {
+            return false;
+        }
+
+        auto hash_index = tables.documents.get_index<eosio::name("idhash")>();
+        DG_COUNT_INDEX("documents", "idhash", lookups, 1);
+        return hash_index.find(hash) != hash_index.end();
+    }
+
+    void Document::erase(eosio::name contract, const eosio::checksum256 &hash)
+    {
+        DocumentTables tables(contract);
+        erase(tables, hash);
+    }
+
+    void Document::erase(DocumentTables &tables, const eosio::checksum256 &hash)
+    {
+#ifdef DOCUMENT_GRAPH_KEYED_DOCUMENTS
+        auto k_itr = findKeyed(tables.keyedDocuments, hash);
+        if (k_itr != tables.keyedDocuments.end())
+        {
+            tables.keyedDocuments.erase(k_itr);
+            DG_COUNT_INDEX("docsbyhash", "primary", erases, 1);
+            DG_JOURNAL_DOCUMENT(tables.contract, tables.scope, ERASE_DOCUMENT, hash);
+            return;
+        }
+#endif
+
+        auto hash_index = tables.documents.get_index<eosio::name("idhash")>();
+        auto h_itr = hash_index.find(hash);
+        DG_COUNT_INDEX("documents", "idhash", lookups, 1);
+
+        eosio::check(h_itr != hash_index.end(), "Cannot erase document; does not exist: " + readableHash(hash));
+        hash_index.erase(h_itr);
+        DG_COUNT_INDEX("documents", "idhash", erases, 1);
+        DG_JOURNAL_DOCUMENT(tables.contract, tables.scope, ERASE_DOCUMENT, hash);
+    }
+
     void Document::emplace()
+    {
+        DocumentTables tables(getContract());
+        emplace(tables);
+    }
+
+    void Document::emplace(DocumentTables &tables)
     {
         hashContents();
 
-        document_table d_t(contract, contract.value);
+#ifdef DOCUMENT_GRAPH_KEYED_DOCUMENTS
+        // availableKey errors out if this content exists already in the keyed table
+        uint64_t key = availableKey(tables.keyedDocuments, hash);
+
+        if (tables.hasLegacyRows())
+        {
+            auto hash_index = tables.documents.get_index<eosio::name("idhash")>();
+            DG_COUNT_INDEX("documents", "idhash", lookups, 1);
+            eosio::check(hash_index.find(hash) == hash_index.end(), "document exists already: " + readableHash(hash));
+        }
+
+        tables.keyedDocuments.emplace(tables.contract, [&](auto &d) {
+            id = key;
+            created_date = eosio::current_time_point();
+            d = *this;
+        });
+        DG_COUNT_INDEX("docsbyhash", "primary", writes, 1);
+#else
+        document_table &d_t = tables.documents;
         auto hash_index = d_t.get_index<eosio::name("idhash")>();
         auto h_itr = hash_index.find(hash);
+        DG_COUNT_INDEX("documents", "idhash", lookups, 1);
 
         // if this content exists already, error out and send back the hash of the existing document
         eosio::check(h_itr == hash_index.end(), "document exists already: " + readableHash(hash));
 
-        d_t.emplace(contract, [&](auto &d) {
+        d_t.emplace(tables.contract, [&](auto &d) {
             id = d_t.available_primary_key();
             created_date = eosio::current_time_point();
             d = *this;
         });
+        DG_COUNT_INDEX("documents", "primary", writes, 1);
+#endif
+        DG_JOURNAL_DOCUMENT(tables.contract, tables.scope, CREATE_DOCUMENT, hash);
+    }
+
+#ifdef DOCUMENT_GRAPH_KEYED_DOCUMENTS
+    uint64_t Document::migrate(eosio::name contract, const uint64_t maxRows)
+    {
+        return migrate(contract, contract, maxRows);
+    }
+
+    uint64_t Document::migrate(eosio::name contract, eosio::name scope, const uint64_t maxRows)
+    {
+        document_table d_t(contract, scope.value);
+        keyed_document_table k_t(contract, scope.value);
+
+        uint64_t migrated = 0;
+        auto d_itr = d_t.begin();
+        while (d_itr != d_t.end() && migrated < maxRows)
+        {
+            // creator, created_date and certificates are carried over unchanged
+            Document document = *d_itr;
+            document.id = availableKey(k_t, document.hash);
+            k_t.emplace(contract, [&](auto &d) {
+                d = document;
+            });
+
+            d_itr = d_t.erase(d_itr);
+            migrated++;
+
+            DG_COUNT_INDEX("documents", "primary", reads, 1);
+            DG_COUNT_INDEX("documents", "primary", erases, 1);
+            DG_COUNT_INDEX("docsbyhash", "primary", writes, 1);
+        }
+        return migrated;
+    }
+#endif
+
+#ifdef DOCUMENT_GRAPH_COMPACT_ROWS
+    uint64_t Document::compact(eosio::name contract, eosio::name scope, const uint64_t fromId, const uint64_t maxRows)
+    {
+        // a keyed build emplaces into docsbyhash, and migrate() writes the rows it moves there in
+        // the v2 layout already
+#ifdef DOCUMENT_GRAPH_KEYED_DOCUMENTS
+        keyed_document_table d_t(contract, scope.value);
+        const eosio::name table = eosio::name("docsbyhash");
+#else
+        document_table d_t(contract, scope.value);
+        const eosio::name table = eosio::name("documents");
+#endif
+        auto itr = d_t.lower_bound(fromId);
+        DG_COUNT_INDEX(table, "primary", lookups, 1);
+
+        // no key changes, so modify only repacks the row; v2 rows are written back unchanged
+        uint64_t count = 0;
+        while (itr != d_t.end() && count < maxRows)
+        {
+            d_t.modify(itr, eosio::same_payer, [](auto &) {});
+            itr++;
+            count++;
+
+            DG_COUNT_INDEX(table, "primary", reads, 1);
+            DG_COUNT_INDEX(table, "primary", writes, 1);
+        }
+
+        return itr == d_t.end() ? std::numeric_limits<uint64_t>::max() : itr->primary_key();
+    }
+#endif
+
+    eosio::name Document::getContract() const
+    {
+#ifdef DOCUMENT_GRAPH_COMPACT_ROWS
+        return eosio::current_receiver();
+#else
+        return contract;
+#endif
     }
 
     Document Document::getOrNew(eosio::name _contract, eosio::name _creator, ContentGroups contentGroups)
     {
         Document document{};
+#ifndef DOCUMENT_GRAPH_COMPACT_ROWS
+        document.contract = _contract;
+#endif
         document.content_groups = contentGroups;
         document.hashContents();
 
-        Document::document_table d_t(_contract, _contract.value);
-        auto hash_index = d_t.get_index<eosio::name("idhash")>();
-        auto h_itr = hash_index.find(document.hash);
-
         // if this content exists already, return this one
-        if (h_itr != hash_index.end())
+        DocumentTables tables(_contract);
+        if (document.load(tables, document.hash))
         {
-            document.creator = h_itr->creator;
-            document.created_date = h_itr->created_date;
-            document.certificates = h_itr->certificates;
-            document.id = h_itr->id;
             return document;
         }
 
@@ -184,6 +474,9 @@ namespace hypha
     const eosio::checksum256 Document::hashContents(ContentGroups &contentGroups)
     {
         std::string string_data = toString(contentGroups);
+        DG_COUNT(fingerprintBytes, string_data.length());
+        DG_COUNT(sha256Calls, 1);
+        DG_COUNT(sha256Bytes, string_data.length());
         return eosio::sha256(const_cast<char *>(string_data.c_str()), string_data.length());
     }
 
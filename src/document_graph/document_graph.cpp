@@ -2,21 +2,69 @@
 #include <document_graph/util.hpp>
 #include <document_graph/document_graph.hpp>
 #include <document_graph/document.hpp>
+#include <document_graph/instrumentation.hpp>
+#include <document_graph/journal.hpp>
+#include <document_graph/gc.hpp>
 
 namespace hypha
 {
+    DocumentTables &DocumentGraph::getDocumentTables()
+    {
+        if (!m_documentTables.has_value())
+        {
+            m_documentTables.emplace(m_contract, m_scope);
+        }
+        return *m_documentTables;
+    }
+
+    Edge::edge_table &DocumentGraph::getEdgeTable()
+    {
+        if (!m_edgeTable.has_value())
+        {
+            m_edgeTable.emplace(m_contract, m_scope.value);
+        }
+        return *m_edgeTable;
+    }
+
+    const Document &DocumentGraph::getDocument(const eosio::checksum256 &hash)
+    {
+        auto itr = m_documents.find(hash);
+        if (itr == m_documents.end())
+        {
+            itr = m_documents.emplace(hash, Document(getDocumentTables(), hash)).first;
+        }
+        return itr->second;
+    }
+
+    bool DocumentGraph::documentExists(const eosio::checksum256 &hash)
+    {
+        return m_documents.count(hash) > 0 || Document::exists(getDocumentTables(), hash);
+    }
+
+    Document DocumentGraph::createDocument(const eosio::name &creator, ContentGroups contentGroups)
+    {
+        Document document(m_contract, creator, std::move(contentGroups));
+        document.emplace(getDocumentTables());
+        m_documents.insert_or_assign(document.getHash(), document);
+        return document;
+    }
+
     std::vector<Edge> DocumentGraph::getEdges(const eosio::checksum256 &fromNode, const eosio::checksum256 &toNode)
     {
         std::vector<Edge> edges;
 
-        // this index uniquely identifies all edges that share this fromNode and toNode
-        uint64_t index = concatHash(fromNode, toNode);
-        Edge::edge_table e_t(m_contract, m_contract.value);
+        // this index uniquely identifies all edges that share this fromNode and toNode; the run ends
+        // at upper_bound, as compact rows would have to hash the key of every row to compare it
+        uint64_t index = concatHash(resolveNode(fromNode), resolveNode(toNode));
+        Edge::edge_table &e_t = getEdgeTable();
         auto from_name_index = e_t.get_index<eosio::name("byfromto")>();
-        auto itr = from_name_index.find(index);
+        auto itr = from_name_index.lower_bound(index);
+        auto end = from_name_index.upper_bound(index);
+        DG_COUNT_INDEX("edges", "byfromto", lookups, 2);
 
-        while (itr != from_name_index.end() && itr->by_from_node_to_node_index() == index)
+        while (itr != end)
         {
+            DG_COUNT_INDEX("edges", "byfromto", reads, 1);
             edges.push_back(*itr);
             itr++;
         }
@@ -31,18 +79,61 @@ namespace hypha
         return edges;
     }
 
+    std::vector<Edge> DocumentGraph::getEdgesFrom(const eosio::checksum256 &fromNode)
+    {
+        std::vector<Edge> edges;
+
+        Edge::edge_table &e_t = getEdgeTable();
+        auto from_node_index = e_t.get_index<eosio::name("fromnode")>();
+        eosio::checksum256 node = resolveNode(fromNode);
+        auto itr = from_node_index.find(node);
+        DG_COUNT_INDEX("edges", "fromnode", lookups, 1);
+
+        while (itr != from_node_index.end() && itr->from_node == node)
+        {
+            DG_COUNT_INDEX("edges", "fromnode", reads, 1);
+            edges.push_back(*itr);
+            itr++;
+        }
+
+        return edges;
+    }
+
+    std::vector<Edge> DocumentGraph::getEdgesTo(const eosio::checksum256 &toNode)
+    {
+        std::vector<Edge> edges;
+
+        Edge::edge_table &e_t = getEdgeTable();
+        auto to_node_index = e_t.get_index<eosio::name("tonode")>();
+        eosio::checksum256 node = resolveNode(toNode);
+        auto itr = to_node_index.find(node);
+        DG_COUNT_INDEX("edges", "tonode", lookups, 1);
+
+        while (itr != to_node_index.end() && itr->to_node == node)
+        {
+            DG_COUNT_INDEX("edges", "tonode", reads, 1);
+            edges.push_back(*itr);
+            itr++;
+        }
+
+        return edges;
+    }
+
     std::vector<Edge> DocumentGraph::getEdgesFrom(const eosio::checksum256 &fromNode, const eosio::name &edgeName)
     {
         std::vector<Edge> edges;
 
         // this index uniquely identifies all edges that share this fromNode and edgeName
-        uint64_t index = concatHash(fromNode, edgeName);
-        Edge::edge_table e_t(m_contract, m_contract.value);
+        uint64_t index = concatHash(resolveNode(fromNode), edgeName);
+        Edge::edge_table &e_t = getEdgeTable();
         auto from_name_index = e_t.get_index<eosio::name("byfromname")>();
-        auto itr = from_name_index.find(index);
+        auto itr = from_name_index.lower_bound(index);
+        auto end = from_name_index.upper_bound(index);
+        DG_COUNT_INDEX("edges", "byfromname", lookups, 2);
 
-        while (itr != from_name_index.end() && itr->by_from_node_edge_name_index() == index)
+        while (itr != end)
         {
+            DG_COUNT_INDEX("edges", "byfromname", reads, 1);
             edges.push_back(*itr);
             itr++;
         }
@@ -62,13 +153,16 @@ namespace hypha
         std::vector<Edge> edges;
 
         // this index uniquely identifies all edges that share this toNode and edgeName
-        uint64_t index = concatHash(toNode, edgeName);
-        Edge::edge_table e_t(m_contract, m_contract.value);
+        uint64_t index = concatHash(resolveNode(toNode), edgeName);
+        Edge::edge_table &e_t = getEdgeTable();
         auto from_name_index = e_t.get_index<eosio::name("bytoname")>();
-        auto itr = from_name_index.find(index);
+        auto itr = from_name_index.lower_bound(index);
+        auto end = from_name_index.upper_bound(index);
+        DG_COUNT_INDEX("edges", "bytoname", lookups, 2);
 
-        while (itr != from_name_index.end() && itr->by_to_node_edge_name_index() == index)
+        while (itr != end)
         {
+            DG_COUNT_INDEX("edges", "bytoname", reads, 1);
             edges.push_back(*itr);
             itr++;
         }
@@ -83,71 +177,205 @@ namespace hypha
         return edges;
     }
 
+    // walks one prefix of a time-ordered index between the range bounds, skipping rows up to and
+    // including range.after; rows with an equal key are ordered by primary key
+    template <typename Index, typename Matches>
+    static std::vector<Edge> scanByTime(const Index &index, const eosio::name &indexName, const uint64_t prefix,
+                                        const EdgeRange &range, Matches &&matches)
+    {
+        std::vector<Edge> edges;
+        uint128_t lower = Edge::timeKey(prefix, range.start);
+        uint128_t upper = Edge::timeKey(prefix, range.end);
+
+        auto isAfter = [&](const Edge &edge) {
+            if (!range.after.has_value())
+            {
+                return true;
+            }
+            if (edge.getCreated() != range.after->getCreated())
+            {
+                return range.newestFirst ? edge.getCreated() < range.after->getCreated()
+                                         : edge.getCreated() > range.after->getCreated();
+            }
+            return range.newestFirst ? edge.id < range.after->id : edge.id > range.after->id;
+        };
+
+        // rows up to the resume point are still visited to skip those sharing its created time
+        if (range.after.has_value() && range.newestFirst)
+        {
+            upper = std::min(upper, Edge::timeKey(prefix, range.after->getCreated()));
+        }
+        else if (range.after.has_value())
+        {
+            lower = std::max(lower, Edge::timeKey(prefix, range.after->getCreated()));
+        }
+
+        auto first = index.lower_bound(lower);
+        auto last = index.upper_bound(upper);
+        DG_COUNT_INDEX("edges", indexName, lookups, 2);
+
+        if (range.newestFirst)
+        {
+            auto itr = last;
+            while (itr != first && edges.size() < range.limit)
+            {
+                --itr;
+                DG_COUNT_INDEX("edges", indexName, reads, 1);
+                if (matches(*itr) && isAfter(*itr))
+                {
+                    edges.push_back(*itr);
+                }
+            }
+        }
+        else
+        {
+            auto itr = first;
+            while (itr != last && edges.size() < range.limit)
+            {
+                DG_COUNT_INDEX("edges", indexName, reads, 1);
+                if (matches(*itr) && isAfter(*itr))
+                {
+                    edges.push_back(*itr);
+                }
+                itr++;
+            }
+        }
+
+        return edges;
+    }
+
+    std::vector<Edge> DocumentGraph::getEdgesFrom(const eosio::checksum256 &fromNode, const eosio::name &edgeName, const EdgeRange &range)
+    {
+        eosio::checksum256 node = resolveNode(fromNode);
+        Edge::edge_table &e_t = getEdgeTable();
+        auto from_time_index = e_t.get_index<eosio::name("byfromtime")>();
+
+        // the prefix is a 64-bit hash, so rows of colliding nodes are filtered out
+        return scanByTime(from_time_index, eosio::name("byfromtime"), Edge::nodeNameKey(node, edgeName), range, [&](const Edge &edge) {
+            return edge.from_node == node && edge.edge_name == edgeName;
+        });
+    }
+
+    std::vector<Edge> DocumentGraph::getEdgesTo(const eosio::checksum256 &toNode, const eosio::name &edgeName, const EdgeRange &range)
+    {
+        eosio::checksum256 node = resolveNode(toNode);
+        Edge::edge_table &e_t = getEdgeTable();
+        auto to_time_index = e_t.get_index<eosio::name("bytotime")>();
+
+        return scanByTime(to_time_index, eosio::name("bytotime"), Edge::nodeNameKey(node, edgeName), range, [&](const Edge &edge) {
+            return edge.to_node == node && edge.edge_name == edgeName;
+        });
+    }
+
+    std::vector<Edge> DocumentGraph::getEdgesByName(const eosio::name &edgeName, const EdgeRange &range)
+    {
+        Edge::edge_table &e_t = getEdgeTable();
+        auto name_time_index = e_t.get_index<eosio::name("bynametime")>();
+
+        return scanByTime(name_time_index, eosio::name("bynametime"), edgeName.value, range, [&](const Edge &edge) {
+            return edge.edge_name == edgeName;
+        });
+    }
+
     // since we are removing multiple edges here, we do not call erase on each edge, which
     // would instantiate the table on each call.  This is faster execution.
     void DocumentGraph::removeEdges(const eosio::checksum256 &node)
     {
-        Edge::edge_table e_t(m_contract, m_contract.value);
+        Edge::edge_table &e_t = getEdgeTable();
 
         auto from_node_index = e_t.get_index<eosio::name("fromnode")>();
         auto from_itr = from_node_index.find(node);
+        DG_COUNT_INDEX("edges", "fromnode", lookups, 1);
 
-        while (from_itr != from_node_index.end() && from_itr->to_node == node)
+        while (from_itr != from_node_index.end() && from_itr->from_node == node)
         {
+            DG_JOURNAL_EDGE(m_contract, m_scope, ERASE_EDGE, *from_itr);
             from_itr = from_node_index.erase(from_itr);
+            DG_COUNT_INDEX("edges", "fromnode", reads, 1);
+            DG_COUNT_INDEX("edges", "fromnode", erases, 1);
         }
 
         auto to_node_index = e_t.get_index<eosio::name("tonode")>();
         auto to_itr = to_node_index.find(node);
+        DG_COUNT_INDEX("edges", "tonode", lookups, 1);
 
         while (to_itr != to_node_index.end() && to_itr->to_node == node)
         {
+            DG_JOURNAL_EDGE(m_contract, m_scope, ERASE_EDGE, *to_itr);
             to_itr = to_node_index.erase(to_itr);
+            DG_COUNT_INDEX("edges", "tonode", reads, 1);
+            DG_COUNT_INDEX("edges", "tonode", erases, 1);
         }
     }
 
     void DocumentGraph::replaceNode(const eosio::checksum256 &oldNode, const eosio::checksum256 &newNode)
     {
-        Edge::edge_table e_t(m_contract, m_contract.value);
+        Edge::edge_table &e_t = getEdgeTable();
 
         auto from_node_index = e_t.get_index<eosio::name("fromnode")>();
         auto from_itr = from_node_index.find(oldNode);
+        DG_COUNT_INDEX("edges", "fromnode", lookups, 1);
 
         while (from_itr != from_node_index.end() && from_itr->from_node == oldNode)
         {
             // create the new edge record
             Edge newEdge(m_contract, m_contract, newNode, from_itr->to_node, from_itr->edge_name);
-            newEdge.emplace();
+            newEdge.emplace(e_t);
 
             // erase the old edge record
+            DG_JOURNAL_EDGE(m_contract, m_scope, ERASE_EDGE, *from_itr);
             from_itr = from_node_index.erase(from_itr);
+            DG_COUNT_INDEX("edges", "fromnode", reads, 1);
+            DG_COUNT_INDEX("edges", "fromnode", erases, 1);
         }
 
         auto to_node_index = e_t.get_index<eosio::name("tonode")>();
         auto to_itr = to_node_index.find(oldNode);
+        DG_COUNT_INDEX("edges", "tonode", lookups, 1);
 
         while (to_itr != to_node_index.end() && to_itr->to_node == oldNode)
         {
             // create the new edge record
             Edge newEdge(m_contract, m_contract, to_itr->from_node, newNode, to_itr->edge_name);
-            newEdge.emplace();
+            newEdge.emplace(e_t);
 
             // erase the old edge record
+            DG_JOURNAL_EDGE(m_contract, m_scope, ERASE_EDGE, *to_itr);
             to_itr = to_node_index.erase(to_itr);
+            DG_COUNT_INDEX("edges", "tonode", reads, 1);
+            DG_COUNT_INDEX("edges", "tonode", erases, 1);
         }
     }
 
+    Edge DocumentGraph::createEdge(eosio::name &creator, const eosio::checksum256 &fromNode, const eosio::checksum256 &toNode, const eosio::name &edgeName)
+    {
+        Edge edge(m_contract, creator, resolveNode(fromNode), resolveNode(toNode), edgeName);
+        edge.emplace(getEdgeTable());
+        return edge;
+    }
+
+    void DocumentGraph::removeEdge(const eosio::checksum256 &fromNode, const eosio::checksum256 &toNode, const eosio::name &edgeName)
+    {
+        Edge edge = Edge::get(m_contract, m_scope, resolveNode(fromNode), resolveNode(toNode), edgeName);
+        edge.erase(getEdgeTable());
+    }
+
     Document DocumentGraph::updateDocument(const eosio::name &updater,
                                            const eosio::checksum256 &documentHash,
                                            ContentGroups contentGroups)
     {
+        if (m_stableIdentities)
+        {
+            return updateVersion(updater, documentHash, contentGroups);
+        }
+
         // removing this under guiding principle that "all authentication checks
         // should take place in contract proper and not DocumentGraph"ß
         // require_auth(updater);
 
-        Document currentDocument(m_contract, documentHash);
-        Document newDocument(m_contract, updater, contentGroups);
-        newDocument.emplace();
+        // fails if the current document does not exist
+        getDocument(documentHash);
+        Document newDocument = createDocument(updater, contentGroups);
 
         replaceNode(documentHash, newDocument.getHash());
         eraseDocument(documentHash, false);
@@ -157,22 +385,288 @@ namespace hypha
     // for now, permissions should be handled in the contract action rather than this class
     void DocumentGraph::eraseDocument(const eosio::checksum256 &documentHash, const bool includeEdges)
     {
-        Document::document_table d_t(m_contract, m_contract.value);
-        auto hash_index = d_t.get_index<eosio::name("idhash")>();
-        auto h_itr = hash_index.find(documentHash);
+        if (m_stableIdentities)
+        {
+            return eraseIdentity(getIdentity(documentHash), includeEdges);
+        }
 
-        eosio::check(h_itr != hash_index.end(), "Cannot erase document; does not exist: " + readableHash(documentHash));
+        // fails if the document does not exist, before any edges are touched
+        Document::erase(getDocumentTables(), documentHash);
+        m_documents.erase(documentHash);
 
         if (includeEdges)
         {
             removeEdges(documentHash);
         }
-
-        hash_index.erase(h_itr);
     }
 
     void DocumentGraph::eraseDocument(const eosio::checksum256 &documentHash)
     {
         return eraseDocument(documentHash, true);
     }
+
+    eosio::checksum256 DocumentGraph::resolveNode(const eosio::checksum256 &hash)
+    {
+        return m_stableIdentities ? getIdentity(hash) : hash;
+    }
+
+    eosio::checksum256 DocumentGraph::getIdentity(const eosio::checksum256 &hash)
+    {
+        // every version after the first has a link that records its identity
+        DocumentVersion::version_table v_t(m_contract, m_scope.value);
+        auto hash_index = v_t.get_index<eosio::name("byhash")>();
+        auto v_itr = hash_index.find(hash);
+        DG_COUNT_INDEX("docversions", "byhash", lookups, 1);
+
+        if (v_itr == hash_index.end())
+        {
+            return hash;
+        }
+        DG_COUNT_INDEX("docversions", "byhash", reads, 1);
+        return v_itr->identity;
+    }
+
+    Document DocumentGraph::getHead(const eosio::checksum256 &identity)
+    {
+        DocumentHead::head_table h_t(m_contract, m_scope.value);
+        auto identity_index = h_t.get_index<eosio::name("byidentity")>();
+        auto h_itr = identity_index.find(identity);
+        DG_COUNT_INDEX("docheads", "byidentity", lookups, 1);
+
+        if (h_itr == identity_index.end())
+        {
+            return getDocument(identity);
+        }
+        DG_COUNT_INDEX("docheads", "byidentity", reads, 1);
+        return getDocument(h_itr->head);
+    }
+
+    std::vector<eosio::checksum256> DocumentGraph::getVersions(const eosio::checksum256 &identity)
+    {
+        std::vector<eosio::checksum256> versions;
+
+        DocumentHead::head_table h_t(m_contract, m_scope.value);
+        auto identity_index = h_t.get_index<eosio::name("byidentity")>();
+        auto h_itr = identity_index.find(identity);
+        DG_COUNT_INDEX("docheads", "byidentity", lookups, 1);
+        eosio::checksum256 hash = h_itr == identity_index.end() ? identity : h_itr->head;
+
+        DocumentVersion::version_table v_t(m_contract, m_scope.value);
+        auto hash_index = v_t.get_index<eosio::name("byhash")>();
+        while (hash != identity)
+        {
+            versions.push_back(hash);
+
+            auto v_itr = hash_index.find(hash);
+            DG_COUNT_INDEX("docversions", "byhash", lookups, 1);
+            eosio::check(v_itr != hash_index.end(), "fatal error: version chain is broken at " + readableHash(hash));
+            DG_COUNT_INDEX("docversions", "byhash", reads, 1);
+            hash = v_itr->previous;
+        }
+
+        versions.push_back(identity);
+        return versions;
+    }
+
+    // the old version is kept and edges are not touched, so the cost does not depend on the
+    // number of edges; writes are the new document, the head row and one version link
+    Document DocumentGraph::updateVersion(const eosio::name &updater,
+                                          const eosio::checksum256 &documentHash,
+                                          ContentGroups contentGroups)
+    {
+        eosio::checksum256 identity = getIdentity(documentHash);
+
+        DocumentHead::head_table h_t(m_contract, m_scope.value);
+        auto identity_index = h_t.get_index<eosio::name("byidentity")>();
+        auto h_itr = identity_index.find(identity);
+        DG_COUNT_INDEX("docheads", "byidentity", lookups, 1);
+
+        eosio::checksum256 current = identity;
+        if (h_itr == identity_index.end())
+        {
+            eosio::check(documentExists(identity), "document not found: " + readableHash(identity));
+        }
+        else
+        {
+            current = h_itr->head;
+        }
+
+        // the identity always refers to the current version, an older version hash does not
+        eosio::check(documentHash == current || documentHash == identity,
+                     "cannot update " + readableHash(documentHash) + "; current version is " + readableHash(current));
+
+        // a hash links to one previous version, so content an identity had before would close the
+        // chain into a loop; the content of a version cannot be written again, even once erased
+        Document newDocument(m_contract, updater, std::move(contentGroups));
+        eosio::checksum256 newHash = newDocument.getHash();
+        eosio::checksum256 owner = getIdentity(newHash);
+        eosio::check(owner == newHash && newHash != identity,
+                     "cannot update " + readableHash(documentHash) + " to " + readableHash(newHash) +
+                         "; it is already a version of " + readableHash(owner));
+
+        newDocument.emplace(getDocumentTables());
+        m_documents.insert_or_assign(newHash, newDocument);
+
+        uint64_t version = 1;
+        if (h_itr == identity_index.end())
+        {
+            h_t.emplace(m_contract, [&](auto &h) {
+                h.id = h_t.available_primary_key();
+                h.identity = identity;
+                h.head = newDocument.getHash();
+                h.version = version;
+                h.updater = updater;
+                h.updated_date = eosio::current_time_point();
+            });
+            DG_COUNT_INDEX("docheads", "primary", writes, 1);
+        }
+        else
+        {
+            version = h_itr->version + 1;
+            identity_index.modify(h_itr, m_contract, [&](auto &h) {
+                h.head = newDocument.getHash();
+                h.version = version;
+                h.updater = updater;
+                h.updated_date = eosio::current_time_point();
+            });
+            DG_COUNT_INDEX("docheads", "byidentity", writes, 1);
+        }
+
+        DocumentVersion::version_table v_t(m_contract, m_scope.value);
+        v_t.emplace(m_contract, [&](auto &v) {
+            v.id = v_t.available_primary_key();
+            v.hash = newDocument.getHash();
+            v.identity = identity;
+            v.previous = current;
+            v.version = version;
+        });
+        DG_COUNT_INDEX("docversions", "primary", writes, 1);
+
+        return newDocument;
+    }
+
+    void DocumentGraph::eraseIdentity(const eosio::checksum256 &identity, const bool includeEdges)
+    {
+        std::vector<eosio::checksum256> versions = getVersions(identity);
+
+        // the current version must exist, older versions may have been erased separately
+        Document::erase(getDocumentTables(), versions.front());
+        m_documents.erase(versions.front());
+
+        DocumentVersion::version_table v_t(m_contract, m_scope.value);
+        auto hash_index = v_t.get_index<eosio::name("byhash")>();
+        for (std::size_t i = 1; i < versions.size(); ++i)
+        {
+            if (documentExists(versions[i]))
+            {
+                Document::erase(getDocumentTables(), versions[i]);
+                m_documents.erase(versions[i]);
+            }
+        }
+
+        for (std::size_t i = 0; i + 1 < versions.size(); ++i)
+        {
+            auto v_itr = hash_index.find(versions[i]);
+            hash_index.erase(v_itr);
+            DG_COUNT_INDEX("docversions", "byhash", lookups, 1);
+            DG_COUNT_INDEX("docversions", "byhash", erases, 1);
+        }
+
+        DocumentHead::head_table h_t(m_contract, m_scope.value);
+        auto identity_index = h_t.get_index<eosio::name("byidentity")>();
+        auto h_itr = identity_index.find(identity);
+        DG_COUNT_INDEX("docheads", "byidentity", lookups, 1);
+        if (h_itr != identity_index.end())
+        {
+            identity_index.erase(h_itr);
+            DG_COUNT_INDEX("docheads", "byidentity", erases, 1);
+        }
+
+        if (includeEdges)
+        {
+            removeEdges(identity);
+        }
+    }
+
+    uint64_t DocumentGraph::eraseScope(const uint64_t maxRows)
+    {
+        uint64_t erased = 0;
+
+        // the bookkeeping of a garbage collection of this scope goes first
+        GcState::state_table s_t(m_contract, m_scope.value);
+        auto s_itr = s_t.begin();
+        if (s_itr != s_t.end() && erased < maxRows)
+        {
+            s_t.erase(s_itr);
+            erased++;
+        }
+
+        GcMark::mark_table m_t(m_contract, m_scope.value);
+        auto m_itr = m_t.begin();
+        while (m_itr != m_t.end() && erased < maxRows)
+        {
+            m_itr = m_t.erase(m_itr);
+            erased++;
+        }
+
+        Edge::edge_table &e_t = getEdgeTable();
+        auto e_itr = e_t.begin();
+        DG_COUNT_INDEX("edges", "primary", lookups, 1);
+        while (e_itr != e_t.end() && erased < maxRows)
+        {
+            DG_JOURNAL_EDGE(m_contract, m_scope, ERASE_EDGE, *e_itr);
+            e_itr = e_t.erase(e_itr);
+            DG_COUNT_INDEX("edges", "primary", reads, 1);
+            DG_COUNT_INDEX("edges", "primary", erases, 1);
+            erased++;
+        }
+
+        DocumentVersion::version_table v_t(m_contract, m_scope.value);
+        auto v_itr = v_t.begin();
+        DG_COUNT_INDEX("docversions", "primary", lookups, 1);
+        while (v_itr != v_t.end() && erased < maxRows)
+        {
+            v_itr = v_t.erase(v_itr);
+            DG_COUNT_INDEX("docversions", "primary", erases, 1);
+            erased++;
+        }
+
+        DocumentHead::head_table h_t(m_contract, m_scope.value);
+        auto h_itr = h_t.begin();
+        DG_COUNT_INDEX("docheads", "primary", lookups, 1);
+        while (h_itr != h_t.end() && erased < maxRows)
+        {
+            h_itr = h_t.erase(h_itr);
+            DG_COUNT_INDEX("docheads", "primary", erases, 1);
+            erased++;
+        }
+
+        DocumentTables &tables = getDocumentTables();
+#ifdef DOCUMENT_GRAPH_KEYED_DOCUMENTS
+        auto k_itr = tables.keyedDocuments.begin();
+        DG_COUNT_INDEX("docsbyhash", "primary", lookups, 1);
+        while (k_itr != tables.keyedDocuments.end() && erased < maxRows)
+        {
+            DG_JOURNAL_DOCUMENT(m_contract, m_scope, ERASE_DOCUMENT, k_itr->getHash());
+            k_itr = tables.keyedDocuments.erase(k_itr);
+            DG_COUNT_INDEX("docsbyhash", "primary", reads, 1);
+            DG_COUNT_INDEX("docsbyhash", "primary", erases, 1);
+            erased++;
+        }
+#endif
+
+        auto d_itr = tables.documents.begin();
+        DG_COUNT_INDEX("documents", "primary", lookups, 1);
+        while (d_itr != tables.documents.end() && erased < maxRows)
+        {
+            DG_JOURNAL_DOCUMENT(m_contract, m_scope, ERASE_DOCUMENT, d_itr->getHash());
+            d_itr = tables.documents.erase(d_itr);
+            DG_COUNT_INDEX("documents", "primary", reads, 1);
+            DG_COUNT_INDEX("documents", "primary", erases, 1);
+            erased++;
+        }
+
+        m_documents.clear();
+        return erased;
+    }
 } // namespace hypha
\ No newline at end of file
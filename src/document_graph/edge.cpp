@@ -1,6 +1,13 @@
 #include <document_graph/edge.hpp>
 #include <document_graph/util.hpp>
 #include <document_graph/document.hpp>
+#include <document_graph/instrumentation.hpp>
+#include <document_graph/journal.hpp>
+#include <document_graph/gc.hpp>
+
+#include <eosio/action.hpp>
+
+#include <limits>
 
 namespace hypha
 {
@@ -10,7 +17,10 @@ namespace hypha
                 const eosio::checksum256 &from_node, 
                 const eosio::checksum256 &to_node, 
                 const eosio::name &edge_name) 
-        : contract {contract}, creator {creator}, from_node {from_node}, to_node {to_node}, edge_name{edge_name}
+        : from_node {from_node}, to_node {to_node}, edge_name{edge_name}, creator {creator}
+#ifndef DOCUMENT_GRAPH_COMPACT_ROWS
+        , contract {contract}
+#endif
     { }
 
     Edge::~Edge(){}
@@ -21,78 +31,228 @@ namespace hypha
                     const eosio::checksum256 &_to_node, 
                     const eosio::name &_edge_name)
     {
-        edge_table e_t (_contract, _contract.value);
+        return get (_contract, _contract, _from_node, _to_node, _edge_name);
+    }
+
+    // static getter
+    Edge Edge::get (const eosio::name &_contract,
+                    const eosio::checksum256 &_from_node, 
+                    const eosio::name &_edge_name)
+    {
+        return get (_contract, _contract, _from_node, _edge_name);
+    }
+
+    // static getter
+    bool Edge::exists (const eosio::name &_contract,
+                        const eosio::checksum256 &_from_node, 
+                        const eosio::checksum256 &_to_node, 
+                        const eosio::name &_edge_name)
+    {
+        return exists (_contract, _contract, _from_node, _to_node, _edge_name);
+    }
+
+    Edge Edge::get (const eosio::name &_contract,
+                    const eosio::name &_scope,
+                    const eosio::checksum256 &_from_node, 
+                    const eosio::checksum256 &_to_node, 
+                    const eosio::name &_edge_name)
+    {
+        edge_table e_t (_contract, _scope.value);
         auto itr = e_t.find (concatHash (_from_node, _to_node, _edge_name));
+        DG_COUNT_INDEX ("edges", "primary", lookups, 1);
 
         eosio::check (itr != e_t.end(), "edge does not exist: from " + readableHash(_from_node) 
                 + " to " + readableHash(_to_node) + " with edge name of " + _edge_name.to_string());
 
+        DG_COUNT_INDEX ("edges", "primary", reads, 1);
         return *itr;
     }
 
-    // static getter
     Edge Edge::get (const eosio::name &_contract,
+                    const eosio::name &_scope,
                     const eosio::checksum256 &_from_node, 
                     const eosio::name &_edge_name)
     {
-        edge_table e_t (_contract, _contract.value);
+        edge_table e_t (_contract, _scope.value);
         auto fromEdgeIndex = e_t.get_index<eosio::name("byfromname")>();
         auto index = concatHash (_from_node, _edge_name);
         auto itr = fromEdgeIndex.find (index);
+        DG_COUNT_INDEX ("edges", "byfromname", lookups, 1);
 
-        eosio::check (itr != fromEdgeIndex.end() && itr->from_node_edge_name_index == index, "edge does not exist: from " + readableHash(_from_node) 
+        eosio::check (itr != fromEdgeIndex.end() && itr->by_from_node_edge_name_index() == index, "edge does not exist: from " + readableHash(_from_node) 
                 + " with edge name of " + _edge_name.to_string());
 
+        DG_COUNT_INDEX ("edges", "byfromname", reads, 1);
         return *itr;
     }
 
-    // static getter
     bool Edge::exists (const eosio::name &_contract,
+                        const eosio::name &_scope,
                         const eosio::checksum256 &_from_node, 
                         const eosio::checksum256 &_to_node, 
                         const eosio::name &_edge_name)
     {
-        edge_table e_t (_contract, _contract.value);
+        edge_table e_t (_contract, _scope.value);
         auto itr = e_t.find (concatHash (_from_node, _to_node, _edge_name));
+        DG_COUNT_INDEX ("edges", "primary", lookups, 1);
         if (itr != e_t.end()) return true;
         return false;
     }
 
     void Edge::emplace () 
+    {
+        edge_table e_t(getContract(), getContract().value);
+        emplace (e_t);
+    }
+
+    void Edge::emplace (edge_table &e_t)
     {
         require_auth (creator);
 
         // update indexes prior to save
-        id = concatHash (from_node, to_node, edge_name);
-        from_node_edge_name_index = concatHash(from_node, edge_name);
-        from_node_to_node_index = concatHash(from_node, to_node);
-        to_node_edge_name_index = concatHash(to_node, edge_name);        
+        deriveKeys();
 
-        edge_table e_t(contract, contract.value);
-        e_t.emplace(contract, [&](auto &e) {
+        e_t.emplace(getContract(), [&](auto &e) {
             e = *this;
             e.created_date = eosio::current_time_point();
         });
+        DG_COUNT_INDEX ("edges", "primary", writes, 1);
+        DG_JOURNAL_EDGE (getContract(), eosio::name(e_t.get_scope()), CREATE_EDGE, *this);
+        DG_GC_EDGE (getContract(), eosio::name(e_t.get_scope()), *this);
     }
 
     void Edge::erase ()
     {       
-        edge_table e_t (contract, contract.value);
+        edge_table e_t (getContract(), getContract().value);
+        erase (e_t);
+    }
+
+    void Edge::erase (edge_table &e_t)
+    {
         auto itr = e_t.find (id);
+        DG_COUNT_INDEX ("edges", "primary", lookups, 1);
 
         eosio::check (itr != e_t.end(), "edge does not exist: from " + readableHash(from_node) 
                 + " to " + readableHash(to_node) + " with edge name of " + edge_name.to_string());
         e_t.erase (itr);
+        DG_COUNT_INDEX ("edges", "primary", erases, 1);
+        DG_JOURNAL_EDGE (getContract(), eosio::name(e_t.get_scope()), ERASE_EDGE, *this);
+    }
+
+    uint64_t Edge::reindex (const eosio::name &contract, const uint64_t from_id, const uint64_t max_rows)
+    {
+        return reindex (contract, contract, from_id, max_rows);
+    }
+
+    uint64_t Edge::reindex (const eosio::name &contract, const eosio::name &scope, const uint64_t from_id, const uint64_t max_rows)
+    {
+        edge_table e_t (contract, scope.value);
+        auto itr = e_t.lower_bound (from_id);
+        DG_COUNT_INDEX ("edges", "primary", lookups, 1);
+
+        // erase does not require the new index entries to exist, emplace creates them
+        uint64_t count = 0;
+        while (itr != e_t.end() && count < max_rows)
+        {
+            Edge edge = *itr;
+            itr = e_t.erase (itr);
+            e_t.emplace (contract, [&](auto &e) {
+                e = edge;
+            });
+            count++;
+
+            DG_COUNT_INDEX ("edges", "primary", reads, 1);
+            DG_COUNT_INDEX ("edges", "primary", erases, 1);
+            DG_COUNT_INDEX ("edges", "primary", writes, 1);
+        }
+
+        return itr == e_t.end() ? std::numeric_limits<uint64_t>::max() : itr->id;
+    }
+
+#ifdef DOCUMENT_GRAPH_COMPACT_ROWS
+    uint64_t Edge::compact (const eosio::name &contract, const eosio::name &scope, const uint64_t from_id, const uint64_t max_rows)
+    {
+        edge_table e_t (contract, scope.value);
+        auto itr = e_t.lower_bound (from_id);
+        DG_COUNT_INDEX ("edges", "primary", lookups, 1);
+
+        // no key changes, so modify only repacks the row in the layout of the build; rows that are
+        // v2 already are written back unchanged
+        uint64_t count = 0;
+        while (itr != e_t.end() && count < max_rows)
+        {
+            e_t.modify (itr, eosio::same_payer, [](auto &) {});
+            itr++;
+            count++;
+
+            DG_COUNT_INDEX ("edges", "primary", reads, 1);
+            DG_COUNT_INDEX ("edges", "primary", writes, 1);
+        }
+
+        return itr == e_t.end() ? std::numeric_limits<uint64_t>::max() : itr->id;
+    }
+#endif
+
+    void Edge::deriveKeys ()
+    {
+        id = concatHash (from_node, to_node, edge_name);
+#ifndef DOCUMENT_GRAPH_COMPACT_ROWS
+        from_node_edge_name_index = concatHash (from_node, edge_name);
+        from_node_to_node_index = concatHash (from_node, to_node);
+        to_node_edge_name_index = concatHash (to_node, edge_name);
+#endif
+    }
+
+    eosio::name Edge::getContract () const
+    {
+#ifdef DOCUMENT_GRAPH_COMPACT_ROWS
+        return eosio::current_receiver();
+#else
+        return contract;
+#endif
+    }
+
+    uint64_t Edge::nodeNameKey (const eosio::checksum256 &node, const eosio::name &edge_name)
+    {
+        auto nbytes = node.extract_as_byte_array();
+        uint64_t key = 0;
+        for (int i = 0; i < 8; i++)
+        {
+            key <<= 8;
+            key |= nbytes[i];
+        }
+
+        // splitmix64 finalizer, so that names sharing a prefix spread over the whole key space
+        uint64_t z = edge_name.value;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return key ^ z ^ (z >> 31);
+    }
+
+    uint128_t Edge::timeKey (const uint64_t prefix, const eosio::time_point &created)
+    {
+        return (uint128_t(prefix) << 64) | uint64_t(created.time_since_epoch().count());
     }
 
     uint64_t Edge::primary_key() const { return id; }
+#ifdef DOCUMENT_GRAPH_COMPACT_ROWS
+    // v2 rows do not store these keys; multi_index only asks for them when a row is written
+    uint64_t Edge::by_from_node_edge_name_index() const { return concatHash(from_node, edge_name); }
+    uint64_t Edge::by_from_node_to_node_index() const { return concatHash(from_node, to_node); }
+    uint64_t Edge::by_to_node_edge_name_index() const { return concatHash(to_node, edge_name); }
+#else
     uint64_t Edge::by_from_node_edge_name_index() const { return from_node_edge_name_index; }
     uint64_t Edge::by_from_node_to_node_index() const { return from_node_to_node_index; }
     uint64_t Edge::by_to_node_edge_name_index() const { return to_node_edge_name_index; }
+#endif
     uint64_t Edge::by_edge_name() const { return edge_name.value; }
-    uint64_t Edge::by_created() const { return created_date.sec_since_epoch(); }
+    uint64_t Edge::by_created() const { return getCreated().sec_since_epoch(); }
     uint64_t Edge::by_creator() const { return creator.value; }
 
     eosio::checksum256 Edge::by_from() const { return from_node; }
     eosio::checksum256 Edge::by_to() const { return to_node; }
+
+    uint128_t Edge::by_from_node_edge_name_created() const { return timeKey(nodeNameKey(from_node, edge_name), getCreated()); }
+    uint128_t Edge::by_to_node_edge_name_created() const { return timeKey(nodeNameKey(to_node, edge_name), getCreated()); }
+    uint128_t Edge::by_edge_name_created() const { return timeKey(edge_name.value, getCreated()); }
 }
\ No newline at end of file
@@ -0,0 +1,468 @@
+#include <document_graph/gc.hpp>
+#include <document_graph/document_graph.hpp>
+#include <document_graph/instrumentation.hpp>
+#include <document_graph/journal.hpp>
+#include <document_graph/util.hpp>
+
+#ifdef DOCUMENT_GRAPH_GC
+
+#include <eosio/print.hpp>
+
+#include <optional>
+
+namespace hypha
+{
+    namespace gc
+    {
+        namespace
+        {
+            bool isMarked(const GcMark::mark_table &m_t, const eosio::checksum256 &node)
+            {
+                auto node_index = m_t.get_index<eosio::name("bynode")>();
+                DG_COUNT_INDEX("gcmarks", "bynode", lookups, 1);
+                return node_index.find(node) != node_index.end();
+            }
+
+            // appends the node to the mark queue; returns false if it was marked already
+            bool mark(GcMark::mark_table &m_t, const eosio::name &contract, const eosio::checksum256 &node)
+            {
+                if (isMarked(m_t, node))
+                {
+                    return false;
+                }
+                m_t.emplace(contract, [&](auto &m) {
+                    m.id = m_t.available_primary_key();
+                    m.node = node;
+                });
+                DG_COUNT_INDEX("gcmarks", "primary", writes, 1);
+                return true;
+            }
+
+            // with stable identities the marks hold identities, so a version is live if its identity is marked
+            bool isLive(DocumentGraph &graph, const GcMark::mark_table &m_t, const eosio::checksum256 &hash)
+            {
+                return isMarked(m_t, hash) || (graph.hasStableIdentities() && isMarked(m_t, graph.getIdentity(hash)));
+            }
+
+            // the node that stands for the document in the marks and in its edges
+            eosio::checksum256 nodeOf(DocumentGraph &graph, const eosio::checksum256 &hash)
+            {
+                return graph.hasStableIdentities() ? graph.getIdentity(hash) : hash;
+            }
+
+            // a node that is neither marked nor a document of the scope is not part of the live graph
+            bool isUnreachableDocument(DocumentGraph &graph, const GcMark::mark_table &m_t, const eosio::checksum256 &node)
+            {
+                return !isLive(graph, m_t, node) && graph.documentExists(node);
+            }
+
+            // erases the previous collection's marks, then queues the roots
+            void reset(DocumentGraph &graph, GcState &state, GcMark::mark_table &m_t, uint64_t &used, const uint64_t maxRows)
+            {
+                auto itr = m_t.begin();
+                DG_COUNT_INDEX("gcmarks", "primary", lookups, 1);
+                while (itr != m_t.end() && used < maxRows)
+                {
+                    itr = m_t.erase(itr);
+                    DG_COUNT_INDEX("gcmarks", "primary", erases, 1);
+                    used++;
+                }
+                if (itr != m_t.end())
+                {
+                    return;
+                }
+
+                state.mark_cursor = m_t.available_primary_key();
+                for (const eosio::checksum256 &root : state.roots)
+                {
+                    state.marked += mark(m_t, graph.getContract(), nodeOf(graph, root)) ? 1 : 0;
+                }
+                state.phase = MARK;
+            }
+
+            // visits the edges of one run of an edge index, the rows from lower_bound(key) to
+            // upper_bound(key), until the budget is used, and erases those for which visit returns true.
+            // Returns true once the run is done. after is the primary key of the last edge visited and
+            // kept; the next step resumes behind it through iterator_to. If that edge has been erased
+            // in the meantime, the run starts over: marks and erases are not repeated, a dry run may
+            // count some edges twice.
+            template <typename Index, typename Key, typename Visit>
+            bool visitRun(DocumentGraph &graph, Edge::edge_table &e_t, Index &index, const eosio::name &indexName,
+                          const Key &key, uint64_t &after, uint64_t &used, const uint64_t maxRows, Visit &&visit)
+            {
+                auto itr = index.lower_bound(key);
+                auto last = index.upper_bound(key);
+                DG_COUNT_INDEX("edges", indexName, lookups, 2);
+
+                if (after != GcState::NO_CURSOR)
+                {
+                    auto row = e_t.find(after);
+                    DG_COUNT_INDEX("edges", "primary", lookups, 1);
+                    if (row != e_t.end())
+                    {
+                        itr = index.iterator_to(*row);
+                        itr++;
+                    }
+                }
+
+                while (itr != last && used < maxRows)
+                {
+                    DG_COUNT_INDEX("edges", indexName, reads, 1);
+                    used++;
+                    if (visit(*itr))
+                    {
+                        DG_JOURNAL_EDGE(graph.getContract(), graph.getScope(), ERASE_EDGE, *itr);
+                        itr = index.erase(itr);
+                        DG_COUNT_INDEX("edges", indexName, erases, 1);
+                        continue;
+                    }
+                    after = itr->id;
+                    itr++;
+                }
+
+                if (itr != last)
+                {
+                    return false;
+                }
+                after = GcState::NO_CURSOR;
+                return true;
+            }
+
+            // expands queued marks: their edges, filtered by name if names are set. A node with more
+            // edges than the budget is expanded over several steps; the mark itself counts once it is done.
+            void expand(DocumentGraph &graph, GcState &state, GcMark::mark_table &m_t, uint64_t &used, const uint64_t maxRows)
+            {
+                Edge::edge_table e_t(graph.getContract(), graph.getScope().value);
+                auto markChild = [&](const Edge &edge) {
+                    state.marked += mark(m_t, graph.getContract(), nodeOf(graph, edge.to_node)) ? 1 : 0;
+                    return false;
+                };
+
+                auto itr = m_t.lower_bound(state.mark_cursor);
+                DG_COUNT_INDEX("gcmarks", "primary", lookups, 1);
+                while (itr != m_t.end() && used < maxRows)
+                {
+                    eosio::checksum256 node = itr->node;
+                    uint64_t id = itr->id;
+                    DG_COUNT_INDEX("gcmarks", "primary", reads, 1);
+
+                    if (state.edge_names.empty())
+                    {
+                        auto from_node_index = e_t.get_index<eosio::name("fromnode")>();
+                        if (!visitRun(graph, e_t, from_node_index, eosio::name("fromnode"), node, state.mark_edge, used, maxRows, markChild))
+                        {
+                            return;
+                        }
+                    }
+                    else
+                    {
+                        // the byfromname key is 32 bits, so a collision may mark a node too many;
+                        // that only keeps garbage, it never sweeps a live node
+                        auto from_name_index = e_t.get_index<eosio::name("byfromname")>();
+                        for (; state.mark_run < state.edge_names.size(); state.mark_run++)
+                        {
+                            uint64_t key = concatHash(node, state.edge_names[state.mark_run]);
+                            if (!visitRun(graph, e_t, from_name_index, eosio::name("byfromname"), key, state.mark_edge, used, maxRows, markChild))
+                            {
+                                return;
+                            }
+                        }
+                    }
+
+                    used++;
+                    state.mark_run = 0;
+                    state.mark_cursor = id + 1;
+                    itr = m_t.lower_bound(state.mark_cursor);
+                    DG_COUNT_INDEX("gcmarks", "primary", lookups, 1);
+                }
+
+                if (itr == m_t.end())
+                {
+                    state.phase = SWEEP_DOCUMENTS;
+                }
+            }
+
+            // erases the edges from and then to the swept node, or in a dry run counts them; returns
+            // true once both runs are done. Edges created since the start are kept. In a dry run, edges
+            // from another unreachable document are left to that document so that none is counted twice.
+            bool sweepNodeEdges(DocumentGraph &graph, GcState &state, GcMark::mark_table &m_t, uint64_t &used, const uint64_t maxRows)
+            {
+                Edge::edge_table e_t(graph.getContract(), graph.getScope().value);
+                const eosio::checksum256 node = state.sweeping;
+
+                if (state.sweep_run == 0)
+                {
+                    auto from_node_index = e_t.get_index<eosio::name("fromnode")>();
+                    bool done = visitRun(graph, e_t, from_node_index, eosio::name("fromnode"), node, state.sweep_edge, used, maxRows,
+                                         [&](const Edge &edge) {
+                                             if (edge.getCreated() >= state.started)
+                                             {
+                                                 return false;
+                                             }
+                                             state.edges++;
+                                             return !state.dry_run;
+                                         });
+                    if (!done)
+                    {
+                        return false;
+                    }
+                    state.sweep_run = 1;
+                }
+
+                auto to_node_index = e_t.get_index<eosio::name("tonode")>();
+                bool done = visitRun(graph, e_t, to_node_index, eosio::name("tonode"), node, state.sweep_edge, used, maxRows,
+                                     [&](const Edge &edge) {
+                                         if (edge.getCreated() >= state.started || edge.from_node == node ||
+                                             (state.dry_run && isUnreachableDocument(graph, m_t, edge.from_node)))
+                                         {
+                                             return false;
+                                         }
+                                         state.edges++;
+                                         return !state.dry_run;
+                                     });
+                if (done)
+                {
+                    state.sweep_run = 0;
+                }
+                return done;
+            }
+
+            // scans the table from the cursor for a document created before the start that is not
+            // live; the cursor moves past it, so that erasing it never moves the scan
+            template <typename Table>
+            std::optional<eosio::checksum256> nextUnreachable(DocumentGraph &graph, Table &table, const eosio::name &tableName, const GcState &state,
+                                                              const GcMark::mark_table &m_t, uint64_t &cursor, uint64_t &used, const uint64_t maxRows)
+            {
+                if (cursor == GcState::NO_CURSOR)
+                {
+                    return std::nullopt;
+                }
+
+                std::optional<eosio::checksum256> unreachable;
+                auto itr = table.lower_bound(cursor);
+                DG_COUNT_INDEX(tableName, "primary", lookups, 1);
+                while (itr != table.end() && used < maxRows && !unreachable.has_value())
+                {
+                    DG_COUNT_INDEX(tableName, "primary", reads, 1);
+                    if (itr->getCreated() < state.started && !isLive(graph, m_t, itr->getHash()))
+                    {
+                        unreachable = itr->getHash();
+                    }
+                    used++;
+                    itr++;
+                }
+                cursor = itr == table.end() ? GcState::NO_CURSOR : itr->primary_key();
+                return unreachable;
+            }
+
+            // erases one unreachable document at a time, with stable identities all versions of its
+            // identity, and then its edges over as many steps as they take
+            void sweepDocuments(DocumentGraph &graph, GcState &state, GcMark::mark_table &m_t, uint64_t &used, const uint64_t maxRows)
+            {
+                DocumentTables tables(graph.getContract(), graph.getScope());
+
+                while (used < maxRows)
+                {
+                    if (state.sweeping != eosio::checksum256())
+                    {
+                        if (!sweepNodeEdges(graph, state, m_t, used, maxRows))
+                        {
+                            return;
+                        }
+                        state.sweeping = eosio::checksum256();
+                        continue;
+                    }
+
+                    std::optional<eosio::checksum256> hash;
+#ifdef DOCUMENT_GRAPH_KEYED_DOCUMENTS
+                    hash = nextUnreachable(graph, tables.keyedDocuments, eosio::name("docsbyhash"), state, m_t, state.keyed_cursor, used, maxRows);
+#else
+                    state.keyed_cursor = GcState::NO_CURSOR;
+#endif
+                    if (!hash.has_value())
+                    {
+                        hash = nextUnreachable(graph, tables.documents, eosio::name("documents"), state, m_t, state.document_cursor, used, maxRows);
+                    }
+                    if (!hash.has_value())
+                    {
+                        if (state.keyed_cursor == GcState::NO_CURSOR && state.document_cursor == GcState::NO_CURSOR)
+                        {
+                            state.phase = SWEEP_EDGES;
+                        }
+                        return;
+                    }
+
+                    // with stable identities, an earlier sweep may have taken the version along
+                    if (!graph.documentExists(*hash))
+                    {
+                        continue;
+                    }
+
+                    eosio::checksum256 node = nodeOf(graph, *hash);
+                    state.documents++;
+                    if (!state.dry_run)
+                    {
+                        graph.eraseDocument(*hash, false);
+                    }
+
+                    // in a dry run every version is still there, and only the identity's row counts the edges
+                    if (!state.dry_run || node == *hash)
+                    {
+                        state.sweeping = node;
+                        state.sweep_run = 0;
+                        state.sweep_edge = GcState::NO_CURSOR;
+                    }
+                }
+            }
+
+            // erases edges left between nodes that are neither marked nor documents of the scope,
+            // e.g. those of documents erased without their edges
+            void sweepEdges(DocumentGraph &graph, GcState &state, GcMark::mark_table &m_t, uint64_t &used, const uint64_t maxRows)
+            {
+                Edge::edge_table e_t(graph.getContract(), graph.getScope().value);
+                auto itr = e_t.lower_bound(state.edge_cursor);
+                DG_COUNT_INDEX("edges", "primary", lookups, 1);
+
+                while (itr != e_t.end() && used < maxRows)
+                {
+                    DG_COUNT_INDEX("edges", "primary", reads, 1);
+                    used++;
+
+                    bool dangling = itr->getCreated() < state.started &&
+                                    !isMarked(m_t, itr->from_node) && !isMarked(m_t, itr->to_node) &&
+                                    !graph.documentExists(itr->from_node) && !graph.documentExists(itr->to_node);
+                    if (dangling)
+                    {
+                        state.edges++;
+                    }
+                    if (dangling && !state.dry_run)
+                    {
+                        DG_JOURNAL_EDGE(graph.getContract(), graph.getScope(), ERASE_EDGE, *itr);
+                        itr = e_t.erase(itr);
+                        DG_COUNT_INDEX("edges", "primary", erases, 1);
+                        continue;
+                    }
+                    itr++;
+                }
+
+                if (itr == e_t.end())
+                {
+                    state.edge_cursor = GcState::NO_CURSOR;
+                    state.phase = DONE;
+                }
+                else
+                {
+                    state.edge_cursor = itr->id;
+                }
+            }
+        } // namespace
+
+        void start(DocumentGraph &graph, const std::vector<eosio::checksum256> &roots,
+                   const std::vector<eosio::name> &edgeNames, const bool dryRun)
+        {
+            eosio::check(!roots.empty(), "garbage collection needs at least one root");
+
+            GcState::state_table s_t(graph.getContract(), graph.getScope().value);
+            auto init = [&](GcState &s) {
+                s.phase = RESET;
+                s.started = eosio::current_time_point();
+                s.roots = roots;
+                s.edge_names = edgeNames;
+                s.dry_run = dryRun;
+                s.mark_cursor = 0;
+                s.document_cursor = 0;
+                s.keyed_cursor = 0;
+                s.edge_cursor = 0;
+                s.mark_run = 0;
+                s.mark_edge = GcState::NO_CURSOR;
+                s.sweep_run = 0;
+                s.sweep_edge = GcState::NO_CURSOR;
+                s.sweeping = eosio::checksum256();
+                s.marked = 0;
+                s.documents = 0;
+                s.edges = 0;
+            };
+
+            auto itr = s_t.find(0);
+            if (itr == s_t.end())
+            {
+                s_t.emplace(graph.getContract(), init);
+            }
+            else
+            {
+                s_t.modify(itr, graph.getContract(), init);
+            }
+        }
+
+        GcState step(DocumentGraph &graph, const uint64_t maxRows)
+        {
+            GcState::state_table s_t(graph.getContract(), graph.getScope().value);
+            auto itr = s_t.find(0);
+            eosio::check(itr != s_t.end(), "no garbage collection has been started in scope " + graph.getScope().to_string());
+
+            GcState state = *itr;
+            GcMark::mark_table m_t(graph.getContract(), graph.getScope().value);
+
+            // a phase that finishes within the budget hands the rest to the next phase
+            uint64_t used = 0;
+            while (used < maxRows && state.phase != DONE)
+            {
+                if (state.phase == RESET)
+                {
+                    reset(graph, state, m_t, used, maxRows);
+                }
+                else if (state.phase == MARK)
+                {
+                    expand(graph, state, m_t, used, maxRows);
+                }
+                else if (state.phase == SWEEP_DOCUMENTS)
+                {
+                    sweepDocuments(graph, state, m_t, used, maxRows);
+                }
+                else
+                {
+                    sweepEdges(graph, state, m_t, used, maxRows);
+                }
+            }
+
+            s_t.modify(itr, graph.getContract(), [&](auto &s) {
+                s = state;
+            });
+
+            if (state.phase == DONE)
+            {
+                eosio::print(state.dry_run ? "gc dry run: " : "gc: ", state.marked, " reachable, ",
+                             state.documents, " unreachable documents, ", state.edges, " edges\n");
+            }
+            return state;
+        }
+
+        void edgeCreated(const eosio::name &contract, const eosio::name &scope, const Edge &edge)
+        {
+            GcState::state_table s_t(contract, scope.value);
+            auto itr = s_t.find(0);
+            DG_COUNT_INDEX("gcstate", "primary", lookups, 1);
+
+            // while resetting, the marks are rebuilt from the roots and will see the edge
+            if (itr == s_t.end() || itr->phase == DONE || itr->phase == RESET)
+            {
+                return;
+            }
+
+            GcMark::mark_table m_t(contract, scope.value);
+            if (!mark(m_t, contract, edge.to_node))
+            {
+                return;
+            }
+
+            // a sweep goes back to marking, so the node's own edges are followed before it resumes
+            s_t.modify(itr, contract, [&](auto &s) {
+                s.marked++;
+                s.phase = MARK;
+            });
+        }
+
+    } // namespace gc
+} // namespace hypha
+
+#endif
@@ -0,0 +1,45 @@
+#include <document_graph/instrumentation.hpp>
+
+#ifdef DOCUMENT_GRAPH_INSTRUMENTATION
+
+#include <eosio/print.hpp>
+
+namespace hypha
+{
+    Counters &counters()
+    {
+        static Counters c;
+        return c;
+    }
+
+    IndexCounters &indexCounters(const eosio::name &table, const eosio::name &index)
+    {
+        return counters().indexes[std::make_pair(table, index)];
+    }
+
+    void resetCounters()
+    {
+        counters() = Counters{};
+    }
+
+    void printCounters()
+    {
+        const Counters &c = counters();
+        eosio::print("document_graph: fingerprint_bytes=", c.fingerprintBytes,
+                     " sha256_calls=", c.sha256Calls,
+                     " sha256_bytes=", c.sha256Bytes,
+                     " concat_hash_calls=", c.concatHashCalls, "\n");
+
+        for (const auto &[key, index] : c.indexes)
+        {
+            eosio::print("document_graph: ", key.first, ".", key.second,
+                         " lookups=", index.lookups,
+                         " reads=", index.reads,
+                         " writes=", index.writes,
+                         " erases=", index.erases, "\n");
+        }
+    }
+
+} // namespace hypha
+
+#endif
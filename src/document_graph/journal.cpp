@@ -0,0 +1,75 @@
+#include <document_graph/journal.hpp>
+#include <document_graph/instrumentation.hpp>
+
+#ifdef DOCUMENT_GRAPH_JOURNAL
+
+#include <algorithm>
+#include <optional>
+
+namespace hypha
+{
+    namespace journal
+    {
+        namespace
+        {
+            // opened once per action and scope, so the last sequence number is looked up on the first
+            // append only; an action usually writes to a single scope
+            JournalEntry::journal_table &getTable(const eosio::name &contract, const eosio::name &scope)
+            {
+                static std::optional<JournalEntry::journal_table> j_t;
+                if (!j_t.has_value() || j_t->get_code() != contract || j_t->get_scope() != scope.value)
+                {
+                    j_t.emplace(contract, scope.value);
+                }
+                return *j_t;
+            }
+
+            void append(const eosio::name &contract, const eosio::name &scope, const eosio::name &operation,
+                        const eosio::checksum256 &node, const eosio::checksum256 &toNode, const eosio::name &edgeName)
+            {
+                JournalEntry::journal_table &j_t = getTable(contract, scope);
+                j_t.emplace(contract, [&](auto &j) {
+                    j.sequence = j_t.available_primary_key();
+                    j.operation = operation;
+                    j.node = node;
+                    j.to_node = toNode;
+                    j.edge_name = edgeName;
+                });
+                DG_COUNT_INDEX("journal", "primary", writes, 1);
+            }
+        } // namespace
+
+        void appendDocument(const eosio::name &contract, const eosio::name &scope, const eosio::name &operation,
+                            const eosio::checksum256 &hash)
+        {
+            append(contract, scope, operation, hash, eosio::checksum256(), eosio::name());
+        }
+
+        void appendEdge(const eosio::name &contract, const eosio::name &scope, const eosio::name &operation, const Edge &edge)
+        {
+            append(contract, scope, operation, edge.from_node, edge.to_node, edge.edge_name);
+        }
+
+        uint64_t prune(const eosio::name &contract, const eosio::name &scope, const uint64_t beforeSequence, const uint64_t maxRows)
+        {
+            JournalEntry::journal_table &j_t = getTable(contract, scope);
+
+            // the newest entry stays, so available_primary_key keeps counting from it
+            uint64_t limit = std::min(beforeSequence, j_t.available_primary_key() - 1);
+
+            uint64_t erased = 0;
+            auto itr = j_t.begin();
+            DG_COUNT_INDEX("journal", "primary", lookups, 1);
+            while (itr != j_t.end() && erased < maxRows && itr->sequence < limit)
+            {
+                itr = j_t.erase(itr);
+                DG_COUNT_INDEX("journal", "primary", erases, 1);
+                erased++;
+            }
+            return erased;
+        }
+
+    } // namespace journal
+} // namespace hypha
+
+#endif
@@ -0,0 +1,78 @@
+#include <document_graph/query.hpp>
+#include <document_graph/document_graph.hpp>
+
+namespace hypha
+{
+    namespace query
+    {
+        std::vector<Document> getDocuments(DocumentGraph &graph, const std::vector<eosio::checksum256> &hashes)
+        {
+            eosio::check(hashes.size() <= MAX_RESULTS, "at most " + std::to_string(MAX_RESULTS) + " hashes per query");
+
+            std::vector<Document> documents;
+            documents.reserve(hashes.size());
+            for (const eosio::checksum256 &hash : hashes)
+            {
+                if (graph.documentExists(hash))
+                {
+                    documents.push_back(graph.getDocument(hash));
+                }
+            }
+            return documents;
+        }
+
+        EdgePage getEdges(DocumentGraph &graph, const eosio::checksum256 &node, const eosio::name &edgeName,
+                          const bool incoming, const std::optional<EdgeCursor> &after, const std::uint32_t limit)
+        {
+            eosio::check(limit > 0 && limit <= MAX_RESULTS, "limit must be between 1 and " + std::to_string(MAX_RESULTS));
+
+            // one edge more than asked for tells whether there is another page
+            EdgeRange range;
+            range.limit = limit + 1;
+            if (after.has_value())
+            {
+                Edge resume;
+                resume.created_date = after->created_date;
+                resume.id = after->id;
+                range.after = resume;
+            }
+
+            EdgePage page;
+            page.edges = incoming ? graph.getEdgesTo(node, edgeName, range) : graph.getEdgesFrom(node, edgeName, range);
+            if (page.edges.size() > limit)
+            {
+                page.edges.resize(limit);
+                page.next = EdgeCursor{page.edges.back().getCreated(), page.edges.back().id};
+            }
+            return page;
+        }
+
+        Neighborhood getNeighbors(DocumentGraph &graph, const eosio::checksum256 &hash, const eosio::name &edgeName,
+                                  const std::optional<EdgeCursor> &after, const std::uint32_t limit)
+        {
+            Neighborhood neighborhood;
+            neighborhood.document = graph.getDocument(hash);
+
+            EdgePage page = getEdges(graph, hash, edgeName, false, after, limit);
+
+            neighborhood.neighbors.reserve(page.edges.size());
+            for (const Edge &edge : page.edges)
+            {
+                // an edge left pointing to an erased document gets an empty one, with a zero hash
+                if (!graph.documentExists(edge.to_node))
+                {
+                    neighborhood.neighbors.push_back(Document());
+                }
+                else
+                {
+                    neighborhood.neighbors.push_back(graph.hasStableIdentities() ? graph.getHead(edge.to_node)
+                                                                                 : graph.getDocument(edge.to_node));
+                }
+            }
+            neighborhood.edges = std::move(page.edges);
+            neighborhood.next = page.next;
+            return neighborhood;
+        }
+
+    } // namespace query
+} // namespace hypha
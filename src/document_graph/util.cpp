@@ -2,6 +2,7 @@
 #include <eosio/name.hpp>
 
 #include <document_graph/util.hpp>
+#include <document_graph/instrumentation.hpp>
 
 namespace hypha
 {
@@ -24,6 +25,9 @@ namespace hypha
 
     const std::uint64_t toUint64(const std::string &fingerprint)
     {
+        DG_COUNT(sha256Calls, 1);
+        DG_COUNT(sha256Bytes, fingerprint.size());
+
         uint64_t id = 0;
         eosio::checksum256 h = eosio::sha256(const_cast<char *>(fingerprint.c_str()), fingerprint.size());
         auto hbytes = h.extract_as_byte_array();
@@ -37,16 +41,19 @@ namespace hypha
 
     const uint64_t concatHash(const eosio::checksum256 sha1, const eosio::checksum256 sha2, const eosio::name label)
     {
+        DG_COUNT(concatHashCalls, 1);
         return toUint64(readableHash(sha1) + readableHash(sha2) + label.to_string());
     }
 
     const uint64_t concatHash(const eosio::checksum256 sha1, const eosio::checksum256 sha2)
     {
+        DG_COUNT(concatHashCalls, 1);
         return toUint64(readableHash(sha1) + readableHash(sha2));
     }
 
     const uint64_t concatHash(const eosio::checksum256 sha, const eosio::name label)
     {
+        DG_COUNT(concatHashCalls, 1);
         return toUint64(readableHash(sha) + label.to_string());
     }
 
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include <graph_tools/query_engine.hpp>
+
+namespace hypha
+{
+    // the adjacency of a whole graph in both directions, e.g. of a QueryEngine or a Snapshot.
+    // Every analysis follows the edges named in edgeNames, or every edge if it is empty; the
+    // names must be sorted and without repeats.
+    struct GraphAdjacency
+    {
+        std::size_t nodeCount;
+        AdjacencyView out;
+        AdjacencyView in;
+        std::vector<eosio::name> edgeNames;
+
+        // calls f(neighbour) for every followed edge of node in direction
+        template <typename F>
+        void forEachNeighbor(const uint32_t node, const Direction direction, F &&f) const
+        {
+            const AdjacencyView &view = direction == Direction::Out ? out : in;
+            if (edgeNames.empty())
+            {
+                for (uint32_t neighbor : view.neighbors(node, eosio::name()))
+                    f(neighbor);
+                return;
+            }
+            for (const eosio::name &edgeName : edgeNames)
+            {
+                for (uint32_t neighbor : view.neighbors(node, edgeName))
+                    f(neighbor);
+            }
+        }
+
+        uint32_t degree(const uint32_t node, const Direction direction) const;
+    };
+
+    struct PageRankOptions
+    {
+        double damping = 0.85;
+        uint32_t maxIterations = 100;
+
+        // stops once the ranks moved by less than this in total, summed over all nodes
+        double tolerance = 1e-9;
+    };
+
+    struct PageRankResult
+    {
+        std::vector<double> ranks;
+        uint32_t iterations = 0;
+        double delta = 0;
+    };
+
+    // pull-based power iteration: each thread computes the new rank of a range of nodes from the
+    // ranks of their in-neighbours, so no two threads write the same value. The rank of nodes
+    // without followed outgoing edges is spread evenly over all nodes; ranks sum to 1.
+    PageRankResult pageRank(const GraphAdjacency &graph, const PageRankOptions &options, const unsigned threadCount);
+
+    // the weakly connected component of every node, named by its lowest node id. Edges are
+    // merged into a shared union-find on threadCount threads; roots are only ever hooked under
+    // lower ids with a compare-and-swap, so concurrent unions cannot form a cycle.
+    std::vector<uint32_t> weakComponents(const GraphAdjacency &graph, const unsigned threadCount);
+
+    // the number of nodes with each degree, over the edges of one name in one direction; nodes
+    // without edges of the name are not counted
+    struct DegreeHistogram
+    {
+        eosio::name edgeName;
+        Direction direction;
+        std::map<uint32_t, uint64_t> nodesByDegree;
+    };
+
+    // one histogram per edge name and direction, in name order, out before in; edgeNames is
+    // ignored, as every name gets its own histogram
+    std::vector<DegreeHistogram> degreeHistograms(const GraphAdjacency &graph, const unsigned threadCount);
+
+    // the followed degree of every node in direction
+    std::vector<uint32_t> degrees(const GraphAdjacency &graph, const Direction direction, const unsigned threadCount);
+
+    // the number of distinct nodes within hops of every node, not counting the node itself, along
+    // direction or along both directions if it is empty; each thread runs its own breadth-first
+    // searches and marks visited nodes with the id of the search, so marks are never cleared
+    std::vector<uint32_t> neighborhoodSizes(const GraphAdjacency &graph, const uint32_t hops,
+                                            const std::optional<Direction> direction, const unsigned threadCount);
+
+} // namespace hypha
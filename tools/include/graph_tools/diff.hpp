@@ -0,0 +1,92 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <document_graph/document.hpp>
+#include <document_graph/edge.hpp>
+#include <graph_tools/replica.hpp>
+#include <graph_tools/snapshot.hpp>
+
+namespace hypha
+{
+    using HashBytes = std::array<uint8_t, 32>;
+
+    // Documents are content addressed and an edge is identified by its endpoints and name, so two
+    // states of a graph are compared by their keys alone. The concatHash id of an edge is only 32
+    // bits and two edges may share it, so edges are keyed by the fields it is hashed from.
+    // row is the position of the row the key was read from: the index into the loaded rows, or
+    // the node of a snapshot document; rows are not compared.
+    struct DocumentKey
+    {
+        HashBytes hash;
+        uint32_t row;
+    };
+
+    // ordered by from_node, edge_name and to_node, the order of a snapshot's outgoing edges
+    struct EdgeKey
+    {
+        HashBytes from;
+        HashBytes to;
+        uint64_t name;
+        uint32_t row;
+    };
+
+    // the keys of one graph state, each list sorted and without repeats
+    struct GraphKeys
+    {
+        std::vector<DocumentKey> documents;
+        std::vector<EdgeKey> edges;
+    };
+
+    // one side of a diff: a dump folder, a binary snapshot or a replica checkpoint. A snapshot is
+    // mapped and read in place; the other inputs are loaded into documents and edges.
+    struct GraphInput
+    {
+        std::vector<Document> documents;
+        std::vector<Edge> edges;
+        std::unique_ptr<Snapshot> snapshot;
+        std::unique_ptr<GraphReplica> replica;
+
+        std::size_t documentCount() const { return snapshot ? snapshot->documentCount() : documents.size(); }
+        std::size_t edgeCount() const { return snapshot ? snapshot->edgeCount() : edges.size(); }
+    };
+
+    // a folder is read as a dump, a file starting with the snapshot magic as a snapshot and any
+    // other file as a checkpoint of the replica of contract's graph in scope
+    GraphInput loadGraphInput(const std::string &path, const eosio::name &contract, const eosio::name &scope);
+
+    // snapshot keys come out sorted, as its nodes are numbered in hash order; loaded rows are
+    // sorted on threadCount threads
+    GraphKeys collectKeys(const GraphInput &input, const unsigned threadCount);
+
+    // the rows behind the keys of input; edges of a snapshot only have their endpoints and name,
+    // the id and index keys are recomputed from them
+    Document inputDocument(const GraphInput &input, const DocumentKey &key);
+    Edge inputEdge(const GraphInput &input, const EdgeKey &key);
+
+    // the changes that turn one graph state into another, each list in key order
+    struct GraphDiff
+    {
+        std::vector<DocumentKey> addedDocuments;
+        std::vector<DocumentKey> removedDocuments;
+        std::vector<EdgeKey> addedEdges;
+        std::vector<EdgeKey> removedEdges;
+
+        bool empty() const { return addedDocuments.empty() && removedDocuments.empty() && addedEdges.empty() && removedEdges.empty(); }
+    };
+
+    // merges the sorted key lists, split into key ranges that are merged on threadCount threads.
+    // Added keys refer to rows of to; of removed keys only the key fields are used.
+    GraphDiff diffKeys(const GraphKeys &from, const GraphKeys &to, const unsigned threadCount);
+
+    // writes the diff as one JSON change per line, in the order it is applied: remove_edge,
+    // remove_document, add_document and add_edge. Added rows are written as SaveGraph does and
+    // are formatted on threadCount threads.
+    void writeChanges(const std::string &fileName, const GraphDiff &diff, const GraphInput &to, const unsigned threadCount);
+
+    // applies the diff to a replica that holds from's state, so that it holds to's
+    void applyChanges(const GraphDiff &diff, const GraphInput &to, GraphReplica &replica);
+
+} // namespace hypha
@@ -0,0 +1,22 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include <document_graph/document.hpp>
+#include <graph_tools/sha256.hpp>
+
+namespace hypha
+{
+    // the string Document::toString builds, appended in place rather than concatenated group by
+    // group; its sha256 is the document's hash
+    std::string fingerprint(const ContentGroups &contentGroups);
+
+    // Document::hashContents of many documents at once. Each of threadCount threads takes chunks
+    // of documents, builds their fingerprints and hashes the chunk with sha256Many, so the hashes
+    // are identical to the contract's on every backend.
+    std::vector<eosio::checksum256> hashContents(const std::vector<ContentGroups> &contentGroups, const unsigned threadCount,
+                                                 const Sha256Backend backend = sha256Backend());
+    std::vector<eosio::checksum256> hashContents(const std::vector<Document> &documents, const unsigned threadCount,
+                                                 const Sha256Backend backend = sha256Backend());
+
+} // namespace hypha
@@ -0,0 +1,112 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <document_graph/content.hpp>
+#include <document_graph/content_group.hpp>
+#include <document_graph/edge.hpp>
+
+namespace hypha
+{
+    // a count drawn per document, e.g. the number of content groups
+    struct SizeDistribution
+    {
+        enum Kind
+        {
+            Fixed,
+            Uniform,
+            // long tailed: geometric with the given mean, cut at max
+            Geometric
+        };
+
+        Kind kind = Fixed;
+        uint32_t min = 1;
+        uint32_t max = 1;
+        double mean = 1;
+    };
+
+    // parses "fixed:N", "uniform:MIN:MAX" or "geometric:MEAN:MAX"
+    SizeDistribution parseSizeDistribution(const std::string &spec);
+
+    // parses "a=3,b=1" into labels and relative weights
+    std::vector<std::pair<std::string, double>> parseWeights(const std::string &spec);
+
+    struct WorkloadSpec
+    {
+        uint64_t seed = 1;
+        uint64_t documents = 1000;
+
+        SizeDistribution groups{SizeDistribution::Uniform, 1, 3, 2};
+        SizeDistribution contents{SizeDistribution::Geometric, 1, 64, 6};
+        SizeDistribution stringLength{SizeDistribution::Uniform, 8, 64, 36};
+
+        // relative weights of the FlexValue types, by their ABI names; monostate, an empty value,
+        // is off by default
+        std::vector<std::pair<std::string, double>> types{
+            {"string", 4}, {"int64", 2}, {"name", 2}, {"asset", 1}, {"time_point", 1}, {"checksum256", 1}, {"monostate", 0}};
+
+        // edges per document on average; the endpoints follow power laws with these exponents, so
+        // that a few documents have most of the edges, as members, roles and periods do in a DAO
+        double edgesPerDocument = 3;
+        double outSkew = 1.2;
+        double inSkew = 1.6;
+        std::vector<std::pair<eosio::name, double>> edgeNames{
+            {eosio::name("memberof"), 5}, {eosio::name("owns"), 2}, {eosio::name("assigned"), 2}, {eosio::name("payment"), 1}};
+
+        eosio::name contract = eosio::name("documents");
+        std::vector<eosio::name> creators{eosio::name("creator1"), eosio::name("creator2"), eosio::name("creator3"), eosio::name("creator4")};
+
+        // created_date of the first row; later rows follow one block, half a second, apart
+        eosio::time_point start = eosio::time_point(eosio::seconds(1609459200));
+    };
+
+    // one generated document; the first content of the first group is a unique "nonce", so
+    // that no two documents of a workload share a hash
+    struct GeneratedDocument
+    {
+        uint64_t id;
+        eosio::checksum256 hash;
+        eosio::name creator;
+        ContentGroups contentGroups;
+        eosio::time_point created;
+    };
+
+    // receives the workload in order: every document, then every edge
+    class WorkloadSink
+    {
+    public:
+        virtual ~WorkloadSink() {}
+        virtual void document(const GeneratedDocument &document) = 0;
+        virtual void edge(const Edge &edge) = 0;
+        virtual void finish() {}
+    };
+
+    struct WorkloadStats
+    {
+        uint64_t documents = 0;
+        uint64_t contents = 0;
+        uint64_t edges = 0;
+        // edge candidates dropped because their 32-bit id was taken; the edges table could not
+        // store them, or they repeat an edge
+        uint64_t droppedEdges = 0;
+        double documentSeconds = 0;
+        double edgeSeconds = 0;
+    };
+
+    // generates the workload on threadCount threads; the output only depends on the spec, each
+    // document and edge draws from its own random stream seeded from spec.seed and its position
+    WorkloadStats generateWorkload(const WorkloadSpec &spec, WorkloadSink &sink, const unsigned threadCount);
+
+    // the three output formats, each written to files in a folder:
+    //   actions  actions.ndjson, one create or newedge action per line, documents first
+    //   dump     documents.json and edges.json as SaveGraph writes them, for the other tools
+    //   binary   documents.bin and edges.bin, each row a uvarint length and the row packed as the
+    //            contract stores it, the format of the Go client's ExportBinary
+    std::unique_ptr<WorkloadSink> newActionSink(const std::string &folder, const eosio::name &contract);
+    std::unique_ptr<WorkloadSink> newDumpSink(const std::string &folder, const eosio::name &contract);
+    std::unique_ptr<WorkloadSink> newBinarySink(const std::string &folder, const eosio::name &contract);
+
+} // namespace hypha
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <document_graph/document.hpp>
+#include <document_graph/edge.hpp>
+
+namespace hypha
+{
+    // reads the rows that SaveGraph writes: documents.json and edges.json hold the JSON
+    // get_table_rows output of the documents (or docsbyhash) and edges tables
+    std::vector<Document> loadDocuments(const std::string &fileName);
+    std::vector<Edge> loadEdges(const std::string &fileName);
+
+    // parses the value of a single JSON content item, e.g. ["asset", "130.00 USD"]
+    Content::FlexValue parseFlexValue(const std::string &type, const std::string &value);
+
+    eosio::checksum256 parseChecksum(const std::string &hex);
+    eosio::time_point parseTimePoint(const std::string &iso);
+
+    // formats a time_point as nodeos does, e.g. 2020-10-16T14:02:32.500
+    std::string formatTimePoint(const eosio::time_point &time);
+
+    // a Document row with the same field order as Document's EOSLIB_SERIALIZE, so that a
+    // packed row unpacks into a Document without going through its private members
+    struct DocumentRow
+    {
+        uint64_t id = 0;
+        eosio::checksum256 hash;
+        eosio::name creator;
+        ContentGroups content_groups;
+        std::vector<Certificate> certificates;
+        eosio::time_point created_date;
+        eosio::name contract;
+
+        EOSLIB_SERIALIZE(DocumentRow, (id)(hash)(creator)(content_groups)(certificates)(created_date)(contract))
+    };
+
+    // a buffered output file; every write failure is reported with eosio::check
+    class OutputFile
+    {
+    public:
+        explicit OutputFile(const std::string &fileName);
+        ~OutputFile() { close(); }
+
+        OutputFile(const OutputFile &) = delete;
+        OutputFile &operator=(const OutputFile &) = delete;
+
+        std::string &buffer() { return m_buffer; }
+
+        // writes the buffer out once it is full
+        void commit();
+        void close();
+
+    private:
+        static constexpr std::size_t BUFFER_SIZE = 1 << 22;
+
+        void flush();
+
+        std::string m_fileName;
+        std::FILE *m_file = nullptr;
+        std::string m_buffer;
+    };
+
+    void appendJsonString(std::string &out, const std::string &value);
+
+    // content groups as the ABI serializer writes them, e.g. [[{"label":"a","value":["int64",1]}]]
+    void appendContentGroups(std::string &out, const ContentGroups &contentGroups);
+
+    // one row of documents.json or edges.json as SaveGraph writes it, without a separator
+    void appendDocumentRow(std::string &out, const DocumentRow &row);
+    void appendEdgeRow(std::string &out, const Edge &edge);
+
+} // namespace hypha
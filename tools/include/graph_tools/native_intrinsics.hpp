@@ -0,0 +1,10 @@
+#pragma once
+
+namespace hypha
+{
+    // the native build of the library stubs out chain intrinsics; tools call this once at startup
+    // so that code shared with the contract, e.g. the Certificate constructor and document
+    // hashing, can run natively
+    void registerNativeIntrinsics();
+
+} // namespace hypha
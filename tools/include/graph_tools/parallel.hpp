@@ -0,0 +1,41 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace hypha
+{
+    inline unsigned defaultThreadCount()
+    {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // calls work(first, last, worker) on chunks of [0, count) from threadCount threads; chunks are
+    // handed out on demand so that uneven items, e.g. documents of very different sizes, balance out
+    template <typename Work>
+    void parallelFor(const std::size_t count, const unsigned threadCount, Work &&work, const std::size_t chunk = 1024)
+    {
+        std::atomic<std::size_t> next{0};
+        auto run = [&](const unsigned worker) {
+            for (std::size_t first = next.fetch_add(chunk); first < count; first = next.fetch_add(chunk))
+            {
+                work(first, std::min(count, first + chunk), worker);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned worker = 1; worker < threadCount; worker++)
+        {
+            threads.emplace_back(run, worker);
+        }
+        run(0);
+
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+} // namespace hypha
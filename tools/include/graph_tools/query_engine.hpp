@@ -0,0 +1,107 @@
+#pragma once
+#include <optional>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include <document_graph/document.hpp>
+#include <document_graph/edge.hpp>
+
+namespace hypha
+{
+    enum class Direction
+    {
+        Out,
+        In
+    };
+
+    // one step of a multi-hop query; an empty edge name follows edges of every name
+    struct Hop
+    {
+        Direction direction = Direction::Out;
+        eosio::name edgeName;
+    };
+
+    struct ChecksumHasher
+    {
+        std::size_t operator()(const eosio::checksum256 &hash) const;
+    };
+
+    // the neighbours of one node over edges of one name, or of every name
+    struct Neighbors
+    {
+        const uint32_t *first;
+        const uint32_t *last;
+
+        const uint32_t *begin() const { return first; }
+        const uint32_t *end() const { return last; }
+        std::size_t size() const { return last - first; }
+    };
+
+    // compressed sparse row adjacency over arrays owned elsewhere: the row of node n is
+    // [offsets[n], offsets[n + 1]) of names and nodes, sorted by edge name
+    struct AdjacencyView
+    {
+        const uint32_t *offsets;
+        const uint64_t *names;
+        const uint32_t *nodes;
+
+        Neighbors neighbors(const uint32_t node, const eosio::name &edgeName) const;
+    };
+
+    // owning compressed sparse row adjacency
+    struct Adjacency
+    {
+        std::vector<uint32_t> offsets;
+        std::vector<uint64_t> names;
+        std::vector<uint32_t> nodes;
+
+        AdjacencyView view() const { return AdjacencyView{offsets.data(), names.data(), nodes.data()}; }
+
+        // rows are (node, edge name, neighbour) and are sorted in place
+        static Adjacency build(std::vector<std::tuple<uint32_t, uint64_t, uint32_t>> &rows, const std::size_t nodeCount);
+    };
+
+    // distinct nodes reached from start after following every hop in order
+    std::vector<uint32_t> followHops(const AdjacencyView &out, const AdjacencyView &in,
+                                     const uint32_t start, const std::vector<Hop> &hops);
+
+    // In-memory, read-only view of a graph snapshot. Document hashes are interned to dense
+    // 32-bit ids and edges are stored twice in compressed sparse row form, once per direction,
+    // each row sorted by edge name so that a name filter is a binary search.
+    class QueryEngine
+    {
+    public:
+        // edge endpoints without a document, e.g. edges to erased documents, still get an id
+        QueryEngine(std::vector<Document> documents, const std::vector<Edge> &edges);
+
+        std::optional<uint32_t> find(const eosio::checksum256 &hash) const;
+        const eosio::checksum256 &getHash(const uint32_t node) const { return m_hashes[node]; }
+
+        // nullptr if the node is only known as an edge endpoint
+        const Document *getDocument(const uint32_t node) const;
+
+        Neighbors neighbors(const uint32_t node, const Direction direction, const eosio::name &edgeName) const;
+
+        // distinct nodes reached from start after following every hop in order
+        std::vector<uint32_t> query(const uint32_t start, const std::vector<Hop> &hops) const;
+        std::vector<eosio::checksum256> query(const eosio::checksum256 &start, const std::vector<Hop> &hops) const;
+
+        std::size_t nodeCount() const { return m_hashes.size(); }
+        std::size_t edgeCount() const { return m_out.nodes.size(); }
+
+        AdjacencyView outgoing() const { return m_out.view(); }
+        AdjacencyView incoming() const { return m_in.view(); }
+
+    private:
+        uint32_t intern(const eosio::checksum256 &hash);
+
+        std::unordered_map<eosio::checksum256, uint32_t, ChecksumHasher> m_ids;
+        std::vector<eosio::checksum256> m_hashes;
+        std::vector<Document> m_documents;
+        std::vector<uint32_t> m_documentIndex; // position in m_documents, or UINT32_MAX
+        Adjacency m_out;
+        Adjacency m_in;
+    };
+
+} // namespace hypha
@@ -0,0 +1,110 @@
+#pragma once
+#include <deque>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <document_graph/document.hpp>
+#include <document_graph/edge.hpp>
+#include <graph_tools/ship_protocol.hpp>
+
+namespace hypha
+{
+    // An off-chain copy of the documents and edges in one scope of a contract, kept current from
+    // state history table deltas. Rows of other scopes are skipped: each scope is a separate
+    // graph whose primary keys may collide with another's, so every scope needs its own replica. Rows are held as the contract packed them and decoded with the library types
+    // on demand. Every reversible block keeps the previous value of the rows it touched, so a
+    // fork is undone by replaying those in reverse.
+    class GraphReplica
+    {
+    public:
+        // follows the graph in the contract's own scope
+        explicit GraphReplica(const eosio::name &contract);
+        GraphReplica(const eosio::name &contract, const eosio::name &scope);
+
+        // applies the contract_row deltas of one block as a unit; a block at or below the current
+        // head means the chain forked, and the replica first rolls back to the block before it
+        void applyBlock(const ship::BlockPosition &block, const std::vector<char> &deltas, const uint32_t lastIrreversible);
+
+        // undoes every block numbered blockNum or higher
+        void rollbackTo(const uint32_t blockNum);
+
+        const std::optional<ship::BlockPosition> &head() const { return m_head; }
+
+        // the reversible blocks applied so far, sent as have_positions when reconnecting
+        std::vector<ship::BlockPosition> reversiblePositions() const;
+
+        // brings the rows in line with another state of the graph, e.g. a dump of the chain at the
+        // head block; the rows change outside of any block, so the head and the undo log are kept.
+        // Removed edges are matched by from_node, to_node and edge_name, their id is recomputed.
+        void reconcile(const std::vector<eosio::checksum256> &removedDocuments, const std::vector<Edge> &removedEdges,
+                       const std::vector<Document> &addedDocuments, const std::vector<Edge> &addedEdges);
+
+        std::vector<Document> documents() const;
+        std::vector<Edge> edges() const;
+        std::size_t documentCount() const;
+        std::size_t edgeCount() const;
+
+        // a checkpoint holds the rows and the undo log, so a restarted replica can still roll back;
+        // it is written to a temporary file first and renamed over the previous one
+        void save(const std::string &fileName) const;
+
+        // returns false if fileName does not exist
+        bool load(const std::string &fileName);
+
+    private:
+        // table name and primary key of a contract row
+        typedef std::pair<uint64_t, uint64_t> RowKey;
+
+        struct Change
+        {
+            uint64_t table;
+            uint64_t primaryKey;
+            std::optional<std::vector<char>> previous;
+
+            EOSLIB_SERIALIZE(Change, (table)(primaryKey)(previous))
+        };
+
+        struct BlockUndo
+        {
+            ship::BlockPosition block;
+            std::vector<Change> changes;
+
+            EOSLIB_SERIALIZE(BlockUndo, (block)(changes))
+        };
+
+        struct CheckpointRow
+        {
+            uint64_t table;
+            uint64_t primaryKey;
+            std::vector<char> value;
+
+            EOSLIB_SERIALIZE(CheckpointRow, (table)(primaryKey)(value))
+        };
+
+        struct Checkpoint
+        {
+            eosio::name contract;
+            eosio::name scope;
+            std::optional<ship::BlockPosition> head;
+            std::optional<ship::BlockPosition> irreversible;
+            std::vector<CheckpointRow> rows;
+            std::vector<BlockUndo> undo;
+
+            EOSLIB_SERIALIZE(Checkpoint, (contract)(scope)(head)(irreversible)(rows)(undo))
+        };
+
+        void setRow(BlockUndo &undo, const RowKey &key, std::optional<std::vector<char>> value);
+
+        eosio::name m_contract;
+        eosio::name m_scope;
+        std::map<RowKey, std::vector<char>> m_rows;
+        std::deque<BlockUndo> m_undo;
+        std::optional<ship::BlockPosition> m_head;
+
+        // the newest block whose undo entry was dropped; rows at this block can no longer be rolled back
+        std::optional<ship::BlockPosition> m_irreversible;
+    };
+
+} // namespace hypha
@@ -0,0 +1,35 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace hypha
+{
+    // portable FIPS 180-4 SHA-256, used as the native implementation of the sha256 intrinsic;
+    // runs on the SHA extensions when the CPU has them
+    std::array<uint8_t, 32> sha256(const char *data, std::size_t length);
+
+    enum class Sha256Backend
+    {
+        Portable,
+
+        // eight messages at once, one per 32-bit lane of an AVX2 register
+        Avx2,
+
+        // one message at a time on the SHA extensions, which beats eight AVX2 lanes
+        ShaNi
+    };
+
+    // the fastest backend the CPU supports, detected once with cpuid
+    Sha256Backend sha256Backend();
+    bool sha256Supported(const Sha256Backend backend);
+    const char *sha256BackendName(const Sha256Backend backend);
+
+    // digests[i] = sha256(messages[i]) for count messages; every backend gives the same digests.
+    // The AVX2 backend hashes messages of similar length side by side, so the order of the
+    // messages does not matter. A backend the CPU lacks falls back to the portable one.
+    void sha256Many(const std::string *messages, const std::size_t count, std::array<uint8_t, 32> *digests,
+                    const Sha256Backend backend = sha256Backend());
+
+} // namespace hypha
@@ -0,0 +1,120 @@
+#pragma once
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include <eosio/crypto.hpp>
+#include <eosio/name.hpp>
+
+// Messages of the nodeos 2.0 state history websocket protocol, laid out as in the
+// state_history_plugin ABI so that they go through the same serializer as the contract types.
+namespace hypha
+{
+    namespace ship
+    {
+        typedef std::vector<char> bytes;
+
+        struct BlockPosition
+        {
+            uint32_t block_num = 0;
+            eosio::checksum256 block_id;
+
+            EOSLIB_SERIALIZE(BlockPosition, (block_num)(block_id))
+        };
+
+        // has no fields, so it cannot go through EOSLIB_SERIALIZE
+        struct GetStatusRequestV0
+        {
+            template <typename DataStream>
+            friend DataStream &operator<<(DataStream &ds, const GetStatusRequestV0 &) { return ds; }
+            template <typename DataStream>
+            friend DataStream &operator>>(DataStream &ds, GetStatusRequestV0 &) { return ds; }
+        };
+
+        struct GetBlocksRequestV0
+        {
+            uint32_t start_block_num = 0;
+            uint32_t end_block_num = 0xffffffff;
+            uint32_t max_messages_in_flight = 0;
+            std::vector<BlockPosition> have_positions;
+            bool irreversible_only = false;
+            bool fetch_block = false;
+            bool fetch_traces = false;
+            bool fetch_deltas = false;
+
+            EOSLIB_SERIALIZE(GetBlocksRequestV0, (start_block_num)(end_block_num)(max_messages_in_flight)(have_positions)(irreversible_only)(fetch_block)(fetch_traces)(fetch_deltas))
+        };
+
+        struct GetBlocksAckRequestV0
+        {
+            uint32_t num_messages = 0;
+
+            EOSLIB_SERIALIZE(GetBlocksAckRequestV0, (num_messages))
+        };
+
+        typedef std::variant<GetStatusRequestV0, GetBlocksRequestV0, GetBlocksAckRequestV0> Request;
+
+        struct GetStatusResultV0
+        {
+            BlockPosition head;
+            BlockPosition last_irreversible;
+            uint32_t trace_begin_block = 0;
+            uint32_t trace_end_block = 0;
+            uint32_t chain_state_begin_block = 0;
+            uint32_t chain_state_end_block = 0;
+
+            EOSLIB_SERIALIZE(GetStatusResultV0, (head)(last_irreversible)(trace_begin_block)(trace_end_block)(chain_state_begin_block)(chain_state_end_block))
+        };
+
+        struct GetBlocksResultV0
+        {
+            BlockPosition head;
+            BlockPosition last_irreversible;
+            std::optional<BlockPosition> this_block;
+            std::optional<BlockPosition> prev_block;
+            std::optional<bytes> block;
+            std::optional<bytes> traces;
+            std::optional<bytes> deltas;
+
+            EOSLIB_SERIALIZE(GetBlocksResultV0, (head)(last_irreversible)(this_block)(prev_block)(block)(traces)(deltas))
+        };
+
+        typedef std::variant<GetStatusResultV0, GetBlocksResultV0> Result;
+
+        // present is false when the row was removed in this block
+        struct Row
+        {
+            bool present = false;
+            bytes data;
+
+            EOSLIB_SERIALIZE(Row, (present)(data))
+        };
+
+        struct TableDeltaV0
+        {
+            std::string name;
+            std::vector<Row> rows;
+
+            EOSLIB_SERIALIZE(TableDeltaV0, (name)(rows))
+        };
+
+        typedef std::variant<TableDeltaV0> TableDelta;
+
+        // the data of a row in the contract_row table delta
+        struct ContractRowV0
+        {
+            eosio::name code;
+            eosio::name scope;
+            eosio::name table;
+            uint64_t primary_key = 0;
+            eosio::name payer;
+            bytes value;
+
+            EOSLIB_SERIALIZE(ContractRowV0, (code)(scope)(table)(primary_key)(payer)(value))
+        };
+
+        typedef std::variant<ContractRowV0> ContractRow;
+
+    } // namespace ship
+} // namespace hypha
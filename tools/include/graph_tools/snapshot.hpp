@@ -0,0 +1,106 @@
+#pragma once
+#include <array>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <document_graph/document.hpp>
+#include <document_graph/edge.hpp>
+#include <graph_tools/query_engine.hpp>
+
+namespace hypha
+{
+    // Binary graph snapshot, version 1. All integers are little endian and every section starts
+    // on an 8 byte boundary, so a mapped file is used in place without deserialising anything:
+    //
+    //   header      SnapshotHeader
+    //   hashes      nodeCount x 32 bytes, sorted; a node id is the position of its hash
+    //   arena       documents packed with the library serializer (eosio::pack)
+    //   documents   nodeCount x SnapshotDocument, the arena slice of each node's document
+    //   out, in     CSR edge arrays: nodeCount + 1 uint32 offsets, edgeCount uint64 edge names
+    //               and edgeCount uint32 neighbour ids, each row sorted by edge name
+    constexpr char SNAPSHOT_MAGIC[8] = {'D', 'G', 'S', 'N', 'A', 'P', 0, 0};
+    constexpr uint32_t SNAPSHOT_VERSION = 1;
+    constexpr uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+    struct SnapshotSection
+    {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct SnapshotHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint64_t nodeCount;
+        uint64_t documentCount;
+        uint64_t edgeCount;
+        SnapshotSection hashes;
+        SnapshotSection arena;
+        SnapshotSection documents;
+        SnapshotSection outOffsets;
+        SnapshotSection outNames;
+        SnapshotSection outNodes;
+        SnapshotSection inOffsets;
+        SnapshotSection inNames;
+        SnapshotSection inNodes;
+    };
+
+    // size is 0 for nodes that are only known as edge endpoints
+    struct SnapshotDocument
+    {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    static_assert(sizeof(SnapshotHeader) == 184, "snapshot header layout changed");
+    static_assert(sizeof(SnapshotDocument) == 16, "snapshot document layout changed");
+
+    void writeSnapshot(const std::string &fileName, const std::vector<Document> &documents, const std::vector<Edge> &edges);
+
+    // read-only view of a mapped snapshot; pages are only read when they are touched
+    class Snapshot
+    {
+    public:
+        explicit Snapshot(const std::string &fileName);
+        ~Snapshot();
+
+        Snapshot(const Snapshot &) = delete;
+        Snapshot &operator=(const Snapshot &) = delete;
+
+        std::size_t nodeCount() const { return m_header->nodeCount; }
+        std::size_t documentCount() const { return m_header->documentCount; }
+        std::size_t edgeCount() const { return m_header->edgeCount; }
+
+        std::optional<uint32_t> find(const eosio::checksum256 &hash) const;
+        eosio::checksum256 getHash(const uint32_t node) const;
+
+        // documents are the only data that is unpacked, and only when asked for
+        bool hasDocument(const uint32_t node) const { return m_documents[node].size > 0; }
+        Document getDocument(const uint32_t node) const;
+
+        Neighbors neighbors(const uint32_t node, const Direction direction, const eosio::name &edgeName) const;
+        std::vector<uint32_t> query(const uint32_t start, const std::vector<Hop> &hops) const;
+
+        // every edge by direction, rows in node and so in hash order, each sorted by edge name and neighbour
+        AdjacencyView outgoing() const { return m_out; }
+        AdjacencyView incoming() const { return m_in; }
+
+    private:
+        template <typename T>
+        const T *section(const SnapshotSection &s, const uint64_t count) const;
+
+        const char *m_data = nullptr;
+        std::size_t m_size = 0;
+
+        const SnapshotHeader *m_header = nullptr;
+        const uint8_t *m_hashes = nullptr;
+        const SnapshotDocument *m_documents = nullptr;
+        const char *m_arena = nullptr;
+        AdjacencyView m_out{};
+        AdjacencyView m_in{};
+    };
+
+} // namespace hypha
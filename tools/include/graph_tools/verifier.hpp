@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include <document_graph/document.hpp>
+#include <document_graph/edge.hpp>
+
+namespace hypha
+{
+    struct HashMismatch
+    {
+        eosio::checksum256 stored;
+        eosio::checksum256 computed;
+    };
+
+    // an edge whose from_node or to_node is not a stored document
+    struct OrphanEdge
+    {
+        Edge edge;
+        bool missingFrom;
+        bool missingTo;
+    };
+
+    // an edge whose stored key differs from the concatHash of its fields
+    struct KeyMismatch
+    {
+        Edge edge;
+        std::string field;
+        uint64_t expected;
+    };
+
+    struct VerifyReport
+    {
+        std::vector<HashMismatch> hashMismatches;
+        std::vector<OrphanEdge> orphanEdges;
+        std::vector<KeyMismatch> keyMismatches;
+
+        double documentSeconds = 0;
+        double edgeSeconds = 0;
+
+        bool ok() const { return hashMismatches.empty() && orphanEdges.empty() && keyMismatches.empty(); }
+    };
+
+    // re-fingerprints every document with the batch hashContents and checks every edge's endpoints
+    // and concatHash-derived keys; documents and edges are split across threadCount threads
+    VerifyReport verifyGraph(const std::vector<Document> &documents, const std::vector<Edge> &edges, const unsigned threadCount);
+
+} // namespace hypha
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace hypha
+{
+    // a blocking client for the subset of RFC 6455 the state history endpoint uses: one connection,
+    // binary and text messages, fragmentation, ping and close; there is no TLS
+    class WebSocket
+    {
+    public:
+        WebSocket(const std::string &host, const std::string &port, const std::string &path = "/");
+        ~WebSocket();
+
+        WebSocket(const WebSocket &) = delete;
+        WebSocket &operator=(const WebSocket &) = delete;
+
+        void send(const std::vector<char> &message);
+
+        // blocks until a complete text or binary message arrives; false once the server closed the connection
+        bool receive(std::vector<char> &message);
+
+    private:
+        void writeAll(const char *data, std::size_t size);
+        void readExact(char *data, std::size_t size);
+        void sendFrame(uint8_t opcode, const char *data, std::size_t size);
+
+        int m_socket = -1;
+
+        // bytes received after the handshake response that belong to the first frames
+        std::vector<char> m_buffer;
+        std::size_t m_bufferPos = 0;
+    };
+
+} // namespace hypha
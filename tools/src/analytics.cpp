@@ -0,0 +1,284 @@
+#include <graph_tools/analytics.hpp>
+#include <graph_tools/parallel.hpp>
+
+#include <atomic>
+#include <cmath>
+#include <unordered_map>
+
+namespace hypha
+{
+    uint32_t GraphAdjacency::degree(const uint32_t node, const Direction direction) const
+    {
+        const AdjacencyView &view = direction == Direction::Out ? out : in;
+        if (edgeNames.empty())
+        {
+            return view.offsets[node + 1] - view.offsets[node];
+        }
+
+        uint32_t degree = 0;
+        for (const eosio::name &edgeName : edgeNames)
+        {
+            degree += view.neighbors(node, edgeName).size();
+        }
+        return degree;
+    }
+
+    PageRankResult pageRank(const GraphAdjacency &graph, const PageRankOptions &options, const unsigned threadCount)
+    {
+        const std::size_t n = graph.nodeCount;
+        PageRankResult result;
+        if (n == 0)
+        {
+            return result;
+        }
+
+        std::vector<uint32_t> outDegrees = degrees(graph, Direction::Out, threadCount);
+        std::vector<double> ranks(n, 1.0 / n);
+        std::vector<double> next(n);
+
+        // each node's rank divided by its out-degree, read by all of its out-neighbours
+        std::vector<double> shares(n);
+
+        std::vector<double> dangling(threadCount);
+        std::vector<double> delta(threadCount);
+        while (result.iterations < options.maxIterations)
+        {
+            std::fill(dangling.begin(), dangling.end(), 0.0);
+            parallelFor(n, threadCount, [&](std::size_t first, std::size_t last, unsigned worker) {
+                for (std::size_t node = first; node < last; node++)
+                {
+                    if (outDegrees[node] == 0)
+                    {
+                        shares[node] = 0;
+                        dangling[worker] += ranks[node];
+                    }
+                    else
+                    {
+                        shares[node] = ranks[node] / outDegrees[node];
+                    }
+                }
+            }, 4096);
+
+            double danglingRank = 0;
+            for (double rank : dangling)
+            {
+                danglingRank += rank;
+            }
+            const double base = (1.0 - options.damping) / n + options.damping * danglingRank / n;
+
+            std::fill(delta.begin(), delta.end(), 0.0);
+            parallelFor(n, threadCount, [&](std::size_t first, std::size_t last, unsigned worker) {
+                for (std::size_t node = first; node < last; node++)
+                {
+                    double sum = 0;
+                    graph.forEachNeighbor(node, Direction::In, [&](uint32_t neighbor) { sum += shares[neighbor]; });
+                    next[node] = base + options.damping * sum;
+                    delta[worker] += std::fabs(next[node] - ranks[node]);
+                }
+            }, 1024);
+
+            std::swap(ranks, next);
+            result.iterations++;
+
+            result.delta = 0;
+            for (double d : delta)
+            {
+                result.delta += d;
+            }
+            if (result.delta < options.tolerance)
+            {
+                break;
+            }
+        }
+
+        result.ranks = std::move(ranks);
+        return result;
+    }
+
+    namespace
+    {
+        // the root of node, halving the path on the way: every other node is pointed at its
+        // grandparent, which only ever shortens paths and is safe while other threads do the same
+        uint32_t findRoot(std::vector<std::atomic<uint32_t>> &parents, uint32_t node)
+        {
+            uint32_t parent = parents[node].load(std::memory_order_relaxed);
+            while (parent != node)
+            {
+                uint32_t grandparent = parents[parent].load(std::memory_order_relaxed);
+                parents[node].compare_exchange_weak(parent, grandparent, std::memory_order_relaxed);
+                node = grandparent;
+                parent = parents[node].load(std::memory_order_relaxed);
+            }
+            return node;
+        }
+
+        void unite(std::vector<std::atomic<uint32_t>> &parents, uint32_t a, uint32_t b)
+        {
+            while (true)
+            {
+                a = findRoot(parents, a);
+                b = findRoot(parents, b);
+                if (a == b)
+                {
+                    return;
+                }
+                if (a < b)
+                {
+                    std::swap(a, b);
+                }
+
+                // a may have been hooked under another root meanwhile, then the roots are found again
+                uint32_t expected = a;
+                if (parents[a].compare_exchange_strong(expected, b, std::memory_order_relaxed))
+                {
+                    return;
+                }
+            }
+        }
+    } // namespace
+
+    std::vector<uint32_t> weakComponents(const GraphAdjacency &graph, const unsigned threadCount)
+    {
+        const std::size_t n = graph.nodeCount;
+        std::vector<std::atomic<uint32_t>> parents(n);
+        for (std::size_t node = 0; node < n; node++)
+        {
+            parents[node].store(node, std::memory_order_relaxed);
+        }
+
+        // every edge is in both directions' rows, so following the outgoing rows is enough
+        parallelFor(n, threadCount, [&](std::size_t first, std::size_t last, unsigned) {
+            for (std::size_t node = first; node < last; node++)
+            {
+                graph.forEachNeighbor(node, Direction::Out, [&](uint32_t neighbor) { unite(parents, node, neighbor); });
+            }
+        }, 1024);
+
+        // all threads are joined, so the roots no longer move
+        std::vector<uint32_t> components(n);
+        parallelFor(n, threadCount, [&](std::size_t first, std::size_t last, unsigned) {
+            for (std::size_t node = first; node < last; node++)
+            {
+                components[node] = findRoot(parents, node);
+            }
+        }, 4096);
+        return components;
+    }
+
+    std::vector<DegreeHistogram> degreeHistograms(const GraphAdjacency &graph, const unsigned threadCount)
+    {
+        std::vector<DegreeHistogram> histograms;
+        for (Direction direction : {Direction::Out, Direction::In})
+        {
+            const AdjacencyView &view = direction == Direction::Out ? graph.out : graph.in;
+
+            // rows are sorted by edge name, so the degree of each name is the length of a run
+            std::vector<std::unordered_map<uint64_t, std::map<uint32_t, uint64_t>>> partial(threadCount);
+            parallelFor(graph.nodeCount, threadCount, [&](std::size_t first, std::size_t last, unsigned worker) {
+                for (std::size_t node = first; node < last; node++)
+                {
+                    uint32_t run = view.offsets[node];
+                    while (run < view.offsets[node + 1])
+                    {
+                        uint32_t end = run;
+                        while (end < view.offsets[node + 1] && view.names[end] == view.names[run])
+                        {
+                            end++;
+                        }
+                        partial[worker][view.names[run]][end - run]++;
+                        run = end;
+                    }
+                }
+            }, 4096);
+
+            std::map<uint64_t, std::map<uint32_t, uint64_t>> merged;
+            for (const auto &byName : partial)
+            {
+                for (const auto &[name, counts] : byName)
+                {
+                    for (const auto &[degree, nodes] : counts)
+                    {
+                        merged[name][degree] += nodes;
+                    }
+                }
+            }
+            for (auto &[name, counts] : merged)
+            {
+                histograms.push_back(DegreeHistogram{eosio::name(name), direction, std::move(counts)});
+            }
+        }
+
+        std::stable_sort(histograms.begin(), histograms.end(), [](const DegreeHistogram &a, const DegreeHistogram &b) {
+            return a.edgeName < b.edgeName;
+        });
+        return histograms;
+    }
+
+    std::vector<uint32_t> degrees(const GraphAdjacency &graph, const Direction direction, const unsigned threadCount)
+    {
+        std::vector<uint32_t> result(graph.nodeCount);
+        parallelFor(graph.nodeCount, threadCount, [&](std::size_t first, std::size_t last, unsigned) {
+            for (std::size_t node = first; node < last; node++)
+            {
+                result[node] = graph.degree(node, direction);
+            }
+        }, 4096);
+        return result;
+    }
+
+    std::vector<uint32_t> neighborhoodSizes(const GraphAdjacency &graph, const uint32_t hops,
+                                            const std::optional<Direction> direction, const unsigned threadCount)
+    {
+        const std::size_t n = graph.nodeCount;
+        std::vector<uint32_t> sizes(n);
+
+        // a mark holds the start node plus one of the search that last reached the node
+        std::vector<std::vector<uint32_t>> marks(threadCount);
+        std::vector<std::vector<uint32_t>> frontiers(threadCount);
+        std::vector<std::vector<uint32_t>> nexts(threadCount);
+
+        // neighbourhoods of hub nodes are far larger than others, so the chunks are small
+        parallelFor(n, threadCount, [&](std::size_t first, std::size_t last, unsigned worker) {
+            std::vector<uint32_t> &mark = marks[worker];
+            std::vector<uint32_t> &frontier = frontiers[worker];
+            std::vector<uint32_t> &next = nexts[worker];
+            if (mark.empty())
+            {
+                mark.assign(n, 0);
+            }
+
+            for (std::size_t start = first; start < last; start++)
+            {
+                const uint32_t search = start + 1;
+                uint32_t reached = 0;
+                mark[start] = search;
+                frontier.assign(1, start);
+
+                auto visit = [&](uint32_t neighbor) {
+                    if (mark[neighbor] != search)
+                    {
+                        mark[neighbor] = search;
+                        next.push_back(neighbor);
+                        reached++;
+                    }
+                };
+
+                for (uint32_t hop = 0; hop < hops && !frontier.empty(); hop++)
+                {
+                    next.clear();
+                    for (uint32_t node : frontier)
+                    {
+                        if (!direction || *direction == Direction::Out)
+                            graph.forEachNeighbor(node, Direction::Out, visit);
+                        if (!direction || *direction == Direction::In)
+                            graph.forEachNeighbor(node, Direction::In, visit);
+                    }
+                    std::swap(frontier, next);
+                }
+                sizes[start] = reached;
+            }
+        }, 64);
+        return sizes;
+    }
+
+} // namespace hypha
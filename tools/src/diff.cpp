@@ -0,0 +1,381 @@
+#include <graph_tools/diff.hpp>
+#include <graph_tools/graph_dump.hpp>
+#include <graph_tools/parallel.hpp>
+
+#include <document_graph/util.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <sys/stat.h>
+
+namespace hypha
+{
+    namespace
+    {
+        struct DocumentOrder
+        {
+            bool operator()(const DocumentKey &a, const DocumentKey &b) const
+            {
+                return std::memcmp(a.hash.data(), b.hash.data(), a.hash.size()) < 0;
+            }
+        };
+
+        struct EdgeOrder
+        {
+            bool operator()(const EdgeKey &a, const EdgeKey &b) const
+            {
+                int order = std::memcmp(a.from.data(), b.from.data(), a.from.size());
+                if (order != 0)
+                    return order < 0;
+                if (a.name != b.name)
+                    return a.name < b.name;
+                return std::memcmp(a.to.data(), b.to.data(), a.to.size()) < 0;
+            }
+        };
+
+        // one slice per thread is sorted, then neighbouring slices are merged pairwise, the pairs
+        // of each round in parallel
+        template <typename Key, typename Less>
+        void parallelSort(std::vector<Key> &keys, const unsigned threadCount, Less less)
+        {
+            const std::size_t slices = std::max<std::size_t>(1, std::min<std::size_t>(threadCount, keys.size() / 4096));
+            std::vector<std::size_t> bounds(slices + 1);
+            for (std::size_t s = 0; s <= slices; s++)
+            {
+                bounds[s] = keys.size() * s / slices;
+            }
+
+            parallelFor(slices, threadCount, [&](std::size_t first, std::size_t last, unsigned) {
+                for (std::size_t s = first; s < last; s++)
+                {
+                    std::sort(keys.begin() + bounds[s], keys.begin() + bounds[s + 1], less);
+                }
+            }, 1);
+
+            for (std::size_t width = 1; width < slices; width *= 2)
+            {
+                std::size_t pairs = (slices + 2 * width - 1) / (2 * width);
+                parallelFor(pairs, threadCount, [&](std::size_t first, std::size_t last, unsigned) {
+                    for (std::size_t p = first; p < last; p++)
+                    {
+                        std::size_t start = p * 2 * width;
+                        std::size_t middle = std::min(start + width, slices);
+                        std::size_t end = std::min(start + 2 * width, slices);
+                        std::inplace_merge(keys.begin() + bounds[start], keys.begin() + bounds[middle], keys.begin() + bounds[end], less);
+                    }
+                }, 1);
+            }
+        }
+
+        // drops repeated keys, e.g. a document that a dump holds in both document tables
+        template <typename Key, typename Less>
+        void removeRepeats(std::vector<Key> &keys, Less less)
+        {
+            auto same = [&](const Key &a, const Key &b) { return !less(a, b) && !less(b, a); };
+            keys.erase(std::unique(keys.begin(), keys.end(), same), keys.end());
+        }
+
+        // calls collect(first, last, out) on chunks of [0, count) in parallel and concatenates the
+        // chunks in order, so that keys read in sorted order stay sorted
+        template <typename Key, typename Collect>
+        std::vector<Key> collectInOrder(const std::size_t count, const unsigned threadCount, Collect &&collect)
+        {
+            constexpr std::size_t CHUNK = 1 << 14;
+            std::vector<std::vector<Key>> chunks((count + CHUNK - 1) / CHUNK);
+            parallelFor(count, threadCount, [&](std::size_t first, std::size_t last, unsigned) {
+                collect(first, last, chunks[first / CHUNK]);
+            }, CHUNK);
+
+            std::size_t total = 0;
+            for (const std::vector<Key> &chunk : chunks)
+            {
+                total += chunk.size();
+            }
+            std::vector<Key> keys;
+            keys.reserve(total);
+            for (const std::vector<Key> &chunk : chunks)
+            {
+                keys.insert(keys.end(), chunk.begin(), chunk.end());
+            }
+            return keys;
+        }
+
+        // both lists are cut at the same keys, taken evenly from the longer one, and each range
+        // is merged on its own; keys only in to are added, keys only in from are removed
+        template <typename Key, typename Less>
+        void diffSorted(const std::vector<Key> &from, const std::vector<Key> &to, const unsigned threadCount, Less less,
+                        std::vector<Key> &added, std::vector<Key> &removed)
+        {
+            const std::vector<Key> &longer = from.size() >= to.size() ? from : to;
+            const std::size_t ranges = std::max<std::size_t>(1, std::min<std::size_t>(threadCount * 4, longer.size() / 4096));
+
+            std::vector<std::size_t> fromBounds(ranges + 1, 0);
+            std::vector<std::size_t> toBounds(ranges + 1, 0);
+            for (std::size_t r = 1; r < ranges; r++)
+            {
+                const Key &cut = longer[longer.size() * r / ranges];
+                fromBounds[r] = std::lower_bound(from.begin(), from.end(), cut, less) - from.begin();
+                toBounds[r] = std::lower_bound(to.begin(), to.end(), cut, less) - to.begin();
+            }
+            fromBounds[ranges] = from.size();
+            toBounds[ranges] = to.size();
+
+            std::vector<std::vector<Key>> rangeAdded(ranges);
+            std::vector<std::vector<Key>> rangeRemoved(ranges);
+            parallelFor(ranges, threadCount, [&](std::size_t first, std::size_t last, unsigned) {
+                for (std::size_t r = first; r < last; r++)
+                {
+                    std::size_t i = fromBounds[r];
+                    std::size_t j = toBounds[r];
+                    while (i < fromBounds[r + 1] && j < toBounds[r + 1])
+                    {
+                        if (less(from[i], to[j]))
+                            rangeRemoved[r].push_back(from[i++]);
+                        else if (less(to[j], from[i]))
+                            rangeAdded[r].push_back(to[j++]);
+                        else
+                            i++, j++;
+                    }
+                    rangeRemoved[r].insert(rangeRemoved[r].end(), from.begin() + i, from.begin() + fromBounds[r + 1]);
+                    rangeAdded[r].insert(rangeAdded[r].end(), to.begin() + j, to.begin() + toBounds[r + 1]);
+                }
+            }, 1);
+
+            for (std::size_t r = 0; r < ranges; r++)
+            {
+                added.insert(added.end(), rangeAdded[r].begin(), rangeAdded[r].end());
+                removed.insert(removed.end(), rangeRemoved[r].begin(), rangeRemoved[r].end());
+            }
+        }
+
+        std::string hexOf(const HashBytes &bytes)
+        {
+            return toHex(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+        }
+
+        Edge edgeOf(const EdgeKey &key)
+        {
+            Edge edge;
+            edge.from_node = eosio::checksum256(key.from);
+            edge.to_node = eosio::checksum256(key.to);
+            edge.edge_name = eosio::name(key.name);
+            edge.id = concatHash(edge.from_node, edge.to_node, edge.edge_name);
+            edge.from_node_edge_name_index = concatHash(edge.from_node, edge.edge_name);
+            edge.from_node_to_node_index = concatHash(edge.from_node, edge.to_node);
+            edge.to_node_edge_name_index = concatHash(edge.to_node, edge.edge_name);
+            return edge;
+        }
+
+        // formats count lines on threadCount threads and writes them in order
+        template <typename Format>
+        void writeLines(OutputFile &file, const std::size_t count, const unsigned threadCount, Format &&format)
+        {
+            constexpr std::size_t CHUNK = 4096;
+            for (std::size_t batch = 0; batch < count; batch += CHUNK * threadCount)
+            {
+                std::size_t batchEnd = std::min(count, batch + CHUNK * threadCount);
+                std::vector<std::string> chunks((batchEnd - batch + CHUNK - 1) / CHUNK);
+                parallelFor(batchEnd - batch, threadCount, [&](std::size_t first, std::size_t last, unsigned) {
+                    std::string &out = chunks[first / CHUNK];
+                    for (std::size_t i = first; i < last; i++)
+                    {
+                        format(batch + i, out);
+                    }
+                }, CHUNK);
+
+                for (const std::string &chunk : chunks)
+                {
+                    file.buffer() += chunk;
+                    file.commit();
+                }
+            }
+        }
+    } // namespace
+
+    GraphInput loadGraphInput(const std::string &path, const eosio::name &contract, const eosio::name &scope)
+    {
+        struct stat status;
+        eosio::check(::stat(path.c_str(), &status) == 0, "cannot open " + path);
+
+        GraphInput input;
+        if (S_ISDIR(status.st_mode))
+        {
+            input.documents = loadDocuments(path + "/documents.json");
+            input.edges = loadEdges(path + "/edges.json");
+            return input;
+        }
+
+        char magic[sizeof(SNAPSHOT_MAGIC)] = {};
+        std::FILE *file = std::fopen(path.c_str(), "rb");
+        eosio::check(file != nullptr, "cannot open " + path);
+        bool isSnapshot = std::fread(magic, sizeof(magic), 1, file) == 1 && std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0;
+        std::fclose(file);
+
+        if (isSnapshot)
+        {
+            input.snapshot = std::make_unique<Snapshot>(path);
+            return input;
+        }
+
+        input.replica = std::make_unique<GraphReplica>(contract, scope);
+        eosio::check(input.replica->load(path), "cannot open " + path);
+        input.documents = input.replica->documents();
+        input.edges = input.replica->edges();
+        return input;
+    }
+
+    GraphKeys collectKeys(const GraphInput &input, const unsigned threadCount)
+    {
+        GraphKeys keys;
+        if (input.snapshot)
+        {
+            const Snapshot &snapshot = *input.snapshot;
+            keys.documents = collectInOrder<DocumentKey>(snapshot.nodeCount(), threadCount, [&](std::size_t first, std::size_t last, std::vector<DocumentKey> &out) {
+                for (std::size_t node = first; node < last; node++)
+                {
+                    if (snapshot.hasDocument(node))
+                        out.push_back(DocumentKey{snapshot.getHash(node).extract_as_byte_array(), uint32_t(node)});
+                }
+            });
+
+            AdjacencyView outgoing = snapshot.outgoing();
+            keys.edges = collectInOrder<EdgeKey>(snapshot.nodeCount(), threadCount, [&](std::size_t first, std::size_t last, std::vector<EdgeKey> &out) {
+                for (std::size_t node = first; node < last; node++)
+                {
+                    if (outgoing.offsets[node] == outgoing.offsets[node + 1])
+                        continue;
+
+                    HashBytes from = snapshot.getHash(node).extract_as_byte_array();
+                    for (uint32_t e = outgoing.offsets[node]; e < outgoing.offsets[node + 1]; e++)
+                    {
+                        out.push_back(EdgeKey{from, snapshot.getHash(outgoing.nodes[e]).extract_as_byte_array(), outgoing.names[e], e});
+                    }
+                }
+            });
+        }
+        else
+        {
+            eosio::check(input.documents.size() < UINT32_MAX && input.edges.size() < UINT32_MAX, "too many rows to diff");
+
+            keys.documents.resize(input.documents.size());
+            parallelFor(input.documents.size(), threadCount, [&](std::size_t first, std::size_t last, unsigned) {
+                for (std::size_t i = first; i < last; i++)
+                {
+                    keys.documents[i] = DocumentKey{input.documents[i].getHash().extract_as_byte_array(), uint32_t(i)};
+                }
+            });
+
+            keys.edges.resize(input.edges.size());
+            parallelFor(input.edges.size(), threadCount, [&](std::size_t first, std::size_t last, unsigned) {
+                for (std::size_t i = first; i < last; i++)
+                {
+                    const Edge &edge = input.edges[i];
+                    keys.edges[i] = EdgeKey{edge.from_node.extract_as_byte_array(), edge.to_node.extract_as_byte_array(), edge.edge_name.value, uint32_t(i)};
+                }
+            });
+
+            parallelSort(keys.documents, threadCount, DocumentOrder{});
+            parallelSort(keys.edges, threadCount, EdgeOrder{});
+        }
+
+        removeRepeats(keys.documents, DocumentOrder{});
+        removeRepeats(keys.edges, EdgeOrder{});
+        return keys;
+    }
+
+    Document inputDocument(const GraphInput &input, const DocumentKey &key)
+    {
+        return input.snapshot ? input.snapshot->getDocument(key.row) : input.documents[key.row];
+    }
+
+    Edge inputEdge(const GraphInput &input, const EdgeKey &key)
+    {
+        if (input.snapshot)
+            return edgeOf(key);
+
+        // dumps may leave out the derived index keys
+        Edge edge = input.edges[key.row];
+        if (edge.from_node_edge_name_index == 0 && edge.from_node_to_node_index == 0 && edge.to_node_edge_name_index == 0)
+        {
+            Edge keyed = edgeOf(key);
+            edge.from_node_edge_name_index = keyed.from_node_edge_name_index;
+            edge.from_node_to_node_index = keyed.from_node_to_node_index;
+            edge.to_node_edge_name_index = keyed.to_node_edge_name_index;
+        }
+        return edge;
+    }
+
+    GraphDiff diffKeys(const GraphKeys &from, const GraphKeys &to, const unsigned threadCount)
+    {
+        GraphDiff diff;
+        diffSorted(from.documents, to.documents, threadCount, DocumentOrder{}, diff.addedDocuments, diff.removedDocuments);
+        diffSorted(from.edges, to.edges, threadCount, EdgeOrder{}, diff.addedEdges, diff.removedEdges);
+        return diff;
+    }
+
+    void writeChanges(const std::string &fileName, const GraphDiff &diff, const GraphInput &to, const unsigned threadCount)
+    {
+        OutputFile file(fileName);
+
+        writeLines(file, diff.removedEdges.size(), threadCount, [&](std::size_t i, std::string &out) {
+            const EdgeKey &key = diff.removedEdges[i];
+            out += "{\"change\":\"remove_edge\",\"from_node\":\"" + hexOf(key.from) + "\",\"to_node\":\"" + hexOf(key.to) +
+                   "\",\"edge_name\":\"" + eosio::name(key.name).to_string() + "\"}\n";
+        });
+        writeLines(file, diff.removedDocuments.size(), threadCount, [&](std::size_t i, std::string &out) {
+            out += "{\"change\":\"remove_document\",\"hash\":\"" + hexOf(diff.removedDocuments[i].hash) + "\"}\n";
+        });
+        writeLines(file, diff.addedDocuments.size(), threadCount, [&](std::size_t i, std::string &out) {
+            out += "{\"change\":\"add_document\",\"row\":";
+            appendDocumentRow(out, eosio::unpack<DocumentRow>(eosio::pack(inputDocument(to, diff.addedDocuments[i]))));
+            out += "}\n";
+        });
+        writeLines(file, diff.addedEdges.size(), threadCount, [&](std::size_t i, std::string &out) {
+            out += "{\"change\":\"add_edge\",\"row\":";
+            appendEdgeRow(out, inputEdge(to, diff.addedEdges[i]));
+            out += "}\n";
+        });
+
+        file.close();
+    }
+
+    void applyChanges(const GraphDiff &diff, const GraphInput &to, GraphReplica &replica)
+    {
+        std::vector<eosio::checksum256> removedDocuments;
+        removedDocuments.reserve(diff.removedDocuments.size());
+        for (const DocumentKey &key : diff.removedDocuments)
+        {
+            removedDocuments.push_back(eosio::checksum256(key.hash));
+        }
+
+        std::vector<Edge> removedEdges;
+        removedEdges.reserve(diff.removedEdges.size());
+        for (const EdgeKey &key : diff.removedEdges)
+        {
+            Edge edge;
+            edge.from_node = eosio::checksum256(key.from);
+            edge.to_node = eosio::checksum256(key.to);
+            edge.edge_name = eosio::name(key.name);
+            removedEdges.push_back(edge);
+        }
+
+        std::vector<Document> addedDocuments;
+        addedDocuments.reserve(diff.addedDocuments.size());
+        for (const DocumentKey &key : diff.addedDocuments)
+        {
+            addedDocuments.push_back(inputDocument(to, key));
+        }
+
+        std::vector<Edge> addedEdges;
+        addedEdges.reserve(diff.addedEdges.size());
+        for (const EdgeKey &key : diff.addedEdges)
+        {
+            addedEdges.push_back(inputEdge(to, key));
+        }
+
+        replica.reconcile(removedDocuments, removedEdges, addedDocuments, addedEdges);
+    }
+
+} // namespace hypha
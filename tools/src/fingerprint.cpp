@@ -0,0 +1,74 @@
+#include <graph_tools/fingerprint.hpp>
+#include <graph_tools/parallel.hpp>
+
+namespace hypha
+{
+    namespace
+    {
+        // enough documents per chunk to fill the AVX2 lanes with messages of similar length
+        constexpr std::size_t CHUNK = 256;
+
+        template <typename GetContentGroups>
+        std::vector<eosio::checksum256> hashAll(const std::size_t count, GetContentGroups &&getContentGroups,
+                                                const unsigned threadCount, const Sha256Backend backend)
+        {
+            std::vector<eosio::checksum256> hashes(count);
+            std::vector<std::vector<std::string>> messages(threadCount);
+            std::vector<std::vector<std::array<uint8_t, 32>>> digests(threadCount);
+
+            parallelFor(count, threadCount, [&](std::size_t first, std::size_t last, unsigned worker) {
+                std::vector<std::string> &chunk = messages[worker];
+                chunk.resize(last - first);
+                for (std::size_t i = first; i < last; i++)
+                {
+                    chunk[i - first] = fingerprint(getContentGroups(i));
+                }
+
+                digests[worker].resize(chunk.size());
+                sha256Many(chunk.data(), chunk.size(), digests[worker].data(), backend);
+                for (std::size_t i = first; i < last; i++)
+                {
+                    hashes[i] = eosio::checksum256(digests[worker][i - first]);
+                }
+            }, CHUNK);
+            return hashes;
+        }
+    } // namespace
+
+    std::string fingerprint(const ContentGroups &contentGroups)
+    {
+        std::string result = "[";
+        for (std::size_t g = 0; g < contentGroups.size(); g++)
+        {
+            result += g > 0 ? ",[" : "[";
+            for (std::size_t c = 0; c < contentGroups[g].size(); c++)
+            {
+                if (c > 0)
+                {
+                    result += ',';
+                }
+
+                // Content::toString only reads the content
+                result += const_cast<Content &>(contentGroups[g][c]).toString();
+            }
+            result += ']';
+        }
+        result += ']';
+        return result;
+    }
+
+    std::vector<eosio::checksum256> hashContents(const std::vector<ContentGroups> &contentGroups, const unsigned threadCount,
+                                                 const Sha256Backend backend)
+    {
+        return hashAll(contentGroups.size(), [&](std::size_t i) -> const ContentGroups & { return contentGroups[i]; },
+                       threadCount, backend);
+    }
+
+    std::vector<eosio::checksum256> hashContents(const std::vector<Document> &documents, const unsigned threadCount,
+                                                 const Sha256Backend backend)
+    {
+        return hashAll(documents.size(), [&](std::size_t i) -> const ContentGroups & { return documents[i].getContentGroups(); },
+                       threadCount, backend);
+    }
+
+} // namespace hypha
@@ -0,0 +1,629 @@
+#include <graph_tools/generator.hpp>
+#include <graph_tools/graph_dump.hpp>
+#include <graph_tools/parallel.hpp>
+
+#include <document_graph/document.hpp>
+#include <document_graph/util.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+
+namespace hypha
+{
+    namespace
+    {
+        // splitmix64; unlike the std distributions its output is the same on every platform,
+        // so a seed names the same workload everywhere
+        class Random
+        {
+        public:
+            Random(const uint64_t seed, const uint64_t stream, const uint64_t index)
+                : m_state{seed * 0x9e3779b97f4a7c15ULL ^ stream * 0xc2b2ae3d27d4eb4fULL ^ index}
+            {
+                next();
+            }
+
+            uint64_t next()
+            {
+                uint64_t z = (m_state += 0x9e3779b97f4a7c15ULL);
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+                return z ^ (z >> 31);
+            }
+
+            // uniform in [0, n)
+            uint64_t below(const uint64_t n) { return (unsigned __int128)next() * n >> 64; }
+
+            // uniform in [0, 1)
+            double unit() { return (next() >> 11) * 0x1.0p-53; }
+
+        private:
+            uint64_t m_state;
+        };
+
+        // random streams, so that documents and edges draw independently
+        constexpr uint64_t DOCUMENT_STREAM = 1;
+        constexpr uint64_t EDGE_STREAM = 2;
+        constexpr uint64_t LAYOUT_STREAM = 3;
+
+        // rows are generated and handed to the sink in blocks of this many
+        constexpr std::size_t BLOCK_SIZE = 1 << 16;
+
+        // created dates are one block apart
+        constexpr int64_t BLOCK_INTERVAL_US = 500000;
+
+        uint32_t draw(const SizeDistribution &distribution, Random &random)
+        {
+            switch (distribution.kind)
+            {
+            case SizeDistribution::Fixed:
+                return distribution.min;
+            case SizeDistribution::Uniform:
+                return distribution.min + random.below(distribution.max - distribution.min + 1);
+            case SizeDistribution::Geometric:
+            {
+                if (distribution.mean <= distribution.min)
+                {
+                    return distribution.min;
+                }
+                // failures before the first success, shifted to start at min
+                double p = 1.0 / (distribution.mean - distribution.min + 1);
+                double k = std::floor(std::log(1 - random.unit()) / std::log(1 - p));
+                return std::min<double>(distribution.max, distribution.min + k);
+            }
+            }
+            return distribution.min;
+        }
+
+        // picks an index by weight from cumulative weights
+        std::size_t pick(const std::vector<double> &cumulative, Random &random)
+        {
+            double target = random.unit() * cumulative.back();
+            return std::upper_bound(cumulative.begin(), cumulative.end(), target) - cumulative.begin();
+        }
+
+        template <typename T>
+        std::vector<double> cumulativeWeights(const std::vector<std::pair<T, double>> &weights)
+        {
+            std::vector<double> cumulative;
+            double total = 0;
+            for (const auto &weight : weights)
+            {
+                eosio::check(weight.second >= 0, "weights must not be negative");
+                total += weight.second;
+                cumulative.push_back(total);
+            }
+            eosio::check(total > 0, "at least one weight must be positive");
+            return cumulative;
+        }
+
+        // rank in [0, n) of a continuous power law with exponent skew; 0 is uniform
+        uint64_t powerLawRank(const uint64_t n, const double skew, Random &random)
+        {
+            double u = random.unit();
+            double x;
+            if (std::abs(skew - 1) < 1e-9)
+            {
+                x = std::exp(u * std::log(double(n) + 1));
+            }
+            else
+            {
+                x = std::pow((std::pow(double(n) + 1, 1 - skew) - 1) * u + 1, 1 / (1 - skew));
+            }
+            return std::min<uint64_t>(n - 1, uint64_t(x) - 1);
+        }
+
+        // spreads power law ranks over the documents, so that the hubs are not simply the oldest
+        // documents and the most linked-from and linked-to documents differ
+        struct RankLayout
+        {
+            uint64_t n;
+            uint64_t multiplier;
+            uint64_t offset;
+
+            RankLayout(const uint64_t n, Random &random) : n{n}, offset{random.below(n)}
+            {
+                multiplier = random.below(n) | 1;
+                while (std::gcd(multiplier, n) != 1)
+                {
+                    multiplier += 2;
+                }
+            }
+
+            uint64_t operator()(const uint64_t rank) const
+            {
+                return ((unsigned __int128)rank * multiplier + offset) % n;
+            }
+        };
+
+        const char LOWERCASE[] = "abcdefghijklmnopqrstuvwxyz";
+        const char NAME_CHARACTERS[] = "abcdefghijklmnopqrstuvwxyz12345";
+        const char *const SYMBOLS[] = {"HUSD", "HYPHA", "SEEDS", "HVOICE", "USD"};
+        const uint8_t PRECISIONS[] = {2, 2, 4, 2, 2};
+
+        Content::FlexValue randomValue(const std::string &type, const WorkloadSpec &spec, Random &random)
+        {
+            if (type == "string")
+            {
+                // words of two to nine letters
+                uint32_t length = draw(spec.stringLength, random);
+                std::string value;
+                value.reserve(length);
+                while (value.size() < length)
+                {
+                    if (!value.empty())
+                    {
+                        value += ' ';
+                    }
+                    for (uint64_t letters = 2 + random.below(8); letters > 0 && value.size() < length; letters--)
+                    {
+                        value += LOWERCASE[random.below(26)];
+                    }
+                }
+                return value;
+            }
+            if (type == "int64")
+            {
+                return static_cast<int64_t>(random.below(2000000001)) - 1000000000;
+            }
+            if (type == "name")
+            {
+                std::string value;
+                for (uint64_t length = 1 + random.below(12); length > 0; length--)
+                {
+                    value += NAME_CHARACTERS[random.below(31)];
+                }
+                return eosio::name(std::string_view(value));
+            }
+            if (type == "asset")
+            {
+                std::size_t symbol = random.below(5);
+                return eosio::asset(random.below(1000000000), eosio::symbol(SYMBOLS[symbol], PRECISIONS[symbol]));
+            }
+            if (type == "time_point")
+            {
+                // within three years before the start, to the millisecond like block times
+                int64_t millis = random.below(3ULL * 365 * 86400 * 1000);
+                return eosio::time_point(eosio::microseconds(spec.start.time_since_epoch().count() - millis * 1000));
+            }
+            if (type == "checksum256")
+            {
+                std::array<uint8_t, 32> bytes;
+                for (std::size_t i = 0; i < bytes.size(); i += 8)
+                {
+                    uint64_t word = random.next();
+                    for (std::size_t j = 0; j < 8; j++)
+                    {
+                        bytes[i + j] = word >> (8 * j);
+                    }
+                }
+                return eosio::checksum256(bytes);
+            }
+            if (type == "monostate")
+            {
+                return std::monostate();
+            }
+
+            eosio::check(false, "unknown content type: " + type);
+            return std::monostate();
+        }
+
+        GeneratedDocument generateDocument(const WorkloadSpec &spec, const std::vector<double> &typeWeights, const uint64_t id)
+        {
+            Random random(spec.seed, DOCUMENT_STREAM, id);
+
+            GeneratedDocument document;
+            document.id = id;
+            document.creator = spec.creators[random.below(spec.creators.size())];
+            document.created = spec.start + eosio::microseconds(int64_t(id) * BLOCK_INTERVAL_US);
+
+            uint32_t groups = std::max<uint32_t>(1, draw(spec.groups, random));
+            for (uint32_t g = 0; g < groups; g++)
+            {
+                ContentGroup group;
+                group.push_back(Content("content_group_label", "group_" + std::to_string(g)));
+                if (g == 0)
+                {
+                    group.push_back(Content("nonce", static_cast<int64_t>(id)));
+                }
+
+                uint32_t contents = draw(spec.contents, random);
+                for (uint32_t c = 0; c < contents; c++)
+                {
+                    const std::string &type = spec.types[pick(typeWeights, random)].first;
+                    group.push_back(Content(type + "_" + std::to_string(c), randomValue(type, spec, random)));
+                }
+                document.contentGroups.push_back(std::move(group));
+            }
+
+            document.hash = Document::hashContents(document.contentGroups);
+            return document;
+        }
+
+        // a set of 32-bit edge ids; open addressing keeps it at 8 bytes per slot at 10^7 edges
+        class IdSet
+        {
+        public:
+            explicit IdSet(const uint64_t expected)
+            {
+                std::size_t capacity = 16;
+                while (capacity < expected * 2)
+                {
+                    capacity <<= 1;
+                }
+                m_slots.assign(capacity, EMPTY);
+            }
+
+            // returns false if the id is already in the set
+            bool insert(const uint64_t id)
+            {
+                if ((m_size + 1) * 2 > m_slots.size())
+                {
+                    grow();
+                }
+                std::size_t mask = m_slots.size() - 1;
+                for (std::size_t slot = (id * 0x9e3779b97f4a7c15ULL) >> 20 & mask;; slot = (slot + 1) & mask)
+                {
+                    if (m_slots[slot] == id)
+                    {
+                        return false;
+                    }
+                    if (m_slots[slot] == EMPTY)
+                    {
+                        m_slots[slot] = id;
+                        m_size++;
+                        return true;
+                    }
+                }
+            }
+
+        private:
+            static constexpr uint64_t EMPTY = ~0ULL;
+
+            void grow()
+            {
+                std::vector<uint64_t> old(m_slots.size() * 2, EMPTY);
+                old.swap(m_slots);
+                m_size = 0;
+                for (uint64_t id : old)
+                {
+                    if (id != EMPTY)
+                    {
+                        insert(id);
+                    }
+                }
+            }
+
+            std::vector<uint64_t> m_slots;
+            std::size_t m_size = 0;
+        };
+
+        double secondsSince(const std::chrono::steady_clock::time_point &started)
+        {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        }
+    } // namespace
+
+    SizeDistribution parseSizeDistribution(const std::string &spec)
+    {
+        std::vector<std::string> parts;
+        for (std::size_t first = 0;;)
+        {
+            std::size_t colon = spec.find(':', first);
+            parts.push_back(spec.substr(first, colon - first));
+            if (colon == std::string::npos)
+            {
+                break;
+            }
+            first = colon + 1;
+        }
+
+        SizeDistribution distribution;
+        if (parts[0] == "fixed" && parts.size() == 2)
+        {
+            distribution.kind = SizeDistribution::Fixed;
+            distribution.min = distribution.max = std::strtoul(parts[1].c_str(), nullptr, 10);
+            distribution.mean = distribution.min;
+        }
+        else if (parts[0] == "uniform" && parts.size() == 3)
+        {
+            distribution.kind = SizeDistribution::Uniform;
+            distribution.min = std::strtoul(parts[1].c_str(), nullptr, 10);
+            distribution.max = std::strtoul(parts[2].c_str(), nullptr, 10);
+            distribution.mean = (distribution.min + distribution.max) / 2.0;
+        }
+        else if (parts[0] == "geometric" && parts.size() == 3)
+        {
+            distribution.kind = SizeDistribution::Geometric;
+            distribution.min = 1;
+            distribution.mean = std::strtod(parts[1].c_str(), nullptr);
+            distribution.max = std::strtoul(parts[2].c_str(), nullptr, 10);
+        }
+        else
+        {
+            eosio::check(false, "invalid size distribution: " + spec + ", expected fixed:N, uniform:MIN:MAX or geometric:MEAN:MAX");
+        }
+        eosio::check(distribution.min <= distribution.max, "invalid size distribution: " + spec);
+        return distribution;
+    }
+
+    std::vector<std::pair<std::string, double>> parseWeights(const std::string &spec)
+    {
+        std::vector<std::pair<std::string, double>> weights;
+        for (std::size_t first = 0; first < spec.size();)
+        {
+            std::size_t comma = std::min(spec.find(',', first), spec.size());
+            std::string item = spec.substr(first, comma - first);
+            std::size_t equals = item.find('=');
+            eosio::check(equals != std::string::npos, "invalid weight, expected label=weight: " + item);
+            weights.emplace_back(item.substr(0, equals), std::strtod(item.c_str() + equals + 1, nullptr));
+            first = comma + 1;
+        }
+        return weights;
+    }
+
+    WorkloadStats generateWorkload(const WorkloadSpec &spec, WorkloadSink &sink, const unsigned threadCount)
+    {
+        eosio::check(!spec.creators.empty(), "at least one creator is needed");
+        const std::vector<double> typeWeights = cumulativeWeights(spec.types);
+        const std::vector<double> nameWeights = cumulativeWeights(spec.edgeNames);
+
+        WorkloadStats stats;
+        auto started = std::chrono::steady_clock::now();
+
+        // edges only need the hashes, the documents themselves are not kept
+        std::vector<eosio::checksum256> hashes(spec.documents);
+        std::vector<GeneratedDocument> block;
+        for (uint64_t first = 0; first < spec.documents; first += BLOCK_SIZE)
+        {
+            block.resize(std::min<uint64_t>(BLOCK_SIZE, spec.documents - first));
+            parallelFor(block.size(), threadCount, [&](std::size_t begin, std::size_t end, unsigned) {
+                for (std::size_t i = begin; i < end; i++)
+                {
+                    block[i] = generateDocument(spec, typeWeights, first + i);
+                }
+            }, 256);
+
+            for (const GeneratedDocument &document : block)
+            {
+                hashes[document.id] = document.hash;
+                stats.contents += std::accumulate(document.contentGroups.begin(), document.contentGroups.end(), std::size_t(0),
+                                                  [](std::size_t sum, const ContentGroup &group) { return sum + group.size(); });
+                sink.document(document);
+            }
+            stats.documents += block.size();
+        }
+        block.clear();
+        stats.documentSeconds = secondsSince(started);
+
+        started = std::chrono::steady_clock::now();
+        const uint64_t target = spec.documents < 2 ? 0 : std::llround(spec.documents * spec.edgesPerDocument);
+        if (target > 0)
+        {
+            Random layoutRandom(spec.seed, LAYOUT_STREAM, 0);
+            const RankLayout fromLayout(spec.documents, layoutRandom);
+            const RankLayout toLayout(spec.documents, layoutRandom);
+
+            // candidates are drawn until the target is met; those whose id is taken are dropped,
+            // and a bound on the candidates keeps a dense graph from running forever
+            IdSet ids(target);
+            std::vector<Edge> candidates;
+            const uint64_t maxCandidates = target * 4;
+            for (uint64_t first = 0; stats.edges < target && first < maxCandidates; first += BLOCK_SIZE)
+            {
+                candidates.resize(std::min<uint64_t>(BLOCK_SIZE, maxCandidates - first));
+                parallelFor(candidates.size(), threadCount, [&](std::size_t begin, std::size_t end, unsigned) {
+                    for (std::size_t i = begin; i < end; i++)
+                    {
+                        Random random(spec.seed, EDGE_STREAM, first + i);
+                        uint64_t from = fromLayout(powerLawRank(spec.documents, spec.outSkew, random));
+                        uint64_t to = toLayout(powerLawRank(spec.documents, spec.inSkew, random));
+                        for (int retry = 0; to == from && retry < 8; retry++)
+                        {
+                            to = toLayout(powerLawRank(spec.documents, spec.inSkew, random));
+                        }
+
+                        Edge &edge = candidates[i];
+                        edge.contract = spec.contract;
+                        edge.creator = spec.creators[random.below(spec.creators.size())];
+                        edge.from_node = hashes[from];
+                        edge.to_node = hashes[to == from ? (to + 1) % spec.documents : to];
+                        edge.edge_name = spec.edgeNames[pick(nameWeights, random)].first;
+                        edge.id = concatHash(edge.from_node, edge.to_node, edge.edge_name);
+                        edge.from_node_edge_name_index = concatHash(edge.from_node, edge.edge_name);
+                        edge.from_node_to_node_index = concatHash(edge.from_node, edge.to_node);
+                        edge.to_node_edge_name_index = concatHash(edge.to_node, edge.edge_name);
+                    }
+                }, 1024);
+
+                for (Edge &edge : candidates)
+                {
+                    if (stats.edges == target)
+                    {
+                        break;
+                    }
+                    if (!ids.insert(edge.id))
+                    {
+                        stats.droppedEdges++;
+                        continue;
+                    }
+                    edge.created_date = spec.start + eosio::microseconds(int64_t(spec.documents + stats.edges) * BLOCK_INTERVAL_US);
+                    sink.edge(edge);
+                    stats.edges++;
+                }
+            }
+        }
+        stats.edgeSeconds = secondsSince(started);
+
+        sink.finish();
+        return stats;
+    }
+
+    namespace
+    {
+        void appendEdgeData(std::string &out, const Edge &edge)
+        {
+            out += "\"creator\":\"" + edge.creator.to_string() +
+                   "\",\"from_node\":\"" + readableHash(edge.from_node) +
+                   "\",\"to_node\":\"" + readableHash(edge.to_node) +
+                   "\",\"edge_name\":\"" + edge.edge_name.to_string() + "\"";
+        }
+
+        void appendUvarint(std::string &out, uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                out += char(value | 0x80);
+                value >>= 7;
+            }
+            out += char(value);
+        }
+
+        class ActionSink : public WorkloadSink
+        {
+        public:
+            ActionSink(const std::string &folder, const eosio::name &contract)
+                : m_out{folder + "/actions.ndjson"}, m_contract{contract.to_string()} {}
+
+            void document(const GeneratedDocument &document) override
+            {
+                std::string &out = m_out.buffer();
+                appendHeader(out, "create", document.creator);
+                out += "\"creator\":\"" + document.creator.to_string() + "\",\"content_groups\":";
+                appendContentGroups(out, document.contentGroups);
+                out += "}}\n";
+                m_out.commit();
+            }
+
+            void edge(const Edge &edge) override
+            {
+                std::string &out = m_out.buffer();
+                appendHeader(out, "newedge", edge.creator);
+                appendEdgeData(out, edge);
+                out += "}}\n";
+                m_out.commit();
+            }
+
+            void finish() override { m_out.close(); }
+
+        private:
+            void appendHeader(std::string &out, const char *action, const eosio::name &actor)
+            {
+                out += "{\"account\":\"" + m_contract + "\",\"name\":\"" + action +
+                       "\",\"authorization\":[{\"actor\":\"" + actor.to_string() + "\",\"permission\":\"active\"}],\"data\":{";
+            }
+
+            OutputFile m_out;
+            std::string m_contract;
+        };
+
+        class DumpSink : public WorkloadSink
+        {
+        public:
+            DumpSink(const std::string &folder, const eosio::name &contract)
+                : m_documents{folder + "/documents.json"}, m_edges{folder + "/edges.json"}, m_contract{contract.to_string()}
+            {
+                m_documents.buffer() += '[';
+                m_edges.buffer() += '[';
+            }
+
+            void document(const GeneratedDocument &document) override
+            {
+                std::string &out = m_documents.buffer();
+                out += m_documentCount++ > 0 ? ",\n{" : "\n{";
+                out += "\"id\":" + std::to_string(document.id) +
+                       ",\"hash\":\"" + readableHash(document.hash) +
+                       "\",\"creator\":\"" + document.creator.to_string() + "\",\"content_groups\":";
+                appendContentGroups(out, document.contentGroups);
+                out += ",\"certificates\":[],\"created_date\":\"" + formatTimePoint(document.created) +
+                       "\",\"contract\":\"" + m_contract + "\"}";
+                m_documents.commit();
+            }
+
+            void edge(const Edge &edge) override
+            {
+                std::string &out = m_edges.buffer();
+                out += m_edgeCount++ > 0 ? ",\n" : "\n";
+                appendEdgeRow(out, edge);
+                m_edges.commit();
+            }
+
+            void finish() override
+            {
+                m_documents.buffer() += "\n]\n";
+                m_edges.buffer() += "\n]\n";
+                m_documents.close();
+                m_edges.close();
+            }
+
+        private:
+            OutputFile m_documents;
+            OutputFile m_edges;
+            std::string m_contract;
+            uint64_t m_documentCount = 0;
+            uint64_t m_edgeCount = 0;
+        };
+
+        class BinarySink : public WorkloadSink
+        {
+        public:
+            BinarySink(const std::string &folder, const eosio::name &contract)
+                : m_documents{folder + "/documents.bin"}, m_edges{folder + "/edges.bin"}, m_contract{contract} {}
+
+            void document(const GeneratedDocument &document) override
+            {
+                DocumentRow row;
+                row.id = document.id;
+                row.hash = document.hash;
+                row.creator = document.creator;
+                row.content_groups = document.contentGroups;
+                row.created_date = document.created;
+                row.contract = m_contract;
+                append(m_documents, eosio::pack(row));
+            }
+
+            void edge(const Edge &edge) override
+            {
+                append(m_edges, eosio::pack(edge));
+            }
+
+            void finish() override
+            {
+                m_documents.close();
+                m_edges.close();
+            }
+
+        private:
+            static void append(OutputFile &file, const std::vector<char> &row)
+            {
+                appendUvarint(file.buffer(), row.size());
+                file.buffer().append(row.data(), row.size());
+                file.commit();
+            }
+
+            OutputFile m_documents;
+            OutputFile m_edges;
+            eosio::name m_contract;
+        };
+    } // namespace
+
+    std::unique_ptr<WorkloadSink> newActionSink(const std::string &folder, const eosio::name &contract)
+    {
+        return std::make_unique<ActionSink>(folder, contract);
+    }
+
+    std::unique_ptr<WorkloadSink> newDumpSink(const std::string &folder, const eosio::name &contract)
+    {
+        return std::make_unique<DumpSink>(folder, contract);
+    }
+
+    std::unique_ptr<WorkloadSink> newBinarySink(const std::string &folder, const eosio::name &contract)
+    {
+        return std::make_unique<BinarySink>(folder, contract);
+    }
+
+} // namespace hypha
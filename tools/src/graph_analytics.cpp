@@ -0,0 +1,279 @@
+#include <graph_tools/analytics.hpp>
+#include <graph_tools/graph_dump.hpp>
+#include <graph_tools/native_intrinsics.hpp>
+#include <graph_tools/parallel.hpp>
+#include <graph_tools/query_engine.hpp>
+#include <graph_tools/snapshot.hpp>
+
+#include <document_graph/util.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+#include <sys/stat.h>
+
+using namespace hypha;
+
+namespace
+{
+    void usage(const char *program)
+    {
+        std::fprintf(stderr,
+                     "usage: %s <dump folder | snapshot file> <output folder> [--format csv|json] [--threads <n>]\n"
+                     "       [--edge-names <name,...>] [--damping <x>] [--iterations <n>] [--tolerance <x>]\n"
+                     "       [--hops <n>] [--hop-direction out|in|both]\n",
+                     program);
+    }
+
+    double secondsSince(const std::chrono::steady_clock::time_point &started)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    }
+
+    bool hasDocument(const QueryEngine &engine, const uint32_t node) { return engine.getDocument(node) != nullptr; }
+    bool hasDocument(const Snapshot &snapshot, const uint32_t node) { return snapshot.hasDocument(node); }
+
+    std::string formatDouble(const double value)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+        return buffer;
+    }
+
+    const char *directionName(const Direction direction)
+    {
+        return direction == Direction::Out ? "out" : "in";
+    }
+
+    struct Analysis
+    {
+        PageRankResult pageRank;
+        std::vector<uint32_t> components;
+        std::vector<uint32_t> outDegrees;
+        std::vector<uint32_t> inDegrees;
+        std::vector<DegreeHistogram> histograms;
+        std::vector<uint32_t> neighborhoods;
+        uint32_t hops = 0;
+    };
+
+    // nodes, components and degrees, each as a CSV or a JSON file in folder
+    template <typename Graph>
+    void writeResults(const Graph &graph, const Analysis &analysis, const std::string &folder, const bool json)
+    {
+        const std::size_t n = graph.nodeCount();
+        const std::string extension = json ? ".json" : ".csv";
+
+        OutputFile nodes(folder + "/nodes" + extension);
+        std::string neighborhood = "neighborhood_" + std::to_string(analysis.hops);
+        nodes.buffer() += json ? "[" : "hash,document,component,pagerank,out_degree,in_degree" +
+                                           (analysis.neighborhoods.empty() ? std::string() : "," + neighborhood) + "\n";
+        for (std::size_t node = 0; node < n; node++)
+        {
+            std::string hash = readableHash(graph.getHash(node));
+            std::string component = readableHash(graph.getHash(analysis.components[node]));
+            std::string &out = nodes.buffer();
+            if (json)
+            {
+                out += node > 0 ? ",\n{\"hash\":\"" : "\n{\"hash\":\"";
+                out += hash + "\",\"document\":" + (hasDocument(graph, node) ? "true" : "false") +
+                       ",\"component\":\"" + component + "\",\"pagerank\":" + formatDouble(analysis.pageRank.ranks[node]) +
+                       ",\"out_degree\":" + std::to_string(analysis.outDegrees[node]) +
+                       ",\"in_degree\":" + std::to_string(analysis.inDegrees[node]);
+                if (!analysis.neighborhoods.empty())
+                    out += ",\"" + neighborhood + "\":" + std::to_string(analysis.neighborhoods[node]);
+                out += "}";
+            }
+            else
+            {
+                out += hash + (hasDocument(graph, node) ? ",1," : ",0,") + component + "," + formatDouble(analysis.pageRank.ranks[node]) +
+                       "," + std::to_string(analysis.outDegrees[node]) + "," + std::to_string(analysis.inDegrees[node]);
+                if (!analysis.neighborhoods.empty())
+                    out += "," + std::to_string(analysis.neighborhoods[node]);
+                out += "\n";
+            }
+            nodes.commit();
+        }
+        nodes.buffer() += json ? "\n]\n" : "";
+        nodes.close();
+
+        // largest first
+        std::unordered_map<uint32_t, uint64_t> sizes;
+        for (uint32_t component : analysis.components)
+        {
+            sizes[component]++;
+        }
+        std::vector<std::pair<uint32_t, uint64_t>> bySize(sizes.begin(), sizes.end());
+        std::sort(bySize.begin(), bySize.end(), [](const auto &a, const auto &b) {
+            return a.second != b.second ? a.second > b.second : a.first < b.first;
+        });
+
+        OutputFile components(folder + "/components" + extension);
+        components.buffer() += json ? "[" : "component,nodes\n";
+        for (std::size_t i = 0; i < bySize.size(); i++)
+        {
+            std::string hash = readableHash(graph.getHash(bySize[i].first));
+            std::string count = std::to_string(bySize[i].second);
+            if (json)
+                components.buffer() += (i > 0 ? ",\n{\"component\":\"" : "\n{\"component\":\"") + hash + "\",\"nodes\":" + count + "}";
+            else
+                components.buffer() += hash + "," + count + "\n";
+            components.commit();
+        }
+        components.buffer() += json ? "\n]\n" : "";
+        components.close();
+
+        OutputFile degrees(folder + "/degrees" + extension);
+        degrees.buffer() += json ? "[" : "edge_name,direction,degree,nodes\n";
+        bool first = true;
+        for (const DegreeHistogram &histogram : analysis.histograms)
+        {
+            for (const auto &[degree, count] : histogram.nodesByDegree)
+            {
+                if (json)
+                    degrees.buffer() += std::string(first ? "\n" : ",\n") + "{\"edge_name\":\"" + histogram.edgeName.to_string() +
+                                        "\",\"direction\":\"" + directionName(histogram.direction) + "\",\"degree\":" +
+                                        std::to_string(degree) + ",\"nodes\":" + std::to_string(count) + "}";
+                else
+                    degrees.buffer() += histogram.edgeName.to_string() + "," + directionName(histogram.direction) + "," +
+                                        std::to_string(degree) + "," + std::to_string(count) + "\n";
+                first = false;
+            }
+        }
+        degrees.buffer() += json ? "\n]\n" : "";
+        degrees.close();
+    }
+
+    template <typename Graph>
+    void analyze(const Graph &graph, const std::vector<eosio::name> &edgeNames, const PageRankOptions &options,
+                 const uint32_t hops, const std::optional<Direction> hopDirection, const std::string &folder,
+                 const bool json, const unsigned threads)
+    {
+        GraphAdjacency adjacency{graph.nodeCount(), graph.outgoing(), graph.incoming(), edgeNames};
+        const std::size_t edges = graph.edgeCount();
+        Analysis analysis;
+        analysis.hops = hops;
+
+        auto started = std::chrono::steady_clock::now();
+        analysis.outDegrees = degrees(adjacency, Direction::Out, threads);
+        analysis.inDegrees = degrees(adjacency, Direction::In, threads);
+        analysis.histograms = degreeHistograms(adjacency, threads);
+        double seconds = secondsSince(started);
+        std::printf("degrees: %.2f s, %.0f edges/s, %zu histograms\n", seconds, 2 * edges / std::max(seconds, 1e-9),
+                    analysis.histograms.size());
+
+        started = std::chrono::steady_clock::now();
+        analysis.pageRank = pageRank(adjacency, options, threads);
+        seconds = secondsSince(started);
+        std::printf("pagerank: %u iterations in %.2f s, %.0f edges/s, delta %.3g\n", analysis.pageRank.iterations, seconds,
+                    double(edges) * analysis.pageRank.iterations / std::max(seconds, 1e-9), analysis.pageRank.delta);
+
+        started = std::chrono::steady_clock::now();
+        analysis.components = weakComponents(adjacency, threads);
+        seconds = secondsSince(started);
+        std::size_t componentCount = 0;
+        for (std::size_t node = 0; node < analysis.components.size(); node++)
+        {
+            componentCount += analysis.components[node] == node ? 1 : 0;
+        }
+        std::printf("components: %zu in %.2f s, %.0f edges/s\n", componentCount, seconds, edges / std::max(seconds, 1e-9));
+
+        if (hops > 0)
+        {
+            started = std::chrono::steady_clock::now();
+            analysis.neighborhoods = neighborhoodSizes(adjacency, hops, hopDirection, threads);
+            seconds = secondsSince(started);
+            std::printf("%u-hop neighborhoods: %.2f s, %.0f nodes/s\n", hops, seconds, graph.nodeCount() / std::max(seconds, 1e-9));
+        }
+
+        started = std::chrono::steady_clock::now();
+        writeResults(graph, analysis, folder, json);
+        std::printf("results written to %s in %.2f s\n", folder.c_str(), secondsSince(started));
+    }
+} // namespace
+
+// graph_analytics <dump folder | snapshot file> <output folder> [options]
+// computes degrees, PageRank, weakly connected components and k-hop neighbourhood sizes on
+// every core and writes them as CSV or JSON
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    registerNativeIntrinsics();
+
+    std::string input = argv[1];
+    std::string folder = argv[2];
+
+    bool json = false;
+    unsigned threads = defaultThreadCount();
+    std::vector<eosio::name> edgeNames;
+    PageRankOptions options;
+    uint32_t hops = 0;
+    std::optional<Direction> hopDirection = Direction::Out;
+    for (int i = 3; i < argc; i++)
+    {
+        if (i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        const char *option = argv[i];
+        std::string value = argv[++i];
+
+        if (std::strcmp(option, "--format") == 0 && (value == "csv" || value == "json"))
+            json = value == "json";
+        else if (std::strcmp(option, "--threads") == 0)
+            threads = std::max(1, std::atoi(value.c_str()));
+        else if (std::strcmp(option, "--edge-names") == 0)
+        {
+            for (std::size_t first = 0; first < value.size();)
+            {
+                std::size_t comma = std::min(value.find(',', first), value.size());
+                edgeNames.push_back(eosio::name(std::string_view(value).substr(first, comma - first)));
+                first = comma + 1;
+            }
+        }
+        else if (std::strcmp(option, "--damping") == 0)
+            options.damping = std::strtod(value.c_str(), nullptr);
+        else if (std::strcmp(option, "--iterations") == 0)
+            options.maxIterations = std::strtoul(value.c_str(), nullptr, 10);
+        else if (std::strcmp(option, "--tolerance") == 0)
+            options.tolerance = std::strtod(value.c_str(), nullptr);
+        else if (std::strcmp(option, "--hops") == 0)
+            hops = std::strtoul(value.c_str(), nullptr, 10);
+        else if (std::strcmp(option, "--hop-direction") == 0 && (value == "out" || value == "in" || value == "both"))
+            hopDirection = value == "both" ? std::nullopt : std::optional<Direction>(value == "out" ? Direction::Out : Direction::In);
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    std::sort(edgeNames.begin(), edgeNames.end());
+    edgeNames.erase(std::unique(edgeNames.begin(), edgeNames.end()), edgeNames.end());
+
+    struct stat status;
+    bool isSnapshot = ::stat(input.c_str(), &status) == 0 && S_ISREG(status.st_mode);
+
+    auto started = std::chrono::steady_clock::now();
+    if (isSnapshot)
+    {
+        Snapshot snapshot(input);
+        std::printf("%zu nodes, %zu edges mapped in %.2f s\n", snapshot.nodeCount(), snapshot.edgeCount(), secondsSince(started));
+        analyze(snapshot, edgeNames, options, hops, hopDirection, folder, json, threads);
+    }
+    else
+    {
+        QueryEngine engine(loadDocuments(input + "/documents.json"), loadEdges(input + "/edges.json"));
+        std::printf("%zu nodes, %zu edges loaded in %.2f s\n", engine.nodeCount(), engine.edgeCount(), secondsSince(started));
+        analyze(engine, edgeNames, options, hops, hopDirection, folder, json, threads);
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <graph_tools/diff.hpp>
+#include <graph_tools/native_intrinsics.hpp>
+#include <graph_tools/parallel.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <string>
+
+using namespace hypha;
+
+namespace
+{
+    void usage(const char *program)
+    {
+        std::fprintf(stderr,
+                     "usage: %s <from> <to> [--changes <file>] [--apply] [--contract <name>] [--scope <name>]\n"
+                     "       [--threads <n>]\n"
+                     "<from> and <to> are dump folders, binary snapshots or replica checkpoints\n",
+                     program);
+    }
+
+    double secondsSince(const std::chrono::steady_clock::time_point &started)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    }
+}
+
+// graph_diff <from> <to> [options]
+// lists the documents and edges to add and remove to turn one graph state into another; exits
+// with 1 if the states differ
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    registerNativeIntrinsics();
+
+    std::string fromPath = argv[1];
+    std::string toPath = argv[2];
+
+    std::string changesFile;
+    bool apply = false;
+    eosio::name contract = eosio::name("documents");
+    std::optional<eosio::name> scope;
+    unsigned threads = defaultThreadCount();
+    for (int i = 3; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--apply") == 0)
+            apply = true;
+        else if (std::strcmp(argv[i], "--changes") == 0 && i + 1 < argc)
+            changesFile = argv[++i];
+        else if (std::strcmp(argv[i], "--contract") == 0 && i + 1 < argc)
+            contract = eosio::name(argv[++i]);
+        else if (std::strcmp(argv[i], "--scope") == 0 && i + 1 < argc)
+            scope = eosio::name(argv[++i]);
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = std::max(1, std::atoi(argv[++i]));
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    GraphInput from = loadGraphInput(fromPath, contract, scope.value_or(contract));
+    GraphInput to = loadGraphInput(toPath, contract, scope.value_or(contract));
+    double loadSeconds = secondsSince(started);
+    eosio::check(!apply || from.replica, "--apply needs a replica checkpoint as <from>");
+
+    started = std::chrono::steady_clock::now();
+    GraphKeys fromKeys = collectKeys(from, threads);
+    GraphKeys toKeys = collectKeys(to, threads);
+    double keySeconds = secondsSince(started);
+
+    started = std::chrono::steady_clock::now();
+    GraphDiff diff = diffKeys(fromKeys, toKeys, threads);
+    double diffSeconds = secondsSince(started);
+
+    std::size_t rows = from.documentCount() + from.edgeCount() + to.documentCount() + to.edgeCount();
+    std::printf("%zu + %zu documents, %zu + %zu edges loaded in %.2f s\n", from.documentCount(), to.documentCount(),
+                from.edgeCount(), to.edgeCount(), loadSeconds);
+    std::printf("keys: %.2f s, %.0f rows/s on %u threads\n", keySeconds, rows / std::max(keySeconds, 1e-9), threads);
+    std::printf("diff: %.2f s, %.0f keys/s on %u threads\n", diffSeconds,
+                (fromKeys.documents.size() + fromKeys.edges.size() + toKeys.documents.size() + toKeys.edges.size()) / std::max(diffSeconds, 1e-9),
+                threads);
+    std::printf("documents: %zu added, %zu removed\n", diff.addedDocuments.size(), diff.removedDocuments.size());
+    std::printf("edges: %zu added, %zu removed\n", diff.addedEdges.size(), diff.removedEdges.size());
+
+    if (!changesFile.empty())
+    {
+        started = std::chrono::steady_clock::now();
+        writeChanges(changesFile, diff, to, threads);
+        std::printf("changes written to %s in %.2f s\n", changesFile.c_str(), secondsSince(started));
+    }
+
+    if (apply)
+    {
+        started = std::chrono::steady_clock::now();
+        applyChanges(diff, to, *from.replica);
+        from.replica->save(fromPath);
+        std::printf("%s reconciled in %.2f s: %zu documents, %zu edges\n", fromPath.c_str(), secondsSince(started),
+                    from.replica->documentCount(), from.replica->edgeCount());
+    }
+
+    return diff.empty() ? 0 : 1;
+}
@@ -0,0 +1,635 @@
+#include <graph_tools/graph_dump.hpp>
+
+#include <document_graph/util.hpp>
+
+#include <array>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace hypha
+{
+    namespace
+    {
+        // just enough JSON for get_table_rows output; numbers are kept as text so that
+        // uint64 values do not lose precision
+        struct Json
+        {
+            enum Kind
+            {
+                Null,
+                Bool,
+                Number,
+                String,
+                Array,
+                Object
+            };
+
+            Kind kind = Null;
+            std::string text;
+            std::vector<Json> items;
+            std::vector<std::pair<std::string, Json>> members;
+
+            const Json *find(const std::string &key) const
+            {
+                for (const auto &member : members)
+                {
+                    if (member.first == key)
+                    {
+                        return &member.second;
+                    }
+                }
+                return nullptr;
+            }
+
+            const Json &at(const std::string &key) const
+            {
+                const Json *value = find(key);
+                eosio::check(value != nullptr, "missing field in JSON row: " + key);
+                return *value;
+            }
+        };
+
+        class JsonParser
+        {
+        public:
+            JsonParser(const std::string &input) : m_pos{input.data()}, m_end{input.data() + input.size()} {}
+
+            Json parse()
+            {
+                Json value = parseValue();
+                skipSpace();
+                eosio::check(m_pos == m_end, "unexpected data after JSON value");
+                return value;
+            }
+
+        private:
+            void skipSpace()
+            {
+                while (m_pos < m_end && (*m_pos == ' ' || *m_pos == '\n' || *m_pos == '\r' || *m_pos == '\t'))
+                {
+                    m_pos++;
+                }
+            }
+
+            void expect(char c)
+            {
+                skipSpace();
+                eosio::check(m_pos < m_end && *m_pos == c, std::string("malformed JSON, expected ") + c);
+                m_pos++;
+            }
+
+            bool consume(char c)
+            {
+                skipSpace();
+                if (m_pos < m_end && *m_pos == c)
+                {
+                    m_pos++;
+                    return true;
+                }
+                return false;
+            }
+
+            Json parseValue()
+            {
+                skipSpace();
+                eosio::check(m_pos < m_end, "unexpected end of JSON");
+
+                Json value;
+                switch (*m_pos)
+                {
+                case '{':
+                    value.kind = Json::Object;
+                    m_pos++;
+                    if (!consume('}'))
+                    {
+                        do
+                        {
+                            skipSpace();
+                            std::string key = parseString();
+                            expect(':');
+                            value.members.emplace_back(std::move(key), parseValue());
+                        } while (consume(','));
+                        expect('}');
+                    }
+                    break;
+                case '[':
+                    value.kind = Json::Array;
+                    m_pos++;
+                    if (!consume(']'))
+                    {
+                        do
+                        {
+                            value.items.push_back(parseValue());
+                        } while (consume(','));
+                        expect(']');
+                    }
+                    break;
+                case '"':
+                    value.kind = Json::String;
+                    value.text = parseString();
+                    break;
+                case 't':
+                case 'f':
+                case 'n':
+                    value.kind = *m_pos == 'n' ? Json::Null : Json::Bool;
+                    while (m_pos < m_end && *m_pos >= 'a' && *m_pos <= 'z')
+                    {
+                        value.text += *m_pos++;
+                    }
+                    eosio::check(value.text == "true" || value.text == "false" || value.text == "null", "malformed JSON literal: " + value.text);
+                    break;
+                default:
+                    value.kind = Json::Number;
+                    while (m_pos < m_end && (std::isdigit(*m_pos) || *m_pos == '-' || *m_pos == '+' || *m_pos == '.' || *m_pos == 'e' || *m_pos == 'E'))
+                    {
+                        value.text += *m_pos++;
+                    }
+                    eosio::check(!value.text.empty(), std::string("malformed JSON, unexpected ") + *m_pos);
+                }
+                return value;
+            }
+
+            std::string parseString()
+            {
+                eosio::check(m_pos < m_end && *m_pos == '"', "malformed JSON, expected a string");
+                m_pos++;
+
+                std::string result;
+                while (m_pos < m_end && *m_pos != '"')
+                {
+                    char c = *m_pos++;
+                    if (c != '\\')
+                    {
+                        result += c;
+                        continue;
+                    }
+
+                    eosio::check(m_pos < m_end, "unexpected end of JSON string");
+                    c = *m_pos++;
+                    switch (c)
+                    {
+                    case 'n': result += '\n'; break;
+                    case 't': result += '\t'; break;
+                    case 'r': result += '\r'; break;
+                    case 'b': result += '\b'; break;
+                    case 'f': result += '\f'; break;
+                    case 'u':
+                    {
+                        eosio::check(m_end - m_pos >= 4, "malformed JSON unicode escape");
+                        uint32_t code = std::strtoul(std::string(m_pos, 4).c_str(), nullptr, 16);
+                        m_pos += 4;
+
+                        // surrogate pairs encode code points above the basic multilingual plane
+                        if (code >= 0xd800 && code < 0xdc00 && m_end - m_pos >= 6 && m_pos[0] == '\\' && m_pos[1] == 'u')
+                        {
+                            uint32_t low = std::strtoul(std::string(m_pos + 2, 4).c_str(), nullptr, 16);
+                            code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                            m_pos += 6;
+                        }
+                        appendUtf8(result, code);
+                        break;
+                    }
+                    default: result += c;
+                    }
+                }
+
+                eosio::check(m_pos < m_end, "unexpected end of JSON string");
+                m_pos++;
+                return result;
+            }
+
+            static void appendUtf8(std::string &out, uint32_t code)
+            {
+                if (code < 0x80)
+                {
+                    out += char(code);
+                }
+                else if (code < 0x800)
+                {
+                    out += char(0xc0 | (code >> 6));
+                    out += char(0x80 | (code & 0x3f));
+                }
+                else if (code < 0x10000)
+                {
+                    out += char(0xe0 | (code >> 12));
+                    out += char(0x80 | ((code >> 6) & 0x3f));
+                    out += char(0x80 | (code & 0x3f));
+                }
+                else
+                {
+                    out += char(0xf0 | (code >> 18));
+                    out += char(0x80 | ((code >> 12) & 0x3f));
+                    out += char(0x80 | ((code >> 6) & 0x3f));
+                    out += char(0x80 | (code & 0x3f));
+                }
+            }
+
+            const char *m_pos;
+            const char *m_end;
+        };
+
+        Json readJsonFile(const std::string &fileName)
+        {
+            std::FILE *file = std::fopen(fileName.c_str(), "rb");
+            eosio::check(file != nullptr, "cannot open " + fileName);
+
+            std::string data;
+            char buffer[1 << 16];
+            std::size_t read;
+            while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+            {
+                data.append(buffer, read);
+            }
+            std::fclose(file);
+
+            Json rows = JsonParser(data).parse();
+
+            // accept both the bare rows array and a full get_table_rows response
+            if (rows.kind == Json::Object)
+            {
+                return rows.at("rows");
+            }
+            eosio::check(rows.kind == Json::Array, fileName + " does not hold table rows");
+            return rows;
+        }
+
+        uint64_t toUint(const Json &value)
+        {
+            return std::strtoull(value.text.c_str(), nullptr, 10);
+        }
+
+        eosio::name toName(const Json &value)
+        {
+            return eosio::name(std::string_view(value.text));
+        }
+
+    } // namespace
+
+    eosio::checksum256 parseChecksum(const std::string &hex)
+    {
+        eosio::check(hex.size() == 64, "checksum256 must be 64 hex characters: " + hex);
+
+        auto nibble = [&](char c) -> uint8_t {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+            eosio::check(false, "invalid hex character in checksum256: " + hex);
+            return 0;
+        };
+
+        std::array<uint8_t, 32> bytes;
+        for (std::size_t i = 0; i < bytes.size(); i++)
+        {
+            bytes[i] = (nibble(hex[2 * i]) << 4) | nibble(hex[2 * i + 1]);
+        }
+        return eosio::checksum256(bytes);
+    }
+
+    // accepts the nodeos format, e.g. 2020-10-16T14:02:32.500, with an optional trailing Z
+    eosio::time_point parseTimePoint(const std::string &iso)
+    {
+        int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+        int consumed = 0;
+        eosio::check(std::sscanf(iso.c_str(), "%d-%d-%dT%d:%d:%d%n", &year, &month, &day, &hour, &minute, &second, &consumed) == 6,
+                     "invalid time_point: " + iso);
+
+        int64_t micros = 0;
+        if (iso[consumed] == '.')
+        {
+            int64_t scale = 100000;
+            for (std::size_t i = consumed + 1; i < iso.size() && std::isdigit(iso[i]); i++, scale /= 10)
+            {
+                micros += (iso[i] - '0') * scale;
+            }
+        }
+
+        // days since 1970-01-01 in the proleptic Gregorian calendar
+        int64_t y = year - (month <= 2);
+        int64_t era = (y >= 0 ? y : y - 399) / 400;
+        int64_t yoe = y - era * 400;
+        int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        int64_t days = era * 146097 + doe - 719468;
+
+        int64_t seconds = ((days * 24 + hour) * 60 + minute) * 60 + second;
+        return eosio::time_point(eosio::microseconds(seconds * 1000000 + micros));
+    }
+
+    std::string formatTimePoint(const eosio::time_point &time)
+    {
+        int64_t micros = time.time_since_epoch().count();
+        int64_t seconds = micros / 1000000;
+        int64_t days = seconds / 86400;
+        int64_t secondOfDay = seconds % 86400;
+        if (secondOfDay < 0)
+        {
+            secondOfDay += 86400;
+            days--;
+        }
+
+        // the inverse of the day count in parseTimePoint
+        int64_t z = days + 719468;
+        int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+        int64_t doe = z - era * 146097;
+        int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        int64_t mp = (5 * doy + 2) / 153;
+        int64_t day = doy - (153 * mp + 2) / 5 + 1;
+        int64_t month = mp < 10 ? mp + 3 : mp - 9;
+        int64_t year = yoe + era * 400 + (month <= 2);
+
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%04lld-%02lld-%02lldT%02lld:%02lld:%02lld.%03lld",
+                      (long long)year, (long long)month, (long long)day, (long long)(secondOfDay / 3600),
+                      (long long)(secondOfDay / 60 % 60), (long long)(secondOfDay % 60), (long long)((micros % 1000000 + 1000000) % 1000000 / 1000));
+        return buffer;
+    }
+
+    Content::FlexValue parseFlexValue(const std::string &type, const std::string &value)
+    {
+        if (type == "name")
+        {
+            return eosio::name(std::string_view(value));
+        }
+        if (type == "string")
+        {
+            return value;
+        }
+        if (type == "int64")
+        {
+            return static_cast<std::int64_t>(std::strtoll(value.c_str(), nullptr, 10));
+        }
+        if (type == "checksum256")
+        {
+            return parseChecksum(value);
+        }
+        if (type == "time_point")
+        {
+            return parseTimePoint(value);
+        }
+        if (type == "asset")
+        {
+            // e.g. "130.00 USD"; the number of decimals is the symbol precision
+            std::size_t space = value.find(' ');
+            eosio::check(space != std::string::npos, "invalid asset: " + value);
+
+            std::string amount = value.substr(0, space);
+            std::size_t dot = amount.find('.');
+            uint8_t precision = dot == std::string::npos ? 0 : amount.size() - dot - 1;
+            if (dot != std::string::npos)
+            {
+                amount.erase(dot, 1);
+            }
+            return eosio::asset(std::strtoll(amount.c_str(), nullptr, 10),
+                                eosio::symbol(std::string_view(value).substr(space + 1), precision));
+        }
+        if (type == "monostate")
+        {
+            return std::monostate();
+        }
+
+        eosio::check(false, "unknown content type: " + type);
+        return std::monostate();
+    }
+
+    std::vector<Document> loadDocuments(const std::string &fileName)
+    {
+        Json rows = readJsonFile(fileName);
+
+        std::vector<Document> documents;
+        documents.reserve(rows.items.size());
+        for (const Json &row : rows.items)
+        {
+            DocumentRow document;
+            document.id = toUint(row.at("id"));
+            document.hash = parseChecksum(row.at("hash").text);
+            document.creator = toName(row.at("creator"));
+            if (const Json *created = row.find("created_date"))
+            {
+                document.created_date = parseTimePoint(created->text);
+            }
+            if (const Json *contract = row.find("contract"))
+            {
+                document.contract = toName(*contract);
+            }
+
+            for (const Json &group : row.at("content_groups").items)
+            {
+                ContentGroup contentGroup;
+                for (const Json &item : group.items)
+                {
+                    const Json &value = item.at("value");
+                    eosio::check(value.items.size() == 2, "content value must be a [type, value] pair");
+                    contentGroup.push_back(Content(item.at("label").text, parseFlexValue(value.items[0].text, value.items[1].text)));
+                }
+                document.content_groups.push_back(std::move(contentGroup));
+            }
+
+            if (const Json *certificates = row.find("certificates"))
+            {
+                for (const Json &certificate : certificates->items)
+                {
+                    Certificate c(toName(certificate.at("certifier")), certificate.at("notes").text);
+                    c.certification_date = parseTimePoint(certificate.at("certification_date").text);
+                    document.certificates.push_back(c);
+                }
+            }
+
+            documents.push_back(eosio::unpack<Document>(eosio::pack(document)));
+        }
+        return documents;
+    }
+
+    std::vector<Edge> loadEdges(const std::string &fileName)
+    {
+        Json rows = readJsonFile(fileName);
+
+        std::vector<Edge> edges;
+        edges.reserve(rows.items.size());
+        for (const Json &row : rows.items)
+        {
+            Edge edge;
+            edge.id = toUint(row.at("id"));
+            edge.from_node = parseChecksum(row.at("from_node").text);
+            edge.to_node = parseChecksum(row.at("to_node").text);
+            edge.edge_name = toName(row.at("edge_name"));
+
+            // the derived index values are optional; they are recomputed where needed
+            const Json *index = nullptr;
+            edge.from_node_edge_name_index = (index = row.find("from_node_edge_name_index")) ? toUint(*index) : 0;
+            edge.from_node_to_node_index = (index = row.find("from_node_to_node_index")) ? toUint(*index) : 0;
+            edge.to_node_edge_name_index = (index = row.find("to_node_edge_name_index")) ? toUint(*index) : 0;
+
+            if (const Json *created = row.find("created_date"))
+            {
+                edge.created_date = parseTimePoint(created->text);
+            }
+            if (const Json *creator = row.find("creator"))
+            {
+                edge.creator = toName(*creator);
+            }
+            if (const Json *contract = row.find("contract"))
+            {
+                edge.contract = toName(*contract);
+            }
+            edges.push_back(edge);
+        }
+        return edges;
+    }
+
+    OutputFile::OutputFile(const std::string &fileName) : m_fileName{fileName}
+    {
+        m_file = std::fopen(fileName.c_str(), "wb");
+        eosio::check(m_file != nullptr, "cannot create " + fileName);
+        m_buffer.reserve(BUFFER_SIZE + (1 << 16));
+    }
+
+    void OutputFile::commit()
+    {
+        if (m_buffer.size() >= BUFFER_SIZE)
+        {
+            flush();
+        }
+    }
+
+    void OutputFile::close()
+    {
+        if (m_file == nullptr)
+        {
+            return;
+        }
+        flush();
+        eosio::check(std::fclose(m_file) == 0, "cannot write " + m_fileName);
+        m_file = nullptr;
+    }
+
+    void OutputFile::flush()
+    {
+        eosio::check(std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file) == m_buffer.size(), "cannot write " + m_fileName);
+        m_buffer.clear();
+    }
+
+    void appendJsonString(std::string &out, const std::string &value)
+    {
+        out += '"';
+        for (char c : value)
+        {
+            switch (c)
+            {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            case '\r': out += "\\r"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                }
+                else
+                {
+                    out += c;
+                }
+            }
+        }
+        out += '"';
+    }
+
+    // content groups as the ABI serializer writes them, e.g. [[{"label":"a","value":["int64",1]}]]
+    void appendContentGroups(std::string &out, const ContentGroups &contentGroups)
+    {
+        out += '[';
+        for (std::size_t g = 0; g < contentGroups.size(); g++)
+        {
+            out += g > 0 ? ",[" : "[";
+            for (std::size_t c = 0; c < contentGroups[g].size(); c++)
+            {
+                const Content &content = contentGroups[g][c];
+                out += c > 0 ? ",{\"label\":" : "{\"label\":";
+                appendJsonString(out, content.label);
+                out += ",\"value\":";
+                std::visit(
+                    [&](const auto &value) {
+                        using T = std::decay_t<decltype(value)>;
+                        if constexpr (std::is_same_v<T, std::monostate>)
+                        {
+                            out += "[\"monostate\",0]";
+                        }
+                        else if constexpr (std::is_same_v<T, eosio::name>)
+                        {
+                            out += "[\"name\",\"" + value.to_string() + "\"]";
+                        }
+                        else if constexpr (std::is_same_v<T, std::string>)
+                        {
+                            out += "[\"string\",";
+                            appendJsonString(out, value);
+                            out += ']';
+                        }
+                        else if constexpr (std::is_same_v<T, eosio::asset>)
+                        {
+                            out += "[\"asset\",\"" + value.to_string() + "\"]";
+                        }
+                        else if constexpr (std::is_same_v<T, eosio::time_point>)
+                        {
+                            out += "[\"time_point\",\"" + formatTimePoint(value) + "\"]";
+                        }
+                        else if constexpr (std::is_same_v<T, std::int64_t>)
+                        {
+                            out += "[\"int64\"," + std::to_string(value) + "]";
+                        }
+                        else
+                        {
+                            out += "[\"checksum256\",\"" + readableHash(value) + "\"]";
+                        }
+                    },
+                    content.value);
+                out += '}';
+            }
+            out += ']';
+        }
+        out += ']';
+    }
+
+    void appendDocumentRow(std::string &out, const DocumentRow &row)
+    {
+        out += "{\"id\":" + std::to_string(row.id) +
+               ",\"hash\":\"" + readableHash(row.hash) +
+               "\",\"creator\":\"" + row.creator.to_string() + "\",\"content_groups\":";
+        appendContentGroups(out, row.content_groups);
+        out += ",\"certificates\":[";
+        for (std::size_t i = 0; i < row.certificates.size(); i++)
+        {
+            const Certificate &certificate = row.certificates[i];
+            out += i > 0 ? ",{\"certifier\":\"" : "{\"certifier\":\"";
+            out += certificate.certifier.to_string() + "\",\"notes\":";
+            appendJsonString(out, certificate.notes);
+            out += ",\"certification_date\":\"" + formatTimePoint(certificate.certification_date) + "\"}";
+        }
+        out += "],\"created_date\":\"" + formatTimePoint(row.created_date) +
+               "\",\"contract\":\"" + row.contract.to_string() + "\"}";
+    }
+
+    void appendEdgeRow(std::string &out, const Edge &edge)
+    {
+        out += "{\"id\":" + std::to_string(edge.id) +
+               ",\"from_node_edge_name_index\":" + std::to_string(edge.from_node_edge_name_index) +
+               ",\"from_node_to_node_index\":" + std::to_string(edge.from_node_to_node_index) +
+               ",\"to_node_edge_name_index\":" + std::to_string(edge.to_node_edge_name_index) +
+               ",\"from_node\":\"" + readableHash(edge.from_node) +
+               "\",\"to_node\":\"" + readableHash(edge.to_node) +
+               "\",\"edge_name\":\"" + edge.edge_name.to_string() +
+               "\",\"created_date\":\"" + formatTimePoint(edge.created_date) +
+               "\",\"creator\":\"" + edge.creator.to_string() +
+               "\",\"contract\":\"" + edge.contract.to_string() + "\"}";
+    }
+
+} // namespace hypha
@@ -0,0 +1,124 @@
+#include <graph_tools/generator.hpp>
+#include <graph_tools/graph_dump.hpp>
+#include <graph_tools/native_intrinsics.hpp>
+#include <graph_tools/parallel.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace hypha;
+
+namespace
+{
+    void usage(const char *program)
+    {
+        std::fprintf(stderr,
+                     "usage: %s <actions|dump|binary> <output folder> [--documents <n>] [--seed <n>] [--threads <n>]\n"
+                     "       [--groups <distribution>] [--contents <distribution>] [--string-length <distribution>]\n"
+                     "       [--types <type=weight,...>] [--edges-per-document <x>] [--out-skew <x>] [--in-skew <x>]\n"
+                     "       [--edge-names <name=weight,...>] [--contract <name>] [--creators <name,...>] [--start <time>]\n"
+                     "distributions are fixed:N, uniform:MIN:MAX or geometric:MEAN:MAX\n",
+                     program);
+    }
+}
+
+// graph_generate <format> <output folder> [options]
+// writes a reproducible synthetic graph: the same options and seed always give the same rows
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    registerNativeIntrinsics();
+
+    std::string format = argv[1];
+    std::string folder = argv[2];
+
+    WorkloadSpec spec;
+    unsigned threads = defaultThreadCount();
+    for (int i = 3; i < argc; i++)
+    {
+        if (i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        const char *option = argv[i];
+        std::string value = argv[++i];
+
+        if (std::strcmp(option, "--documents") == 0)
+            spec.documents = std::strtoull(value.c_str(), nullptr, 10);
+        else if (std::strcmp(option, "--seed") == 0)
+            spec.seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if (std::strcmp(option, "--threads") == 0)
+            threads = std::max(1, std::atoi(value.c_str()));
+        else if (std::strcmp(option, "--groups") == 0)
+            spec.groups = parseSizeDistribution(value);
+        else if (std::strcmp(option, "--contents") == 0)
+            spec.contents = parseSizeDistribution(value);
+        else if (std::strcmp(option, "--string-length") == 0)
+            spec.stringLength = parseSizeDistribution(value);
+        else if (std::strcmp(option, "--types") == 0)
+            spec.types = parseWeights(value);
+        else if (std::strcmp(option, "--edges-per-document") == 0)
+            spec.edgesPerDocument = std::strtod(value.c_str(), nullptr);
+        else if (std::strcmp(option, "--out-skew") == 0)
+            spec.outSkew = std::strtod(value.c_str(), nullptr);
+        else if (std::strcmp(option, "--in-skew") == 0)
+            spec.inSkew = std::strtod(value.c_str(), nullptr);
+        else if (std::strcmp(option, "--edge-names") == 0)
+        {
+            spec.edgeNames.clear();
+            for (const auto &weight : parseWeights(value))
+            {
+                spec.edgeNames.emplace_back(eosio::name(std::string_view(weight.first)), weight.second);
+            }
+        }
+        else if (std::strcmp(option, "--contract") == 0)
+            spec.contract = eosio::name(std::string_view(value));
+        else if (std::strcmp(option, "--creators") == 0)
+        {
+            spec.creators.clear();
+            for (std::size_t first = 0; first < value.size();)
+            {
+                std::size_t comma = std::min(value.find(',', first), value.size());
+                spec.creators.push_back(eosio::name(std::string_view(value).substr(first, comma - first)));
+                first = comma + 1;
+            }
+        }
+        else if (std::strcmp(option, "--start") == 0)
+            spec.start = parseTimePoint(value);
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    std::unique_ptr<WorkloadSink> sink;
+    if (format == "actions")
+        sink = newActionSink(folder, spec.contract);
+    else if (format == "dump")
+        sink = newDumpSink(folder, spec.contract);
+    else if (format == "binary")
+        sink = newBinarySink(folder, spec.contract);
+    else
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    WorkloadStats stats = generateWorkload(spec, *sink, threads);
+
+    std::printf("%llu documents, %llu contents in %.2f s, %.0f documents/s on %u threads\n",
+                (unsigned long long)stats.documents, (unsigned long long)stats.contents, stats.documentSeconds,
+                stats.documents / std::max(stats.documentSeconds, 1e-9), threads);
+    std::printf("%llu edges in %.2f s, %.0f edges/s, %llu candidates dropped for a taken id\n",
+                (unsigned long long)stats.edges, stats.edgeSeconds, stats.edges / std::max(stats.edgeSeconds, 1e-9),
+                (unsigned long long)stats.droppedEdges);
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <graph_tools/graph_dump.hpp>
+#include <graph_tools/native_intrinsics.hpp>
+#include <graph_tools/query_engine.hpp>
+#include <graph_tools/snapshot.hpp>
+
+#include <document_graph/util.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include <sys/stat.h>
+
+using namespace hypha;
+
+namespace
+{
+    template <typename Graph>
+    std::vector<eosio::checksum256> run(const Graph &graph, const eosio::checksum256 &start, const std::vector<Hop> &hops)
+    {
+        std::vector<eosio::checksum256> hashes;
+        if (std::optional<uint32_t> node = graph.find(start))
+        {
+            for (uint32_t reached : graph.query(*node, hops))
+            {
+                hashes.push_back(graph.getHash(reached));
+            }
+        }
+        return hashes;
+    }
+} // namespace
+
+// graph_query <dump folder | snapshot file> <start hash> <hop>...
+// each hop is out:<edge name> or in:<edge name>, with * as the edge name to follow every edge
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::fprintf(stderr, "usage: %s <dump folder | snapshot file> <start hash> [out|in:<edge name>|*]...\n", argv[0]);
+        return 1;
+    }
+    registerNativeIntrinsics();
+
+    std::string folder = argv[1];
+    std::vector<Hop> hops;
+    for (int i = 3; i < argc; i++)
+    {
+        std::string hop = argv[i];
+        std::size_t colon = hop.find(':');
+        if (colon == std::string::npos || (hop.substr(0, colon) != "out" && hop.substr(0, colon) != "in"))
+        {
+            std::fprintf(stderr, "invalid hop: %s\n", argv[i]);
+            return 1;
+        }
+
+        std::string edgeName = hop.substr(colon + 1);
+        hops.push_back(Hop{hop.substr(0, colon) == "out" ? Direction::Out : Direction::In,
+                           edgeName == "*" ? eosio::name() : eosio::name(std::string_view(edgeName))});
+    }
+
+    struct stat status;
+    bool isSnapshot = ::stat(folder.c_str(), &status) == 0 && S_ISREG(status.st_mode);
+
+    auto started = std::chrono::steady_clock::now();
+    std::optional<Snapshot> snapshot;
+    std::optional<QueryEngine> engine;
+    if (isSnapshot)
+    {
+        snapshot.emplace(folder);
+    }
+    else
+    {
+        engine.emplace(loadDocuments(folder + "/documents.json"), loadEdges(folder + "/edges.json"));
+    }
+    auto loaded = std::chrono::steady_clock::now();
+
+    eosio::checksum256 start = parseChecksum(argv[2]);
+    std::vector<eosio::checksum256> reached = isSnapshot ? run(*snapshot, start, hops) : run(*engine, start, hops);
+    auto queried = std::chrono::steady_clock::now();
+
+    for (const eosio::checksum256 &hash : reached)
+    {
+        std::printf("%s\n", readableHash(hash).c_str());
+    }
+
+    std::fprintf(stderr, "%zu nodes, %zu edges %s in %.1f ms; %zu results in %.1f us\n",
+                 isSnapshot ? snapshot->nodeCount() : engine->nodeCount(),
+                 isSnapshot ? snapshot->edgeCount() : engine->edgeCount(),
+                 isSnapshot ? "mapped" : "loaded",
+                 std::chrono::duration<double, std::milli>(loaded - started).count(),
+                 reached.size(),
+                 std::chrono::duration<double, std::micro>(queried - loaded).count());
+    return 0;
+}
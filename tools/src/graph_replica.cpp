@@ -0,0 +1,138 @@
+#include <graph_tools/native_intrinsics.hpp>
+#include <graph_tools/replica.hpp>
+#include <graph_tools/ship_protocol.hpp>
+#include <graph_tools/snapshot.hpp>
+#include <graph_tools/websocket.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace hypha;
+
+namespace
+{
+    // blocks nodeos may send ahead of our acknowledgements; acks go out in batches of half of it
+    constexpr uint32_t MAX_MESSAGES_IN_FLIGHT = 64;
+
+    void usage(const char *program)
+    {
+        std::fprintf(stderr,
+                     "usage: %s <host:port> <contract> <checkpoint file> [--scope <name>] [--irreversible]\n"
+                     "       [--checkpoint-every <blocks>] [--until <block>] [--snapshot <file>]\n",
+                     program);
+    }
+
+    void sendRequest(WebSocket &socket, const ship::Request &request)
+    {
+        socket.send(eosio::pack(request));
+    }
+}
+
+// graph_replica <host:port> <contract> <checkpoint file> [options]
+// follows a nodeos state_history_plugin endpoint and keeps the documents and edges of one scope of
+// the contract, its own unless --scope names another, in the checkpoint file; it resumes from the
+// checkpoint and stops at --until or when the node closes
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    registerNativeIntrinsics();
+
+    std::string endpoint = argv[1];
+    eosio::name contract = eosio::name(argv[2]);
+    std::string checkpointFile = argv[3];
+
+    eosio::name scope = contract;
+    bool irreversibleOnly = false;
+    uint32_t checkpointEvery = 100;
+    uint32_t until = 0;
+    std::string snapshotFile;
+    for (int i = 4; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--scope") == 0 && i + 1 < argc)
+            scope = eosio::name(argv[++i]);
+        else if (std::strcmp(argv[i], "--irreversible") == 0)
+            irreversibleOnly = true;
+        else if (std::strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc)
+            checkpointEvery = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--until") == 0 && i + 1 < argc)
+            until = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc)
+            snapshotFile = argv[++i];
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    std::size_t colon = endpoint.rfind(':');
+    eosio::check(colon != std::string::npos, "endpoint must be host:port");
+
+    GraphReplica replica(contract, scope);
+    if (replica.load(checkpointFile) && replica.head())
+        std::printf("resuming after block %u\n", replica.head()->block_num);
+
+    WebSocket socket(endpoint.substr(0, colon), endpoint.substr(colon + 1));
+
+    // the first message is the protocol ABI as JSON; the layouts in ship_protocol.hpp stand in for it
+    std::vector<char> message;
+    eosio::check(socket.receive(message), "state history endpoint closed before sending its ABI");
+
+    ship::GetBlocksRequestV0 request;
+    request.start_block_num = replica.head() ? replica.head()->block_num + 1 : 0;
+    request.max_messages_in_flight = MAX_MESSAGES_IN_FLIGHT;
+    request.have_positions = replica.reversiblePositions();
+    request.irreversible_only = irreversibleOnly;
+    request.fetch_deltas = true;
+    sendRequest(socket, request);
+
+    uint32_t unacknowledged = 0;
+    uint32_t sinceCheckpoint = 0;
+    bool done = false;
+    while (!done && socket.receive(message))
+    {
+        ship::Result result = eosio::unpack<ship::Result>(message);
+        eosio::check(std::holds_alternative<ship::GetBlocksResultV0>(result), "unexpected state history result");
+        const ship::GetBlocksResultV0 &blocks = std::get<ship::GetBlocksResultV0>(result);
+
+        if (blocks.this_block)
+        {
+            bool fork = replica.head() && blocks.this_block->block_num <= replica.head()->block_num;
+            replica.applyBlock(*blocks.this_block, blocks.deltas ? *blocks.deltas : std::vector<char>(), blocks.last_irreversible.block_num);
+            if (fork)
+                std::printf("fork: switched to block %u\n", blocks.this_block->block_num);
+
+            done = until > 0 && blocks.this_block->block_num >= until;
+            if (++sinceCheckpoint >= checkpointEvery || done)
+            {
+                replica.save(checkpointFile);
+                sinceCheckpoint = 0;
+                std::printf("block %u: %zu documents, %zu edges\n", blocks.this_block->block_num,
+                            replica.documentCount(), replica.edgeCount());
+                std::fflush(stdout);
+            }
+        }
+
+        if (++unacknowledged >= MAX_MESSAGES_IN_FLIGHT / 2)
+        {
+            sendRequest(socket, ship::GetBlocksAckRequestV0{unacknowledged});
+            unacknowledged = 0;
+        }
+    }
+
+    if (sinceCheckpoint > 0)
+        replica.save(checkpointFile);
+    if (!snapshotFile.empty())
+        writeSnapshot(snapshotFile, replica.documents(), replica.edges());
+
+    if (replica.head())
+        std::printf("replica at block %u: %zu documents, %zu edges\n", replica.head()->block_num,
+                    replica.documentCount(), replica.edgeCount());
+    return 0;
+}
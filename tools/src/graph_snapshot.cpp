@@ -0,0 +1,36 @@
+#include <graph_tools/graph_dump.hpp>
+#include <graph_tools/native_intrinsics.hpp>
+#include <graph_tools/snapshot.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+using namespace hypha;
+
+// graph_snapshot <dump folder> <snapshot file>
+// converts the SaveGraph JSON dumps into a binary snapshot that graph_query can map
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        std::fprintf(stderr, "usage: %s <dump folder> <snapshot file>\n", argv[0]);
+        return 1;
+    }
+    registerNativeIntrinsics();
+
+    std::string folder = argv[1];
+    auto started = std::chrono::steady_clock::now();
+    std::vector<Document> documents = loadDocuments(folder + "/documents.json");
+    std::vector<Edge> edges = loadEdges(folder + "/edges.json");
+    auto loaded = std::chrono::steady_clock::now();
+
+    writeSnapshot(argv[2], documents, edges);
+    auto written = std::chrono::steady_clock::now();
+
+    std::fprintf(stderr, "%zu documents, %zu edges parsed in %.1f ms, snapshot written in %.1f ms\n",
+                 documents.size(), edges.size(),
+                 std::chrono::duration<double, std::milli>(loaded - started).count(),
+                 std::chrono::duration<double, std::milli>(written - loaded).count());
+    return 0;
+}
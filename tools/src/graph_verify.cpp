@@ -0,0 +1,70 @@
+#include <graph_tools/graph_dump.hpp>
+#include <graph_tools/native_intrinsics.hpp>
+#include <graph_tools/parallel.hpp>
+#include <graph_tools/verifier.hpp>
+
+#include <document_graph/util.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace hypha;
+
+namespace
+{
+    // only the first problems of each kind are listed, the totals are always printed
+    constexpr std::size_t MAX_LISTED = 100;
+}
+
+// graph_verify <dump folder> [threads]
+// exits with 1 if any document hash, edge endpoint or edge key does not check out
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::fprintf(stderr, "usage: %s <dump folder> [threads]\n", argv[0]);
+        return 2;
+    }
+    registerNativeIntrinsics();
+
+    std::string folder = argv[1];
+    unsigned threads = argc > 2 ? std::max(1, std::atoi(argv[2])) : defaultThreadCount();
+
+    auto started = std::chrono::steady_clock::now();
+    std::vector<Document> documents = loadDocuments(folder + "/documents.json");
+    std::vector<Edge> edges = loadEdges(folder + "/edges.json");
+    double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    VerifyReport report = verifyGraph(documents, edges, threads);
+
+    for (std::size_t i = 0; i < report.hashMismatches.size() && i < MAX_LISTED; i++)
+    {
+        const HashMismatch &mismatch = report.hashMismatches[i];
+        std::printf("hash mismatch: document %s hashes to %s\n",
+                    readableHash(mismatch.stored).c_str(), readableHash(mismatch.computed).c_str());
+    }
+    for (std::size_t i = 0; i < report.orphanEdges.size() && i < MAX_LISTED; i++)
+    {
+        const OrphanEdge &orphan = report.orphanEdges[i];
+        std::printf("orphan edge: %llu %s -%s-> %s, missing %s\n", (unsigned long long)orphan.edge.id,
+                    readableHash(orphan.edge.from_node).c_str(), orphan.edge.edge_name.to_string().c_str(),
+                    readableHash(orphan.edge.to_node).c_str(),
+                    orphan.missingFrom && orphan.missingTo ? "both nodes" : orphan.missingFrom ? "from_node" : "to_node");
+    }
+    for (std::size_t i = 0; i < report.keyMismatches.size() && i < MAX_LISTED; i++)
+    {
+        const KeyMismatch &mismatch = report.keyMismatches[i];
+        std::printf("key mismatch: edge %llu %s, expected %llu\n", (unsigned long long)mismatch.edge.id,
+                    mismatch.field.c_str(), (unsigned long long)mismatch.expected);
+    }
+
+    std::printf("%zu documents, %zu edges loaded in %.2f s\n", documents.size(), edges.size(), loadSeconds);
+    std::printf("documents: %.2f s, %.0f/s on %u threads, %zu hash mismatches\n", report.documentSeconds,
+                documents.size() / std::max(report.documentSeconds, 1e-9), threads, report.hashMismatches.size());
+    std::printf("edges: %.2f s, %.0f/s on %u threads, %zu orphans, %zu key mismatches\n", report.edgeSeconds,
+                edges.size() / std::max(report.edgeSeconds, 1e-9), threads, report.orphanEdges.size(), report.keyMismatches.size());
+
+    return report.ok() ? 0 : 1;
+}
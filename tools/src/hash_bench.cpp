@@ -0,0 +1,177 @@
+#include <graph_tools/fingerprint.hpp>
+#include <graph_tools/graph_dump.hpp>
+#include <graph_tools/native_intrinsics.hpp>
+#include <graph_tools/parallel.hpp>
+#include <graph_tools/sha256.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace hypha;
+
+namespace
+{
+    double secondsSince(const std::chrono::steady_clock::time_point &started)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    }
+
+    void report(const char *label, const std::size_t documents, const std::size_t bytes, const double seconds)
+    {
+        std::printf("%-36s %8.3f s  %10.0f documents/s  %8.1f MiB/s\n", label, seconds,
+                    documents / std::max(seconds, 1e-9), bytes / std::max(seconds, 1e-9) / (1 << 20));
+    }
+
+    struct KnownAnswer
+    {
+        std::string message;
+        const char *digest;
+    };
+
+    // the FIPS 180-4 examples, and messages whose padding just fits in the last block, just
+    // spills into another one, or starts a block of its own
+    const KnownAnswer KNOWN_ANSWERS[] = {
+        {"", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+        {"abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+        {std::string(55, 'a'), "9f4390f8d30c2dd92ec9f095b65e2b9ae9b0a925a5258e241c9f1e910f734318"},
+        {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+        {std::string(63, 'a'), "7d3e74a05d7db15bce4ad9ec0658ea98e3f06eeecf16b4c6fff2da457ddc2f34"},
+        {std::string(64, 'a'), "ffe054fe7ae0cb6dc65c3af9b61d5209f439851db43d0ba5997337df154668eb"},
+        {std::string(65, 'a'), "635361c48bb9eab14198e76ea8ab7f1a41685d6ad62aa9146d301d4f17eb0ae0"},
+    };
+
+    std::string toHex(const std::array<uint8_t, 32> &digest)
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex;
+        for (uint8_t byte : digest)
+        {
+            hex += digits[byte >> 4];
+            hex += digits[byte & 15];
+        }
+        return hex;
+    }
+
+    std::size_t checkKnownAnswer(const char *label, const KnownAnswer &answer, const std::array<uint8_t, 32> &digest)
+    {
+        if (toHex(digest) == answer.digest)
+            return 0;
+        std::fprintf(stderr, "%s: sha256 of %zu bytes is %s, expected %s\n", label, answer.message.size(),
+                     toHex(digest).c_str(), answer.digest);
+        return 1;
+    }
+
+    // hashes the known answers on the backend side by side and one at a time; Document::hashContents
+    // goes through the same code, so this is the check that does not compare it with itself
+    std::size_t knownAnswerMismatches(const Sha256Backend backend)
+    {
+        const std::size_t count = sizeof(KNOWN_ANSWERS) / sizeof(KNOWN_ANSWERS[0]);
+        std::vector<std::string> messages;
+        for (const KnownAnswer &answer : KNOWN_ANSWERS)
+        {
+            messages.push_back(answer.message);
+        }
+
+        std::size_t mismatches = 0;
+        std::vector<std::array<uint8_t, 32>> digests(count);
+        sha256Many(messages.data(), count, digests.data(), backend);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            mismatches += checkKnownAnswer(sha256BackendName(backend), KNOWN_ANSWERS[i], digests[i]);
+
+            std::array<uint8_t, 32> digest;
+            sha256Many(&messages[i], 1, &digest, backend);
+            mismatches += checkKnownAnswer(sha256BackendName(backend), KNOWN_ANSWERS[i], digest);
+        }
+        return mismatches;
+    }
+
+    std::size_t countMismatches(const std::vector<eosio::checksum256> &hashes, const std::vector<eosio::checksum256> &expected)
+    {
+        std::size_t mismatches = 0;
+        for (std::size_t i = 0; i < hashes.size(); i++)
+        {
+            mismatches += hashes[i] != expected[i] ? 1 : 0;
+        }
+        return mismatches;
+    }
+}
+
+// hash_bench <dump folder> [--threads <n>]
+// checks every SHA-256 backend the CPU supports against known answers, then fingerprints every
+// document of a dump with Document::hashContents, one at a time, and with the batch hashContents
+// on each backend; exits with 1 if a backend gets a known answer wrong or disagrees with
+// Document::hashContents
+int main(int argc, char **argv)
+{
+    if (argc != 2 && !(argc == 4 && std::strcmp(argv[2], "--threads") == 0))
+    {
+        std::fprintf(stderr, "usage: %s <dump folder> [--threads <n>]\n", argv[0]);
+        return 2;
+    }
+    registerNativeIntrinsics();
+
+    std::string folder = argv[1];
+    unsigned threads = argc == 4 ? std::max(1, std::atoi(argv[3])) : defaultThreadCount();
+
+    std::size_t wrongAnswers = 0;
+    for (Sha256Backend backend : {Sha256Backend::Portable, Sha256Backend::Avx2, Sha256Backend::ShaNi})
+    {
+        if (sha256Supported(backend))
+            wrongAnswers += knownAnswerMismatches(backend);
+    }
+    std::printf("%zu wrong known answers\n", wrongAnswers);
+
+    auto started = std::chrono::steady_clock::now();
+    std::vector<Document> documents = loadDocuments(folder + "/documents.json");
+    std::printf("%zu documents loaded in %.2f s, sha256 intrinsic on %s\n", documents.size(), secondsSince(started),
+                sha256BackendName(sha256Backend()));
+
+    std::size_t bytes = 0;
+    started = std::chrono::steady_clock::now();
+    for (const Document &document : documents)
+    {
+        bytes += fingerprint(document.getContentGroups()).size();
+    }
+    report("fingerprints only", documents.size(), bytes, secondsSince(started));
+
+    // the path the tools took before: a copy of the contents, Document::toString and the intrinsic
+    std::vector<eosio::checksum256> expected;
+    expected.reserve(documents.size());
+    started = std::chrono::steady_clock::now();
+    for (const Document &document : documents)
+    {
+        ContentGroups contentGroups = document.getContentGroups();
+        expected.push_back(Document::hashContents(contentGroups));
+    }
+    report("Document::hashContents", documents.size(), bytes, secondsSince(started));
+
+    std::size_t mismatches = 0;
+    for (Sha256Backend backend : {Sha256Backend::Portable, Sha256Backend::Avx2, Sha256Backend::ShaNi})
+    {
+        if (!sha256Supported(backend))
+        {
+            std::printf("%-36s not supported by this CPU\n", sha256BackendName(backend));
+            continue;
+        }
+
+        started = std::chrono::steady_clock::now();
+        std::vector<eosio::checksum256> hashes = hashContents(documents, 1, backend);
+        std::string label = std::string("hashContents, ") + sha256BackendName(backend) + ", 1 thread";
+        report(label.c_str(), documents.size(), bytes, secondsSince(started));
+        mismatches += countMismatches(hashes, expected);
+    }
+
+    started = std::chrono::steady_clock::now();
+    std::vector<eosio::checksum256> hashes = hashContents(documents, threads);
+    std::string label = std::string("hashContents, ") + sha256BackendName(sha256Backend()) + ", " + std::to_string(threads) + (threads == 1 ? " thread" : " threads");
+    report(label.c_str(), documents.size(), bytes, secondsSince(started));
+    mismatches += countMismatches(hashes, expected);
+
+    std::printf("%zu mismatches against Document::hashContents\n", mismatches);
+    return mismatches == 0 && wrongAnswers == 0 ? 0 : 1;
+}
@@ -0,0 +1,26 @@
+#include <graph_tools/native_intrinsics.hpp>
+#include <graph_tools/sha256.hpp>
+
+#include <eosio/native/intrinsics.hpp>
+
+#include <chrono>
+#include <cstring>
+
+namespace hypha
+{
+    void registerNativeIntrinsics()
+    {
+        using namespace eosio::native;
+
+        intrinsics::set_intrinsic<intrinsics::current_time>([]() -> uint64_t {
+            return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        });
+
+        // Document::hashContents and concatHash; must be safe to call from several threads
+        intrinsics::set_intrinsic<intrinsics::sha256>([](const char *data, uint32_t length, capi_checksum256 *hash) {
+            std::array<uint8_t, 32> digest = hypha::sha256(data, length);
+            std::memcpy(hash->hash, digest.data(), digest.size());
+        });
+    }
+
+} // namespace hypha
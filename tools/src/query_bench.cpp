@@ -0,0 +1,147 @@
+#include <graph_tools/native_intrinsics.hpp>
+#include <graph_tools/query_engine.hpp>
+#include <graph_tools/snapshot.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace hypha;
+
+namespace
+{
+    uint64_t splitmix64(uint64_t &state)
+    {
+        uint64_t z = (state += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+
+    eosio::checksum256 syntheticHash(uint64_t seed)
+    {
+        std::array<uint8_t, 32> bytes;
+        for (std::size_t i = 0; i < bytes.size(); i += 8)
+        {
+            uint64_t word = splitmix64(seed);
+            for (std::size_t b = 0; b < 8; b++)
+            {
+                bytes[i + b] = uint8_t(word >> (8 * b));
+            }
+        }
+        return eosio::checksum256(bytes);
+    }
+
+    void report(const char *label, std::vector<double> &micros, std::size_t results)
+    {
+        std::sort(micros.begin(), micros.end());
+        double total = 0;
+        for (double m : micros)
+        {
+            total += m;
+        }
+        std::printf("%-28s mean %8.2f us  p50 %8.2f us  p99 %8.2f us  avg results %.1f\n", label,
+                    total / micros.size(), micros[micros.size() / 2], micros[micros.size() * 99 / 100],
+                    double(results) / micros.size());
+    }
+
+    struct Case
+    {
+        const char *label;
+        std::vector<Hop> hops;
+    };
+
+    template <typename Graph>
+    void runCases(const Graph &graph, const std::vector<Case> &cases, const std::vector<eosio::checksum256> &hashes,
+                  const std::size_t queryCount)
+    {
+        uint64_t state = 7;
+        for (const Case &c : cases)
+        {
+            std::vector<double> micros;
+            micros.reserve(queryCount);
+            std::size_t results = 0;
+            for (std::size_t q = 0; q < queryCount; q++)
+            {
+                std::optional<uint32_t> start = graph.find(hashes[splitmix64(state) % hashes.size()]);
+                if (!start.has_value())
+                {
+                    continue;
+                }
+
+                auto before = std::chrono::steady_clock::now();
+                results += graph.query(*start, c.hops).size();
+                micros.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - before).count());
+            }
+            report(c.label, micros, results);
+        }
+    }
+} // namespace
+
+// query_bench [nodes] [edges] [edge names] [queries] [snapshot file]
+// builds a random graph with uniformly chosen endpoints and times multi-hop queries over it; with
+// a snapshot file, the graph is also written to it, mapped back and queried through the mapping
+int main(int argc, char **argv)
+{
+    registerNativeIntrinsics();
+
+    const std::size_t nodeCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    const std::size_t edgeCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+    const std::size_t nameCount = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 8;
+    const std::size_t queryCount = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 100000;
+
+    std::vector<eosio::checksum256> hashes;
+    hashes.reserve(nodeCount);
+    for (std::size_t n = 0; n < nodeCount; n++)
+    {
+        hashes.push_back(syntheticHash(n));
+    }
+
+    std::vector<eosio::name> names;
+    for (std::size_t n = 0; n < nameCount; n++)
+    {
+        names.push_back(eosio::name(std::string_view("edge" + std::string(1, char('a' + n % 26)))));
+    }
+
+    uint64_t state = 42;
+    std::vector<Edge> edges(edgeCount);
+    for (Edge &edge : edges)
+    {
+        edge.from_node = hashes[splitmix64(state) % nodeCount];
+        edge.to_node = hashes[splitmix64(state) % nodeCount];
+        edge.edge_name = names[splitmix64(state) % nameCount];
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    QueryEngine engine({}, edges);
+    auto built = std::chrono::steady_clock::now();
+    std::printf("built %zu nodes, %zu edges in %.1f ms\n", engine.nodeCount(), engine.edgeCount(),
+                std::chrono::duration<double, std::milli>(built - started).count());
+
+    std::vector<Case> cases = {
+        {"1 hop, named", {{Direction::Out, names[0]}}},
+        {"2 hops, named", {{Direction::Out, names[0]}, {Direction::Out, names[1 % nameCount]}}},
+        {"2 hops, out then in", {{Direction::Out, names[0]}, {Direction::In, names[0]}}},
+        {"2 hops, any name", {{Direction::Out, eosio::name()}, {Direction::Out, eosio::name()}}},
+        {"3 hops, named", {{Direction::Out, names[0]}, {Direction::Out, names[1 % nameCount]}, {Direction::Out, names[2 % nameCount]}}},
+    };
+
+    runCases(engine, cases, hashes, queryCount);
+
+    if (argc > 5)
+    {
+        auto writing = std::chrono::steady_clock::now();
+        writeSnapshot(argv[5], {}, edges);
+        auto opening = std::chrono::steady_clock::now();
+        Snapshot snapshot(argv[5]);
+        auto opened = std::chrono::steady_clock::now();
+
+        std::printf("snapshot written in %.1f ms, mapped in %.3f ms\n",
+                    std::chrono::duration<double, std::milli>(opening - writing).count(),
+                    std::chrono::duration<double, std::milli>(opened - opening).count());
+        runCases(snapshot, cases, hashes, queryCount);
+    }
+    return 0;
+}
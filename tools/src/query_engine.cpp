@@ -0,0 +1,166 @@
+#include <graph_tools/query_engine.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <tuple>
+
+namespace hypha
+{
+    namespace
+    {
+        constexpr uint32_t NO_DOCUMENT = std::numeric_limits<uint32_t>::max();
+    }
+
+    // document hashes are uniformly distributed, so the first 8 bytes are a good hash already
+    std::size_t ChecksumHasher::operator()(const eosio::checksum256 &hash) const
+    {
+        auto bytes = hash.extract_as_byte_array();
+        std::size_t result;
+        std::memcpy(&result, bytes.data(), sizeof(result));
+        return result;
+    }
+
+    QueryEngine::QueryEngine(std::vector<Document> documents, const std::vector<Edge> &edges)
+        : m_documents{std::move(documents)}
+    {
+        m_ids.reserve(m_documents.size() + edges.size() / 4);
+        for (std::size_t i = 0; i < m_documents.size(); i++)
+        {
+            uint32_t node = intern(m_documents[i].getHash());
+            m_documentIndex.resize(m_hashes.size(), NO_DOCUMENT);
+            m_documentIndex[node] = i;
+        }
+
+        std::vector<std::tuple<uint32_t, uint64_t, uint32_t>> out;
+        std::vector<std::tuple<uint32_t, uint64_t, uint32_t>> in;
+        out.reserve(edges.size());
+        in.reserve(edges.size());
+        for (const Edge &edge : edges)
+        {
+            uint32_t from = intern(edge.from_node);
+            uint32_t to = intern(edge.to_node);
+            out.emplace_back(from, edge.edge_name.value, to);
+            in.emplace_back(to, edge.edge_name.value, from);
+        }
+        m_documentIndex.resize(m_hashes.size(), NO_DOCUMENT);
+
+        m_out = Adjacency::build(out, m_hashes.size());
+        m_in = Adjacency::build(in, m_hashes.size());
+    }
+
+    uint32_t QueryEngine::intern(const eosio::checksum256 &hash)
+    {
+        auto [itr, inserted] = m_ids.try_emplace(hash, m_hashes.size());
+        if (inserted)
+        {
+            m_hashes.push_back(hash);
+        }
+        return itr->second;
+    }
+
+    Adjacency Adjacency::build(std::vector<std::tuple<uint32_t, uint64_t, uint32_t>> &rows, const std::size_t nodeCount)
+    {
+        std::sort(rows.begin(), rows.end());
+
+        Adjacency adjacency;
+        adjacency.offsets.assign(nodeCount + 1, 0);
+        adjacency.names.reserve(rows.size());
+        adjacency.nodes.reserve(rows.size());
+        for (const auto &[node, name, other] : rows)
+        {
+            adjacency.offsets[node + 1]++;
+            adjacency.names.push_back(name);
+            adjacency.nodes.push_back(other);
+        }
+        for (std::size_t n = 0; n < nodeCount; n++)
+        {
+            adjacency.offsets[n + 1] += adjacency.offsets[n];
+        }
+        return adjacency;
+    }
+
+    std::optional<uint32_t> QueryEngine::find(const eosio::checksum256 &hash) const
+    {
+        auto itr = m_ids.find(hash);
+        if (itr == m_ids.end())
+        {
+            return std::nullopt;
+        }
+        return itr->second;
+    }
+
+    const Document *QueryEngine::getDocument(const uint32_t node) const
+    {
+        return m_documentIndex[node] == NO_DOCUMENT ? nullptr : &m_documents[m_documentIndex[node]];
+    }
+
+    Neighbors AdjacencyView::neighbors(const uint32_t node, const eosio::name &edgeName) const
+    {
+        uint32_t first = offsets[node];
+        uint32_t last = offsets[node + 1];
+
+        if (edgeName.value != 0)
+        {
+            auto range = std::equal_range(names + first, names + last, edgeName.value);
+            first = range.first - names;
+            last = range.second - names;
+        }
+        return Neighbors{nodes + first, nodes + last};
+    }
+
+    std::vector<uint32_t> followHops(const AdjacencyView &out, const AdjacencyView &in,
+                                     const uint32_t start, const std::vector<Hop> &hops)
+    {
+        std::vector<uint32_t> frontier{start};
+        std::vector<uint32_t> next;
+
+        for (const Hop &hop : hops)
+        {
+            next.clear();
+            for (uint32_t node : frontier)
+            {
+                Neighbors reached = (hop.direction == Direction::Out ? out : in).neighbors(node, hop.edgeName);
+                next.insert(next.end(), reached.begin(), reached.end());
+            }
+
+            // frontiers are small compared to the graph, so sorting beats a visited bitmap
+            std::sort(next.begin(), next.end());
+            next.erase(std::unique(next.begin(), next.end()), next.end());
+            std::swap(frontier, next);
+
+            if (frontier.empty())
+            {
+                break;
+            }
+        }
+        return frontier;
+    }
+
+    Neighbors QueryEngine::neighbors(const uint32_t node, const Direction direction, const eosio::name &edgeName) const
+    {
+        return (direction == Direction::Out ? m_out : m_in).view().neighbors(node, edgeName);
+    }
+
+    std::vector<uint32_t> QueryEngine::query(const uint32_t start, const std::vector<Hop> &hops) const
+    {
+        return followHops(m_out.view(), m_in.view(), start, hops);
+    }
+
+    std::vector<eosio::checksum256> QueryEngine::query(const eosio::checksum256 &start, const std::vector<Hop> &hops) const
+    {
+        std::vector<eosio::checksum256> hashes;
+        std::optional<uint32_t> node = find(start);
+        if (!node.has_value())
+        {
+            return hashes;
+        }
+
+        for (uint32_t reached : query(*node, hops))
+        {
+            hashes.push_back(m_hashes[reached]);
+        }
+        return hashes;
+    }
+
+} // namespace hypha
@@ -0,0 +1,263 @@
+#include <graph_tools/replica.hpp>
+
+#include <document_graph/util.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+
+namespace hypha
+{
+    namespace
+    {
+        const eosio::name DOCUMENTS_TABLE = eosio::name("documents");
+        const eosio::name KEYED_DOCUMENTS_TABLE = eosio::name("docsbyhash");
+        const eosio::name EDGES_TABLE = eosio::name("edges");
+
+        bool isDocumentTable(uint64_t table)
+        {
+            return table == DOCUMENTS_TABLE.value || table == KEYED_DOCUMENTS_TABLE.value;
+        }
+    } // namespace
+
+    GraphReplica::GraphReplica(const eosio::name &contract) : GraphReplica(contract, contract) {}
+
+    GraphReplica::GraphReplica(const eosio::name &contract, const eosio::name &scope) : m_contract{contract}, m_scope{scope} {}
+
+    void GraphReplica::applyBlock(const ship::BlockPosition &block, const std::vector<char> &deltas, const uint32_t lastIrreversible)
+    {
+        if (m_head && block.block_num <= m_head->block_num)
+        {
+            rollbackTo(block.block_num);
+        }
+
+        BlockUndo undo{block, {}};
+        if (!deltas.empty())
+        {
+            for (const ship::TableDelta &variant : eosio::unpack<std::vector<ship::TableDelta>>(deltas))
+            {
+                const ship::TableDeltaV0 &delta = std::get<ship::TableDeltaV0>(variant);
+                if (delta.name != "contract_row")
+                    continue;
+
+                for (const ship::Row &row : delta.rows)
+                {
+                    ship::ContractRowV0 contractRow = std::get<ship::ContractRowV0>(eosio::unpack<ship::ContractRow>(row.data));
+                    if (contractRow.code != m_contract || contractRow.scope != m_scope)
+                        continue;
+                    if (!isDocumentTable(contractRow.table.value) && contractRow.table != EDGES_TABLE)
+                        continue;
+
+                    RowKey key{contractRow.table.value, contractRow.primary_key};
+                    if (row.present)
+                        setRow(undo, key, std::move(contractRow.value));
+                    else
+                        setRow(undo, key, std::nullopt);
+                }
+            }
+        }
+
+        m_head = block;
+        m_undo.push_back(std::move(undo));
+        while (!m_undo.empty() && m_undo.front().block.block_num <= lastIrreversible)
+        {
+            m_irreversible = m_undo.front().block;
+            m_undo.pop_front();
+        }
+    }
+
+    void GraphReplica::setRow(BlockUndo &undo, const RowKey &key, std::optional<std::vector<char>> value)
+    {
+        auto itr = m_rows.find(key);
+        Change change{key.first, key.second, std::nullopt};
+        if (itr != m_rows.end())
+        {
+            change.previous = std::move(itr->second);
+        }
+        undo.changes.push_back(std::move(change));
+
+        if (value)
+        {
+            // decoding up front rejects rows whose layout does not match the library types
+            if (isDocumentTable(key.first))
+                eosio::unpack<Document>(*value);
+            else
+                eosio::unpack<Edge>(*value);
+            m_rows[key] = std::move(*value);
+        }
+        else if (itr != m_rows.end())
+        {
+            m_rows.erase(itr);
+        }
+    }
+
+    void GraphReplica::rollbackTo(const uint32_t blockNum)
+    {
+        eosio::check(!m_irreversible || m_irreversible->block_num < blockNum,
+                     "cannot roll back to block " + std::to_string(blockNum) + ", it is older than the retained undo history");
+
+        while (!m_undo.empty() && m_undo.back().block.block_num >= blockNum)
+        {
+            BlockUndo &undo = m_undo.back();
+            for (auto change = undo.changes.rbegin(); change != undo.changes.rend(); ++change)
+            {
+                RowKey key{change->table, change->primaryKey};
+                if (change->previous)
+                    m_rows[key] = std::move(*change->previous);
+                else
+                    m_rows.erase(key);
+            }
+            m_undo.pop_back();
+        }
+        m_head = m_undo.empty() ? m_irreversible : m_undo.back().block;
+    }
+
+    void GraphReplica::reconcile(const std::vector<eosio::checksum256> &removedDocuments, const std::vector<Edge> &removedEdges,
+                                 const std::vector<Document> &addedDocuments, const std::vector<Edge> &addedEdges)
+    {
+        for (const Edge &edge : removedEdges)
+        {
+            auto itr = m_rows.find(RowKey{EDGES_TABLE.value, concatHash(edge.from_node, edge.to_node, edge.edge_name)});
+            if (itr == m_rows.end())
+                continue;
+
+            // the id is 32 bits, so the row may be another edge that happens to share it
+            Edge stored = eosio::unpack<Edge>(itr->second);
+            if (stored.from_node == edge.from_node && stored.to_node == edge.to_node && stored.edge_name == edge.edge_name)
+                m_rows.erase(itr);
+        }
+
+        // a packed document row starts with its id and hash, so rows are matched without unpacking them
+        std::vector<std::array<uint8_t, 32>> removed;
+        removed.reserve(removedDocuments.size());
+        for (const eosio::checksum256 &hash : removedDocuments)
+        {
+            removed.push_back(hash.extract_as_byte_array());
+        }
+        std::sort(removed.begin(), removed.end());
+
+        for (auto itr = m_rows.begin(); itr != m_rows.end() && !removed.empty();)
+        {
+            std::array<uint8_t, 32> hash;
+            if (isDocumentTable(itr->first.first) && itr->second.size() >= 40)
+            {
+                std::memcpy(hash.data(), itr->second.data() + 8, 32);
+                if (std::binary_search(removed.begin(), removed.end(), hash))
+                {
+                    itr = m_rows.erase(itr);
+                    continue;
+                }
+            }
+            ++itr;
+        }
+
+        // a document whose id was derived from its hash belongs to the keyed table
+        for (const Document &document : addedDocuments)
+        {
+            uint64_t id = document.primary_key();
+            uint64_t keyed = Document::hashKey(document.getHash());
+            bool isKeyed = id - keyed < Document::MAX_KEY_PROBES;
+            m_rows[RowKey{(isKeyed ? KEYED_DOCUMENTS_TABLE : DOCUMENTS_TABLE).value, id}] = eosio::pack(document);
+        }
+        for (const Edge &edge : addedEdges)
+        {
+            m_rows[RowKey{EDGES_TABLE.value, edge.id}] = eosio::pack(edge);
+        }
+    }
+
+    std::vector<ship::BlockPosition> GraphReplica::reversiblePositions() const
+    {
+        std::vector<ship::BlockPosition> positions;
+        positions.reserve(m_undo.size());
+        for (const BlockUndo &undo : m_undo)
+        {
+            positions.push_back(undo.block);
+        }
+        return positions;
+    }
+
+    std::vector<Document> GraphReplica::documents() const
+    {
+        std::vector<Document> documents;
+        for (const auto &[key, value] : m_rows)
+        {
+            if (isDocumentTable(key.first))
+                documents.push_back(eosio::unpack<Document>(value));
+        }
+        return documents;
+    }
+
+    std::vector<Edge> GraphReplica::edges() const
+    {
+        std::vector<Edge> edges;
+        for (auto itr = m_rows.lower_bound(RowKey{EDGES_TABLE.value, 0});
+             itr != m_rows.end() && itr->first.first == EDGES_TABLE.value; ++itr)
+        {
+            edges.push_back(eosio::unpack<Edge>(itr->second));
+        }
+        return edges;
+    }
+
+    std::size_t GraphReplica::documentCount() const
+    {
+        return m_rows.size() - edgeCount();
+    }
+
+    std::size_t GraphReplica::edgeCount() const
+    {
+        auto first = m_rows.lower_bound(RowKey{EDGES_TABLE.value, 0});
+        auto last = m_rows.lower_bound(RowKey{EDGES_TABLE.value + 1, 0});
+        return std::distance(first, last);
+    }
+
+    void GraphReplica::save(const std::string &fileName) const
+    {
+        std::vector<CheckpointRow> rows;
+        rows.reserve(m_rows.size());
+        for (const auto &[key, value] : m_rows)
+        {
+            rows.push_back(CheckpointRow{key.first, key.second, value});
+        }
+        Checkpoint checkpoint{m_contract, m_scope, m_head, m_irreversible, std::move(rows), std::vector<BlockUndo>(m_undo.begin(), m_undo.end())};
+        std::vector<char> data = eosio::pack(checkpoint);
+
+        std::string temporary = fileName + ".tmp";
+        std::FILE *file = std::fopen(temporary.c_str(), "wb");
+        eosio::check(file != nullptr, "cannot create " + temporary);
+        bool written = std::fwrite(data.data(), data.size(), 1, file) == 1;
+        eosio::check(std::fclose(file) == 0 && written, "cannot write " + temporary);
+        eosio::check(std::rename(temporary.c_str(), fileName.c_str()) == 0, "cannot replace " + fileName);
+    }
+
+    bool GraphReplica::load(const std::string &fileName)
+    {
+        std::FILE *file = std::fopen(fileName.c_str(), "rb");
+        if (file == nullptr)
+            return false;
+
+        std::vector<char> data;
+        char chunk[65536];
+        std::size_t read;
+        while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+        {
+            data.insert(data.end(), chunk, chunk + read);
+        }
+        std::fclose(file);
+
+        Checkpoint checkpoint = eosio::unpack<Checkpoint>(data);
+        eosio::check(checkpoint.contract == m_contract && checkpoint.scope == m_scope,
+                     fileName + " is a checkpoint of " + checkpoint.contract.to_string() + " in scope " + checkpoint.scope.to_string());
+
+        m_head = checkpoint.head;
+        m_irreversible = checkpoint.irreversible;
+        m_rows.clear();
+        for (CheckpointRow &row : checkpoint.rows)
+        {
+            m_rows.emplace(RowKey{row.table, row.primaryKey}, std::move(row.value));
+        }
+        m_undo.assign(std::make_move_iterator(checkpoint.undo.begin()), std::make_move_iterator(checkpoint.undo.end()));
+        return true;
+    }
+
+} // namespace hypha
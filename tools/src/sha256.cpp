@@ -0,0 +1,435 @@
+#include <graph_tools/sha256.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define HYPHA_SHA256_X86
+#endif
+
+namespace hypha
+{
+    namespace
+    {
+        alignas(16) constexpr uint32_t K[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+        constexpr uint32_t INITIAL_STATE[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                               0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+        inline uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+        inline uint32_t loadBigEndian(const uint8_t *bytes)
+        {
+            return uint32_t(bytes[0]) << 24 | uint32_t(bytes[1]) << 16 | uint32_t(bytes[2]) << 8 | uint32_t(bytes[3]);
+        }
+
+        // a message split into 64-byte blocks: the full blocks are read in place, and the tail,
+        // a 0x80 byte and the bit length fit in one or two final blocks
+        struct PaddedMessage
+        {
+            PaddedMessage(const char *data, const std::size_t length)
+                : bytes{reinterpret_cast<const uint8_t *>(data)}, full{length / 64}
+            {
+                std::size_t rest = length - 64 * full;
+                std::memcpy(tail, bytes + 64 * full, rest);
+                tail[rest] = 0x80;
+
+                std::size_t tailLength = rest < 56 ? 64 : 128;
+                uint64_t bits = uint64_t(length) * 8;
+                for (int i = 0; i < 8; i++)
+                {
+                    tail[tailLength - 1 - i] = uint8_t(bits >> (8 * i));
+                }
+                blocks = full + tailLength / 64;
+            }
+
+            const uint8_t *block(const std::size_t b) const { return b < full ? bytes + 64 * b : tail + 64 * (b - full); }
+
+            const uint8_t *bytes;
+            std::size_t full;
+            std::size_t blocks;
+            uint8_t tail[128] = {};
+        };
+
+        std::size_t blockCount(const std::size_t length) { return (length + 9 + 63) / 64; }
+
+        void storeDigest(const uint32_t state[8], std::array<uint8_t, 32> &digest)
+        {
+            for (int i = 0; i < 8; i++)
+            {
+                digest[4 * i] = uint8_t(state[i] >> 24);
+                digest[4 * i + 1] = uint8_t(state[i] >> 16);
+                digest[4 * i + 2] = uint8_t(state[i] >> 8);
+                digest[4 * i + 3] = uint8_t(state[i]);
+            }
+        }
+
+        void compress(uint32_t state[8], const uint8_t block[64])
+        {
+            uint32_t w[64];
+            for (int i = 0; i < 16; i++)
+            {
+                w[i] = loadBigEndian(block + 4 * i);
+            }
+            for (int i = 16; i < 64; i++)
+            {
+                uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+            uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+            for (int i = 0; i < 64; i++)
+            {
+                uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+                uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+                h = g;
+                g = f;
+                f = e;
+                e = d + t1;
+                d = c;
+                c = b;
+                b = a;
+                a = t1 + t2;
+            }
+
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+            state[4] += e;
+            state[5] += f;
+            state[6] += g;
+            state[7] += h;
+        }
+
+        std::array<uint8_t, 32> sha256Portable(const char *data, const std::size_t length)
+        {
+            uint32_t state[8];
+            std::memcpy(state, INITIAL_STATE, sizeof(state));
+            PaddedMessage message(data, length);
+            for (std::size_t b = 0; b < message.blocks; b++)
+            {
+                compress(state, message.block(b));
+            }
+
+            std::array<uint8_t, 32> digest;
+            storeDigest(state, digest);
+            return digest;
+        }
+
+#ifdef HYPHA_SHA256_X86
+        bool cpuHasShaNi()
+        {
+            unsigned a, b, c, d;
+            if (!__get_cpuid(1, &a, &b, &c, &d) || !(c & bit_SSSE3) || !(c & bit_SSE4_1))
+            {
+                return false;
+            }
+            return __get_cpuid_count(7, 0, &a, &b, &c, &d) && (b & (1u << 29));
+        }
+
+        bool cpuHasAvx2()
+        {
+            unsigned a, b, c, d;
+            if (!__get_cpuid(1, &a, &b, &c, &d) || !(c & bit_OSXSAVE) || !(c & bit_AVX))
+            {
+                return false;
+            }
+
+            // the OS must save the YMM registers on a context switch
+            unsigned low, high;
+            __asm__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+            if ((low & 6) != 6)
+            {
+                return false;
+            }
+            return __get_cpuid_count(7, 0, &a, &b, &c, &d) && (b & bit_AVX2);
+        }
+
+        // the state lives in two registers as ABEF and CDGH; each sha256rnds2 runs two rounds and
+        // sha256msg1 and sha256msg2 extend the schedule four words at a time
+        __attribute__((target("sha,sse4.1"))) std::array<uint8_t, 32> sha256ShaNi(const char *data, const std::size_t length)
+        {
+            const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+            __m128i dcba = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&INITIAL_STATE[0]));
+            __m128i hgfe = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&INITIAL_STATE[4]));
+            __m128i badc = _mm_shuffle_epi32(dcba, 0xB1);
+            __m128i efgh = _mm_shuffle_epi32(hgfe, 0x1B);
+            __m128i abef = _mm_alignr_epi8(badc, efgh, 8);
+            __m128i cdgh = _mm_blend_epi16(efgh, badc, 0xF0);
+
+            PaddedMessage message(data, length);
+            for (std::size_t b = 0; b < message.blocks; b++)
+            {
+                const uint8_t *block = message.block(b);
+                __m128i savedAbef = abef;
+                __m128i savedCdgh = cdgh;
+
+                __m128i w[4];
+                for (int i = 0; i < 4; i++)
+                {
+                    w[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16 * i)), byteSwap);
+                }
+
+                for (int i = 0; i < 16; i++)
+                {
+                    __m128i words = _mm_add_epi32(w[i & 3], _mm_load_si128(reinterpret_cast<const __m128i *>(&K[4 * i])));
+                    cdgh = _mm_sha256rnds2_epu32(cdgh, abef, words);
+                    abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(words, 0x0E));
+                    if (i < 12)
+                    {
+                        // words 4i+16 to 4i+19 replace words 4i to 4i+3, which are used up
+                        __m128i next = _mm_add_epi32(_mm_sha256msg1_epu32(w[i & 3], w[(i + 1) & 3]),
+                                                     _mm_alignr_epi8(w[(i + 3) & 3], w[(i + 2) & 3], 4));
+                        w[i & 3] = _mm_sha256msg2_epu32(next, w[(i + 3) & 3]);
+                    }
+                }
+
+                abef = _mm_add_epi32(abef, savedAbef);
+                cdgh = _mm_add_epi32(cdgh, savedCdgh);
+            }
+
+            __m128i feba = _mm_shuffle_epi32(abef, 0x1B);
+            __m128i dchg = _mm_shuffle_epi32(cdgh, 0xB1);
+            uint32_t state[8];
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(&state[0]), _mm_blend_epi16(feba, dchg, 0xF0));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(&state[4]), _mm_alignr_epi8(dchg, feba, 8));
+
+            std::array<uint8_t, 32> digest;
+            storeDigest(state, digest);
+            return digest;
+        }
+
+        template <int n>
+        __attribute__((target("avx2"))) inline __m256i rotr8(const __m256i x)
+        {
+            return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+        }
+
+        // the portable rounds on eight messages at once, one per lane; lanes that ran out of blocks
+        // hash a zero block and keep their state
+        __attribute__((target("avx2"))) void sha256Avx2(const PaddedMessage *messages[8], std::array<uint8_t, 32> *digests[8])
+        {
+            static const uint8_t zeroBlock[64] = {};
+
+            __m256i state[8];
+            for (int i = 0; i < 8; i++)
+            {
+                state[i] = _mm256_set1_epi32(int(INITIAL_STATE[i]));
+            }
+
+            std::size_t blocks = 0;
+            alignas(32) int32_t laneBlocks[8];
+            for (int lane = 0; lane < 8; lane++)
+            {
+                laneBlocks[lane] = messages[lane] ? int32_t(messages[lane]->blocks) : 0;
+                blocks = std::max<std::size_t>(blocks, laneBlocks[lane]);
+            }
+            const __m256i remaining = _mm256_load_si256(reinterpret_cast<const __m256i *>(laneBlocks));
+
+            for (std::size_t step = 0; step < blocks; step++)
+            {
+                const uint8_t *block[8];
+                for (int lane = 0; lane < 8; lane++)
+                {
+                    block[lane] = step < std::size_t(laneBlocks[lane]) ? messages[lane]->block(step) : zeroBlock;
+                }
+
+                __m256i w[64];
+                for (int i = 0; i < 16; i++)
+                {
+                    w[i] = _mm256_setr_epi32(int(loadBigEndian(block[0] + 4 * i)), int(loadBigEndian(block[1] + 4 * i)),
+                                             int(loadBigEndian(block[2] + 4 * i)), int(loadBigEndian(block[3] + 4 * i)),
+                                             int(loadBigEndian(block[4] + 4 * i)), int(loadBigEndian(block[5] + 4 * i)),
+                                             int(loadBigEndian(block[6] + 4 * i)), int(loadBigEndian(block[7] + 4 * i)));
+                }
+                for (int i = 16; i < 64; i++)
+                {
+                    __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr8<7>(w[i - 15]), rotr8<18>(w[i - 15])), _mm256_srli_epi32(w[i - 15], 3));
+                    __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr8<17>(w[i - 2]), rotr8<19>(w[i - 2])), _mm256_srli_epi32(w[i - 2], 10));
+                    w[i] = _mm256_add_epi32(_mm256_add_epi32(w[i - 16], s0), _mm256_add_epi32(w[i - 7], s1));
+                }
+
+                __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+                __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+                for (int i = 0; i < 64; i++)
+                {
+                    __m256i sum1 = _mm256_xor_si256(_mm256_xor_si256(rotr8<6>(e), rotr8<11>(e)), rotr8<25>(e));
+                    __m256i choose = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+                    __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, sum1),
+                                                  _mm256_add_epi32(choose, _mm256_add_epi32(_mm256_set1_epi32(int(K[i])), w[i])));
+                    __m256i sum0 = _mm256_xor_si256(_mm256_xor_si256(rotr8<2>(a), rotr8<13>(a)), rotr8<22>(a));
+                    __m256i majority = _mm256_xor_si256(_mm256_xor_si256(_mm256_and_si256(a, b), _mm256_and_si256(a, c)),
+                                                        _mm256_and_si256(b, c));
+                    __m256i t2 = _mm256_add_epi32(sum0, majority);
+                    h = g;
+                    g = f;
+                    f = e;
+                    e = _mm256_add_epi32(d, t1);
+                    d = c;
+                    c = b;
+                    b = a;
+                    a = _mm256_add_epi32(t1, t2);
+                }
+
+                const __m256i active = _mm256_cmpgt_epi32(remaining, _mm256_set1_epi32(int(step)));
+                __m256i rounds[8] = {a, b, c, d, e, f, g, h};
+                for (int i = 0; i < 8; i++)
+                {
+                    state[i] = _mm256_blendv_epi8(state[i], _mm256_add_epi32(state[i], rounds[i]), active);
+                }
+            }
+
+            alignas(32) uint32_t words[8][8];
+            for (int i = 0; i < 8; i++)
+            {
+                _mm256_store_si256(reinterpret_cast<__m256i *>(words[i]), state[i]);
+            }
+            for (int lane = 0; lane < 8; lane++)
+            {
+                if (digests[lane])
+                {
+                    uint32_t laneState[8];
+                    for (int i = 0; i < 8; i++)
+                    {
+                        laneState[i] = words[i][lane];
+                    }
+                    storeDigest(laneState, *digests[lane]);
+                }
+            }
+        }
+#endif
+
+        Sha256Backend detectBackend()
+        {
+#ifdef HYPHA_SHA256_X86
+            if (cpuHasShaNi())
+            {
+                return Sha256Backend::ShaNi;
+            }
+            if (cpuHasAvx2())
+            {
+                return Sha256Backend::Avx2;
+            }
+#endif
+            return Sha256Backend::Portable;
+        }
+    } // namespace
+
+    Sha256Backend sha256Backend()
+    {
+        static const Sha256Backend backend = detectBackend();
+        return backend;
+    }
+
+    bool sha256Supported(const Sha256Backend backend)
+    {
+        switch (backend)
+        {
+#ifdef HYPHA_SHA256_X86
+        case Sha256Backend::ShaNi:
+        {
+            static const bool supported = cpuHasShaNi();
+            return supported;
+        }
+        case Sha256Backend::Avx2:
+        {
+            static const bool supported = cpuHasAvx2();
+            return supported;
+        }
+#endif
+        case Sha256Backend::Portable:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    const char *sha256BackendName(const Sha256Backend backend)
+    {
+        switch (backend)
+        {
+        case Sha256Backend::ShaNi:
+            return "sha-ni";
+        case Sha256Backend::Avx2:
+            return "avx2";
+        default:
+            return "portable";
+        }
+    }
+
+    std::array<uint8_t, 32> sha256(const char *data, std::size_t length)
+    {
+#ifdef HYPHA_SHA256_X86
+        if (sha256Backend() == Sha256Backend::ShaNi)
+        {
+            return sha256ShaNi(data, length);
+        }
+#endif
+        return sha256Portable(data, length);
+    }
+
+    void sha256Many(const std::string *messages, const std::size_t count, std::array<uint8_t, 32> *digests,
+                    const Sha256Backend backend)
+    {
+#ifdef HYPHA_SHA256_X86
+        if (backend == Sha256Backend::ShaNi && sha256Supported(backend))
+        {
+            for (std::size_t i = 0; i < count; i++)
+            {
+                digests[i] = sha256ShaNi(messages[i].data(), messages[i].size());
+            }
+            return;
+        }
+
+        if (backend == Sha256Backend::Avx2 && sha256Supported(backend))
+        {
+            // lanes are only as fast as the longest message of their group, so messages are
+            // grouped by their number of blocks
+            std::vector<uint32_t> order(count);
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [&](uint32_t x, uint32_t y) {
+                return blockCount(messages[x].size()) < blockCount(messages[y].size());
+            });
+
+            std::vector<PaddedMessage> padded;
+            padded.reserve(8);
+            for (std::size_t first = 0; first < count; first += 8)
+            {
+                padded.clear();
+                const PaddedMessage *lanes[8] = {};
+                std::array<uint8_t, 32> *laneDigests[8] = {};
+                for (std::size_t lane = 0; lane < 8 && first + lane < count; lane++)
+                {
+                    const std::string &message = messages[order[first + lane]];
+                    padded.emplace_back(message.data(), message.size());
+                    lanes[lane] = &padded.back();
+                    laneDigests[lane] = &digests[order[first + lane]];
+                }
+                sha256Avx2(lanes, laneDigests);
+            }
+            return;
+        }
+#endif
+        for (std::size_t i = 0; i < count; i++)
+        {
+            digests[i] = sha256Portable(messages[i].data(), messages[i].size());
+        }
+    }
+
+} // namespace hypha
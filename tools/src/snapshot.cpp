@@ -0,0 +1,262 @@
+#include <graph_tools/snapshot.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace hypha
+{
+    namespace
+    {
+        using HashBytes = std::array<uint8_t, 32>;
+
+        class SnapshotWriter
+        {
+        public:
+            SnapshotWriter(const std::string &fileName) : m_file{std::fopen(fileName.c_str(), "wb")}
+            {
+                eosio::check(m_file != nullptr, "cannot create " + fileName);
+            }
+
+            ~SnapshotWriter()
+            {
+                if (m_file != nullptr)
+                {
+                    std::fclose(m_file);
+                }
+            }
+
+            // pads to the next 8 byte boundary, where the next section starts
+            uint64_t beginSection()
+            {
+                static const char padding[8] = {};
+                write(padding, ((m_offset + 7) & ~uint64_t(7)) - m_offset);
+                return m_offset;
+            }
+
+            SnapshotSection endSection(const uint64_t start) const
+            {
+                return SnapshotSection{start, m_offset - start};
+            }
+
+            SnapshotSection append(const void *data, const uint64_t size)
+            {
+                uint64_t start = beginSection();
+                write(data, size);
+                return endSection(start);
+            }
+
+            template <typename T>
+            SnapshotSection append(const std::vector<T> &items)
+            {
+                return append(items.data(), items.size() * sizeof(T));
+            }
+
+            void writeHeader(const SnapshotHeader &header)
+            {
+                eosio::check(std::fseek(m_file, 0, SEEK_SET) == 0, "cannot write snapshot header");
+                eosio::check(std::fwrite(&header, sizeof(header), 1, m_file) == 1, "cannot write snapshot header");
+            }
+
+            void close()
+            {
+                eosio::check(std::fclose(m_file) == 0, "cannot close snapshot");
+                m_file = nullptr;
+            }
+
+            void write(const void *data, const uint64_t size)
+            {
+                eosio::check(size == 0 || std::fwrite(data, size, 1, m_file) == 1, "cannot write snapshot");
+                m_offset += size;
+            }
+
+        private:
+            std::FILE *m_file;
+            uint64_t m_offset = 0;
+        };
+    } // namespace
+
+    void writeSnapshot(const std::string &fileName, const std::vector<Document> &documents, const std::vector<Edge> &edges)
+    {
+        // node ids follow hash order so that the hash array doubles as the lookup index
+        std::vector<HashBytes> hashes;
+        hashes.reserve(documents.size() + 2 * edges.size());
+        for (const Document &document : documents)
+        {
+            hashes.push_back(document.getHash().extract_as_byte_array());
+        }
+        for (const Edge &edge : edges)
+        {
+            hashes.push_back(edge.from_node.extract_as_byte_array());
+            hashes.push_back(edge.to_node.extract_as_byte_array());
+        }
+        std::sort(hashes.begin(), hashes.end());
+        hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+        eosio::check(hashes.size() < std::numeric_limits<uint32_t>::max(), "too many nodes for a snapshot");
+
+        auto nodeOf = [&](const eosio::checksum256 &hash) {
+            return uint32_t(std::lower_bound(hashes.begin(), hashes.end(), hash.extract_as_byte_array()) - hashes.begin());
+        };
+
+        SnapshotWriter writer(fileName);
+        SnapshotHeader header{};
+        writer.append(&header, sizeof(header));
+
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_VERSION;
+        header.byteOrder = SNAPSHOT_BYTE_ORDER;
+        header.nodeCount = hashes.size();
+        header.documentCount = documents.size();
+        header.edgeCount = edges.size();
+        header.hashes = writer.append(hashes);
+
+        // documents are streamed to the arena one at a time, the slices follow it
+        std::vector<SnapshotDocument> slices(hashes.size(), SnapshotDocument{0, 0});
+        uint64_t arenaStart = writer.beginSection();
+        for (const Document &document : documents)
+        {
+            std::vector<char> packed = eosio::pack(document);
+            slices[nodeOf(document.getHash())] = SnapshotDocument{writer.endSection(arenaStart).size, packed.size()};
+            writer.write(packed.data(), packed.size());
+        }
+        header.arena = writer.endSection(arenaStart);
+        header.documents = writer.append(slices);
+
+        std::vector<std::tuple<uint32_t, uint64_t, uint32_t>> out;
+        std::vector<std::tuple<uint32_t, uint64_t, uint32_t>> in;
+        out.reserve(edges.size());
+        in.reserve(edges.size());
+        for (const Edge &edge : edges)
+        {
+            uint32_t from = nodeOf(edge.from_node);
+            uint32_t to = nodeOf(edge.to_node);
+            out.emplace_back(from, edge.edge_name.value, to);
+            in.emplace_back(to, edge.edge_name.value, from);
+        }
+
+        Adjacency outAdjacency = Adjacency::build(out, hashes.size());
+        header.outOffsets = writer.append(outAdjacency.offsets);
+        header.outNames = writer.append(outAdjacency.names);
+        header.outNodes = writer.append(outAdjacency.nodes);
+
+        Adjacency inAdjacency = Adjacency::build(in, hashes.size());
+        header.inOffsets = writer.append(inAdjacency.offsets);
+        header.inNames = writer.append(inAdjacency.names);
+        header.inNodes = writer.append(inAdjacency.nodes);
+
+        writer.writeHeader(header);
+        writer.close();
+    }
+
+    Snapshot::Snapshot(const std::string &fileName)
+    {
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        eosio::check(fd >= 0, "cannot open " + fileName);
+
+        struct stat status;
+        if (::fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(SnapshotHeader)))
+        {
+            ::close(fd);
+            eosio::check(false, fileName + " is not a graph snapshot");
+        }
+
+        m_size = status.st_size;
+        void *mapped = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        eosio::check(mapped != MAP_FAILED, "cannot map " + fileName);
+
+        // lookups and traversals jump around the file, so read-ahead mostly loads unused pages
+        ::madvise(mapped, m_size, MADV_RANDOM);
+        m_data = static_cast<const char *>(mapped);
+
+        m_header = reinterpret_cast<const SnapshotHeader *>(m_data);
+        eosio::check(std::memcmp(m_header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0, fileName + " is not a graph snapshot");
+        eosio::check(m_header->version == SNAPSHOT_VERSION, "unsupported snapshot version " + std::to_string(m_header->version));
+        eosio::check(m_header->byteOrder == SNAPSHOT_BYTE_ORDER, "snapshot was written with a different byte order");
+
+        const uint64_t nodes = m_header->nodeCount;
+        const uint64_t edges = m_header->edgeCount;
+        m_hashes = section<uint8_t>(m_header->hashes, nodes * 32);
+        m_documents = section<SnapshotDocument>(m_header->documents, nodes);
+        m_arena = section<char>(m_header->arena, m_header->arena.size);
+        m_out = AdjacencyView{section<uint32_t>(m_header->outOffsets, nodes + 1),
+                              section<uint64_t>(m_header->outNames, edges),
+                              section<uint32_t>(m_header->outNodes, edges)};
+        m_in = AdjacencyView{section<uint32_t>(m_header->inOffsets, nodes + 1),
+                             section<uint64_t>(m_header->inNames, edges),
+                             section<uint32_t>(m_header->inNodes, edges)};
+    }
+
+    Snapshot::~Snapshot()
+    {
+        ::munmap(const_cast<char *>(m_data), m_size);
+    }
+
+    // checks that a section holds count items inside the file; the data itself is not touched
+    template <typename T>
+    const T *Snapshot::section(const SnapshotSection &s, const uint64_t count) const
+    {
+        eosio::check(s.size == count * sizeof(T) && s.offset % alignof(T) == 0 && s.offset <= m_size && s.size <= m_size - s.offset,
+                     "corrupt snapshot section");
+        return reinterpret_cast<const T *>(m_data + s.offset);
+    }
+
+    std::optional<uint32_t> Snapshot::find(const eosio::checksum256 &hash) const
+    {
+        HashBytes bytes = hash.extract_as_byte_array();
+
+        uint64_t low = 0;
+        uint64_t high = m_header->nodeCount;
+        while (low < high)
+        {
+            uint64_t middle = low + (high - low) / 2;
+            int order = std::memcmp(m_hashes + middle * 32, bytes.data(), 32);
+            if (order == 0)
+            {
+                return uint32_t(middle);
+            }
+            if (order < 0)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+        return std::nullopt;
+    }
+
+    eosio::checksum256 Snapshot::getHash(const uint32_t node) const
+    {
+        HashBytes bytes;
+        std::memcpy(bytes.data(), m_hashes + uint64_t(node) * 32, 32);
+        return eosio::checksum256(bytes);
+    }
+
+    Document Snapshot::getDocument(const uint32_t node) const
+    {
+        const SnapshotDocument &slice = m_documents[node];
+        eosio::check(slice.size > 0, "snapshot has no document for " + std::to_string(node));
+        eosio::check(slice.offset + slice.size <= m_header->arena.size, "corrupt snapshot document slice");
+        return eosio::unpack<Document>(m_arena + slice.offset, slice.size);
+    }
+
+    Neighbors Snapshot::neighbors(const uint32_t node, const Direction direction, const eosio::name &edgeName) const
+    {
+        return (direction == Direction::Out ? m_out : m_in).neighbors(node, edgeName);
+    }
+
+    std::vector<uint32_t> Snapshot::query(const uint32_t start, const std::vector<Hop> &hops) const
+    {
+        return followHops(m_out, m_in, start, hops);
+    }
+
+} // namespace hypha
@@ -0,0 +1,78 @@
+#include <graph_tools/fingerprint.hpp>
+#include <graph_tools/parallel.hpp>
+#include <graph_tools/query_engine.hpp>
+#include <graph_tools/verifier.hpp>
+
+#include <document_graph/util.hpp>
+
+#include <chrono>
+#include <unordered_set>
+
+namespace hypha
+{
+    VerifyReport verifyGraph(const std::vector<Document> &documents, const std::vector<Edge> &edges, const unsigned threadCount)
+    {
+        VerifyReport report;
+
+        // per-thread results, merged once all threads are done
+        std::vector<VerifyReport> partial(threadCount);
+
+        auto started = std::chrono::steady_clock::now();
+        std::vector<eosio::checksum256> computed = hashContents(documents, threadCount);
+        for (std::size_t i = 0; i < documents.size(); i++)
+        {
+            if (computed[i] != documents[i].getHash())
+            {
+                report.hashMismatches.push_back(HashMismatch{documents[i].getHash(), computed[i]});
+            }
+        }
+        auto documentsDone = std::chrono::steady_clock::now();
+
+        std::unordered_set<eosio::checksum256, ChecksumHasher> stored;
+        stored.reserve(documents.size());
+        for (const Document &document : documents)
+        {
+            stored.insert(document.getHash());
+        }
+
+        // each edge costs four concatHash calls, so the chunks are smaller than for documents
+        parallelFor(edges.size(), threadCount, [&](std::size_t first, std::size_t last, unsigned worker) {
+            VerifyReport &result = partial[worker];
+            for (std::size_t i = first; i < last; i++)
+            {
+                const Edge &edge = edges[i];
+
+                bool missingFrom = stored.count(edge.from_node) == 0;
+                bool missingTo = stored.count(edge.to_node) == 0;
+                if (missingFrom || missingTo)
+                {
+                    result.orphanEdges.push_back(OrphanEdge{edge, missingFrom, missingTo});
+                }
+
+                auto checkKey = [&](const char *field, uint64_t stored, uint64_t expected) {
+                    if (stored != expected)
+                    {
+                        result.keyMismatches.push_back(KeyMismatch{edge, field, expected});
+                    }
+                };
+                checkKey("id", edge.id, concatHash(edge.from_node, edge.to_node, edge.edge_name));
+                checkKey("from_node_edge_name_index", edge.from_node_edge_name_index, concatHash(edge.from_node, edge.edge_name));
+                checkKey("from_node_to_node_index", edge.from_node_to_node_index, concatHash(edge.from_node, edge.to_node));
+                checkKey("to_node_edge_name_index", edge.to_node_edge_name_index, concatHash(edge.to_node, edge.edge_name));
+            }
+        }, 256);
+        auto edgesDone = std::chrono::steady_clock::now();
+
+        for (VerifyReport &result : partial)
+        {
+            report.hashMismatches.insert(report.hashMismatches.end(), result.hashMismatches.begin(), result.hashMismatches.end());
+            report.orphanEdges.insert(report.orphanEdges.end(), result.orphanEdges.begin(), result.orphanEdges.end());
+            report.keyMismatches.insert(report.keyMismatches.end(), result.keyMismatches.begin(), result.keyMismatches.end());
+        }
+
+        report.documentSeconds = std::chrono::duration<double>(documentsDone - started).count();
+        report.edgeSeconds = std::chrono::duration<double>(edgesDone - documentsDone).count();
+        return report;
+    }
+
+} // namespace hypha
@@ -0,0 +1,226 @@
+#include <graph_tools/websocket.hpp>
+
+#include <eosio/eosio.hpp>
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <random>
+
+namespace hypha
+{
+    namespace
+    {
+        constexpr uint8_t OPCODE_CONTINUATION = 0x0;
+        constexpr uint8_t OPCODE_TEXT = 0x1;
+        constexpr uint8_t OPCODE_BINARY = 0x2;
+        constexpr uint8_t OPCODE_CLOSE = 0x8;
+        constexpr uint8_t OPCODE_PING = 0x9;
+        constexpr uint8_t OPCODE_PONG = 0xa;
+
+        std::string base64(const uint8_t *data, std::size_t size)
+        {
+            static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            std::string result;
+            for (std::size_t i = 0; i < size; i += 3)
+            {
+                uint32_t chunk = uint32_t(data[i]) << 16;
+                if (i + 1 < size)
+                    chunk |= uint32_t(data[i + 1]) << 8;
+                if (i + 2 < size)
+                    chunk |= data[i + 2];
+
+                result += alphabet[(chunk >> 18) & 0x3f];
+                result += alphabet[(chunk >> 12) & 0x3f];
+                result += i + 1 < size ? alphabet[(chunk >> 6) & 0x3f] : '=';
+                result += i + 2 < size ? alphabet[chunk & 0x3f] : '=';
+            }
+            return result;
+        }
+    } // namespace
+
+    WebSocket::WebSocket(const std::string &host, const std::string &port, const std::string &path)
+    {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        addrinfo *addresses = nullptr;
+        eosio::check(getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) == 0, "cannot resolve " + host + ":" + port);
+        for (addrinfo *address = addresses; address && m_socket < 0; address = address->ai_next)
+        {
+            m_socket = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (m_socket >= 0 && connect(m_socket, address->ai_addr, address->ai_addrlen) != 0)
+            {
+                close(m_socket);
+                m_socket = -1;
+            }
+        }
+        freeaddrinfo(addresses);
+        eosio::check(m_socket >= 0, "cannot connect to " + host + ":" + port);
+
+        std::random_device random;
+        uint8_t nonce[16];
+        for (uint8_t &byte : nonce)
+            byte = uint8_t(random());
+
+        std::string request = "GET " + path + " HTTP/1.1\r\n"
+                              "Host: " + host + ":" + port + "\r\n"
+                              "Upgrade: websocket\r\n"
+                              "Connection: Upgrade\r\n"
+                              "Sec-WebSocket-Key: " + base64(nonce, sizeof(nonce)) + "\r\n"
+                              "Sec-WebSocket-Version: 13\r\n\r\n";
+        writeAll(request.data(), request.size());
+
+        // read the response headers; anything after them is already frame data
+        std::string response;
+        char chunk[4096];
+        std::size_t end;
+        while ((end = response.find("\r\n\r\n")) == std::string::npos)
+        {
+            ssize_t received = recv(m_socket, chunk, sizeof(chunk), 0);
+            eosio::check(received > 0, "connection closed during websocket handshake");
+            response.append(chunk, received);
+        }
+        eosio::check(response.compare(0, 12, "HTTP/1.1 101") == 0,
+                     "websocket upgrade refused: " + response.substr(0, response.find("\r\n")));
+        m_buffer.assign(response.begin() + end + 4, response.end());
+    }
+
+    WebSocket::~WebSocket()
+    {
+        if (m_socket >= 0)
+            close(m_socket);
+    }
+
+    void WebSocket::send(const std::vector<char> &message)
+    {
+        sendFrame(OPCODE_BINARY, message.data(), message.size());
+    }
+
+    bool WebSocket::receive(std::vector<char> &message)
+    {
+        message.clear();
+        for (;;)
+        {
+            uint8_t header[2];
+            readExact(reinterpret_cast<char *>(header), 2);
+            bool final = header[0] & 0x80;
+            uint8_t opcode = header[0] & 0x0f;
+            bool masked = header[1] & 0x80;
+
+            uint64_t size = header[1] & 0x7f;
+            if (size >= 126)
+            {
+                uint8_t extended[8];
+                std::size_t bytes = size == 126 ? 2 : 8;
+                readExact(reinterpret_cast<char *>(extended), bytes);
+                size = 0;
+                for (std::size_t i = 0; i < bytes; i++)
+                    size = (size << 8) | extended[i];
+            }
+
+            uint8_t mask[4] = {0, 0, 0, 0};
+            if (masked)
+                readExact(reinterpret_cast<char *>(mask), 4);
+
+            // control frames may arrive between the fragments of a message, so they are read separately
+            bool control = opcode & 0x8;
+            std::vector<char> controlPayload;
+            std::vector<char> &target = control ? controlPayload : message;
+
+            std::size_t offset = target.size();
+            target.resize(offset + size);
+            readExact(target.data() + offset, size);
+            if (masked)
+                for (uint64_t i = 0; i < size; i++)
+                    target[offset + i] ^= mask[i % 4];
+
+            if (opcode == OPCODE_CLOSE)
+            {
+                sendFrame(OPCODE_CLOSE, controlPayload.data(), std::min<std::size_t>(controlPayload.size(), 2));
+                return false;
+            }
+            if (opcode == OPCODE_PING)
+            {
+                sendFrame(OPCODE_PONG, controlPayload.data(), controlPayload.size());
+                continue;
+            }
+            if (control)
+                continue;
+
+            eosio::check(opcode == OPCODE_CONTINUATION || opcode == OPCODE_TEXT || opcode == OPCODE_BINARY,
+                         "unsupported websocket opcode " + std::to_string(opcode));
+            if (final)
+                return true;
+        }
+    }
+
+    void WebSocket::writeAll(const char *data, std::size_t size)
+    {
+        while (size > 0)
+        {
+            ssize_t sent = ::send(m_socket, data, size, MSG_NOSIGNAL);
+            eosio::check(sent > 0, std::string("websocket write failed: ") + std::strerror(errno));
+            data += sent;
+            size -= sent;
+        }
+    }
+
+    void WebSocket::readExact(char *data, std::size_t size)
+    {
+        std::size_t buffered = std::min(size, m_buffer.size() - m_bufferPos);
+        std::memcpy(data, m_buffer.data() + m_bufferPos, buffered);
+        m_bufferPos += buffered;
+        if (m_bufferPos == m_buffer.size())
+        {
+            m_buffer.clear();
+            m_bufferPos = 0;
+        }
+
+        for (std::size_t read = buffered; read < size;)
+        {
+            ssize_t received = recv(m_socket, data + read, size - read, 0);
+            eosio::check(received > 0, "websocket connection lost");
+            read += received;
+        }
+    }
+
+    // client frames are always sent as a single masked frame
+    void WebSocket::sendFrame(uint8_t opcode, const char *data, std::size_t size)
+    {
+        std::vector<char> frame;
+        frame.reserve(size + 14);
+        frame.push_back(char(0x80 | opcode));
+        if (size < 126)
+        {
+            frame.push_back(char(0x80 | size));
+        }
+        else if (size <= 0xffff)
+        {
+            frame.push_back(char(0x80 | 126));
+            frame.push_back(char(size >> 8));
+            frame.push_back(char(size));
+        }
+        else
+        {
+            frame.push_back(char(0x80 | 127));
+            for (int shift = 56; shift >= 0; shift -= 8)
+                frame.push_back(char(uint64_t(size) >> shift));
+        }
+
+        static std::mt19937 random{std::random_device{}()};
+        uint32_t maskBits = random();
+        char mask[4];
+        std::memcpy(mask, &maskBits, 4);
+        frame.insert(frame.end(), mask, mask + 4);
+
+        for (std::size_t i = 0; i < size; i++)
+            frame.push_back(data[i] ^ mask[i % 4]);
+        writeAll(frame.data(), frame.size());
+    }
+
+} // namespace hypha
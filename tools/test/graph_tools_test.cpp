@@ -0,0 +1,420 @@
+#include <graph_tools/diff.hpp>
+#include <graph_tools/graph_dump.hpp>
+#include <graph_tools/native_intrinsics.hpp>
+#include <graph_tools/query_engine.hpp>
+#include <graph_tools/replica.hpp>
+#include <graph_tools/ship_protocol.hpp>
+#include <graph_tools/snapshot.hpp>
+#include <graph_tools/verifier.hpp>
+
+#include <document_graph/util.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+using namespace hypha;
+
+namespace
+{
+    // The fixtures are two states of one small graph, written as SaveGraph writes them:
+    //
+    //   from   A -owns-> B, A -owns-> C, B -memberof-> D, C -memberof-> D, C -assigned-> A
+    //   to     B is gone and E takes its place: A -owns-> E, E -memberof-> D
+    //
+    // Their hashes and edge keys are what the contract computes, so both states verify.
+    const char *const HASH_A = "2404353ebf87567c6e52586a5e1e6c18da17b8a45f324a5ef716da67e9506cc5";
+    const char *const HASH_B = "92a8ca3402790f27b6ee79b9f9bd4c0d4b05f0770cd9315c8cc924f67b7bc514";
+    const char *const HASH_C = "492d3bee70210e41adae5410a3820bede3312fdcf724b5bb25517188ff9603ce";
+    const char *const HASH_D = "c47602d59d5a36024681e8188825f3b37502744271a9a6e059520dc2d788c3bb";
+    const char *const HASH_E = "a370ca428d5dae8c671b8d8340d1d79f995af1308d507eeaeaf1761b8c2572d4";
+
+    const eosio::name CONTRACT = eosio::name("documents");
+    const eosio::name OWNS = eosio::name("owns");
+    const eosio::name MEMBER_OF = eosio::name("memberof");
+    const eosio::name DOCUMENTS_TABLE = eosio::name("documents");
+    const eosio::name EDGES_TABLE = eosio::name("edges");
+
+    int failures = 0;
+
+    void expect(const bool condition, const std::string &what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what.c_str());
+            failures++;
+        }
+    }
+
+    // rows are compared as the contract packs them, in any order
+    template <typename Row>
+    std::vector<std::vector<char>> packedRows(const std::vector<Row> &rows)
+    {
+        std::vector<std::vector<char>> packed;
+        packed.reserve(rows.size());
+        for (const Row &row : rows)
+        {
+            packed.push_back(eosio::pack(row));
+        }
+        std::sort(packed.begin(), packed.end());
+        return packed;
+    }
+
+    std::vector<std::string> sortedHashes(const std::vector<eosio::checksum256> &hashes)
+    {
+        std::vector<std::string> readable;
+        for (const eosio::checksum256 &hash : hashes)
+        {
+            readable.push_back(readableHash(hash));
+        }
+        std::sort(readable.begin(), readable.end());
+        return readable;
+    }
+
+    std::vector<std::string> sortedHashes(std::vector<std::string> hashes)
+    {
+        std::sort(hashes.begin(), hashes.end());
+        return hashes;
+    }
+
+    std::string makeFolder(const std::string &folder)
+    {
+        ::mkdir(folder.c_str(), 0755);
+        return folder;
+    }
+
+    void writeDump(const std::string &folder, const std::vector<Document> &documents, const std::vector<Edge> &edges)
+    {
+        OutputFile documentFile(folder + "/documents.json");
+        documentFile.buffer() += '[';
+        for (std::size_t i = 0; i < documents.size(); i++)
+        {
+            documentFile.buffer() += i > 0 ? ",\n" : "\n";
+            appendDocumentRow(documentFile.buffer(), eosio::unpack<DocumentRow>(eosio::pack(documents[i])));
+        }
+        documentFile.buffer() += "\n]\n";
+        documentFile.close();
+
+        OutputFile edgeFile(folder + "/edges.json");
+        edgeFile.buffer() += '[';
+        for (std::size_t i = 0; i < edges.size(); i++)
+        {
+            edgeFile.buffer() += i > 0 ? ",\n" : "\n";
+            appendEdgeRow(edgeFile.buffer(), edges[i]);
+        }
+        edgeFile.buffer() += "\n]\n";
+        edgeFile.close();
+    }
+
+    // a dump written by the tools reads back into the same rows, escapes and all
+    void testDump(const std::string &fixtures, const std::string &work)
+    {
+        std::vector<Document> documents = loadDocuments(fixtures + "/from/documents.json");
+        std::vector<Edge> edges = loadEdges(fixtures + "/from/edges.json");
+        expect(documents.size() == 4, "from holds 4 documents");
+        expect(edges.size() == 5, "from holds 5 edges");
+        expect(verifyGraph(documents, edges, 2).ok(), "from verifies");
+        expect(verifyGraph(loadDocuments(fixtures + "/to/documents.json"), loadEdges(fixtures + "/to/edges.json"), 2).ok(), "to verifies");
+
+        for (const Document &document : documents)
+        {
+            if (readableHash(document.getHash()) != HASH_B)
+                continue;
+            const ContentGroups &contentGroups = document.getContentGroups();
+            expect(std::get<std::string>(contentGroups[0][0].value) == "quote \" and\nnewline \xc3\xa9 \xf0\x9f\x98\x80",
+                   "string escapes are decoded");
+            expect(std::get<std::int64_t>(contentGroups[0][1].value) == 42, "int64 contents are read");
+            expect(eosio::unpack<DocumentRow>(eosio::pack(document)).certificates.size() == 1, "certificates are read");
+        }
+
+        writeDump(work, documents, edges);
+        expect(packedRows(loadDocuments(work + "/documents.json")) == packedRows(documents), "documents survive a dump round trip");
+        expect(packedRows(loadEdges(work + "/edges.json")) == packedRows(edges), "edges survive a dump round trip");
+    }
+
+    const std::vector<std::pair<std::vector<Hop>, std::vector<std::string>>> &hopAnswers()
+    {
+        static const std::vector<std::pair<std::vector<Hop>, std::vector<std::string>>> answers = {
+            {{{Direction::Out, OWNS}, {Direction::Out, MEMBER_OF}}, {HASH_D}},
+            {{{Direction::Out, OWNS}, {Direction::Out, eosio::name()}}, {HASH_A, HASH_D}},
+            {{{Direction::Out, OWNS}, {Direction::Out, MEMBER_OF}, {Direction::In, MEMBER_OF}}, {HASH_B, HASH_C}},
+            {{{Direction::In, eosio::name("assigned")}}, {HASH_C}},
+            {{{Direction::Out, eosio::name("payment")}}, {}},
+        };
+        return answers;
+    }
+
+    // n-hop queries from A with known answers
+    void testQuery(const std::string &fixtures, const std::string &)
+    {
+        QueryEngine engine(loadDocuments(fixtures + "/from/documents.json"), loadEdges(fixtures + "/from/edges.json"));
+        expect(engine.nodeCount() == 4, "the engine interns 4 nodes");
+        expect(engine.edgeCount() == 5, "the engine holds 5 edges");
+
+        for (std::size_t i = 0; i < hopAnswers().size(); i++)
+        {
+            const auto &[hops, answer] = hopAnswers()[i];
+            expect(sortedHashes(engine.query(parseChecksum(HASH_A), hops)) == sortedHashes(answer), "query " + std::to_string(i));
+        }
+
+        std::optional<uint32_t> d = engine.find(parseChecksum(HASH_D));
+        expect(d.has_value() && engine.neighbors(*d, Direction::In, MEMBER_OF).size() == 2, "D has two incoming memberof edges");
+        expect(!engine.find(parseChecksum(HASH_E)), "E is not in from");
+    }
+
+    // a snapshot maps back to the rows and answers queries as the engine does
+    void testSnapshot(const std::string &fixtures, const std::string &work)
+    {
+        std::vector<Document> documents = loadDocuments(fixtures + "/from/documents.json");
+        std::vector<Edge> edges = loadEdges(fixtures + "/from/edges.json");
+
+        std::string fileName = work + "/from.dgs";
+        writeSnapshot(fileName, documents, edges);
+        Snapshot snapshot(fileName);
+        expect(snapshot.nodeCount() == 4 && snapshot.documentCount() == 4, "the snapshot holds 4 documents");
+        expect(snapshot.edgeCount() == 5, "the snapshot holds 5 edges");
+
+        std::vector<Document> mapped;
+        for (const Document &document : documents)
+        {
+            std::optional<uint32_t> node = snapshot.find(document.getHash());
+            expect(node && snapshot.getHash(*node) == document.getHash(), "the snapshot finds " + readableHash(document.getHash()));
+            if (node && snapshot.hasDocument(*node))
+                mapped.push_back(snapshot.getDocument(*node));
+        }
+        expect(packedRows(mapped) == packedRows(documents), "documents survive a snapshot round trip");
+
+        std::optional<uint32_t> a = snapshot.find(parseChecksum(HASH_A));
+        for (std::size_t i = 0; a && i < hopAnswers().size(); i++)
+        {
+            const auto &[hops, answer] = hopAnswers()[i];
+            std::vector<eosio::checksum256> reached;
+            for (uint32_t node : snapshot.query(*a, hops))
+            {
+                reached.push_back(snapshot.getHash(node));
+            }
+            expect(sortedHashes(reached) == sortedHashes(answer), "snapshot query " + std::to_string(i));
+        }
+    }
+
+    void expectFixtureDiff(const GraphDiff &diff, const std::string &what)
+    {
+        expect(diff.removedDocuments.size() == 1 && readableHash(eosio::checksum256(diff.removedDocuments[0].hash)) == HASH_B,
+               what + " removes B");
+        expect(diff.addedDocuments.size() == 1, what + " adds E");
+        expect(diff.removedEdges.size() == 2, what + " removes the edges of B");
+        expect(diff.addedEdges.size() == 2, what + " adds the edges of E");
+    }
+
+    // the diff of from and to, applied to a replica holding from, leaves it holding to
+    void testDiff(const std::string &fixtures, const std::string &work)
+    {
+        GraphInput from = loadGraphInput(fixtures + "/from", CONTRACT, CONTRACT);
+        GraphInput to = loadGraphInput(fixtures + "/to", CONTRACT, CONTRACT);
+        GraphDiff diff = diffKeys(collectKeys(from, 2), collectKeys(to, 2), 2);
+        expectFixtureDiff(diff, "the diff of the dumps");
+        expect(diffKeys(collectKeys(to, 2), collectKeys(to, 2), 2).empty(), "a state does not differ from itself");
+
+        std::string snapshotFile = work + "/to.dgs";
+        writeSnapshot(snapshotFile, to.documents, to.edges);
+        GraphInput snapshot = loadGraphInput(snapshotFile, CONTRACT, CONTRACT);
+        expectFixtureDiff(diffKeys(collectKeys(from, 2), collectKeys(snapshot, 2), 2), "the diff against a snapshot");
+
+        GraphReplica replica(CONTRACT);
+        replica.reconcile({}, {}, from.documents, from.edges);
+        applyChanges(diff, to, replica);
+        expect(packedRows(replica.documents()) == packedRows(to.documents), "applying the diff gives to's documents");
+        expect(packedRows(replica.edges()) == packedRows(to.edges), "applying the diff gives to's edges");
+    }
+
+    // a contract_row delta of the contract; a removed row still carries the value it had
+    ship::Row contractRow(const eosio::name &scope, const eosio::name &table, const uint64_t primaryKey,
+                          std::vector<char> value, const bool present)
+    {
+        ship::ContractRow row = ship::ContractRowV0{CONTRACT, scope, table, primaryKey, CONTRACT, std::move(value)};
+        return ship::Row{present, eosio::pack(row)};
+    }
+
+    ship::Row documentRow(const Document &document, const bool present = true, const eosio::name &scope = CONTRACT)
+    {
+        return contractRow(scope, DOCUMENTS_TABLE, document.primary_key(), eosio::pack(document), present);
+    }
+
+    ship::Row edgeRow(const Edge &edge, const bool present = true)
+    {
+        return contractRow(CONTRACT, EDGES_TABLE, edge.id, eosio::pack(edge), present);
+    }
+
+    // the deltas of a block as state history sends them, with only the contract_row table
+    std::vector<char> blockDeltas(std::vector<ship::Row> rows)
+    {
+        return eosio::pack(std::vector<ship::TableDelta>{ship::TableDeltaV0{"contract_row", std::move(rows)}});
+    }
+
+    // blocks of different forks have the same number and a different id
+    ship::BlockPosition blockPosition(const uint32_t blockNum, const uint8_t fork)
+    {
+        std::array<uint8_t, 32> id{};
+        id[0] = uint8_t(blockNum);
+        id[1] = fork;
+        return ship::BlockPosition{blockNum, eosio::checksum256(id)};
+    }
+
+    std::vector<std::vector<char>> replicaRows(const GraphReplica &replica)
+    {
+        std::vector<std::vector<char>> rows = packedRows(replica.documents());
+        std::vector<std::vector<char>> edges = packedRows(replica.edges());
+        rows.insert(rows.end(), edges.begin(), edges.end());
+        return rows;
+    }
+
+    bool samePositions(const std::vector<ship::BlockPosition> &a, const std::vector<ship::BlockPosition> &b)
+    {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const ship::BlockPosition &x, const ship::BlockPosition &y) {
+            return x.block_num == y.block_num && x.block_id == y.block_id;
+        });
+    }
+
+    // blocks 1 to 3 of the main fork and block 2 of another fork, built from the from fixture
+    struct ReplicaBlocks
+    {
+        std::vector<char> block1, block2, block3, block2b;
+    };
+
+    ReplicaBlocks replicaBlocks(const std::string &fixtures)
+    {
+        std::vector<Document> documents = loadDocuments(fixtures + "/from/documents.json");
+        std::vector<Edge> edges = loadEdges(fixtures + "/from/edges.json");
+
+        ReplicaBlocks blocks;
+
+        // the same document in another scope is a different graph and is left out
+        std::vector<ship::Row> rows;
+        for (const Document &document : documents)
+        {
+            rows.push_back(documentRow(document));
+        }
+        rows.push_back(documentRow(documents[0], true, eosio::name("tenant")));
+        blocks.block1 = blockDeltas(std::move(rows));
+
+        blocks.block2 = blockDeltas({edgeRow(edges[0]), edgeRow(edges[1]), edgeRow(edges[2])});
+
+        // block 3 removes B with its edges, adds an edge and rewrites another row in place
+        Edge rewritten = edges[1];
+        rewritten.creator = eosio::name("rewriter");
+        blocks.block3 = blockDeltas({edgeRow(edges[0], false), edgeRow(edges[2], false), documentRow(documents[1], false),
+                                     edgeRow(rewritten), edgeRow(edges[3])});
+
+        blocks.block2b = blockDeltas({documentRow(documents[1], false), edgeRow(edges[3]), edgeRow(edges[4])});
+        return blocks;
+    }
+
+    // applying blocks, rolling them back and switching forks leaves the rows of the blocks applied
+    void testReplicaFork(const std::string &fixtures, const std::string &)
+    {
+        ReplicaBlocks blocks = replicaBlocks(fixtures);
+
+        GraphReplica replica(CONTRACT);
+        replica.applyBlock(blockPosition(1, 0), blocks.block1, 0);
+        std::vector<std::vector<char>> afterBlock1 = replicaRows(replica);
+        expect(replica.documentCount() == 4 && replica.edgeCount() == 0, "block 1 stores 4 documents of the contract's scope");
+
+        replica.applyBlock(blockPosition(2, 0), blocks.block2, 0);
+        std::vector<std::vector<char>> afterBlock2 = replicaRows(replica);
+        expect(replica.edgeCount() == 3, "block 2 stores 3 edges");
+
+        replica.applyBlock(blockPosition(3, 0), blocks.block3, 0);
+        std::vector<std::vector<char>> afterBlock3 = replicaRows(replica);
+        expect(replica.documentCount() == 3 && replica.edgeCount() == 2, "block 3 removes B and its edges");
+
+        replica.rollbackTo(3);
+        expect(replicaRows(replica) == afterBlock2, "rolling back block 3 restores the rows of block 2");
+        expect(replica.head() && replica.head()->block_num == 2, "the head is block 2 after the rollback");
+
+        replica.applyBlock(blockPosition(3, 0), blocks.block3, 0);
+        expect(replicaRows(replica) == afterBlock3, "reapplying block 3 gives the same rows");
+
+        replica.rollbackTo(2);
+        expect(replicaRows(replica) == afterBlock1, "rolling back blocks 2 and 3 restores the rows of block 1");
+        replica.applyBlock(blockPosition(2, 0), blocks.block2, 0);
+        replica.applyBlock(blockPosition(3, 0), blocks.block3, 0);
+        expect(replicaRows(replica) == afterBlock3, "reapplying blocks 2 and 3 gives the same rows");
+
+        // a block at or below the head switches forks: blocks 2 and 3 are undone before 2b applies
+        replica.applyBlock(blockPosition(2, 1), blocks.block2b, 0);
+        GraphReplica fork(CONTRACT);
+        fork.applyBlock(blockPosition(1, 0), blocks.block1, 0);
+        fork.applyBlock(blockPosition(2, 1), blocks.block2b, 0);
+        expect(replicaRows(replica) == replicaRows(fork), "switching to block 2b gives the rows of blocks 1 and 2b");
+        expect(samePositions(replica.reversiblePositions(), {blockPosition(1, 0), blockPosition(2, 1)}),
+               "the reversible blocks are 1 and 2b");
+
+        // undo entries of irreversible blocks are dropped
+        replica.applyBlock(blockPosition(3, 1), blockDeltas({}), 2);
+        expect(samePositions(replica.reversiblePositions(), {blockPosition(3, 1)}), "only block 3b is reversible");
+        expect(replicaRows(replica) == replicaRows(fork), "an empty block changes no rows");
+    }
+
+    // a checkpoint holds the rows, the head and the undo log, so a loaded replica can still fork
+    void testReplicaCheckpoint(const std::string &fixtures, const std::string &work)
+    {
+        ReplicaBlocks blocks = replicaBlocks(fixtures);
+
+        GraphReplica replica(CONTRACT);
+        replica.applyBlock(blockPosition(1, 0), blocks.block1, 0);
+        replica.applyBlock(blockPosition(2, 0), blocks.block2, 1);
+        replica.applyBlock(blockPosition(3, 0), blocks.block3, 1);
+
+        std::string fileName = work + "/replica.ckpt";
+        replica.save(fileName);
+
+        GraphReplica loaded(CONTRACT);
+        expect(!loaded.load(work + "/missing.ckpt"), "a missing checkpoint is not loaded");
+        expect(loaded.load(fileName), "the checkpoint is loaded");
+        expect(replicaRows(loaded) == replicaRows(replica), "the rows survive a checkpoint");
+        expect(loaded.head() && loaded.head()->block_num == 3 && loaded.head()->block_id == replica.head()->block_id,
+               "the head survives a checkpoint");
+        expect(samePositions(loaded.reversiblePositions(), replica.reversiblePositions()), "the undo log survives a checkpoint");
+
+        replica.applyBlock(blockPosition(2, 1), blocks.block2b, 1);
+        loaded.applyBlock(blockPosition(2, 1), blocks.block2b, 1);
+        expect(replicaRows(loaded) == replicaRows(replica), "a loaded replica switches forks as the saved one does");
+    }
+} // namespace
+
+// graph_tools_test <test> <fixtures folder> <work folder>
+// runs one test on the graphs in the fixtures folder, writing its files to the work folder;
+// exits with 1 if any expectation fails. ctest runs each test, see CMakeLists.txt
+int main(int argc, char **argv)
+{
+    static const std::map<std::string, std::function<void(const std::string &, const std::string &)>> tests = {
+        {"dump", testDump},
+        {"query", testQuery},
+        {"snapshot", testSnapshot},
+        {"diff", testDiff},
+        {"replica_fork", testReplicaFork},
+        {"replica_checkpoint", testReplicaCheckpoint},
+    };
+
+    if (argc != 4 || tests.count(argv[1]) == 0)
+    {
+        std::fprintf(stderr, "usage: %s <dump|query|snapshot|diff|replica_fork|replica_checkpoint> <fixtures folder> <work folder>\n", argv[0]);
+        return 2;
+    }
+    registerNativeIntrinsics();
+
+    tests.at(argv[1])(argv[2], makeFolder(std::string(argv[3]) + "/" + argv[1]));
+    if (failures > 0)
+    {
+        std::fprintf(stderr, "%d expectations failed\n", failures);
+        return 1;
+    }
+    return 0;
+}